@@ -1,5 +1,6 @@
 ####################################################################################################
-# This function compile any GLSL shader into SPIR-V shader and embed it in a C header file.
+# This function compile any GLSL shader into SPIR-V shader and embed it in a C header file
+# as a constexpr word array (see embed_words).
 # Example:
 #	compile_shaders(TARGETS "assets/shader/basic.frag" "assets/shader/basic.vert")
 ####################################################################################################
@@ -35,7 +36,7 @@ function(compile_shaders TARGET_NAME)
 
 		# Create header file with binary const
 		execute_process(COMMAND ${glslCompiler} -V ${SHADER} -o ${SHADER_SPV})
-		embed_resource(${SHADER_SPV} ${SHADER_HEADER} ${GLOBAL_SHADER_VAR})
+		embed_words(${SHADER_SPV} ${SHADER_HEADER} ${GLOBAL_SHADER_VAR})
 		
 		message(STATUS "Generating build commands for ${SHADER}")
 	endforeach()
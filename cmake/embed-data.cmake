@@ -39,3 +39,54 @@ function(embed_resource resource_file_name source_file_name variable_name)
 
 endfunction()
 
+
+####################################################################################################
+# Same as embed_resource, for data read as little-endian 32-bit words (SPIR-V).
+# The header defines one constexpr word array and a span over it. Both are inline variables,
+# so every translation unit shares a single definition, with no static initializer and no heap.
+# Example:
+# - input file: base.vert.spv
+# - output file: base_vert.h
+# - span declared in output file: BASE_VERT (std::span<const uint32_t>)
+# embed_words("base.vert.spv" "base_vert.h" "BASE_VERT")
+####################################################################################################
+
+function(embed_words resource_file_name source_file_name variable_name)
+
+    if(EXISTS "${source_file_name}")
+        if("${source_file_name}" IS_NEWER_THAN "${resource_file_name}")
+            return()
+        endif()
+    endif()
+
+    if(EXISTS "${resource_file_name}")
+        file(READ "${resource_file_name}" hex_content HEX)
+
+        string(LENGTH "${hex_content}" hex_length)
+        math(EXPR tail_bytes "${hex_length} / 2 % 4")
+        if(NOT tail_bytes EQUAL 0)
+            message(FATAL_ERROR "${resource_file_name} is not a whole number of 32-bit words")
+        endif()
+
+        # 8 words per line
+        string(REPEAT "[0-9a-f]" 64 pattern)
+        string(REGEX REPLACE "(${pattern})" "\\1\n" content "${hex_content}")
+
+        # Bytes are in file order, swap them into little-endian words
+        string(REGEX REPLACE "([0-9a-f][0-9a-f])([0-9a-f][0-9a-f])([0-9a-f][0-9a-f])([0-9a-f][0-9a-f])" "0x\\4\\3\\2\\1, " content "${content}")
+
+        string(REGEX REPLACE ", $" "" content "${content}")
+
+        set(array_definition "alignas(4) inline constexpr uint32_t ${variable_name}_WORDS[] =\n{\n${content}\n};")
+        set(span_definition "inline constexpr std::span<const uint32_t> ${variable_name}{ ${variable_name}_WORDS };")
+
+        get_filename_component(file_name ${source_file_name} NAME)
+        set(source "/**\n * @file ${file_name}\n * @brief Auto generated file.\n */\n#pragma once\n#include <cstdint>\n#include <span>\n${array_definition}\n${span_definition}\n")
+
+        file(WRITE "${source_file_name}" "${source}")
+    else()
+        message("ERROR: ${resource_file_name} doesn't exist")
+        return()
+    endif()
+
+endfunction()
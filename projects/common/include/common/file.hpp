@@ -8,4 +8,11 @@ namespace vulkan
 
 std::vector<char> LoadFile( const std::filesystem::path path );
 
+// Next to path, unique across processes and the threads of this one
+std::filesystem::path UniqueTempPath( const std::filesystem::path& path );
+
+// Writes a uniquely named temporary file next to path, flushes it to disk and renames it
+// over path, so readers and crashes never leave a partially written file
+void SaveFileAtomic( const std::filesystem::path& path, const void* data, size_t size );
+
 }
\ No newline at end of file
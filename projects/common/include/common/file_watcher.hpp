@@ -0,0 +1,41 @@
+#pragma once
+
+#include <filesystem>
+#include <map>
+#include <set>
+#include <vector>
+
+#include "common/non_copyable.hpp"
+
+namespace vulkan
+{
+
+// Reports watched files modified since the last poll, without blocking.
+// On Linux inotify watches the files' directories, editors often save by replacing the file.
+// Elsewhere modification times are compared on every poll
+class FileWatcher : public NonCopyable
+{
+public:
+	FileWatcher();
+	~FileWatcher();
+
+	// False when the file's directory can't be watched (missing, out of watches)
+	bool watch( const std::filesystem::path& file );
+	// Normalized paths of the files changed, each once
+	std::vector<std::filesystem::path> poll();
+
+	// Absolute and lexically normal, what watch() stores and poll() returns
+	static std::filesystem::path Normalize( const std::filesystem::path& path );
+
+private:
+	std::set<std::filesystem::path> m_files;
+#ifdef __linux__
+	int m_fd;
+	// Watch descriptor to directory
+	std::map<int, std::filesystem::path> m_directories;
+#else
+	std::map<std::filesystem::path, std::filesystem::file_time_type> m_times;
+#endif
+};
+
+}
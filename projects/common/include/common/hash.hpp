@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace vulkan
+{
+
+// 64-bit FNV-1a, stable between runs and platforms so hashes can key on-disk data too
+constexpr uint64_t HashSeed = 0xcbf29ce484222325ull;
+
+inline uint64_t HashBytes( const void* data, size_t size, uint64_t seed = HashSeed )
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>( data );
+	uint64_t hash = seed;
+	for( size_t i = 0; i < size; i++ )
+	{
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+
+// Plain values only, padding bytes of structs would make equal values hash differently
+template <typename T>
+inline uint64_t HashValue( const T& value, uint64_t seed = HashSeed )
+{
+	static_assert( std::is_trivially_copyable_v<T> && std::has_unique_object_representations_v<T>,
+				   "hash the members one by one" );
+	return HashBytes( &value, sizeof( T ), seed );
+}
+
+}
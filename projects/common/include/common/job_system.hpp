@@ -0,0 +1,135 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "common/non_copyable.hpp"
+
+namespace vulkan
+{
+
+using Job = std::function<void()>;
+
+// Number of jobs still to finish, jobs run with a counter bump it until they complete.
+// It also keeps the first exception its jobs threw, for wait() on it to rethrow
+class JobCounter : public NonCopyable
+{
+public:
+	JobCounter() = default;
+
+	inline bool done() const
+	{
+		return m_count.load( std::memory_order_acquire ) == 0;
+	}
+	inline uint32_t pending() const
+	{
+		return m_count.load( std::memory_order_relaxed );
+	}
+
+	// Blocks until its jobs finished without running any, for the owner of background jobs
+	// before it goes away: those only run on workers, JobSystem::wait() wouldn't help them along.
+	// Exceptions stay on the counter
+	void drain() const;
+
+private:
+	friend class JobSystem;
+	std::atomic<uint32_t> m_count{ 0 };
+	std::mutex m_errorMutex;
+	std::exception_ptr m_error;
+};
+
+// Work-stealing job system.
+// Every thread has its own deque: it pushes and pops at the back (LIFO, cache warm) and
+// idle threads steal from the front of the others (FIFO, oldest and biggest work first).
+// Thread index 0 belongs to the thread that owns the system, it only runs jobs while waiting
+class JobSystem : public NonCopyable
+{
+public:
+	// 0 workers picks one per hardware thread besides the calling one
+	explicit JobSystem( uint32_t numWorkers = 0 );
+	~JobSystem();
+
+	// Jobs without a counter handle their own errors, whatever they throw is dropped
+	void run( Job job, JobCounter* counter = nullptr );
+	// Long low priority work (pipeline compiles, asset loads). Only worker threads pick it up,
+	// and only when they have nothing else to do, so a thread waiting on frame jobs never gets stuck in it
+	void runBackground( Job job, JobCounter* counter = nullptr );
+	// Runs other jobs until the counter reaches zero, rethrows the first exception thrown by one of its jobs
+	void wait( JobCounter& counter );
+
+	// Splits [0, count) in chunks of at least grain items and blocks until all ran
+	void parallelFor( uint32_t count, uint32_t grain, const std::function<void( uint32_t first, uint32_t count )>& func );
+
+	// Workers plus the owning thread
+	inline uint32_t numThreads() const
+	{
+		return static_cast<uint32_t>( m_queues.size() );
+	}
+
+	// Index of the calling thread inside the system it works for, 0 for any other thread
+	static uint32_t CurrentThreadIndex();
+
+private:
+	struct Queue
+	{
+		std::mutex mutex;
+		std::deque<std::pair<Job, JobCounter*>> jobs;
+	};
+
+	std::vector<std::unique_ptr<Queue>> m_queues;
+	Queue m_background;
+	std::vector<std::thread> m_threads;
+
+	std::mutex m_sleepMutex;
+	std::condition_variable m_wake;
+	std::atomic<uint32_t> m_queued;
+	std::atomic<bool> m_quit;
+
+	// Background jobs only for idle workers, waits run urgent work alone
+	bool tryRunOne( uint32_t thread, bool takeBackground );
+	void push( Queue& queue, Job job, JobCounter* counter );
+	void execute( Job& job, JobCounter* counter );
+	void workerLoop( uint32_t thread );
+};
+
+// Jobs with dependencies. Nodes start once every node they depend on finished
+class JobGraph : public NonCopyable
+{
+public:
+	using NodeId = uint32_t;
+
+	JobGraph() = default;
+
+	// Name must be a string literal, it labels the node's trace zone
+	NodeId add( const char* name, Job job, std::initializer_list<NodeId> dependencies = {} );
+	void clear();
+
+	// Starts the roots and returns, counter drops to zero once the whole graph ran
+	void dispatch( JobSystem& jobs, JobCounter& counter );
+	void execute( JobSystem& jobs );
+
+private:
+	struct Node
+	{
+		const char* name;
+		Job job;
+		std::vector<NodeId> dependents;
+		uint32_t dependencies = 0;
+		std::atomic<uint32_t> remaining{ 0 };
+	};
+
+	// Deque keeps nodes in place, atomics can't move
+	std::deque<Node> m_nodes;
+
+	void schedule( JobSystem& jobs, JobCounter& counter, NodeId id );
+};
+
+}  // namespace vulkan
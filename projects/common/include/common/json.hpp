@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+namespace vulkan
+{
+
+// Small JSON document, enough for asset headers (glTF).
+// Parse throws std::runtime_error on malformed input. Lookups of missing members
+// and out of range indices return a shared null value, so optional fields chain
+class Json
+{
+public:
+	using Array = std::vector<Json>;
+	using Object = std::map<std::string, Json, std::less<>>;
+
+	Json() = default;
+
+	static Json Parse( std::string_view text );
+
+	inline bool isNull() const
+	{
+		return std::holds_alternative<std::monostate>( m_value );
+	}
+	inline bool isNumber() const
+	{
+		return std::holds_alternative<double>( m_value );
+	}
+	inline bool isString() const
+	{
+		return std::holds_alternative<std::string>( m_value );
+	}
+	inline bool isArray() const
+	{
+		return std::holds_alternative<Array>( m_value );
+	}
+	inline bool isObject() const
+	{
+		return std::holds_alternative<Object>( m_value );
+	}
+
+	// fallback when the value has another type
+	double number( double fallback = 0.0 ) const;
+	bool boolean( bool fallback = false ) const;
+	const std::string& string() const;
+	// Empty for anything but arrays
+	const Array& array() const;
+
+	inline bool contains( std::string_view key ) const
+	{
+		const Object* object = std::get_if<Object>( &m_value );
+		return object && object->find( key ) != object->end();
+	}
+	const Json& operator[]( std::string_view key ) const;
+	const Json& operator[]( size_t index ) const;
+	size_t size() const;
+
+private:
+	std::variant<std::monostate, bool, double, std::string, Array, Object> m_value;
+
+	friend class JsonParser;
+};
+
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+#include "common/non_copyable.hpp"
+
+namespace vulkan
+{
+
+// Read-only memory mapping of a whole file.
+// Pages are loaded by the OS on first touch and shared with its file cache,
+// nothing is copied into the process. The mapping starts page aligned
+class MappedFile : public NonCopyable
+{
+public:
+	explicit MappedFile( const std::filesystem::path& path );
+	~MappedFile();
+
+	inline const std::byte* data() const
+	{
+		return m_data;
+	}
+	inline size_t size() const
+	{
+		return m_size;
+	}
+	inline std::span<const std::byte> bytes() const
+	{
+		return { m_data, m_size };
+	}
+
+private:
+	const std::byte* m_data;
+	size_t m_size;
+#ifdef _WIN32
+	void* m_file;
+	void* m_mapping;
+#endif
+};
+
+}
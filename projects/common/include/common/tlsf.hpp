@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace vulkan
+{
+
+// Two-level segregated fit allocator over an abstract range [0, size).
+// Only offsets are handed out, the memory itself lives elsewhere (a VkDeviceMemory block).
+// Free ranges are binned by the position of their top bit and the next SecondLevelBits bits,
+// bitmaps find a non-empty bin in constant time, and freed ranges merge with free neighbours
+class Tlsf
+{
+public:
+	static constexpr uint64_t InvalidOffset = std::numeric_limits<uint64_t>::max();
+
+	struct Allocation
+	{
+		uint64_t offset = InvalidOffset;
+		// Handle for free(), an index into the range table
+		uint32_t id = 0;
+	};
+
+	explicit Tlsf( uint64_t size );
+
+	// offset is InvalidOffset when no free range fits. alignment is a power of two
+	Allocation allocate( uint64_t size, uint64_t alignment );
+	void free( uint32_t id );
+
+	inline uint64_t size() const
+	{
+		return m_size;
+	}
+	// Bytes handed out, alignment padding kept with the allocation included
+	inline uint64_t used() const
+	{
+		return m_used;
+	}
+	inline uint32_t allocations() const
+	{
+		return m_allocations;
+	}
+	inline bool empty() const
+	{
+		return m_allocations == 0;
+	}
+	// Walks the free lists
+	uint64_t largestFree() const;
+	uint32_t freeRanges() const;
+
+private:
+	static constexpr uint32_t SecondLevelBits = 4;
+	static constexpr uint32_t SecondLevelCount = 1u << SecondLevelBits;
+	static constexpr uint32_t FirstLevelCount = 64;
+	static constexpr uint32_t None = std::numeric_limits<uint32_t>::max();
+
+	struct Range
+	{
+		uint64_t offset;
+		uint64_t size;
+		// Neighbours in address order
+		uint32_t prevPhysical = None;
+		uint32_t nextPhysical = None;
+		// Neighbours in the bin, only while free
+		uint32_t prevFree = None;
+		uint32_t nextFree = None;
+		bool free = false;
+	};
+
+	uint64_t m_size;
+	uint64_t m_used;
+	uint32_t m_allocations;
+
+	std::vector<Range> m_ranges;
+	// Unused entries of m_ranges
+	std::vector<uint32_t> m_spare;
+
+	uint64_t m_firstLevelMap;
+	uint32_t m_secondLevelMap[FirstLevelCount];
+	uint32_t m_bins[FirstLevelCount][SecondLevelCount];
+
+	static void Mapping( uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel );
+
+	uint32_t newRange( uint64_t offset, uint64_t size );
+	void insertFree( uint32_t id );
+	void removeFree( uint32_t id );
+	// Splits size bytes off the front of range id, the rest becomes a free range after it
+	void split( uint32_t id, uint64_t size );
+	// Absorbs the range after id, which must be free
+	void merge( uint32_t id, uint32_t next );
+	// First non-empty bin at or after (firstLevel, secondLevel), false when there's none
+	bool findBin( uint32_t& firstLevel, uint32_t& secondLevel ) const;
+};
+
+}
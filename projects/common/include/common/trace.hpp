@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+
+#include "common/non_copyable.hpp"
+
+namespace vulkan
+{
+
+struct TraceEvent
+{
+	// Names must be string literals (or otherwise outlive the tracer)
+	const char* name;
+	const char* category;
+	uint64_t start;     // ns, Tracer::Now() clock
+	uint64_t duration;  // ns
+	uint32_t thread;
+};
+
+// Always-on event recorder.
+// Events go into a fixed size lock-free ring, writers never block and the oldest
+// events are overwritten. flush() dumps whatever is in the ring as Chrome trace JSON
+// (chrome://tracing, ui.perfetto.dev)
+class Tracer : public NonCopyable
+{
+public:
+	static constexpr size_t Capacity = 1 << 16;
+	// Track used for GPU timestamps
+	static constexpr uint32_t GpuThread = 0xFFFF;
+
+	static Tracer& Get();
+
+	inline void setEnabled( bool enabled )
+	{
+		m_enabled.store( enabled, std::memory_order_relaxed );
+	}
+	inline bool enabled() const
+	{
+		return m_enabled.load( std::memory_order_relaxed );
+	}
+
+	void record( const char* name, const char* category, uint64_t start, uint64_t duration, uint32_t thread );
+	void flush( const std::filesystem::path& path ) const;
+
+	static uint64_t Now();
+	static uint32_t CurrentThread();
+
+private:
+	struct Slot
+	{
+		// Odd while the slot is written, 2 * (index + 1) once event for index is complete
+		std::atomic<uint64_t> sequence{ 0 };
+		TraceEvent event{};
+	};
+
+	std::unique_ptr<Slot[]> m_slots;
+	std::atomic<uint64_t> m_head;
+	std::atomic<bool> m_enabled;
+
+	Tracer();
+};
+
+// Records the lifetime of the scope as a CPU zone
+class TraceZone : public NonCopyable
+{
+public:
+	explicit TraceZone( const char* name, const char* category = "cpu" )
+		: m_name( name ),
+		m_category( category ),
+		m_start( Tracer::Now() )
+	{}
+	~TraceZone()
+	{
+		Tracer& tracer = Tracer::Get();
+		if( tracer.enabled() )
+			tracer.record( m_name, m_category, m_start, Tracer::Now() - m_start, Tracer::CurrentThread() );
+	}
+
+private:
+	const char* m_name;
+	const char* m_category;
+	uint64_t m_start;
+};
+
+}  // namespace vulkan
+
+#define TRACE_CONCAT_IMPL( a, b ) a##b
+#define TRACE_CONCAT( a, b ) TRACE_CONCAT_IMPL( a, b )
+#define TRACE_ZONE( name ) ::vulkan::TraceZone TRACE_CONCAT( traceZone, __LINE__ )( name )
@@ -1,10 +1,105 @@
 
 #include "common/file.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
 #include <fstream>
+#include <stdexcept>
+#include <string>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 namespace vulkan
 {
 
+namespace
+{
+
+#ifdef _WIN32
+
+// Creates the file, which must not exist, and returns once the data is on disk
+bool WriteDurable( const std::filesystem::path& path, const void* data, size_t size )
+{
+	HANDLE file = CreateFileW( path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_NEW, FILE_ATTRIBUTE_NORMAL, nullptr );
+	if( file == INVALID_HANDLE_VALUE )
+		return false;
+
+	const char* bytes = static_cast<const char*>( data );
+	bool written = true;
+	while( written && size > 0 )
+	{
+		DWORD chunk = static_cast<DWORD>( std::min<size_t>( size, 1u << 30 ) );
+		DWORD done = 0;
+		written = WriteFile( file, bytes, chunk, &done, nullptr ) && done > 0;
+		bytes += done;
+		size -= done;
+	}
+	written = written && FlushFileBuffers( file );
+	CloseHandle( file );
+	return written;
+}
+
+bool Replace( const std::filesystem::path& from, const std::filesystem::path& to )
+{
+	return MoveFileExW( from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH );
+}
+
+#else
+
+// Creates the file, which must not exist, and returns once the data is on disk
+bool WriteDurable( const std::filesystem::path& path, const void* data, size_t size )
+{
+	int fd = open( path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644 );
+	if( fd < 0 )
+		return false;
+
+	const char* bytes = static_cast<const char*>( data );
+	bool written = true;
+	while( written && size > 0 )
+	{
+		ssize_t done = write( fd, bytes, size );
+		if( done < 0 && errno == EINTR )
+			continue;
+		written = done > 0;
+		if( written )
+		{
+			bytes += done;
+			size -= static_cast<size_t>( done );
+		}
+	}
+	written = written && fsync( fd ) == 0;
+	close( fd );
+	return written;
+}
+
+bool Replace( const std::filesystem::path& from, const std::filesystem::path& to )
+{
+	if( std::rename( from.c_str(), to.c_str() ) != 0 )
+		return false;
+	// The rename itself lasts once the directory is synced, a failure there still left a whole file
+	std::filesystem::path directory = to.has_parent_path() ? to.parent_path() : std::filesystem::path( "." );
+	int fd = open( directory.c_str(), O_RDONLY | O_CLOEXEC );
+	if( fd >= 0 )
+	{
+		fsync( fd );
+		close( fd );
+	}
+	return true;
+}
+
+#endif
+
+}  // namespace
+
 std::vector<char> LoadFile( const std::filesystem::path path )
 {
 	std::ifstream file( path, std::ios::ate | std::ios::binary );
@@ -20,4 +115,34 @@ std::vector<char> LoadFile( const std::filesystem::path path )
 	return buffer;
 }
 
-}
\ No newline at end of file
+std::filesystem::path UniqueTempPath( const std::filesystem::path& path )
+{
+	static std::atomic<uint64_t> counter = 0;
+#ifdef _WIN32
+	unsigned long pid = GetCurrentProcessId();
+#else
+	long pid = static_cast<long>( getpid() );
+#endif
+	std::filesystem::path temp = path;
+	temp += "." + std::to_string( pid ) + "." + std::to_string( counter.fetch_add( 1 ) ) + ".tmp";
+	return temp;
+}
+
+void SaveFileAtomic( const std::filesystem::path& path, const void* data, size_t size )
+{
+	std::filesystem::path temp = UniqueTempPath( path );
+	if( !WriteDurable( temp, data, size ) )
+	{
+		std::error_code ignored;
+		std::filesystem::remove( temp, ignored );
+		throw std::runtime_error( "failed to write file!" );
+	}
+	if( !Replace( temp, path ) )
+	{
+		std::error_code ignored;
+		std::filesystem::remove( temp, ignored );
+		throw std::runtime_error( "failed to replace file!" );
+	}
+}
+
+}
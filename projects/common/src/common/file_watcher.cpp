@@ -0,0 +1,125 @@
+#include "common/file_watcher.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace vulkan
+{
+
+std::filesystem::path FileWatcher::Normalize( const std::filesystem::path& path )
+{
+	return std::filesystem::absolute( path ).lexically_normal();
+}
+
+#ifdef __linux__
+
+FileWatcher::FileWatcher()
+	: m_fd( inotify_init1( IN_NONBLOCK | IN_CLOEXEC ) )
+{
+	if( m_fd < 0 )
+		throw std::runtime_error( "failed to initialize inotify" );
+}
+
+FileWatcher::~FileWatcher()
+{
+	close( m_fd );
+}
+
+bool FileWatcher::watch( const std::filesystem::path& file )
+{
+	std::filesystem::path path = Normalize( file );
+	std::filesystem::path directory = path.parent_path();
+	for( const auto& [descriptor, watched] : m_directories )
+	{
+		if( watched == directory )
+		{
+			m_files.insert( path );
+			return true;
+		}
+	}
+
+	// Written in place, or replaced by a rename
+	int descriptor = inotify_add_watch( m_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO );
+	if( descriptor < 0 )
+		return false;
+	m_directories[descriptor] = directory;
+	m_files.insert( path );
+	return true;
+}
+
+std::vector<std::filesystem::path> FileWatcher::poll()
+{
+	std::vector<std::filesystem::path> changed;
+
+	alignas( inotify_event ) char buffer[4096];
+	while( true )
+	{
+		ssize_t length = read( m_fd, buffer, sizeof( buffer ) );
+		// EAGAIN, nothing more queued
+		if( length <= 0 )
+			break;
+
+		for( ssize_t offset = 0; offset < length; )
+		{
+			const inotify_event* event = reinterpret_cast<const inotify_event*>( buffer + offset );
+			offset += sizeof( inotify_event ) + event->len;
+
+			auto directory = m_directories.find( event->wd );
+			if( event->len == 0 || directory == m_directories.end() )
+				continue;
+
+			std::filesystem::path path = directory->second / event->name;
+			if( m_files.count( path ) && std::find( changed.begin(), changed.end(), path ) == changed.end() )
+				changed.push_back( path );
+		}
+	}
+	return changed;
+}
+
+#else
+
+FileWatcher::FileWatcher()
+{}
+
+FileWatcher::~FileWatcher()
+{}
+
+bool FileWatcher::watch( const std::filesystem::path& file )
+{
+	std::filesystem::path path = Normalize( file );
+	if( m_files.count( path ) )
+		return true;
+
+	std::error_code error;
+	std::filesystem::file_time_type time = std::filesystem::last_write_time( path, error );
+	if( error )
+		return false;
+	m_files.insert( path );
+	m_times[path] = time;
+	return true;
+}
+
+std::vector<std::filesystem::path> FileWatcher::poll()
+{
+	std::vector<std::filesystem::path> changed;
+	for( auto& [path, time] : m_times )
+	{
+		// Missing in the middle of a save, it's picked up once the file is back
+		std::error_code error;
+		std::filesystem::file_time_type current = std::filesystem::last_write_time( path, error );
+		if( error || current == time )
+			continue;
+		time = current;
+		changed.push_back( path );
+	}
+	return changed;
+}
+
+#endif
+
+}
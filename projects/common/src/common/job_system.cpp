@@ -0,0 +1,261 @@
+
+#include "common/job_system.hpp"
+#include "common/trace.hpp"
+
+#include <algorithm>
+
+namespace vulkan
+{
+
+static thread_local const JobSystem* CurrentSystem = nullptr;
+static thread_local uint32_t CurrentIndex = 0;
+
+JobSystem::JobSystem( uint32_t numWorkers )
+	: m_queued( 0 ),
+	m_quit( false )
+{
+	if( numWorkers == 0 )
+		numWorkers = std::max( std::thread::hardware_concurrency(), 2u ) - 1;
+
+	for( uint32_t i = 0; i <= numWorkers; i++ )
+		m_queues.push_back( std::make_unique<Queue>() );
+	for( uint32_t i = 1; i <= numWorkers; i++ )
+		m_threads.emplace_back( &JobSystem::workerLoop, this, i );
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock( m_sleepMutex );
+		m_quit = true;
+	}
+	m_wake.notify_all();
+	for( std::thread& thread : m_threads )
+		thread.join();
+}
+
+uint32_t JobSystem::CurrentThreadIndex()
+{
+	return CurrentIndex;
+}
+
+void JobSystem::run( Job job, JobCounter* counter )
+{
+	uint32_t thread = CurrentSystem == this ? CurrentIndex : 0;
+	push( *m_queues[thread], std::move( job ), counter );
+}
+
+void JobSystem::runBackground( Job job, JobCounter* counter )
+{
+	push( m_background, std::move( job ), counter );
+}
+
+void JobSystem::push( Queue& queue, Job job, JobCounter* counter )
+{
+	if( counter )
+		counter->m_count.fetch_add( 1, std::memory_order_relaxed );
+
+	{
+		std::lock_guard<std::mutex> lock( queue.mutex );
+		queue.jobs.emplace_back( std::move( job ), counter );
+	}
+	{
+		std::lock_guard<std::mutex> lock( m_sleepMutex );
+		m_queued.fetch_add( 1, std::memory_order_relaxed );
+	}
+	m_wake.notify_one();
+}
+
+bool JobSystem::tryRunOne( uint32_t thread, bool takeBackground )
+{
+	std::pair<Job, JobCounter*> entry;
+	bool found = false;
+
+	// Own work first, newest job
+	{
+		Queue& own = *m_queues[thread];
+		std::lock_guard<std::mutex> lock( own.mutex );
+		if( !own.jobs.empty() )
+		{
+			entry = std::move( own.jobs.back() );
+			own.jobs.pop_back();
+			found = true;
+		}
+	}
+
+	// Steal the oldest job of someone else
+	for( uint32_t i = 1; !found && i < m_queues.size(); i++ )
+	{
+		Queue& victim = *m_queues[( thread + i ) % m_queues.size()];
+		std::lock_guard<std::mutex> lock( victim.mutex );
+		if( !victim.jobs.empty() )
+		{
+			entry = std::move( victim.jobs.front() );
+			victim.jobs.pop_front();
+			found = true;
+		}
+	}
+
+	// Nothing urgent anywhere, idle workers take background work in submission order.
+	// Never from wait(): a frame job waiting on its children would be stuck behind a compile
+	if( !found && takeBackground )
+	{
+		std::lock_guard<std::mutex> lock( m_background.mutex );
+		if( !m_background.jobs.empty() )
+		{
+			entry = std::move( m_background.jobs.front() );
+			m_background.jobs.pop_front();
+			found = true;
+		}
+	}
+
+	if( !found )
+		return false;
+
+	m_queued.fetch_sub( 1, std::memory_order_relaxed );
+	execute( entry.first, entry.second );
+	return true;
+}
+
+void JobSystem::execute( Job& job, JobCounter* counter )
+{
+	try
+	{
+		job();
+	}
+	catch( ... )
+	{
+		if( counter )
+		{
+			std::lock_guard<std::mutex> lock( counter->m_errorMutex );
+			if( !counter->m_error )
+				counter->m_error = std::current_exception();
+		}
+	}
+
+	// Captures go first, whoever drains the counter may free what they reference
+	job = nullptr;
+	if( counter )
+		counter->m_count.fetch_sub( 1, std::memory_order_acq_rel );
+}
+
+void JobCounter::drain() const
+{
+	while( !done() )
+		std::this_thread::yield();
+}
+
+void JobSystem::wait( JobCounter& counter )
+{
+	uint32_t thread = CurrentSystem == this ? CurrentIndex : 0;
+	while( !counter.done() )
+	{
+		if( !tryRunOne( thread, false ) )
+			std::this_thread::yield();
+	}
+
+	std::exception_ptr error;
+	{
+		std::lock_guard<std::mutex> lock( counter.m_errorMutex );
+		std::swap( error, counter.m_error );
+	}
+	if( error )
+		std::rethrow_exception( error );
+}
+
+void JobSystem::parallelFor( uint32_t count, uint32_t grain, const std::function<void( uint32_t first, uint32_t count )>& func )
+{
+	if( count == 0 )
+		return;
+
+	uint32_t chunks = std::clamp( count / std::max( grain, 1u ), 1u, numThreads() );
+	uint32_t perChunk = ( count + chunks - 1 ) / chunks;
+
+	JobCounter counter;
+	for( uint32_t first = perChunk; first < count; first += perChunk )
+		run( [&func, first, perChunk, count] { func( first, std::min( perChunk, count - first ) ); }, &counter );
+
+	// Caller takes the first chunk itself, the other chunks reference func so they must finish either way
+	std::exception_ptr error;
+	try
+	{
+		func( 0, std::min( perChunk, count ) );
+	}
+	catch( ... )
+	{
+		error = std::current_exception();
+	}
+	wait( counter );
+	if( error )
+		std::rethrow_exception( error );
+}
+
+void JobSystem::workerLoop( uint32_t thread )
+{
+	CurrentSystem = this;
+	CurrentIndex = thread;
+
+	while( true )
+	{
+		if( tryRunOne( thread, true ) )
+			continue;
+
+		std::unique_lock<std::mutex> lock( m_sleepMutex );
+		m_wake.wait( lock, [this] { return m_quit || m_queued.load( std::memory_order_relaxed ) > 0; } );
+		if( m_quit )
+			return;
+	}
+}
+
+JobGraph::NodeId JobGraph::add( const char* name, Job job, std::initializer_list<NodeId> dependencies )
+{
+	NodeId id = static_cast<NodeId>( m_nodes.size() );
+	Node& node = m_nodes.emplace_back();
+	node.name = name;
+	node.job = std::move( job );
+	node.dependencies = static_cast<uint32_t>( dependencies.size() );
+	for( NodeId dependency : dependencies )
+		m_nodes[dependency].dependents.push_back( id );
+	return id;
+}
+
+void JobGraph::clear()
+{
+	m_nodes.clear();
+}
+
+void JobGraph::dispatch( JobSystem& jobs, JobCounter& counter )
+{
+	for( Node& node : m_nodes )
+		node.remaining.store( node.dependencies, std::memory_order_relaxed );
+
+	for( NodeId id = 0; id < m_nodes.size(); id++ )
+		if( m_nodes[id].dependencies == 0 )
+			schedule( jobs, counter, id );
+}
+
+void JobGraph::execute( JobSystem& jobs )
+{
+	JobCounter counter;
+	dispatch( jobs, counter );
+	jobs.wait( counter );
+}
+
+void JobGraph::schedule( JobSystem& jobs, JobCounter& counter, NodeId id )
+{
+	jobs.run( [this, &jobs, &counter, id]
+	{
+		Node& node = m_nodes[id];
+		{
+			TraceZone zone( node.name, "job" );
+			node.job();
+		}
+		// Dependents are queued before this job's counter decrement, so the
+		// counter can't reach zero while part of the graph is still pending
+		for( NodeId dependent : node.dependents )
+			if( m_nodes[dependent].remaining.fetch_sub( 1, std::memory_order_acq_rel ) == 1 )
+				schedule( jobs, counter, dependent );
+	}, &counter );
+}
+
+}
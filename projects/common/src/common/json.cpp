@@ -0,0 +1,265 @@
+#include "common/json.hpp"
+
+#include <charconv>
+#include <stdexcept>
+
+namespace vulkan
+{
+
+class JsonParser
+{
+public:
+	explicit JsonParser( std::string_view text )
+		: m_text( text ),
+		m_pos( 0 )
+	{}
+
+	Json document()
+	{
+		Json json = value( 0 );
+		skipSpace();
+		if( m_pos != m_text.size() )
+			fail( "trailing characters" );
+		return json;
+	}
+
+private:
+	std::string_view m_text;
+	size_t m_pos;
+
+	[[noreturn]] void fail( const char* what ) const
+	{
+		throw std::runtime_error( std::string( "JSON " ) + what + " at offset " + std::to_string( m_pos ) );
+	}
+
+	void skipSpace()
+	{
+		while( m_pos < m_text.size() &&
+			   ( m_text[m_pos] == ' ' || m_text[m_pos] == '\t' || m_text[m_pos] == '\n' || m_text[m_pos] == '\r' ) )
+			m_pos++;
+	}
+
+	char peek()
+	{
+		skipSpace();
+		if( m_pos >= m_text.size() )
+			fail( "ended early" );
+		return m_text[m_pos];
+	}
+
+	void expect( char c )
+	{
+		if( peek() != c )
+			fail( "unexpected character" );
+		m_pos++;
+	}
+
+	bool literal( std::string_view word )
+	{
+		if( m_text.substr( m_pos, word.size() ) != word )
+			return false;
+		m_pos += word.size();
+		return true;
+	}
+
+	Json value( uint32_t depth )
+	{
+		if( depth > 256 )
+			fail( "nests too deep" );
+
+		Json json;
+		char c = peek();
+		if( c == '{' )
+		{
+			m_pos++;
+			Json::Object object;
+			while( peek() != '}' )
+			{
+				if( !object.empty() )
+					expect( ',' );
+				std::string key = string();
+				expect( ':' );
+				object.insert_or_assign( std::move( key ), value( depth + 1 ) );
+			}
+			m_pos++;
+			json.m_value = std::move( object );
+		}
+		else if( c == '[' )
+		{
+			m_pos++;
+			Json::Array array;
+			while( peek() != ']' )
+			{
+				if( !array.empty() )
+					expect( ',' );
+				array.push_back( value( depth + 1 ) );
+			}
+			m_pos++;
+			json.m_value = std::move( array );
+		}
+		else if( c == '"' )
+			json.m_value = string();
+		else if( literal( "true" ) )
+			json.m_value = true;
+		else if( literal( "false" ) )
+			json.m_value = false;
+		else if( literal( "null" ) )
+			json.m_value = std::monostate{};
+		else
+			json.m_value = number();
+		return json;
+	}
+
+	double number()
+	{
+		double result = 0.0;
+		auto [end, error] = std::from_chars( m_text.data() + m_pos, m_text.data() + m_text.size(), result );
+		if( error != std::errc() )
+			fail( "invalid value" );
+		m_pos = end - m_text.data();
+		return result;
+	}
+
+	std::string string()
+	{
+		expect( '"' );
+		std::string result;
+		for( ;; )
+		{
+			if( m_pos >= m_text.size() )
+				fail( "unterminated string" );
+			char c = m_text[m_pos++];
+			if( c == '"' )
+				return result;
+			if( c != '\\' )
+			{
+				result += c;
+				continue;
+			}
+
+			if( m_pos >= m_text.size() )
+				fail( "unterminated string" );
+			char escape = m_text[m_pos++];
+			switch( escape )
+			{
+				case '"': result += '"'; break;
+				case '\\': result += '\\'; break;
+				case '/': result += '/'; break;
+				case 'b': result += '\b'; break;
+				case 'f': result += '\f'; break;
+				case 'n': result += '\n'; break;
+				case 'r': result += '\r'; break;
+				case 't': result += '\t'; break;
+				case 'u': AppendUtf8( result, codePoint() ); break;
+				default: fail( "invalid escape" );
+			}
+		}
+	}
+
+	uint32_t hex4()
+	{
+		uint32_t value = 0;
+		if( m_pos + 4 > m_text.size() ||
+			std::from_chars( m_text.data() + m_pos, m_text.data() + m_pos + 4, value, 16 ).ptr != m_text.data() + m_pos + 4 )
+			fail( "invalid unicode escape" );
+		m_pos += 4;
+		return value;
+	}
+
+	uint32_t codePoint()
+	{
+		uint32_t code = hex4();
+		// Surrogate pair
+		if( code >= 0xD800 && code < 0xDC00 && literal( "\\u" ) )
+		{
+			uint32_t low = hex4();
+			code = 0x10000 + ( ( code - 0xD800 ) << 10 ) + ( low - 0xDC00 );
+		}
+		return code;
+	}
+
+	static void AppendUtf8( std::string& out, uint32_t code )
+	{
+		if( code < 0x80 )
+			out += static_cast<char>( code );
+		else if( code < 0x800 )
+		{
+			out += static_cast<char>( 0xC0 | ( code >> 6 ) );
+			out += static_cast<char>( 0x80 | ( code & 0x3F ) );
+		}
+		else if( code < 0x10000 )
+		{
+			out += static_cast<char>( 0xE0 | ( code >> 12 ) );
+			out += static_cast<char>( 0x80 | ( ( code >> 6 ) & 0x3F ) );
+			out += static_cast<char>( 0x80 | ( code & 0x3F ) );
+		}
+		else
+		{
+			out += static_cast<char>( 0xF0 | ( code >> 18 ) );
+			out += static_cast<char>( 0x80 | ( ( code >> 12 ) & 0x3F ) );
+			out += static_cast<char>( 0x80 | ( ( code >> 6 ) & 0x3F ) );
+			out += static_cast<char>( 0x80 | ( code & 0x3F ) );
+		}
+	}
+};
+
+}
+
+using namespace vulkan;
+
+static const Json Null;
+static const Json::Array EmptyArray;
+static const std::string EmptyString;
+
+Json Json::Parse( std::string_view text )
+{
+	return JsonParser( text ).document();
+}
+
+double Json::number( double fallback ) const
+{
+	const double* value = std::get_if<double>( &m_value );
+	return value ? *value : fallback;
+}
+
+bool Json::boolean( bool fallback ) const
+{
+	const bool* value = std::get_if<bool>( &m_value );
+	return value ? *value : fallback;
+}
+
+const std::string& Json::string() const
+{
+	const std::string* value = std::get_if<std::string>( &m_value );
+	return value ? *value : EmptyString;
+}
+
+const Json::Array& Json::array() const
+{
+	const Array* value = std::get_if<Array>( &m_value );
+	return value ? *value : EmptyArray;
+}
+
+const Json& Json::operator[]( std::string_view key ) const
+{
+	const Object* object = std::get_if<Object>( &m_value );
+	if( !object )
+		return Null;
+	auto found = object->find( key );
+	return found != object->end() ? found->second : Null;
+}
+
+const Json& Json::operator[]( size_t index ) const
+{
+	const Array& values = array();
+	return index < values.size() ? values[index] : Null;
+}
+
+size_t Json::size() const
+{
+	if( const Array* array = std::get_if<Array>( &m_value ) )
+		return array->size();
+	if( const Object* object = std::get_if<Object>( &m_value ) )
+		return object->size();
+	return 0;
+}
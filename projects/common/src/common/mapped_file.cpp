@@ -0,0 +1,105 @@
+#include "common/mapped_file.hpp"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace vulkan
+{
+
+#ifdef _WIN32
+
+MappedFile::MappedFile( const std::filesystem::path& path )
+	: m_data( nullptr ),
+	m_size( 0 ),
+	m_file( INVALID_HANDLE_VALUE ),
+	m_mapping( nullptr )
+{
+	m_file = CreateFileW( path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+						  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+	if( m_file == INVALID_HANDLE_VALUE )
+		throw std::runtime_error( "failed to open file " + path.string() + "!" );
+
+	LARGE_INTEGER size;
+	if( !GetFileSizeEx( m_file, &size ) )
+	{
+		CloseHandle( m_file );
+		throw std::runtime_error( "failed to stat file " + path.string() + "!" );
+	}
+	m_size = static_cast<size_t>( size.QuadPart );
+	// Empty files can't be mapped, and have nothing to map
+	if( m_size == 0 )
+		return;
+
+	m_mapping = CreateFileMappingW( m_file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+	if( m_mapping )
+		m_data = static_cast<const std::byte*>( MapViewOfFile( m_mapping, FILE_MAP_READ, 0, 0, 0 ) );
+	if( !m_data )
+	{
+		if( m_mapping )
+			CloseHandle( m_mapping );
+		CloseHandle( m_file );
+		throw std::runtime_error( "failed to map file " + path.string() + "!" );
+	}
+}
+
+MappedFile::~MappedFile()
+{
+	if( m_data )
+		UnmapViewOfFile( m_data );
+	if( m_mapping )
+		CloseHandle( m_mapping );
+	CloseHandle( m_file );
+}
+
+#else
+
+MappedFile::MappedFile( const std::filesystem::path& path )
+	: m_data( nullptr ),
+	m_size( 0 )
+{
+	int fd = open( path.c_str(), O_RDONLY | O_CLOEXEC );
+	if( fd < 0 )
+		throw std::runtime_error( "failed to open file " + path.string() + "!" );
+
+	struct stat info;
+	if( fstat( fd, &info ) != 0 )
+	{
+		close( fd );
+		throw std::runtime_error( "failed to stat file " + path.string() + "!" );
+	}
+	m_size = static_cast<size_t>( info.st_size );
+
+	// Empty files can't be mapped, and have nothing to map
+	if( m_size > 0 )
+	{
+		void* data = mmap( nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+		if( data == MAP_FAILED )
+		{
+			close( fd );
+			throw std::runtime_error( "failed to map file " + path.string() + "!" );
+		}
+		m_data = static_cast<const std::byte*>( data );
+	}
+	// The mapping keeps the file referenced
+	close( fd );
+}
+
+MappedFile::~MappedFile()
+{
+	if( m_data )
+		munmap( const_cast<std::byte*>( m_data ), m_size );
+}
+
+#endif
+
+}
@@ -0,0 +1,238 @@
+#include "common/tlsf.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+using namespace vulkan;
+
+Tlsf::Tlsf( uint64_t size )
+	: m_size( size ),
+	m_used( 0 ),
+	m_allocations( 0 ),
+	m_firstLevelMap( 0 ),
+	m_secondLevelMap{}
+{
+	if( size == 0 )
+		throw std::runtime_error( "TLSF range can't be empty" );
+
+	for( auto& bins : m_bins )
+		std::fill( std::begin( bins ), std::end( bins ), None );
+	insertFree( newRange( 0, size ) );
+}
+
+void Tlsf::Mapping( uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel )
+{
+	firstLevel = static_cast<uint32_t>( std::bit_width( size ) - 1 );
+	// Small sizes spread their few values over the second level
+	if( firstLevel < SecondLevelBits )
+		secondLevel = static_cast<uint32_t>( size << ( SecondLevelBits - firstLevel ) ) & ( SecondLevelCount - 1 );
+	else
+		secondLevel = static_cast<uint32_t>( size >> ( firstLevel - SecondLevelBits ) ) & ( SecondLevelCount - 1 );
+}
+
+Tlsf::Allocation Tlsf::allocate( uint64_t size, uint64_t alignment )
+{
+	if( size == 0 )
+		size = 1;
+	alignment = std::max<uint64_t>( alignment, 1 );
+
+	// Ranges of the size's own bin may be too small, bins above only hold bigger ones.
+	// Alignment padding can still fail a range anywhere, so the lists are walked until one fits
+	uint32_t firstLevel = 0;
+	uint32_t secondLevel = 0;
+	Mapping( size, firstLevel, secondLevel );
+
+	while( findBin( firstLevel, secondLevel ) )
+	{
+		for( uint32_t id = m_bins[firstLevel][secondLevel]; id != None; id = m_ranges[id].nextFree )
+		{
+			const Range& range = m_ranges[id];
+			uint64_t aligned = ( range.offset + alignment - 1 ) & ~( alignment - 1 );
+			uint64_t padding = aligned - range.offset;
+			if( padding + size > range.size )
+				continue;
+
+			removeFree( id );
+			// Padding goes back to the free lists
+			if( padding > 0 )
+			{
+				split( id, padding );
+				uint32_t next = m_ranges[id].nextPhysical;
+				insertFree( id );
+				id = next;
+			}
+			if( m_ranges[id].size > size )
+			{
+				split( id, size );
+				insertFree( m_ranges[id].nextPhysical );
+			}
+
+			m_ranges[id].free = false;
+			m_used += m_ranges[id].size;
+			m_allocations++;
+			return { m_ranges[id].offset, id };
+		}
+
+		// Next bin
+		if( ++secondLevel == SecondLevelCount )
+		{
+			secondLevel = 0;
+			if( ++firstLevel == FirstLevelCount )
+				break;
+		}
+	}
+	return {};
+}
+
+void Tlsf::free( uint32_t id )
+{
+	Range& range = m_ranges[id];
+	if( range.free )
+		throw std::runtime_error( "TLSF range freed twice" );
+
+	m_used -= range.size;
+	m_allocations--;
+	range.free = true;
+
+	uint32_t next = range.nextPhysical;
+	if( next != None && m_ranges[next].free )
+	{
+		removeFree( next );
+		merge( id, next );
+	}
+	uint32_t prev = m_ranges[id].prevPhysical;
+	if( prev != None && m_ranges[prev].free )
+	{
+		removeFree( prev );
+		merge( prev, id );
+		id = prev;
+	}
+	insertFree( id );
+}
+
+uint64_t Tlsf::largestFree() const
+{
+	if( m_firstLevelMap == 0 )
+		return 0;
+
+	// Biggest ranges are in the highest non-empty bin
+	uint32_t firstLevel = static_cast<uint32_t>( std::bit_width( m_firstLevelMap ) - 1 );
+	uint32_t secondLevel = static_cast<uint32_t>( std::bit_width( m_secondLevelMap[firstLevel] ) - 1 );
+
+	uint64_t largest = 0;
+	for( uint32_t id = m_bins[firstLevel][secondLevel]; id != None; id = m_ranges[id].nextFree )
+		largest = std::max( largest, m_ranges[id].size );
+	return largest;
+}
+
+uint32_t Tlsf::freeRanges() const
+{
+	uint32_t count = 0;
+	for( uint32_t firstLevel = 0; firstLevel < FirstLevelCount; firstLevel++ )
+		for( uint32_t secondLevel = 0; secondLevel < SecondLevelCount; secondLevel++ )
+			for( uint32_t id = m_bins[firstLevel][secondLevel]; id != None; id = m_ranges[id].nextFree )
+				count++;
+	return count;
+}
+
+uint32_t Tlsf::newRange( uint64_t offset, uint64_t size )
+{
+	Range range;
+	range.offset = offset;
+	range.size = size;
+
+	if( !m_spare.empty() )
+	{
+		uint32_t id = m_spare.back();
+		m_spare.pop_back();
+		m_ranges[id] = range;
+		return id;
+	}
+	m_ranges.push_back( range );
+	return static_cast<uint32_t>( m_ranges.size() - 1 );
+}
+
+void Tlsf::insertFree( uint32_t id )
+{
+	uint32_t firstLevel = 0;
+	uint32_t secondLevel = 0;
+	Mapping( m_ranges[id].size, firstLevel, secondLevel );
+
+	Range& range = m_ranges[id];
+	range.free = true;
+	range.prevFree = None;
+	range.nextFree = m_bins[firstLevel][secondLevel];
+	if( range.nextFree != None )
+		m_ranges[range.nextFree].prevFree = id;
+	m_bins[firstLevel][secondLevel] = id;
+
+	m_firstLevelMap |= uint64_t( 1 ) << firstLevel;
+	m_secondLevelMap[firstLevel] |= 1u << secondLevel;
+}
+
+void Tlsf::removeFree( uint32_t id )
+{
+	uint32_t firstLevel = 0;
+	uint32_t secondLevel = 0;
+	Mapping( m_ranges[id].size, firstLevel, secondLevel );
+
+	Range& range = m_ranges[id];
+	if( range.prevFree != None )
+		m_ranges[range.prevFree].nextFree = range.nextFree;
+	else
+		m_bins[firstLevel][secondLevel] = range.nextFree;
+	if( range.nextFree != None )
+		m_ranges[range.nextFree].prevFree = range.prevFree;
+	range.prevFree = None;
+	range.nextFree = None;
+	range.free = false;
+
+	if( m_bins[firstLevel][secondLevel] == None )
+	{
+		m_secondLevelMap[firstLevel] &= ~( 1u << secondLevel );
+		if( m_secondLevelMap[firstLevel] == 0 )
+			m_firstLevelMap &= ~( uint64_t( 1 ) << firstLevel );
+	}
+}
+
+void Tlsf::split( uint32_t id, uint64_t size )
+{
+	// newRange may grow m_ranges, no references across it
+	uint32_t rest = newRange( m_ranges[id].offset + size, m_ranges[id].size - size );
+	uint32_t next = m_ranges[id].nextPhysical;
+
+	m_ranges[rest].prevPhysical = id;
+	m_ranges[rest].nextPhysical = next;
+	if( next != None )
+		m_ranges[next].prevPhysical = rest;
+	m_ranges[id].nextPhysical = rest;
+	m_ranges[id].size = size;
+}
+
+void Tlsf::merge( uint32_t id, uint32_t next )
+{
+	Range& range = m_ranges[id];
+	range.size += m_ranges[next].size;
+	range.nextPhysical = m_ranges[next].nextPhysical;
+	if( range.nextPhysical != None )
+		m_ranges[range.nextPhysical].prevPhysical = id;
+	m_spare.push_back( next );
+}
+
+bool Tlsf::findBin( uint32_t& firstLevel, uint32_t& secondLevel ) const
+{
+	uint32_t secondMap = m_secondLevelMap[firstLevel] & ( ~0u << secondLevel );
+	if( secondMap == 0 )
+	{
+		if( firstLevel + 1 >= FirstLevelCount )
+			return false;
+		uint64_t firstMap = m_firstLevelMap & ( ~uint64_t( 0 ) << ( firstLevel + 1 ) );
+		if( firstMap == 0 )
+			return false;
+		firstLevel = static_cast<uint32_t>( std::countr_zero( firstMap ) );
+		secondMap = m_secondLevelMap[firstLevel];
+	}
+	secondLevel = static_cast<uint32_t>( std::countr_zero( secondMap ) );
+	return true;
+}
@@ -0,0 +1,101 @@
+
+#include "common/trace.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+namespace vulkan
+{
+
+Tracer::Tracer()
+	: m_slots( std::make_unique<Slot[]>( Capacity ) ),
+	m_head( 0 ),
+	m_enabled( true )
+{}
+
+Tracer& Tracer::Get()
+{
+	static Tracer tracer;
+	return tracer;
+}
+
+uint64_t Tracer::Now()
+{
+	auto now = std::chrono::steady_clock::now().time_since_epoch();
+	return static_cast<uint64_t>( std::chrono::duration_cast<std::chrono::nanoseconds>( now ).count() );
+}
+
+uint32_t Tracer::CurrentThread()
+{
+	static std::atomic<uint32_t> counter{ 0 };
+	thread_local uint32_t id = counter.fetch_add( 1, std::memory_order_relaxed );
+	return id;
+}
+
+void Tracer::record( const char* name, const char* category, uint64_t start, uint64_t duration, uint32_t thread )
+{
+	uint64_t index = m_head.fetch_add( 1, std::memory_order_relaxed );
+	Slot& slot = m_slots[index & ( Capacity - 1 )];
+
+	// Seqlock style publish, readers drop slots that change under them
+	slot.sequence.store( 2 * index + 1, std::memory_order_relaxed );
+	std::atomic_thread_fence( std::memory_order_release );
+	slot.event = { name, category, start, duration, thread };
+	slot.sequence.store( 2 * ( index + 1 ), std::memory_order_release );
+}
+
+static void WriteEscaped( std::ofstream& file, const char* str )
+{
+	for( ; *str; str++ )
+	{
+		if( *str == '"' || *str == '\\' )
+			file << '\\';
+		file << *str;
+	}
+}
+
+void Tracer::flush( const std::filesystem::path& path ) const
+{
+	uint64_t head = m_head.load( std::memory_order_acquire );
+	uint64_t first = head > Capacity ? head - Capacity : 0;
+
+	std::vector<TraceEvent> events;
+	events.reserve( static_cast<size_t>( head - first ) );
+	for( uint64_t index = first; index < head; index++ )
+	{
+		const Slot& slot = m_slots[index & ( Capacity - 1 )];
+		uint64_t before = slot.sequence.load( std::memory_order_acquire );
+		if( before != 2 * ( index + 1 ) )
+			continue;
+		TraceEvent event = slot.event;
+		std::atomic_thread_fence( std::memory_order_acquire );
+		if( slot.sequence.load( std::memory_order_relaxed ) != before )
+			continue;
+		events.push_back( event );
+	}
+
+	std::ofstream file( path );
+	if( !file.is_open() )
+		throw std::runtime_error( "failed to open trace file!" );
+
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << GpuThread
+		 << ",\"args\":{\"name\":\"GPU\"}}";
+	file.precision( 3 );
+	file << std::fixed;
+	for( const TraceEvent& event : events )
+	{
+		file << ",\n{\"name\":\"";
+		WriteEscaped( file, event.name );
+		file << "\",\"cat\":\"";
+		WriteEscaped( file, event.category );
+		file << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread
+			 << ",\"ts\":" << event.start / 1000.0
+			 << ",\"dur\":" << event.duration / 1000.0 << "}";
+	}
+	file << "\n]}\n";
+}
+
+}
@@ -5,6 +5,7 @@
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <optional>
@@ -19,14 +20,34 @@
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_vulkan.h>
 
+#include "common/job_system.hpp"
+
 //#include <vulkan/Triangle/TriangleCommandBuffers.hpp>
+#include <vulkan/Bvh.hpp>
+#include <vulkan/CommandBuffers.hpp>
+#include <vulkan/ComputePipeline.hpp>
 #include <vulkan/DebugUtilsMessenger.hpp>
+#include <vulkan/DeletionQueue.hpp>
 #include <vulkan/Device.hpp>
+#include <vulkan/FrameScheduler.hpp>
+#include <vulkan/FrustumCuller.hpp>
+#include <vulkan/GpuProfiler.hpp>
+#include <vulkan/GpuScene.hpp>
 #include <vulkan/GraphicsPipeline.hpp>
 #include <vulkan/ImGui/ImGuiApp.hpp>
 #include <vulkan/Instance.hpp>
+#include <vulkan/InstanceBuffer.hpp>
+#include <vulkan/LatencyMonitor.hpp>
+#include <vulkan/MemoryAllocator.hpp>
+#include <vulkan/Mesh.hpp>
+#include <vulkan/ParallelRecorder.hpp>
+#include <vulkan/PipelineCache.hpp>
+#include <vulkan/PipelineLibrary.hpp>
+#include <vulkan/RenderGraph.hpp>
+#include <vulkan/ShaderCompiler.hpp>
+#include <vulkan/ShaderWatcher.hpp>
 #include <vulkan/SwapChain.hpp>
-#include <vulkan/SyncObjects.hpp>
+#include <vulkan/UploadManager.hpp>
 #include <vulkan/Window.hpp>
 
 namespace vulkan
@@ -35,7 +56,10 @@ namespace vulkan
 class Application
 {
 public:
-	Application();
+	// A mesh path (OBJ or glTF) is loaded in the background and drawn instead of the triangle
+	explicit Application( LatencyMode mode = LatencyMode::Throughput,
+						  std::filesystem::path meshFile = {},
+						  VertexLayout meshLayout = VertexLayout::Interleaved );
 
 	void run()
 	{
@@ -43,26 +67,162 @@ public:
 	}
 
 private:
+	// Passes of render_graph, in frame order
+	enum FramePass : uint32_t
+	{
+		ScenePass,
+		UiPass
+	};
+
 	Window window;
 	Instance instance;
 	DebugUtilsMessenger debugMessenger;
 	Device device;
+	// Outlives the deletion queue, deferred deletions free into it
+	MemoryAllocator allocator;
+	// Before everything that defers deletions into it, so it's flushed after them
+	DeletionQueue deletion;
 	SwapChain swap_chain;
 	CommandPool command_pool;
-	SyncObjects syncObjects;
-	
-	RenderPass render_pass;
+	FrameScheduler frames;
+	GpuProfiler profiler;
+	PipelineCache pipelineCache;
+	// Flushed once per frame, frames wait for it on the GPU
+	UploadManager uploads;
+	// Transforms and colors of the instanced stress scene
+	InstanceBuffer instances;
+
+	RenderGraph render_graph;
 	GraphicsPipeline graphicsPipeline;
+	GraphicsPipeline instancedPipeline;
 	CommandBuffers commandBuffers;
 	ImGuiApp interface;
+	// Written by the loading job, read once meshLoad is done. Before jobs, which may still run it
+	std::filesystem::path meshPath;
+	JobCounter meshLoad;
+	Scope<Mesh> mesh;
+	std::string meshError;
+	double meshLoadMs = 0.0;
+	// Draws the mesh, only with a mesh path
+	Scope<GraphicsPipeline> meshPipeline;
+	// GPU driven scene, built when first shown. Its meshes outlive it
+	std::vector<Scope<Mesh>> gpuSceneMeshes;
+	Scope<GpuScene> gpuScene;
+	Scope<GraphicsPipeline> indirectPipeline;
+	Scope<ComputePipeline> cullPipeline;
+	JobSystem jobs;
+	// Bounds of the GPU driven scene's objects, for picking and the CPU culling numbers.
+	// After jobs, its rebuilds run there
+	Bvh sceneBvh;
+	ParallelRecorder recorder;
+	// Scene material variants, graphicsPipeline draws while they compile
+	PipelineLibrary pipelines;
+	ShaderCompiler shaderCompiler;
+	// Hot reloads graphicsPipeline when the shader sources are edited
+	ShaderWatcher shaderWatcher;
+	// Runtime compiled variant of the base fragment shader
+	std::shared_future<Ref<Shader>> grayscaleRequest;
+	Ref<Shader> grayscaleShader;
+	std::string shaderError;
+
+	// UI edited settings
+	bool parallelRecording = true;
+	int drawCount = 1;
+	int sceneMaterial = 0;
+	bool instancedScene = false;
+	int instanceCount = 100000;
+
+	// Stress ramp of the instanced scene: the count doubles every step and each step's
+	// timings are kept (and printed) once it settled
+	struct InstanceSample
+	{
+		uint32_t instances;
+		double updateMs;
+		double frameMs;
+		double gpuMs;
+	};
+	bool instanceRamp = false;
+	uint32_t rampFrame = 0;
+	InstanceSample rampSum{};
+	std::vector<InstanceSample> rampSamples;
+	// CPU time filling the instance buffer, of the last finished frame
+	double instanceUpdateMs = 0.0;
+	// Bounding spheres of the instanced scene, culled every frame: only the visible
+	// instances are written and drawn. Written by the CullInstances job, read by the jobs after it
+	FrustumCuller instanceCuller;
+	std::vector<uint32_t> instanceVisible;
+	// Of the last finished frame
+	uint32_t instanceVisibleCount = 0;
+	double instanceCullMs = 0.0;
+	bool gpuDrivenScene = false;
+	int gpuSceneObjects = 250000;
+	// The object count changed, the scene is rebuilt next frame
+	bool gpuSceneDirty = false;
+	// Culling the scene with sceneBvh on the CPU, of the last finished frame
+	uint32_t bvhVisibleCount = 0;
+	double bvhCullMs = 0.0;
+	// Only touched by the CullBvh job
+	std::vector<uint32_t> bvhVisible;
+	// Last object clicked
+	std::optional<Bvh::Hit> pickedObject;
+
+	// Work on the job system for the frame being built, jobs read frameParams
+	// and not the settings the UI changes at the same time
+	struct FrameParams
+	{
+		uint32_t imageIndex;
+		uint32_t frameSlot;
+		VkExtent2D extent;
+		uint32_t drawCount;
+		bool parallelRecording;
+		VkPipeline scenePipeline;
+		// Null until the mesh is loaded and uploaded
+		const Mesh* mesh;
+		VkPipeline meshPipeline;
+		VkPipelineLayout meshLayout;
+		// Empty unless the instanced scene draws, filled by the frame graph
+		std::span<InstanceBuffer::Instance> instances;
+		// Culled by the graph's prologue and drawn with the indirect pipeline, null otherwise
+		const GpuScene* gpuScene;
+		VkPipeline indirectPipeline;
+		VkPipelineLayout indirectLayout;
+		float time;
+		glm::mat4 viewProjection;
+	};
+	FrameParams frameParams{};
+	// Written by the frame graph's jobs while the UI is built, which only reads
+	// the copies made once the graph is joined
+	struct FrameResults
+	{
+		double instanceUpdateMs;
+		uint32_t instanceVisibleCount;
+		double instanceCullMs;
+		uint32_t bvhVisibleCount;
+		double bvhCullMs;
+	};
+	FrameResults frameResults{};
+	JobGraph frameGraph;
+	// Scene secondary buffers of the frame being built, executed by ScenePass
+	const std::vector<VkCommandBuffer>* sceneCommands = nullptr;
 
-	size_t currentFrame = 0;
+	LatencyMode latencyMode;
+	LatencyMode requestedLatencyMode;
+	LatencyMonitor latency;
+	uint64_t inputSampleTime = 0;
 
 	void mainLoop();
 
 	void drawFrame( bool& framebufferResized );
 	void drawImGui();
 
+	RenderGraph::Desc describeFrame();
+	// Nothing while the material's shaders still compile
+	std::optional<PipelineDesc> describeSceneMaterial();
+	void buildFrameGraph();
+	void loadMesh( VertexLayout layout );
+	void updateInstanceRamp();
+	void buildGpuScene( uint32_t objectCount );
+	void applyLatencyMode();
 	void recreateSwapChain( bool& framebufferResized );
 };
 
@@ -0,0 +1,48 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "common/non_copyable.hpp"
+
+#include <vulkan/MemoryAllocator.hpp>
+
+namespace vulkan
+{
+class DeletionQueue;
+class Device;
+
+// VkBuffer placed in sub-allocated memory.
+// Destruction is deferred through the deletion queue, frames in flight may still read it
+class Buffer : public NonCopyable
+{
+public:
+	Buffer( const Device& device,
+			MemoryAllocator& allocator,
+			VkDeviceSize size,
+			VkBufferUsageFlags usage,
+			VkMemoryPropertyFlags properties,
+			DeletionQueue* deletion = nullptr );
+	~Buffer();
+
+	inline VkBuffer handle() const
+	{
+		return m_buffer;
+	}
+	inline VkDeviceSize size() const
+	{
+		return m_size;
+	}
+	// Null unless host visible. Writes need host coherent memory, nothing flushes them
+	inline void* mapped() const
+	{
+		return m_memory.mapped;
+	}
+
+private:
+	const Device& m_device;
+	MemoryAllocator& m_allocator;
+	DeletionQueue* m_deletion;
+
+	VkBuffer m_buffer;
+	VkDeviceSize m_size;
+	MemoryAllocator::Allocation m_memory;
+};
+}  // namespace vulkan
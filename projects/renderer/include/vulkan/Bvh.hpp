@@ -0,0 +1,168 @@
+#pragma once
+#include "common/job_system.hpp"
+#include "common/non_copyable.hpp"
+#include "common/pointers.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <vulkan/FrustumCuller.hpp>
+
+namespace vulkan
+{
+struct Aabb
+{
+	glm::vec3 min;
+	glm::vec3 max;
+};
+
+// Bounding volume hierarchy over object boxes, for frustum culling and ray picking of large,
+// mostly static scenes.
+// Built top down with the surface area heuristic (binned). Moved objects only refit their
+// leaves and the nodes above them, which slowly loosens the tree: update() rebuilds it on the
+// job system's background queue once it got too much worse than when built, or objects were
+// added, and swaps the new tree in when done. Queries stay correct meanwhile, objects added
+// since the last build are tested one by one.
+// Nodes and primitives are flat arrays of 32 byte entries, a node's children are next to each
+// other and a leaf's objects too, so they upload to a storage buffer as they are
+class Bvh : public NonCopyable
+{
+public:
+	// std430: struct { vec3 boundsMin; uint first; vec3 boundsMax; uint count; }
+	struct Node
+	{
+		glm::vec3 boundsMin;
+		// Leaves: first of their primitives. Inner nodes: left child, the right one follows it
+		uint32_t first;
+		glm::vec3 boundsMax;
+		// Primitives of a leaf, 0 for inner nodes
+		uint32_t count;
+
+		inline bool leaf() const
+		{
+			return count != 0;
+		}
+	};
+	static_assert( sizeof( Node ) == 32 );
+
+	// Object bounds in leaf order, same layout as a node
+	struct Primitive
+	{
+		glm::vec3 boundsMin;
+		uint32_t object;
+		glm::vec3 boundsMax;
+		uint32_t padding;
+	};
+	static_assert( sizeof( Primitive ) == 32 );
+
+	struct Hit
+	{
+		uint32_t object;
+		// Along the ray to the object's bounds, 0 when it starts inside them
+		float distance;
+	};
+
+	Bvh() = default;
+	// Waits for a rebuild still running
+	~Bvh();
+
+	// Returns the object's index, removed objects' indices are reused
+	uint32_t add( const Aabb& bounds );
+	// Moved objects, the tree is refit by the next refit() or update()
+	void set( uint32_t object, const Aabb& bounds );
+	// Objects already removed are ignored
+	void remove( uint32_t object );
+	void reserve( uint32_t count );
+	// Drops every object, a rebuild still running is discarded when it finishes
+	void clear();
+
+	// Builds the tree over every object on the calling thread
+	void build();
+	// Refits the nodes above moved objects
+	void refit();
+	// Once a frame: swaps in a finished rebuild, refits, and starts a background rebuild
+	// when objects were added or the tree degraded past rebuildThreshold
+	void update( JobSystem& jobs, float rebuildThreshold = 1.5f );
+
+	// Appends the objects whose bounds touch the frustum
+	void cull( const Frustum& frustum, std::vector<uint32_t>& visible ) const;
+	// Nearest object whose bounds the ray hits within maxDistance. direction needn't be normalized,
+	// distances are then in its length
+	std::optional<Hit> raycast( const glm::vec3& origin,
+								const glm::vec3& direction,
+								float maxDistance = std::numeric_limits<float>::max() ) const;
+
+	inline const std::vector<Node>& nodes() const
+	{
+		return m_nodes;
+	}
+	inline const std::vector<Primitive>& primitives() const
+	{
+		return m_primitives;
+	}
+	inline uint32_t objectCount() const
+	{
+		return static_cast<uint32_t>( m_bounds.size() - m_free.size() );
+	}
+	// Added since the last build, not in the tree yet
+	inline uint32_t pendingCount() const
+	{
+		return static_cast<uint32_t>( m_pending.size() );
+	}
+	// Surface area heuristic cost now against right after the build, 1 for a fresh tree
+	float degradation() const;
+	inline bool rebuilding() const
+	{
+		return !m_rebuild.done();
+	}
+
+private:
+	// Index into m_nodes or m_primitives of objects not in the tree
+	static constexpr uint32_t NotInTree = std::numeric_limits<uint32_t>::max();
+
+	struct Tree
+	{
+		std::vector<Node> nodes;
+		std::vector<Primitive> primitives;
+		uint64_t generation;
+	};
+
+	std::vector<Aabb> m_bounds;
+	std::vector<bool> m_removed;
+	std::vector<uint32_t> m_free;
+	// Of every object
+	std::vector<uint32_t> m_leaf;
+	std::vector<uint32_t> m_primitive;
+	std::vector<uint32_t> m_pending;
+
+	std::vector<Node> m_nodes;
+	std::vector<Primitive> m_primitives;
+	std::vector<uint32_t> m_parents;
+	// Leaves of moved objects, and which nodes refit() recomputes
+	std::vector<uint32_t> m_moved;
+	std::vector<bool> m_refit;
+	// Sum of node areas weighted by their cost, right after the build and now
+	float m_builtCost = 0.0f;
+	float m_cost = 0.0f;
+	// Removed objects whose primitives are still in the tree
+	uint32_t m_stale = 0;
+
+	// Background rebuild, installed by update() unless clear() ran since it started
+	JobSystem* m_jobs = nullptr;
+	JobCounter m_rebuild;
+	Scope<Tree> m_rebuilt;
+	uint64_t m_generation = 0;
+
+	// Over the given objects' bounds
+	static Tree Build( std::vector<Primitive> primitives );
+	// Of every object not removed
+	std::vector<Primitive> snapshot() const;
+	void install( Tree tree );
+	void markMoved( uint32_t object );
+	void refitNode( uint32_t index );
+};
+}  // namespace vulkan
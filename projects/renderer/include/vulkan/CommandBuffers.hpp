@@ -5,25 +5,28 @@
 #include <vector>
 #include <vulkan/CommandPool.hpp>
 #include <vulkan/Device.hpp>
-#include <vulkan/GraphicsPipeline.hpp>
-#include <vulkan/RenderPass.hpp>
-#include <vulkan/SwapChain.hpp>
 
 namespace vulkan
 {
+class Buffer;
+class DeletionQueue;
 
+// One primary command buffer per target image, re-recorded every frame
 class CommandBuffers : public NonCopyable
 {
 public:
+	// Replaced buffers go through deletion, or are freed right away without it
 	CommandBuffers( const Device& device,
-					const RenderPass& renderpass,
-					const SwapChain& swap_chain,
-					const GraphicsPipeline& graphical_pipeline,
-					const CommandPool& command_pool );
+					const CommandPool& command_pool,
+					uint32_t count,
+					DeletionQueue* deletion = nullptr );
 	~CommandBuffers();
 
-	void createCommandBuffers();
-	void recreate();
+	void recreate( uint32_t count );
+
+	// The pool must allow resetting single buffers to record one more than once
+	void begin( uint32_t index, VkCommandBufferUsageFlags flags = 0 );
+	void end( uint32_t index );
 
 	inline VkCommandBuffer& command( uint32_t index )
 	{
@@ -33,21 +36,40 @@ public:
 	{
 		return m_commandBuffers[index];
 	}
+	inline size_t size() const
+	{
+		return m_commandBuffers.size();
+	}
 
+	// Records and submits on the graphics queue, blocks until it ran.
+	// For tools and setup, uploads at runtime go through UploadManager
 	static void SingleTimeCommands( const Device& device,
 									const CommandPool& cmdPool,
 									const std::function<void( const VkCommandBuffer& )>& func );
 
+	// Indirect draws, tightly packed VkDrawIndexedIndirectCommand records.
+	// Draws the first count records, count being the uint at countOffset, up to maxDraws.
+	// Needs Device::drawIndirectCount()
+	static void DrawIndexedIndirectCount( VkCommandBuffer cmd,
+										  const Buffer& commands,
+										  VkDeviceSize offset,
+										  const Buffer& count,
+										  VkDeviceSize countOffset,
+										  uint32_t maxDraws );
+	// Compute shader writes before indirect draws: makes them visible to the indirect argument
+	// fetch and to the vertex shaders of the draws that follow
+	static void ComputeToIndirectBarrier( VkCommandBuffer cmd );
+	// Before indirect argument buffers are cleared or rewritten, draws still reading them finish
+	static void IndirectReuseBarrier( VkCommandBuffer cmd );
+
 protected:
 	std::vector<VkCommandBuffer> m_commandBuffers;
 
 	const Device& m_device;
-	const RenderPass& m_render_pass;
-	const SwapChain& m_swap_chain;
 	const CommandPool& m_command_pool;
-	const GraphicsPipeline& m_graphicsPipeline;
+	DeletionQueue* m_deletion;
 
-	//virtual void createCommandBuffers() = 0;
+	void createCommandBuffers( uint32_t count );
 	void destroyCommandBuffers();
 };
 }  // namespace vulkan
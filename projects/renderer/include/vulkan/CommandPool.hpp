@@ -2,6 +2,8 @@
 #include <vulkan/vulkan.h>
 #include "common/non_copyable.hpp"
 
+#include <optional>
+
 namespace vulkan
 {
 class Device;
@@ -9,7 +11,10 @@ class Device;
 class CommandPool : public NonCopyable
 {
 public:
-	CommandPool( const Device& device, const VkCommandPoolCreateFlags& flags );
+	// Graphics family unless another one is given
+	CommandPool( const Device& device,
+				 const VkCommandPoolCreateFlags& flags,
+				 std::optional<uint32_t> queueFamily = std::nullopt );
 	~CommandPool();
 
 	inline const VkCommandPool& handle() const
@@ -17,6 +22,9 @@ public:
 		return m_pool;
 	};
 
+	// Recycles every command buffer allocated from the pool
+	void reset() const;
+
 private:
 	VkCommandPool m_pool;
 	VkCommandPoolCreateFlags m_flags;
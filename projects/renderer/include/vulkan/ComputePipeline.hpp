@@ -0,0 +1,67 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "common/non_copyable.hpp"
+
+#include <cstdint>
+
+#include <vulkan/Shader.hpp>
+
+#include "common/pointers.hpp"
+
+namespace vulkan
+{
+
+class Device;
+class PipelineCache;
+class PipelineLayoutCache;
+
+// Compute counterpart of GraphicsPipeline: one compute shader, its layout taken from the
+// shader's reflection and shared through the cache's layouts. Compute work is recorded
+// outside of render passes, so nothing about the render graph's targets goes in.
+// Not hot reloaded, its shader is fixed for the pipeline's life
+class ComputePipeline : public NonCopyable
+{
+public:
+	ComputePipeline( const Device& device,
+					 Ref<Shader> shader,
+					 const PipelineCache* cache = nullptr );
+	~ComputePipeline();
+
+	// Builds a pipeline of the shader with the given layout, thread safe
+	static VkPipeline Create( const Device& device, const Ref<Shader>& shader, VkPipelineLayout layout, const PipelineCache* cache );
+
+	void bind( VkCommandBuffer cmd ) const;
+	// Groups covering count invocations along x, the shader's local size is groupSize
+	static inline uint32_t GroupCount( uint32_t count, uint32_t groupSize )
+	{
+		return ( count + groupSize - 1 ) / groupSize;
+	}
+
+	inline const VkPipeline& pipeline() const
+	{
+		return m_pipeline;
+	}
+	inline const VkPipelineLayout& layout() const
+	{
+		return m_layout;
+	}
+	inline const Ref<Shader>& shader() const
+	{
+		return m_shader;
+	}
+	// Layout of a descriptor set in the shader's reflected interface, for allocating its sets
+	VkDescriptorSetLayout setLayout( uint32_t set ) const;
+
+private:
+	const Device& m_device;
+	Ref<Shader> m_shader;
+	// Without a pipeline cache to share them through
+	Scope<PipelineLayoutCache> m_ownLayouts;
+	const PipelineCache* m_cache;
+
+	VkPipelineLayout m_layout;
+	VkPipeline m_pipeline;
+
+	PipelineLayoutCache& layouts() const;
+};
+}  // namespace vulkan
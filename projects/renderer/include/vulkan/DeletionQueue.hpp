@@ -0,0 +1,52 @@
+#pragma once
+#include "common/non_copyable.hpp"
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+namespace vulkan
+{
+class FrameScheduler;
+
+// Destroys Vulkan objects replaced while frames may still use them.
+// Deleters are tagged with the frame being built when they are pushed, the last frame
+// that can reference the object, and run once that frame retired on the timeline
+class DeletionQueue : public NonCopyable
+{
+public:
+	using Deleter = std::function<void()>;
+
+	DeletionQueue() = default;
+	// Runs everything left, the device must be idle
+	~DeletionQueue();
+
+	// Runs deleters whose frame retired, later pushes are tagged with the frame being built
+	void beginFrame( const FrameScheduler& frames );
+	void push( Deleter deleter );
+	// Runs everything now, the device must be idle
+	void flush();
+
+	inline size_t size() const
+	{
+		std::lock_guard lock( m_mutex );
+		return m_entries.size();
+	}
+
+	// Pushes into queue, or deletes right away without one (the caller keeps the device idle then)
+	static void Defer( DeletionQueue* queue, Deleter deleter );
+
+private:
+	struct Entry
+	{
+		uint64_t frame;
+		Deleter deleter;
+	};
+
+	mutable std::mutex m_mutex;
+	// Ordered by frame, frames only grow
+	std::deque<Entry> m_entries;
+	uint64_t m_frame = 0;
+};
+}  // namespace vulkan
@@ -15,6 +15,9 @@ namespace vulkan {
     Device(const Instance& instance,
            const Window& window,
            const std::vector<const char*>& extensions);
+    // Headless device, no surface and no present queue
+    Device(const Instance& instance,
+           const std::vector<const char*>& extensions);
     ~Device();
 
     inline const VkPhysicalDevice& physical() const { return m_physical; }
@@ -22,17 +25,43 @@ namespace vulkan {
     inline const QueueFamilyIndices& queueFamilyIndices() const { return m_indices; }
     inline const VkQueue& graphicsQueue() const { return m_graphicsQueue; }
     inline const VkQueue& presentQueue() const { return m_presentQueue; }
+    // Dedicated queue when the device has one, the graphics queue otherwise
+    inline const VkQueue& transferQueue() const { return m_transferQueue; }
+    inline uint32_t graphicsFamily() const { return m_indices.graphicsFamily.value(); }
+    inline uint32_t transferFamily() const { return m_indices.transferFamily.value_or(graphicsFamily()); }
+    inline bool headless() const { return m_window == nullptr; }
+
+    uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+
+    // VK_KHR_dynamic_rendering is enabled when supported, render passes are the fallback
+    inline bool dynamicRendering() const { return m_cmdBeginRendering != nullptr; }
+    void cmdBeginRendering(VkCommandBuffer cmd, const VkRenderingInfoKHR& info) const;
+    void cmdEndRendering(VkCommandBuffer cmd) const;
+
+    // GPU generated draws: vkCmdDrawIndexedIndirectCount with many draws per call,
+    // each draw's firstInstance read by the shaders. Enabled when all of it is supported
+    inline bool drawIndirectCount() const { return m_drawIndirectCount; }
 
   private:
     VkPhysicalDevice m_physical;
     VkDevice m_logical;
 
     const Instance& m_instance;
-    const Window& m_window;
+    const Window* m_window;
 
     QueueFamilyIndices m_indices;
     VkQueue m_graphicsQueue;
     VkQueue m_presentQueue;
+    VkQueue m_transferQueue;
+
+    // Extension commands aren't exported by the loader
+    PFN_vkCmdBeginRenderingKHR m_cmdBeginRendering;
+    PFN_vkCmdEndRenderingKHR m_cmdEndRendering;
+    bool m_drawIndirectCount;
+
+    Device(const Instance& instance,
+           const Window* window,
+           const std::vector<const char*>& extensions);
 
     static bool CheckDeviceExtensionSupport(const VkPhysicalDevice& device,
                                             const std::vector<const char*>& extensions);
@@ -41,6 +70,12 @@ namespace vulkan {
                                                const VkSurfaceKHR& surface,
                                                const std::vector<const char*>& requiredExtensions);
 
-    static bool IsDeviceSuitable(const VkPhysicalDevice& device, const VkSurfaceKHR& surface);
+    static bool CheckFeatureSupport(const VkPhysicalDevice& device);
+    static bool CheckDynamicRenderingSupport(const VkPhysicalDevice& device);
+    static bool CheckDrawIndirectCountSupport(const VkPhysicalDevice& device);
+
+    static bool IsDeviceSuitable(const VkPhysicalDevice& device,
+                                 const VkSurfaceKHR& surface,
+                                 const std::vector<const char*>& requiredExtensions);
   };
 }  // namespace vulkan
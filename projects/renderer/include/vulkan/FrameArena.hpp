@@ -0,0 +1,71 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "common/non_copyable.hpp"
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <optional>
+
+#include <vulkan/Buffer.hpp>
+
+namespace vulkan
+{
+class FrameScheduler;
+
+// Linear allocator for data written once per frame (uniforms, instance data, staging).
+// A ring over one host visible buffer: allocations are bump pointer, and whole frames
+// are given back once they retired on the timeline. Any other timeline works the same through begin().
+// Not thread safe, it's filled by the frame's builder
+class FrameArena : public NonCopyable
+{
+public:
+	struct Slice
+	{
+		VkBuffer buffer;
+		VkDeviceSize offset;
+		void* data;
+	};
+
+	FrameArena( const Device& device,
+				MemoryAllocator& allocator,
+				VkDeviceSize capacity,
+				VkBufferUsageFlags usage,
+				DeletionQueue* deletion = nullptr );
+
+	// Takes back what retired frames used, later allocations belong to the frame being built
+	void beginFrame( const FrameScheduler& frames );
+	// Same for a timeline of another queue, later allocations belong to value
+	void begin( uint64_t value, const std::function<bool( uint64_t value )>& retired );
+	// Nothing when frames in flight still hold too much of the ring. alignment is a power of two
+	std::optional<Slice> allocate( VkDeviceSize size, VkDeviceSize alignment = 16 );
+
+	inline VkDeviceSize capacity() const
+	{
+		return m_buffer.size();
+	}
+	// Frames in flight included, and space skipped at the end of the ring when wrapping
+	inline VkDeviceSize used() const
+	{
+		return m_used;
+	}
+
+private:
+	struct Frame
+	{
+		uint64_t frame;
+		// Where the frame's allocations ended and how much of the ring they took
+		VkDeviceSize end;
+		VkDeviceSize bytes;
+	};
+
+	Buffer m_buffer;
+	VkDeviceSize m_head;
+	VkDeviceSize m_tail;
+	VkDeviceSize m_used;
+
+	uint64_t m_frame;
+	VkDeviceSize m_frameBytes;
+	std::deque<Frame> m_frames;
+};
+}  // namespace vulkan
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include "common/non_copyable.hpp"
+#include <atomic>
+#include <vector>
+
+namespace vulkan
+{
+class Device;
+
+// Frame pacing on a single timeline semaphore.
+// Frame N signals value N on the timeline when its submission completes, so
+// "has frame N retired?" is an integer comparison against the semaphore counter.
+// Binary semaphores are only kept for the swap chain, which can't wait on timelines
+class FrameScheduler : public NonCopyable
+{
+public:
+	FrameScheduler( const Device& device, uint32_t numImages, uint32_t maxFramesInFlight );
+	~FrameScheduler();
+
+	// Waits until the frame slot can be reused and returns the timeline value of the new frame
+	uint64_t beginFrame();
+	// Waits for the last frame that rendered to the image, then hands the image to the current frame
+	void useImage( uint32_t imageIndex );
+	// Signals the current frame's value without any work, for frames dropped after beginFrame
+	void skipFrame( VkQueue queue );
+	// Chains the timeline signal for the current frame into a submission,
+	// the timeline is appended after the caller's binary signal semaphores
+	void fillSubmit( VkSubmitInfo& submitInfo,
+					 VkTimelineSemaphoreSubmitInfo& timelineInfo,
+					 std::vector<VkSemaphore>& signalSemaphores,
+					 std::vector<uint64_t>& signalValues ) const;
+
+	bool retired( uint64_t value ) const;
+	void wait( uint64_t value ) const;
+
+	// Number of swap chain images changed
+	void resizeImages( uint32_t numImages );
+	// Drains submitted frames on the timeline (device stays alive) and changes the queue depth
+	void setMaxFramesInFlight( uint32_t maxFramesInFlight );
+
+	inline uint64_t currentFrame() const
+	{
+		return m_frame;
+	}
+	inline uint32_t frameSlot() const
+	{
+		return static_cast<uint32_t>( m_frame % m_maxFramesInFlight );
+	}
+	inline uint32_t maxFramesInFlight() const
+	{
+		return m_maxFramesInFlight;
+	}
+	inline const VkSemaphore& timeline() const
+	{
+		return m_timeline;
+	}
+	inline const VkSemaphore& imageAvailable() const
+	{
+		return m_imageAvailable[frameSlot()];
+	}
+	inline const VkSemaphore& renderFinished() const
+	{
+		return m_renderFinished[frameSlot()];
+	}
+
+private:
+	const Device& m_device;
+
+	uint32_t m_maxFramesInFlight;
+	// Value signaled by the frame being built, 0 is the initial counter value
+	uint64_t m_frame;
+	mutable std::atomic<uint64_t> m_completed;
+
+	VkSemaphore m_timeline;
+	// Grow only, a smaller queue depth just leaves slots unused
+	std::vector<VkSemaphore> m_imageAvailable;
+	std::vector<VkSemaphore> m_renderFinished;
+	// Last frame that rendered to each swap chain image
+	std::vector<uint64_t> m_imageFrames;
+
+	void createSemaphores();
+	void destroySemaphores();
+	void raiseCompleted( uint64_t value ) const;
+};
+
+}  // namespace vulkan
@@ -0,0 +1,79 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace vulkan
+{
+// Planes of a view frustum, normalized and facing inside:
+// a point p is inside when dot( plane.xyz, p ) + plane.w >= 0 for all of them
+struct Frustum
+{
+	std::array<glm::vec4, 6> planes;
+
+	// Of a glm projection (OpenGL depth range) times a view matrix
+	static Frustum FromViewProjection( const glm::mat4& viewProjection );
+};
+
+// CPU frustum culling of bounding spheres kept as structure of arrays (center x, y, z and
+// radius each in an array of their own), tested 8 (AVX2) or 4 (SSE, NEON) at a time against
+// the six planes. The indices of visible spheres come out in order as a compact list, the
+// draws to record. The kernel is picked at runtime from what the CPU supports, the scalar
+// one is the fallback and the reference the others are checked against
+class FrustumCuller
+{
+public:
+	enum class Kernel : uint8_t
+	{
+		Scalar,
+		Sse,
+		Avx2,
+		Neon
+	};
+
+	// Widest kernel this CPU runs
+	static Kernel DefaultKernel();
+	static bool Supported( Kernel kernel );
+	static const char* KernelName( Kernel kernel );
+
+	// Returns the sphere's index
+	uint32_t add( const glm::vec3& center, float radius );
+	// Moved objects
+	void set( uint32_t index, const glm::vec3& center, float radius );
+	void reserve( uint32_t count );
+	void clear();
+
+	inline uint32_t size() const
+	{
+		return static_cast<uint32_t>( m_radius.size() );
+	}
+
+	// Writes the indices of the spheres in [first, first + count) touching the frustum to visible,
+	// which has room for count of them, and returns how many it wrote.
+	// Thread safe, disjoint ranges can be culled on separate jobs
+	uint32_t cull( const Frustum& frustum, uint32_t first, uint32_t count, uint32_t* visible, Kernel kernel ) const;
+	// Every sphere, visible is resized to the visible ones
+	void cull( const Frustum& frustum, std::vector<uint32_t>& visible, Kernel kernel = DefaultKernel() ) const;
+
+	struct BenchmarkResult
+	{
+		Kernel kernel;
+		// Best of the iterations
+		double nsPerSphere;
+		uint32_t visible;
+		// Same visible list as the scalar kernel
+		bool matchesScalar;
+	};
+
+	// Culls objectCount random spheres around a camera with every supported kernel
+	static std::vector<BenchmarkResult> Benchmark( uint32_t objectCount, uint32_t iterations );
+
+private:
+	std::vector<float> m_x;
+	std::vector<float> m_y;
+	std::vector<float> m_z;
+	std::vector<float> m_radius;
+};
+}  // namespace vulkan
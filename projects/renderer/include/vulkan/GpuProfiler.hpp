@@ -0,0 +1,74 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "common/non_copyable.hpp"
+#include <array>
+#include <vector>
+
+namespace vulkan
+{
+class DeletionQueue;
+class Device;
+
+// Passes timed on the GPU
+enum class GpuZone : uint32_t
+{
+	Scene,
+	Ui,
+	Cull,
+	Count
+};
+
+// Timestamp queries written around each GpuZone, one set of queries per slot (swap chain image).
+// Results of a slot are read back once the frame that last used it has finished,
+// converted to the Tracer clock and pushed as events on the GPU track
+class GpuProfiler : public NonCopyable
+{
+public:
+	// Replaced query pools go through deletion, or are destroyed right away without it
+	GpuProfiler( const Device& device, uint32_t numSlots, DeletionQueue* deletion = nullptr );
+	~GpuProfiler();
+
+	void recreate( uint32_t numSlots );
+
+	// Recorded into command buffers, no-ops when timestamps are unsupported
+	void reset( VkCommandBuffer cmd, uint32_t slot ) const;
+	void beginZone( VkCommandBuffer cmd, uint32_t slot, GpuZone zone ) const;
+	void endZone( VkCommandBuffer cmd, uint32_t slot, GpuZone zone ) const;
+
+	// CPU side, around the submission that executes the slot
+	void submitted( uint32_t slot, uint64_t cpuTime );
+	void collect( uint32_t slot );
+
+	inline bool supported() const
+	{
+		return m_supported;
+	}
+	inline double lastDurationMs( GpuZone zone ) const
+	{
+		return m_lastDurationMs[static_cast<uint32_t>( zone )];
+	}
+
+private:
+	static constexpr uint32_t QueriesPerSlot = 2 * static_cast<uint32_t>( GpuZone::Count );
+
+	const Device& m_device;
+	DeletionQueue* m_deletion;
+
+	VkQueryPool m_pool;
+	bool m_supported;
+	float m_timestampPeriod;
+	uint64_t m_timestampMask;
+
+	std::vector<bool> m_pending;
+	std::vector<uint64_t> m_submitTimes;
+	std::array<double, static_cast<size_t>( GpuZone::Count )> m_lastDurationMs;
+
+	// GPU ticks have no relation to the CPU clock, anchor them on a submit time
+	bool m_anchored;
+	uint64_t m_gpuAnchor;
+	uint64_t m_cpuAnchor;
+
+	void createQueryPool( uint32_t numSlots );
+	void destroyQueryPool();
+};
+}  // namespace vulkan
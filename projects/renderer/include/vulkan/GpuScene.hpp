@@ -0,0 +1,109 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "common/non_copyable.hpp"
+#include "common/pointers.hpp"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <vulkan/Buffer.hpp>
+#include <vulkan/InstanceBuffer.hpp>
+
+namespace vulkan
+{
+class ComputePipeline;
+class DeletionQueue;
+class Device;
+class Mesh;
+class UploadManager;
+
+// Objects culled and drawn by the GPU, no per object work on the CPU once they're uploaded.
+// Transforms and the mesh of every object live in device local buffers. Each frame cull()
+// dispatches cull.comp, testing the objects' bounding spheres against the frustum: visible
+// ones append a VkDrawIndexedIndirectCommand to their mesh's range and bump its count.
+// draw() is then one vkCmdDrawIndexedIndirectCount per mesh, the vertex shader reads the
+// object's transform through gl_InstanceIndex (mesh_indirect.vert).
+// Frames share the command and count buffers, cull() waits for the previous frame's draws
+class GpuScene : public NonCopyable
+{
+public:
+	struct Object
+	{
+		InstanceBuffer::Instance instance;
+		// Into the meshes the scene was created with
+		uint32_t mesh;
+	};
+
+	// Meshes must be interleaved and outlive the scene. The set layouts are set 0 of the cull
+	// and draw pipelines, objects are uploaded before the constructor returns
+	GpuScene( const Device& device,
+			  MemoryAllocator& allocator,
+			  UploadManager& uploads,
+			  std::vector<const Mesh*> meshes,
+			  std::span<const Object> objects,
+			  VkDescriptorSetLayout cullSetLayout,
+			  VkDescriptorSetLayout drawSetLayout,
+			  DeletionQueue* deletion = nullptr );
+	~GpuScene();
+
+	// Objects and meshes were flushed to the GPU
+	bool ready( const UploadManager& uploads ) const;
+
+	// Outside of rendering, before the frame's draws
+	void cull( VkCommandBuffer cmd, const ComputePipeline& pipeline, const glm::mat4& viewProjection ) const;
+	// In the pass, the pipeline bound draws interleaved meshes and reads the instances from set 0
+	void draw( VkCommandBuffer cmd, VkPipelineLayout layout ) const;
+
+	inline uint32_t objectCount() const
+	{
+		return m_objectCount;
+	}
+	inline size_t meshCount() const
+	{
+		return m_meshes.size();
+	}
+
+private:
+	// struct MeshInfo in cull.comp
+	struct MeshInfo
+	{
+		glm::vec4 sphere;
+		uint32_t indexCount;
+		uint32_t firstCommand;
+		uint32_t padding[2];
+	};
+	static_assert( sizeof( MeshInfo ) == 32 );
+
+	// push constants of cull.comp
+	struct CullConstants
+	{
+		glm::vec4 planes[6];
+		uint32_t objectCount;
+	};
+
+	const Device& m_device;
+	DeletionQueue* m_deletion;
+
+	std::vector<const Mesh*> m_meshes;
+	// Objects of each mesh, the most draws its range can hold
+	std::vector<uint32_t> m_meshObjects;
+	std::vector<uint32_t> m_firstCommands;
+	uint32_t m_objectCount;
+
+	Scope<Buffer> m_instances;
+	Scope<Buffer> m_objectMeshes;
+	Scope<Buffer> m_meshInfos;
+	Scope<Buffer> m_commands;
+	Scope<Buffer> m_counts;
+	uint64_t m_uploadValue;
+
+	VkDescriptorPool m_pool;
+	VkDescriptorSet m_cullSet;
+	VkDescriptorSet m_drawSet;
+
+	void createDescriptorSets( VkDescriptorSetLayout cullSetLayout, VkDescriptorSetLayout drawSetLayout );
+};
+}  // namespace vulkan
@@ -1,9 +1,13 @@
 #pragma once
 #include <vulkan/vulkan.h>
+#include "common/job_system.hpp"
 #include "common/non_copyable.hpp"
 #include <vector>
 #include <filesystem>
+#include <mutex>
+#include <optional>
 #include <span>
+#include <string>
 
 #include <vulkan/Shader.hpp>
 
@@ -13,42 +17,148 @@
 namespace vulkan
 {
 
+class DeletionQueue;
 class Device;
-class SwapChain;
-class RenderPass;
-struct ShaderDetails;
+class PipelineCache;
+class PipelineLayoutCache;
+class RenderGraph;
+class ShaderCompiler;
+
+// Everything a graphics pipeline is built from, compact enough to hash.
+// Viewport and scissor are always dynamic state, so the extent is not part of it
+struct PipelineDesc
+{
+	Shaders shaders;
+
+	std::vector<VkVertexInputBindingDescription> vertexBindings;
+	std::vector<VkVertexInputAttributeDescription> vertexAttributes;
+
+	VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	VkPolygonMode polygonMode = VK_POLYGON_MODE_FILL;
+	VkCullModeFlags cullMode = VK_CULL_MODE_BACK_BIT;
+	VkFrontFace frontFace = VK_FRONT_FACE_CLOCKWISE;
+
+	// Straight alpha "over" blending of the color output, opaque otherwise
+	bool alphaBlend = false;
+
+	bool depthTest = false;
+	bool depthWrite = false;
+	VkCompareOp depthCompare = VK_COMPARE_OP_LESS_OR_EQUAL;
+
+	// Null derives the layout from the shaders' reflection
+	VkPipelineLayout layout = VK_NULL_HANDLE;
+
+	// Render pass compatibility: render pass and subpass,
+	// or attachment formats when the render pass is null (dynamic rendering)
+	VkRenderPass renderPass = VK_NULL_HANDLE;
+	uint32_t subpass = 0;
+	std::vector<VkFormat> colorFormats;
+	VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+
+	// Takes the compatibility part from a pass of the graph
+	void setTarget( const RenderGraph& graph, uint32_t pass );
+
+	uint64_t hash() const;
+	bool operator==( const PipelineDesc& other ) const;
+};
 
 class GraphicsPipeline : public NonCopyable
 {
 public:
+	// Draws in a pass of the graph with the state of desc, its target is filled in here.
+	// Without a layout in desc it's taken from the shaders' reflection, shared through the cache.
+	// Replaced pipelines go through deletion, or are destroyed right away without it
 	GraphicsPipeline( const Device& device,
-					  const SwapChain& swap_chain,
-					  const RenderPass& render_pass,
-					  Shaders shaders );
+					  const RenderGraph& graph,
+					  uint32_t pass,
+					  PipelineDesc desc,
+					  const PipelineCache* cache = nullptr,
+					  DeletionQueue* deletion = nullptr );
 	~GraphicsPipeline();
 
+	// The graph's target formats changed
 	void recreate();
 
+	// Hot reload: recompiles the shaders from their sources and builds the replacement pipeline
+	// on a background job, the current one keeps drawing meanwhile. Ignored while a reload runs
+	void reload( ShaderCompiler& compiler, JobSystem& jobs );
+	// At a frame boundary, swaps in a finished reload. The replaced pipeline goes through deletion
+	bool swapReloaded();
+	inline bool reloading() const
+	{
+		return !m_reload.done();
+	}
+	// A finished reload was built for targets recreate() replaced and dropped, reload() again
+	inline bool reloadStale() const
+	{
+		return m_reloadStale;
+	}
+	// Blocks until a reload in flight finished
+	inline void waitReload() const
+	{
+		m_reload.drain();
+	}
+	// Of the last reload, empty if it succeeded
+	inline const std::string& reloadError() const
+	{
+		return m_reloadError;
+	}
+	// Files the shaders were compiled from, empty for shaders without source
+	std::vector<std::filesystem::path> sources() const;
+
+	inline const PipelineDesc& desc() const
+	{
+		return m_desc;
+	}
+
+	// Builds the pipeline described, thread safe
+	static VkPipeline Create( const Device& device, const PipelineDesc& desc, const PipelineCache* cache );
+
 	inline const VkPipeline& pipeline() const
 	{
 		return m_pipeline;
 	}
 	inline const VkPipelineLayout& layout() const
 	{
-		return m_layout;
+		return m_desc.layout;
 	}
+	// Layout of a descriptor set in the shaders' reflected interface, for allocating its sets.
+	// Reloads keep the handle while the set's bindings stay the same
+	VkDescriptorSetLayout setLayout( uint32_t set ) const;
 
 private:
 	VkPipeline m_pipeline;
-	VkPipelineLayout m_layout;
-	VkPipelineLayout m_oldLayout;
 
 	const Device& m_device;
-	const SwapChain& m_swap_chain;
-	const RenderPass& m_render_pass;
-	Shaders mShaders;
+	const PipelineCache* m_cache;
+	DeletionQueue* m_deletion;
+	const RenderGraph& m_graph;
+	uint32_t m_pass;
+	PipelineDesc m_desc;
+	// Layout follows the shaders, also through reloads
+	bool m_reflectLayout;
+	// Without a pipeline cache to share them through
+	Scope<PipelineLayoutCache> m_ownLayouts;
+
+	struct Reload
+	{
+		PipelineDesc desc;
+		VkPipeline pipeline = VK_NULL_HANDLE;
+		// Built against this generation's targets
+		uint64_t generation = 0;
+		std::string error;
+	};
+
+	JobCounter m_reload;
+	std::mutex m_reloadMutex;
+	std::optional<Reload> m_reloaded;
+	std::string m_reloadError;
+	// Bumped by recreate(), reloads of an older generation are thrown away
+	uint64_t m_generation;
+	bool m_reloadStale;
 
 	void createPipeline();
-	VkShaderModule createShaderModule( const std::vector<unsigned char>& code );
+	PipelineLayoutCache& layouts() const;
+	static VkShaderModule CreateShaderModule( const Device& device, const Shader& shader );
 };
 }  // namespace vulkan
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include <vulkan/CommandBuffers.hpp>
+#include <vulkan/CommandPool.hpp>
+#include <vulkan/DebugUtilsMessenger.hpp>
+#include <vulkan/Device.hpp>
+#include <vulkan/FrameScheduler.hpp>
+#include <vulkan/GraphicsPipeline.hpp>
+#include <vulkan/Instance.hpp>
+#include <vulkan/MemoryAllocator.hpp>
+#include <vulkan/OffscreenTarget.hpp>
+#include <vulkan/PipelineCache.hpp>
+#include <vulkan/RenderGraph.hpp>
+
+namespace vulkan
+{
+
+// Renders into device owned images without GLFW, a surface or a swap chain.
+// Frames are submitted back to back, so throughput is bound only by the device (or software ICD)
+class HeadlessApplication
+{
+public:
+	HeadlessApplication( VkExtent2D extent, bool validationLayers );
+
+	void run( uint32_t frameCount )
+	{
+		mainLoop( frameCount );
+	}
+
+private:
+	Instance instance;
+	DebugUtilsMessenger debugMessenger;
+	Device device;
+	MemoryAllocator allocator;
+	OffscreenTarget target;
+	CommandPool command_pool;
+	FrameScheduler frames;
+	PipelineCache pipelineCache;
+
+	RenderGraph render_graph;
+	GraphicsPipeline graphicsPipeline;
+	CommandBuffers commandBuffers;
+
+	RenderGraph::Desc describeFrame();
+	void mainLoop( uint32_t frameCount );
+
+	void drawFrame();
+};
+
+}  // namespace vulkan
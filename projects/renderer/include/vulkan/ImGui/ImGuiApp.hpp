@@ -7,17 +7,20 @@
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_vulkan.h>
 
+#include <vulkan/CommandBuffers.hpp>
 #include <vulkan/CommandPool.hpp>
 #include <vulkan/Device.hpp>
-#include <vulkan/ImGui/ImGuiCommandBuffers.hpp>
-#include <vulkan/ImGui/ImGuiRenderPass.hpp>
 #include <vulkan/Instance.hpp>
+#include <vulkan/PipelineCache.hpp>
+#include <vulkan/RenderGraph.hpp>
 #include <vulkan/SwapChain.hpp>
+#include <vulkan/UploadManager.hpp>
 #include <vulkan/Window.hpp>
 
 namespace vulkan
 {
 
+// Draws the UI as a pass of the frame's render graph
 class ImGuiApp
 {
 public:
@@ -25,37 +28,24 @@ public:
 			  Window& window,
 			  const Device& device,
 			  const SwapChain& swap_chain,
-			  const GraphicsPipeline& graphical_pipeline );
+			  const RenderGraph& graph,
+			  uint32_t pass,
+			  UploadManager& uploads,
+			  const PipelineCache* cache = nullptr );
 	~ImGuiApp();
 
-	inline VkCommandBuffer& command( uint32_t index )
-	{
-		return commandBuffers.command( index );
-	}
-	inline const VkCommandBuffer& command( uint32_t index ) const
-	{
-		return commandBuffers.command( index );
-	}
-
-	void recordCommandBuffers( uint32_t bufferIdx )
-	{
-		commandBuffers.recordCommandBuffers( bufferIdx );
-	}
-
-	void recreate();
+	// Records the draw data of the last ImGui::Render() inside the UI pass
+	void record( VkCommandBuffer cmd );
 
 private:
 	VkDescriptorPool imGuiDescriptorPool;
 
-	//ImGuiRenderPass render_pass;
-	RenderPass render_pass;
-	CommandPool command_pool;
-	ImGuiCommandBuffers commandBuffers;
-
 	const Instance& m_instance;
 	const Device& m_device;
 	const SwapChain& m_swap_chain;
-	//const GraphicsPipeline& m_graphicsPipeline;
+	UploadManager& m_uploads;
+	// Upload of the font texture, its staging buffer is kept until it's done
+	uint64_t m_fontUpload;
 
 	void createImGuiDescriptorPool();
 };
@@ -0,0 +1,53 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "common/non_copyable.hpp"
+
+#include <vulkan/MemoryAllocator.hpp>
+
+namespace vulkan
+{
+class DeletionQueue;
+class Device;
+
+// VkImage placed in sub-allocated memory, with a view of all its mips and layers.
+// Destruction is deferred through the deletion queue, frames in flight may still read it
+class Image : public NonCopyable
+{
+public:
+	Image( const Device& device,
+		   MemoryAllocator& allocator,
+		   const VkImageCreateInfo& createInfo,
+		   VkImageAspectFlags aspect,
+		   VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		   DeletionQueue* deletion = nullptr );
+	~Image();
+
+	inline VkImage handle() const
+	{
+		return m_image;
+	}
+	inline VkImageView view() const
+	{
+		return m_view;
+	}
+	inline VkFormat format() const
+	{
+		return m_format;
+	}
+	inline VkExtent3D extent() const
+	{
+		return m_extent;
+	}
+
+private:
+	const Device& m_device;
+	MemoryAllocator& m_allocator;
+	DeletionQueue* m_deletion;
+
+	VkImage m_image;
+	VkImageView m_view;
+	VkFormat m_format;
+	VkExtent3D m_extent;
+	MemoryAllocator::Allocation m_memory;
+};
+}  // namespace vulkan
@@ -20,6 +20,10 @@ public:
 			  const char* appName,
 			  const char* engineName,
 			  bool validationLayers );
+	// Headless instance, no window surface and no GLFW extensions
+	Instance( const char* appName,
+			  const char* engineName,
+			  bool validationLayers );
 	Instance() = delete;
 	~Instance();
 
@@ -36,10 +40,15 @@ public:
 	static const std::vector<const char*> DeviceExtensions;
 
 private:
-	Window& mWindow;
+	Window* mWindow;
 	VkInstance m_instance;
 	bool m_enableValidationLayers;
 
+	Instance( Window* window,
+			  const char* appName,
+			  const char* engineName,
+			  bool validationLayers );
+
 	static bool CheckValidationLayerSupport();
 	std::vector<const char*> GetRequiredExtensions( bool validationLayers );
 };
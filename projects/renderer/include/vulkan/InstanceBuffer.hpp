@@ -0,0 +1,91 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "common/non_copyable.hpp"
+#include "common/pointers.hpp"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <vulkan/FrameArena.hpp>
+
+namespace vulkan
+{
+class DeletionQueue;
+class Device;
+class FrameScheduler;
+
+// Per instance transforms and colors of instanced draws, rewritten every frame.
+// Instances go in a FrameArena, a persistently mapped ring that frames in flight hand back
+// as they retire, and shaders read them from a storage buffer with gl_InstanceIndex
+// (lib/instance.glsl). One draw call covers every instance of a mesh and pipeline.
+// Each frame slot has its own descriptor set, pointed at the frame's range by begin()
+class InstanceBuffer : public NonCopyable
+{
+public:
+	// 32 bytes, struct Instance in lib/instance.glsl
+	struct Instance
+	{
+		glm::vec3 position;
+		float scale;
+		// Quaternion xyzw, snorm16
+		uint64_t rotation;
+		// RGBA8 unorm
+		uint32_t color;
+		uint32_t padding;
+
+		inline static Instance Pack( const glm::vec3& position, float scale, const glm::quat& rotation, const glm::vec4& color )
+		{
+			return { position,
+					 scale,
+					 glm::packSnorm4x16( glm::vec4( rotation.x, rotation.y, rotation.z, rotation.w ) ),
+					 glm::packUnorm4x8( color ),
+					 0 };
+		}
+	};
+	static_assert( sizeof( Instance ) == 32 );
+
+	// Room for maxInstances per frame to start with, numSlots frames in flight at most
+	InstanceBuffer( const Device& device,
+					MemoryAllocator& allocator,
+					uint32_t maxInstances,
+					uint32_t numSlots,
+					DeletionQueue* deletion = nullptr );
+	~InstanceBuffer();
+
+	// Space for count instances of the frame being built, for any threads to fill
+	// (disjoint ranges) until the frame is submitted. Grows the ring when it's too small.
+	// setLayout is the storage buffer's set in the shaders, its binding 0 holds the instances
+	std::span<Instance> begin( const FrameScheduler& frames, uint32_t count, VkDescriptorSetLayout setLayout );
+	// Binds the instances of the frame begun last as set
+	void bind( VkCommandBuffer cmd, VkPipelineLayout layout, uint32_t set = 0 ) const;
+
+	inline VkDeviceSize capacity() const
+	{
+		return m_arena->capacity();
+	}
+
+private:
+	struct Slot
+	{
+		VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+		VkDescriptorSet set = VK_NULL_HANDLE;
+	};
+
+	const Device& m_device;
+	MemoryAllocator& m_allocator;
+	DeletionQueue* m_deletion;
+
+	Scope<FrameArena> m_arena;
+	VkDescriptorPool m_pool;
+	std::vector<Slot> m_slots;
+	uint32_t m_currentSlot;
+	VkDeviceSize m_alignment;
+
+	Scope<FrameArena> createArena( VkDeviceSize perFrame ) const;
+};
+}  // namespace vulkan
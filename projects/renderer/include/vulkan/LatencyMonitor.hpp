@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <deque>
+
+namespace vulkan
+{
+class FrameScheduler;
+
+enum class LatencyMode
+{
+	// Several frames queued, CPU and GPU overlap as much as possible
+	Throughput,
+	// One frame in flight, input sampled after waiting for the previous frame
+	LowLatency,
+	Count
+};
+
+// Latency from input sampling to the GPU finishing the frame, per LatencyMode.
+// A frame counts as done once its timeline value is seen retired, so the measurement
+// is an upper bound that gets tight whenever the CPU waits on the GPU. Presentation
+// itself isn't observed, the time the image waits for scan out is not included
+class LatencyMonitor
+{
+public:
+	LatencyMonitor() = default;
+
+	void submitted( uint64_t frame, uint64_t inputTime, LatencyMode mode );
+	void update( const FrameScheduler& frames );
+
+	// Smoothed latency, 0 until a frame of the mode retired
+	inline double latencyMs( LatencyMode mode ) const
+	{
+		return m_latencyMs[static_cast<size_t>( mode )];
+	}
+
+private:
+	struct Sample
+	{
+		uint64_t frame;
+		uint64_t inputTime;
+		LatencyMode mode;
+	};
+
+	std::deque<Sample> m_pending;
+	std::array<double, static_cast<size_t>( LatencyMode::Count )> m_latencyMs{};
+};
+
+}  // namespace vulkan
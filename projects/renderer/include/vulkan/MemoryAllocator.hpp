@@ -0,0 +1,123 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "common/non_copyable.hpp"
+#include "common/pointers.hpp"
+#include "common/tlsf.hpp"
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace vulkan
+{
+class Device;
+
+// Sub-allocated device memory.
+// Resources are placed in large VkDeviceMemory blocks, one list of blocks per memory type,
+// with a TLSF allocator per block. Drivers cap maxMemoryAllocationCount (4096 is common)
+// and every vkAllocateMemory is slow, so a block serves hundreds of resources.
+// Buffers and linear images never share a block with optimal images, so neighbours
+// are always of the same kind and bufferImageGranularity doesn't apply. Thread safe
+class MemoryAllocator : public NonCopyable
+{
+public:
+	// What is bound to the memory, for bufferImageGranularity
+	enum class Kind : uint8_t
+	{
+		Linear,
+		Optimal
+	};
+
+	struct Allocation
+	{
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize offset = 0;
+		VkDeviceSize size = 0;
+		// Persistently mapped host visible memory, at offset
+		void* mapped = nullptr;
+
+		inline explicit operator bool() const
+		{
+			return memory != VK_NULL_HANDLE;
+		}
+
+	private:
+		friend class MemoryAllocator;
+		uint32_t memoryType = 0;
+		// Index into the blocks of memoryType and kind, dedicated allocations have none
+		uint32_t block = 0;
+		uint32_t range = 0;
+		Kind kind = Kind::Linear;
+		bool dedicated = false;
+	};
+
+	struct HeapStats
+	{
+		VkDeviceSize heapSize = 0;
+		// vkAllocateMemory'd, and handed out of that
+		VkDeviceSize blockBytes = 0;
+		VkDeviceSize usedBytes = 0;
+		uint32_t blocks = 0;
+		uint32_t allocations = 0;
+		uint32_t dedicated = 0;
+		VkDeviceSize largestFree = 0;
+		// 0 when the free space is one range, towards 1 the more it's scattered
+		float fragmentation = 0.0f;
+	};
+
+	struct Stats
+	{
+		std::vector<HeapStats> heaps;
+		// Driver allocations out of maxMemoryAllocationCount
+		uint32_t deviceAllocations = 0;
+		uint32_t maxDeviceAllocations = 0;
+	};
+
+	static constexpr VkDeviceSize DefaultBlockSize = 64ull << 20;
+
+	explicit MemoryAllocator( const Device& device, VkDeviceSize blockSize = DefaultBlockSize );
+	// Every allocation must have been freed
+	~MemoryAllocator();
+
+	// Memory of a type in requirements with all of properties. Resources bigger than half
+	// a block get their own allocation. Host visible memory comes back mapped
+	Allocation allocate( const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, Kind kind );
+	// Frees now, the caller made sure the device is done with it
+	void free( Allocation& allocation );
+
+	Stats stats() const;
+
+private:
+	struct Block
+	{
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		void* mapped = nullptr;
+		Scope<Tlsf> ranges;
+	};
+
+	struct Pool
+	{
+		// Emptied blocks stay as null entries so indices of the others don't move
+		std::vector<Block> blocks;
+	};
+
+	const Device& m_device;
+	VkDeviceSize m_blockSize;
+	VkPhysicalDeviceMemoryProperties m_properties;
+	uint32_t m_maxAllocations;
+
+	mutable std::mutex m_mutex;
+	// Per memory type and kind
+	std::vector<Pool> m_pools;
+	std::vector<uint32_t> m_dedicated;
+	uint32_t m_deviceAllocations;
+
+	inline Pool& pool( uint32_t memoryType, Kind kind )
+	{
+		return m_pools[memoryType * 2 + static_cast<uint32_t>( kind )];
+	}
+	// Null when its heap is out of memory, throws at maxMemoryAllocationCount. m_mutex must be held
+	VkDeviceMemory allocateMemory( uint32_t memoryType, VkDeviceSize size, void*& mapped );
+	void freeMemory( VkDeviceMemory memory, void* mapped );
+};
+}  // namespace vulkan
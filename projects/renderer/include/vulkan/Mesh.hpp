@@ -0,0 +1,151 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "common/non_copyable.hpp"
+#include "common/pointers.hpp"
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <vulkan/Buffer.hpp>
+
+namespace vulkan
+{
+class DeletionQueue;
+class Device;
+class UploadManager;
+struct PipelineDesc;
+
+// How vertex attributes are laid out in the vertex buffer.
+// Interleaved keeps a vertex in one 32 byte stride, Split gives every attribute a stream
+// (binding) of its own, so passes that only read positions (depth, shadows) fetch 12 bytes.
+// Either way position, normal and uv are at locations 0, 1 and 2 as floats.
+// Quantized packs a vertex with its tangent frame in 16 bytes, decoded by the shaders
+// with lib/vertex_decode.glsl:
+//  - location 0, RGBA16 unorm: position against the mesh bounds, w the tangent handedness
+//  - location 1, RGBA8 snorm: octahedral normal in xy and tangent in zw, about a degree off
+//  - location 2, RG16 float: uv
+enum class VertexLayout : uint8_t
+{
+	Interleaved,
+	Split,
+	Quantized
+};
+
+// Geometry on the CPU, one array per attribute, all of the same length
+struct MeshData
+{
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> normals;
+	std::vector<glm::vec2> uvs;
+	// xyz along increasing u, w the handedness of the bitangent. Empty unless the source
+	// has them or computeTangents() ran, only the quantized layout stores them
+	std::vector<glm::vec4> tangents;
+	// Triangle list
+	std::vector<uint32_t> indices;
+
+	glm::vec3 boundsMin = glm::vec3( 0.0f );
+	glm::vec3 boundsMax = glm::vec3( 0.0f );
+
+	inline size_t vertexCount() const
+	{
+		return positions.size();
+	}
+
+	void computeBounds();
+	// Area weighted smooth normals for vertices whose normal is zero
+	void computeNormals();
+	// Tangents along the uv mapping for vertices whose tangent is zero
+	void computeTangents();
+};
+
+// Device local vertex and index buffers of a mesh.
+// Created from any thread: the data goes through the upload manager, which copies it to
+// staging before the constructor returns, so the MeshData can go right after.
+// It can be drawn by frames submitted once ready() says so
+class Mesh : public NonCopyable
+{
+public:
+	Mesh( const Device& device,
+		  MemoryAllocator& allocator,
+		  UploadManager& uploads,
+		  const MeshData& data,
+		  VertexLayout layout = VertexLayout::Interleaved,
+		  DeletionQueue* deletion = nullptr );
+
+	// Push constants after the view projection matrix of quantized meshes
+	struct Dequantization
+	{
+		glm::vec4 boundsMin;
+		glm::vec4 boundsExtent;
+	};
+
+	// Vertex input state of a layout
+	static void DescribeVertexInput( VertexLayout layout, PipelineDesc& desc );
+	static VkDeviceSize VertexSize( VertexLayout layout );
+
+	// The uploads were flushed: frames submitted from now on wait for them on the GPU
+	bool ready( const UploadManager& uploads ) const;
+	inline uint64_t uploadValue() const
+	{
+		return m_uploadValue;
+	}
+
+	void bind( VkCommandBuffer cmd ) const;
+	void draw( VkCommandBuffer cmd, uint32_t instanceCount = 1, uint32_t firstInstance = 0 ) const;
+
+	inline VertexLayout layout() const
+	{
+		return m_layout;
+	}
+	inline uint32_t vertexCount() const
+	{
+		return m_vertexCount;
+	}
+	inline uint32_t indexCount() const
+	{
+		return m_indexCount;
+	}
+	inline VkIndexType indexType() const
+	{
+		return m_indexType;
+	}
+	inline const glm::vec3& boundsMin() const
+	{
+		return m_boundsMin;
+	}
+	inline const glm::vec3& boundsMax() const
+	{
+		return m_boundsMax;
+	}
+	inline const Dequantization& dequantization() const
+	{
+		return m_dequantization;
+	}
+	// Of the vertex and index buffers
+	inline VkDeviceSize memorySize() const
+	{
+		return m_vertices->size() + m_indices->size();
+	}
+
+private:
+	VertexLayout m_layout;
+	uint32_t m_vertexCount;
+	uint32_t m_indexCount;
+	// 16 bit when every index fits, halves the index fetch bandwidth
+	VkIndexType m_indexType;
+	glm::vec3 m_boundsMin;
+	glm::vec3 m_boundsMax;
+	Dequantization m_dequantization;
+
+	Scope<Buffer> m_vertices;
+	Scope<Buffer> m_indices;
+	// Offset of every stream in m_vertices, one for Interleaved
+	std::vector<VkDeviceSize> m_streamOffsets;
+	uint64_t m_uploadValue;
+
+	void uploadVertices( UploadManager& uploads, const MeshData& data );
+	void uploadIndices( UploadManager& uploads, const MeshData& data );
+};
+}  // namespace vulkan
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <filesystem>
+
+#include <vulkan/Mesh.hpp>
+
+namespace vulkan
+{
+class JobSystem;
+
+// Loads OBJ, glTF (.gltf with external buffers) and binary glTF (.glb) into one MeshData.
+// Files are memory mapped and parsed in place on the job system's threads: OBJ text is
+// split into chunks at line ends, glTF primitives are read one job each. Nothing but
+// the resulting arrays is allocated per vertex. Meant to run in a background job, it
+// blocks until done and throws std::runtime_error on files it can't read
+class MeshImporter
+{
+public:
+	static MeshData Load( const std::filesystem::path& path, JobSystem& jobs );
+
+	static MeshData LoadObj( const std::filesystem::path& path, JobSystem& jobs );
+	// glTF scenes are flattened, node transforms are applied to the vertices
+	static MeshData LoadGltf( const std::filesystem::path& path, JobSystem& jobs );
+};
+}  // namespace vulkan
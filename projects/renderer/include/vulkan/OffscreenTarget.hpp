@@ -0,0 +1,56 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "common/non_copyable.hpp"
+#include "common/pointers.hpp"
+#include <vector>
+
+#include <vulkan/Image.hpp>
+#include <vulkan/RenderTarget.hpp>
+
+namespace vulkan
+{
+class Device;
+
+// Device owned color images used instead of swap chain images when rendering headless
+class OffscreenTarget : public NonCopyable, public RenderTarget
+{
+public:
+	OffscreenTarget( const Device& device,
+					 MemoryAllocator& allocator,
+					 VkExtent2D extent,
+					 VkFormat format,
+					 uint32_t numImages );
+
+	inline const VkFormat& imageFormat() const override
+	{
+		return m_imageFormat;
+	}
+	inline const VkExtent2D& extent() const override
+	{
+		return m_extent;
+	}
+	inline size_t numImages() const override
+	{
+		return m_images.size();
+	}
+	inline VkImageView imageView( uint32_t index ) const override
+	{
+		return m_images[index]->view();
+	}
+	// Images are left ready to be copied out
+	inline VkImageLayout finalLayout() const override
+	{
+		return VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	}
+	inline VkImage image( uint32_t index ) const override
+	{
+		return m_images[index]->handle();
+	}
+
+private:
+	std::vector<Scope<Image>> m_images;
+
+	VkFormat m_imageFormat;
+	VkExtent2D m_extent;
+};
+}  // namespace vulkan
@@ -0,0 +1,62 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "common/job_system.hpp"
+#include "common/non_copyable.hpp"
+#include "common/pointers.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include <vulkan/CommandPool.hpp>
+
+namespace vulkan
+{
+class Device;
+
+// Records slices of a draw list into secondary command buffers as jobs.
+// Every job system thread owns one command pool per frame slot, so recording never shares
+// a pool between threads and a slot's pools are reset wholesale once its frame retired
+class ParallelRecorder : public NonCopyable
+{
+public:
+	// Records draws [first, first + count) into cmd
+	using RecordSliceFunc = std::function<void( VkCommandBuffer cmd, uint32_t first, uint32_t count )>;
+
+	// Slices smaller than this aren't worth a job
+	static constexpr uint32_t MinDrawsPerSlice = 256;
+
+	ParallelRecorder( const Device& device, JobSystem& jobs );
+	~ParallelRecorder();
+
+	// Returns one secondary command buffer per slice, in draw order
+	const std::vector<VkCommandBuffer>& record( uint32_t frameSlot,
+												const VkCommandBufferInheritanceInfo& inheritance,
+												uint32_t drawCount,
+												const RecordSliceFunc& func,
+												uint32_t maxSlices = UINT32_MAX );
+
+	inline uint32_t numThreads() const
+	{
+		return m_jobs.numThreads();
+	}
+
+private:
+	struct ThreadFrame
+	{
+		Scope<CommandPool> pool;
+		std::vector<VkCommandBuffer> buffers;
+		size_t used = 0;
+	};
+
+	const Device& m_device;
+	JobSystem& m_jobs;
+
+	// [frame slot][job system thread]
+	std::vector<std::vector<ThreadFrame>> m_frames;
+	std::vector<VkCommandBuffer> m_recorded;
+
+	void ensureFrameSlot( uint32_t frameSlot );
+	VkCommandBuffer nextBuffer( ThreadFrame& frame );
+};
+}  // namespace vulkan
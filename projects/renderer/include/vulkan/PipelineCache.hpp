@@ -0,0 +1,64 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "common/non_copyable.hpp"
+
+#include <filesystem>
+#include <vector>
+
+#include <vulkan/PipelineLayoutCache.hpp>
+#include <vulkan/ShaderModuleCache.hpp>
+
+namespace vulkan
+{
+class Device;
+
+// VkPipelineCache persisted between runs.
+// The blob on disk is only used when its header matches this device and driver,
+// anything else (other GPU, driver update, truncated file) starts from an empty cache.
+// Written back on destruction if pipelines were added, atomically so a crash never leaves half a file
+class PipelineCache : public NonCopyable
+{
+public:
+	// Next to the executable's working directory, shared by windowed and headless runs
+	static constexpr const char* DefaultPath = "pipeline_cache.bin";
+
+	PipelineCache( const Device& device, std::filesystem::path path = DefaultPath );
+	~PipelineCache();
+
+	void save();
+
+	inline const VkPipelineCache& handle() const
+	{
+		return m_cache;
+	}
+	// Started from a blob on disk
+	inline bool warm() const
+	{
+		return m_loadedSize > 0;
+	}
+	// Modules pipelines are created from live as long as the cache, it's handed to everyone creating pipelines
+	inline ShaderModuleCache& shaderModules() const
+	{
+		return m_shaderModules;
+	}
+	// Same for the layouts derived from the shaders
+	inline PipelineLayoutCache& pipelineLayouts() const
+	{
+		return m_pipelineLayouts;
+	}
+
+	// Header written by vkGetPipelineCacheData matches the device
+	static bool IsCompatible( const VkPhysicalDeviceProperties& properties, const std::vector<char>& data );
+
+private:
+	const Device& m_device;
+	std::filesystem::path m_path;
+
+	VkPipelineCache m_cache;
+	size_t m_loadedSize;
+	mutable ShaderModuleCache m_shaderModules;
+	mutable PipelineLayoutCache m_pipelineLayouts;
+
+	std::vector<char> load() const;
+};
+}  // namespace vulkan
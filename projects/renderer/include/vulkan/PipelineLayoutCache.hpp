@@ -0,0 +1,54 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "common/non_copyable.hpp"
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <span>
+#include <vector>
+
+#include <vulkan/Shader.hpp>
+
+namespace vulkan
+{
+class Device;
+
+// Descriptor set and pipeline layouts derived from shader reflection.
+// Identical interfaces share the same layout objects, so pipelines switched between
+// keep their bound descriptor sets compatible and layouts don't multiply. Thread safe
+class PipelineLayoutCache : public NonCopyable
+{
+public:
+	struct Layout
+	{
+		VkPipelineLayout layout;
+		// Index is the set number, sets a shader skips get an empty layout
+		std::vector<VkDescriptorSetLayout> sets;
+		// Size 0 without push constants
+		VkPushConstantRange pushConstants;
+	};
+
+	explicit PipelineLayoutCache( const Device& device );
+	// The device must be done with every pipeline using the layouts
+	~PipelineLayoutCache();
+
+	// Merged interface of the stages, stays valid until the cache is destroyed.
+	// Throws when stages declare the same binding differently
+	const Layout& get( const Shaders& shaders );
+	// Any set of stages, a compute shader alone
+	const Layout& get( std::span<const Ref<Shader>> stages );
+
+	size_t size() const;
+
+private:
+	const Device& m_device;
+	mutable std::mutex m_mutex;
+	// Keyed by the flattened bindings
+	std::map<std::vector<uint64_t>, VkDescriptorSetLayout> m_setLayouts;
+	// Keyed by set layout handles and the push constant range
+	std::map<std::vector<uint64_t>, Layout> m_layouts;
+
+	VkDescriptorSetLayout setLayout( const std::vector<VkDescriptorSetLayoutBinding>& bindings );
+};
+}  // namespace vulkan
@@ -0,0 +1,81 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "common/job_system.hpp"
+#include "common/non_copyable.hpp"
+#include "common/pointers.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <vulkan/GraphicsPipeline.hpp>
+
+namespace vulkan
+{
+class DeletionQueue;
+class Device;
+class PipelineCache;
+class PipelineLayoutCache;
+
+// Graphics pipelines shared by description.
+// Descriptions are hashed, identical ones get the same VkPipeline. A miss compiles in the
+// background on a worker thread and callers draw with their fallback until it's ready,
+// so new materials never stall a frame on pipeline creation
+class PipelineLibrary : public NonCopyable
+{
+public:
+	PipelineLibrary( const Device& device,
+					 JobSystem& jobs,
+					 const PipelineCache* cache = nullptr,
+					 DeletionQueue* deletion = nullptr );
+	// Waits for compiles in flight, the device must be idle
+	~PipelineLibrary();
+
+	// Pipeline for desc, or fallback until its compile finished (or if it failed).
+	// The first request of a description queues the compile. Without a layout in desc
+	// it's derived from the shaders' reflection
+	VkPipeline get( const PipelineDesc& desc, VkPipeline fallback = VK_NULL_HANDLE );
+	// Compiles on the calling thread when missing, for pipelines needed right away
+	VkPipeline require( const PipelineDesc& desc );
+
+	// Render targets changed, retires every pipeline.
+	// Compiles in flight are thrown away when they finish
+	void clear();
+
+	size_t size() const;
+	inline uint32_t compiling() const
+	{
+		return m_compiling.pending();
+	}
+
+private:
+	struct Entry
+	{
+		PipelineDesc desc;
+		std::atomic<VkPipeline> pipeline{ VK_NULL_HANDLE };
+		// Guarded by m_mutex, set once the library let go of the entry
+		bool retired = false;
+	};
+
+	const Device& m_device;
+	JobSystem& m_jobs;
+	const PipelineCache* m_cache;
+	DeletionQueue* m_deletion;
+	// Without a pipeline cache to share them through
+	Scope<PipelineLayoutCache> m_ownLayouts;
+
+	mutable std::mutex m_mutex;
+	// Hash collisions share a bucket, entries compare their whole description
+	std::unordered_map<uint64_t, std::vector<Ref<Entry>>> m_entries;
+	JobCounter m_compiling;
+
+	// Entry of desc, created when missing. m_mutex must be held
+	Ref<Entry>& find( const PipelineDesc& desc, bool& created );
+	void compile( Ref<Entry> entry );
+	// desc with its layout filled in
+	PipelineDesc resolve( const PipelineDesc& desc ) const;
+	void retire( Entry& entry );
+};
+}  // namespace vulkan
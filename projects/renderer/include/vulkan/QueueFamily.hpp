@@ -8,8 +8,14 @@ namespace vulkan {
     std::optional<uint32_t> graphicsFamily;
     // Support for drawing to surface
     std::optional<uint32_t> presentFamily;
+    // Dedicated family, only set when it exists apart from graphics.
+    // Transfer-only families are usually the copy engines, they run beside rendering
+    std::optional<uint32_t> transferFamily;
 
-    inline bool isComplete() { return graphicsFamily.has_value() && presentFamily.has_value(); }
+    // Headless devices have no surface and only need a graphics family
+    inline bool isComplete(bool needPresent = true) const {
+      return graphicsFamily.has_value() && (!needPresent || presentFamily.has_value());
+    }
   };
 
   class QueueFamily {
@@ -17,6 +23,7 @@ namespace vulkan {
     QueueFamily() = delete;
     ~QueueFamily() = delete;
 
+    // Pass VK_NULL_HANDLE as surface to skip the presentation family lookup
     static QueueFamilyIndices FindQueueFamilies(const VkPhysicalDevice& device,
                                                 const VkSurfaceKHR& surface);
   };
@@ -0,0 +1,57 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <vector>
+
+namespace vulkan
+{
+
+// Handing resources and work from one queue to another.
+// An exclusive resource written on one family is released there and acquired on the other
+// with the same barrier (families, layouts and range must match), and the acquiring
+// submission waits on a semaphore the releasing one signals. Families that are the same
+// give plain barriers, so callers don't need to tell the cases apart
+class QueueSync
+{
+public:
+	QueueSync() = delete;
+
+	// Release: srcAccess is the writes being handed over, dstAccess 0.
+	// Acquire: srcAccess 0, dstAccess the reads that follow
+	static VkBufferMemoryBarrier BufferTransfer( VkBuffer buffer,
+												 VkDeviceSize offset,
+												 VkDeviceSize size,
+												 uint32_t srcFamily,
+												 uint32_t dstFamily,
+												 VkAccessFlags srcAccess,
+												 VkAccessFlags dstAccess );
+	static VkImageMemoryBarrier ImageTransfer( VkImage image,
+											   const VkImageSubresourceRange& range,
+											   VkImageLayout oldLayout,
+											   VkImageLayout newLayout,
+											   uint32_t srcFamily,
+											   uint32_t dstFamily,
+											   VkAccessFlags srcAccess,
+											   VkAccessFlags dstAccess );
+};
+
+// One queue submission waiting on and signaling timeline semaphores.
+// Binary semaphores can be mixed in, their values are ignored
+class TimelineSubmit
+{
+public:
+	void wait( VkSemaphore semaphore, uint64_t value, VkPipelineStageFlags stages );
+	void signal( VkSemaphore semaphore, uint64_t value );
+
+	// Throws when the submission fails
+	void submit( VkQueue queue, const std::vector<VkCommandBuffer>& commands, VkFence fence = VK_NULL_HANDLE ) const;
+
+private:
+	std::vector<VkSemaphore> m_waits;
+	std::vector<uint64_t> m_waitValues;
+	std::vector<VkPipelineStageFlags> m_waitStages;
+	std::vector<VkSemaphore> m_signals;
+	std::vector<uint64_t> m_signalValues;
+};
+
+}  // namespace vulkan
@@ -0,0 +1,166 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "common/non_copyable.hpp"
+#include "common/pointers.hpp"
+
+#include <functional>
+#include <optional>
+#include <vector>
+
+#include <vulkan/GpuProfiler.hpp>
+#include <vulkan/RenderPass.hpp>
+
+namespace vulkan
+{
+class DeletionQueue;
+class Device;
+class RenderTarget;
+
+// Frame described as passes reading and writing render targets.
+// Load/store ops, layouts and synchronization are derived from the declared accesses,
+// instead of each pass guessing what ran before it. Two backends:
+//  - DynamicRendering: every pass is a vkCmdBeginRenderingKHR scope with image barriers
+//    between them, nothing depends on the target images so resizing costs nothing
+//  - RenderPasses: consecutive passes are merged into subpasses of one VkRenderPass,
+//    the fallback for devices without VK_KHR_dynamic_rendering
+class RenderGraph : public NonCopyable
+{
+public:
+	enum class Backend
+	{
+		RenderPasses,
+		DynamicRendering
+	};
+
+	// Records the pass contents, rendering is already begun for the pass.
+	// Viewport and scissor are set to the whole target for INLINE passes
+	using ExecuteFunc = std::function<void( VkCommandBuffer cmd, uint32_t imageIndex )>;
+
+	struct Pass
+	{
+		const char* name = "";
+		// Indices into Desc::resources drawn to as color attachments
+		std::vector<uint32_t> colorWrites;
+		// Indices into Desc::resources sampled by shaders, a pass can't sample what its render pass draws
+		std::vector<uint32_t> sampledReads;
+		// Clear the written attachments instead of keeping their previous contents
+		bool clear = false;
+		VkClearColorValue clearColor = { { 0.0f, 0.0f, 0.0f, 1.0f } };
+		// SECONDARY passes may only execute secondary command buffers, which set their own viewport
+		VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE;
+		std::optional<GpuZone> zone;
+		ExecuteFunc execute;
+	};
+
+	struct Desc
+	{
+		// Targets the graph renders to, all of the same extent
+		std::vector<const RenderTarget*> resources;
+		std::vector<Pass> passes;
+		// Recorded before the first pass, outside of rendering: compute work the passes
+		// consume (culling, indirect arguments). It brings its own barriers
+		ExecuteFunc prologue;
+		std::optional<GpuZone> prologueZone;
+	};
+
+	// What pipelines drawing in a pass are created against
+	struct PipelineTarget
+	{
+		VkRenderPass renderPass;
+		uint32_t subpass;
+		// Chained into the pipeline create info for dynamic rendering, null otherwise
+		const VkPipelineRenderingCreateInfoKHR* rendering;
+	};
+
+	// Uses dynamic rendering when the device supports it
+	RenderGraph( const Device& device,
+				 Desc desc,
+				 const GpuProfiler* profiler = nullptr,
+				 DeletionQueue* deletion = nullptr );
+
+	// Records every pass for one target image, the profiler slot is the image index
+	void record( VkCommandBuffer cmd, uint32_t imageIndex ) const;
+
+	// Targets were recreated. Returns true when their formats changed,
+	// pipelines drawing in the graph have to be recreated then
+	bool resize();
+
+	PipelineTarget pipelineTarget( uint32_t pass ) const;
+	// Formats of the pass's color attachments, in attachment order
+	std::vector<VkFormat> colorFormats( uint32_t pass ) const;
+	// For secondary command buffers recorded ahead of record()
+	VkCommandBufferInheritanceInfo inheritance( uint32_t pass, uint32_t imageIndex ) const;
+	VkExtent2D extent( uint32_t pass ) const;
+
+	inline Backend backend() const
+	{
+		return m_backend;
+	}
+
+	// Dynamic viewport and scissor covering the extent
+	static void SetViewport( VkCommandBuffer cmd, VkExtent2D extent );
+
+private:
+	// Consecutive passes merged into one render pass
+	struct Group
+	{
+		std::vector<uint32_t> passes;
+		// Resources used as attachments, in attachment order
+		std::vector<uint32_t> attachments;
+		std::vector<VkClearValue> clearValues;
+	};
+
+	struct PassLocation
+	{
+		uint32_t group;
+		uint32_t subpass;
+	};
+
+	// Layout change and execution/memory dependency of one resource
+	struct Transition
+	{
+		uint32_t resource;
+		VkImageLayout oldLayout;
+		VkImageLayout newLayout;
+		VkPipelineStageFlags srcStage;
+		VkPipelineStageFlags dstStage;
+		VkAccessFlags srcAccess;
+		VkAccessFlags dstAccess;
+	};
+
+	// Dynamic rendering state of a pass
+	struct RenderingPass
+	{
+		std::vector<Transition> transitions;
+		std::vector<VkAttachmentLoadOp> loadOps;
+		std::vector<VkFormat> formats;
+		VkPipelineRenderingCreateInfoKHR pipelineRendering;
+		VkCommandBufferInheritanceRenderingInfoKHR inheritanceRendering;
+	};
+
+	const Device& m_device;
+	const GpuProfiler* m_profiler;
+	DeletionQueue* m_deletion;
+	Desc m_desc;
+	Backend m_backend;
+	std::vector<VkFormat> m_formats;
+
+	std::vector<Group> m_groups;
+	std::vector<PassLocation> m_locations;
+	std::vector<Scope<RenderPass>> m_renderPasses;
+
+	std::vector<RenderingPass> m_renderingPasses;
+	// Into the targets' final layouts after the last pass
+	std::vector<Transition> m_finalTransitions;
+
+	void compile();
+	RenderPassDesc describeGroup( uint32_t group ) const;
+	void compileRendering();
+	void updateRenderingFormats();
+
+	void recordRenderPasses( VkCommandBuffer cmd, uint32_t imageIndex ) const;
+	void recordRendering( VkCommandBuffer cmd, uint32_t imageIndex ) const;
+	void executePass( const Pass& pass, VkCommandBuffer cmd, uint32_t imageIndex, VkExtent2D extent ) const;
+	void transition( VkCommandBuffer cmd, uint32_t imageIndex, const std::vector<Transition>& transitions ) const;
+};
+}  // namespace vulkan
@@ -5,13 +5,31 @@
 
 namespace vulkan
 {
+class DeletionQueue;
 class Device;
-class SwapChain;
+class RenderTarget;
+
+struct SubpassDesc
+{
+	std::vector<VkAttachmentReference> colors;
+	// Attachments untouched by this subpass whose contents a later subpass needs
+	std::vector<uint32_t> preserves;
+};
+
+struct RenderPassDesc
+{
+	std::vector<VkAttachmentDescription> attachments;
+	// Target backing each attachment, formats are refreshed from it on recreate
+	std::vector<const RenderTarget*> targets;
+	std::vector<SubpassDesc> subpasses;
+	std::vector<VkSubpassDependency> dependencies;
+};
 
 class RenderPass : public NonCopyable
 {
 public:
-	RenderPass( const Device& device, const SwapChain& swap_chain );
+	// Replaced objects go through deletion, or are destroyed right away without it
+	RenderPass( const Device& device, RenderPassDesc desc, DeletionQueue* deletion = nullptr );
 	~RenderPass();
 
 	inline const VkRenderPass& handle() const
@@ -26,20 +44,27 @@ public:
 	{
 		return m_frameBuffers.size();
 	}
+	inline const RenderPassDesc& desc() const
+	{
+		return m_desc;
+	}
+	const VkExtent2D& extent() const;
 
+	// Target formats changed
 	void recreate();
-	void cleanupOld();
+	// Target images changed but not their formats
+	void recreateFrameBuffers();
 
 protected:
 	VkRenderPass m_render_pass;
-	VkRenderPass m_oldRenderPass;
 	std::vector<VkFramebuffer> m_frameBuffers;
 	const Device& m_device;
-	const SwapChain& m_swap_chain;
+	DeletionQueue* m_deletion;
+	RenderPassDesc m_desc;
 
 	void createRenderPass();
 	void createFrameBuffers();
 
-	void destroyFrameBuffers();
+	void retireFrameBuffers();
 };
 }  // namespace vulkan
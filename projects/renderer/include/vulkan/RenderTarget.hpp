@@ -0,0 +1,24 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+namespace vulkan
+{
+
+// Set of color images a render pass can draw into
+// Implemented by the swap chain and by device owned offscreen images
+class RenderTarget
+{
+public:
+	virtual ~RenderTarget() = default;
+
+	virtual const VkFormat& imageFormat() const = 0;
+	virtual const VkExtent2D& extent() const = 0;
+	virtual size_t numImages() const = 0;
+	virtual VkImage image( uint32_t index ) const = 0;
+	virtual VkImageView imageView( uint32_t index ) const = 0;
+
+	// Layout the images are left in after rendering
+	virtual VkImageLayout finalLayout() const = 0;
+};
+
+}  // namespace vulkan
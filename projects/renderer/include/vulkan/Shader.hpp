@@ -1,31 +1,86 @@
 #pragma once
 
+#include <cstdint>
 #include <vector>
 #include <filesystem>
+#include <span>
+#include <string>
+#include <utility>
 
+#include <vulkan/ShaderReflection.hpp>
+
+#include "common/mapped_file.hpp"
+#include "common/non_copyable.hpp"
 #include "common/pointers.hpp"
 
 namespace vulkan
 {
 
-class Shader
+// Preprocessor definitions a GLSL source is compiled with, name and value
+using ShaderDefines = std::vector<std::pair<std::string, std::string>>;
+
+// SPIR-V code of one stage, owned, embedded in the binary or mapped straight from a file.
+// The code is checked to be whole, aligned words starting with the SPIR-V magic number
+class Shader : public NonCopyable
 {
 public:
 	enum class Type
 	{
 		Vert,
-		Frag
+		Frag,
+		Comp
 	};
 
-	Shader( std::vector<unsigned char> compiled_shader, Type type );
+	// Code in static storage (embedded shaders), referenced and never copied
+	Shader( std::span<const uint32_t> static_code, Type type );
+	Shader( const std::vector<unsigned char>& compiled_shader, Type type );
 	Shader( std::vector<unsigned char>&& compiled_shader, Type type );
+	// Memory maps the file, its pages stay shared with the OS file cache
 	Shader( const std::filesystem::path& path, Type type );
 
-	std::vector<unsigned char> GetShaderData();
+	std::span<const uint32_t> GetShaderData() const;
+	// Of the SPIR-V, equal code shares a hash (and a shader module)
+	uint64_t GetHash() const;
+	// Bindings, push constants and vertex inputs, read once when the code is set
+	inline const ShaderReflection& GetReflection() const
+	{
+		return mReflection;
+	}
+
+	inline Type GetType() const
+	{
+		return mType;
+	}
+
+	// GLSL the code was compiled from and every file it includes, for hot reload
+	void SetSource( std::filesystem::path source, ShaderDefines defines, std::vector<std::filesystem::path> dependencies );
+	// Empty when the shader has no known source
+	inline const std::filesystem::path& GetSource() const
+	{
+		return mSource;
+	}
+	inline const ShaderDefines& GetDefines() const
+	{
+		return mDefines;
+	}
+	inline const std::vector<std::filesystem::path>& GetDependencies() const
+	{
+		return mDependencies;
+	}
 
 private:
 	Type mType;
 	std::vector<unsigned char> mData;
+	Scope<MappedFile> mMapped;
+	std::span<const uint32_t> mCode;
+	uint64_t mHash = 0;
+	ShaderReflection mReflection;
+
+	std::filesystem::path mSource;
+	ShaderDefines mDefines;
+	std::vector<std::filesystem::path> mDependencies;
+
+	void setCode( const void* data, size_t size, const char* source );
 };
 
 struct Shaders
@@ -34,4 +89,17 @@ struct Shaders
 	Ref<Shader> Frag;
 };
 
-}
\ No newline at end of file
+// Built-in triangle shaders embedded at build time
+Shaders GetBaseShaders();
+// Vertex buffer shaders of Mesh, position, normal and uv inputs and a view projection push constant
+Shaders GetMeshShaders();
+// Same for VertexLayout::Quantized, the push constants add the dequantization bounds
+Shaders GetQuantizedMeshShaders();
+// Built-in triangle drawn once per instance of an InstanceBuffer, bound as set 0
+Shaders GetInstancedShaders();
+// Interleaved meshes of a GpuScene, transformed by the instance of gl_InstanceIndex
+Shaders GetMeshIndirectShaders();
+// GpuScene's frustum culling compute shader
+Ref<Shader> GetCullShader();
+
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include "common/job_system.hpp"
+#include "common/non_copyable.hpp"
+#include "common/pointers.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <vulkan/Shader.hpp>
+
+namespace vulkan
+{
+
+// GLSL to SPIR-V at runtime, for shader variants that shouldn't need a rebuild.
+// Results are cached on disk under a hash of the source (includes expanded), stage,
+// defines and compiler version: an unchanged shader compiles once and is memory mapped after.
+// Uses the shaderc library when built with it (BUBBLE_SHADERC), the glslangValidator executable otherwise
+class ShaderCompiler : public NonCopyable
+{
+public:
+	using Defines = ShaderDefines;
+
+	// Next to the executable's working directory, like the pipeline cache
+	static constexpr const char* DefaultCacheDir = "shader_cache";
+
+	explicit ShaderCompiler( JobSystem& jobs, std::filesystem::path cacheDir = DefaultCacheDir );
+	// Waits for compiles in flight
+	~ShaderCompiler();
+
+	// Compiles in the background on a worker thread. Requests of the same source, stage and
+	// defines share one compile, the future holds the compile error if it failed
+	std::shared_future<Ref<Shader>> request( const std::filesystem::path& source,
+											 Shader::Type type,
+											 const Defines& defines = {} );
+	// Compiles on the calling thread when not cached
+	Ref<Shader> compile( const std::filesystem::path& source, Shader::Type type, const Defines& defines = {} ) const;
+
+	// Sources changed, later requests compile again (or hit the disk cache if they didn't change)
+	void invalidate();
+
+	inline const std::string& version() const
+	{
+		return m_version;
+	}
+	inline uint32_t compiling() const
+	{
+		return m_compiling.pending();
+	}
+
+private:
+	JobSystem& m_jobs;
+	std::filesystem::path m_cacheDir;
+	std::string m_version;
+
+	std::mutex m_mutex;
+	std::unordered_map<uint64_t, std::shared_future<Ref<Shader>>> m_requests;
+	JobCounter m_compiling;
+
+	// Cache key, reads the source and every file it includes into dependencies
+	uint64_t key( const std::filesystem::path& source,
+				  Shader::Type type,
+				  const Defines& defines,
+				  std::vector<std::filesystem::path>& dependencies ) const;
+	std::filesystem::path cachePath( uint64_t key ) const;
+	void compileToFile( const std::filesystem::path& source,
+						Shader::Type type,
+						const Defines& defines,
+						const std::filesystem::path& output ) const;
+};
+}  // namespace vulkan
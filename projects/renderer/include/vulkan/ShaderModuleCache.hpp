@@ -0,0 +1,48 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "common/non_copyable.hpp"
+#include "common/pointers.hpp"
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace vulkan
+{
+class Device;
+class Shader;
+
+// VkShaderModules keyed by the hash of their SPIR-V.
+// Pipelines of the same code share one module, across pipelines and their recreations.
+// Thread safe, pipelines compile on worker threads
+class ShaderModuleCache : public NonCopyable
+{
+public:
+	explicit ShaderModuleCache( const Device& device );
+	// The device must be done creating pipelines
+	~ShaderModuleCache();
+
+	// Module of the shader's code, created on first use.
+	// Stays valid while the shader is held outside the cache
+	VkShaderModule get( const Ref<Shader>& shader );
+	// Destroys the modules of shaders only the cache still holds, such as the ones
+	// hot reloads replaced. Pipelines don't need their modules once created
+	void release();
+
+	size_t size() const;
+
+private:
+	struct Module
+	{
+		// Every shader the module was handed out for. Keeps the code alive to tell hash
+		// collisions apart, and the module while any of them is held elsewhere
+		std::vector<Ref<Shader>> shaders;
+		VkShaderModule module;
+	};
+
+	const Device& m_device;
+	mutable std::mutex m_mutex;
+	std::unordered_map<uint64_t, std::vector<Module>> m_modules;
+};
+}  // namespace vulkan
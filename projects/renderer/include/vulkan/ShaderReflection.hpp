@@ -0,0 +1,43 @@
+#pragma once
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace vulkan
+{
+
+// Interface of a SPIR-V module: resources it binds, push constants and vertex inputs.
+// Read straight from the module's decorations and types, enough to build its pipeline layout
+struct ShaderReflection
+{
+	struct Binding
+	{
+		uint32_t set;
+		uint32_t binding;
+		VkDescriptorType type;
+		uint32_t count;
+	};
+
+	struct Input
+	{
+		uint32_t location;
+		VkFormat format;
+		// Bytes, for tightly packed vertex buffers
+		uint32_t size;
+	};
+
+	VkShaderStageFlagBits stage = VK_SHADER_STAGE_ALL;
+	// Ordered by set then binding
+	std::vector<Binding> bindings;
+	// 0 without a push constant block
+	uint32_t pushConstantSize = 0;
+	// Vertex shader inputs ordered by location, built-ins left out
+	std::vector<Input> inputs;
+
+	// Throws on malformed code and resources Vulkan layouts can't describe without extensions
+	static ShaderReflection Reflect( std::span<const uint32_t> code );
+};
+
+}  // namespace vulkan
@@ -0,0 +1,44 @@
+#pragma once
+#include "common/file_watcher.hpp"
+#include "common/non_copyable.hpp"
+
+#include <set>
+#include <vector>
+
+namespace vulkan
+{
+class GraphicsPipeline;
+class JobSystem;
+class ShaderCompiler;
+
+// Shader hot reload for pipelines whose shaders were compiled from source.
+// Watches every file their shaders were built from. update() runs at a frame boundary:
+// it starts background rebuilds of the pipelines affected by edits and swaps in finished ones,
+// so the frame loop never waits on a compile
+class ShaderWatcher : public NonCopyable
+{
+public:
+	ShaderWatcher( ShaderCompiler& compiler, JobSystem& jobs );
+	// Waits for reloads in flight, they use the compiler
+	~ShaderWatcher();
+
+	// The pipeline must outlive the watcher
+	void add( GraphicsPipeline& pipeline );
+
+	// True when shader files changed or a pipeline was swapped,
+	// whatever derives from the pipelines' shaders is stale then
+	bool update();
+
+private:
+	ShaderCompiler& m_compiler;
+	JobSystem& m_jobs;
+	FileWatcher m_files;
+
+	std::vector<GraphicsPipeline*> m_pipelines;
+	// Edited while their previous reload still ran, or whose reload was dropped for targets
+	// recreated meanwhile. Started once no reload runs
+	std::set<GraphicsPipeline*> m_dirty;
+
+	void watch( const GraphicsPipeline& pipeline );
+};
+}  // namespace vulkan
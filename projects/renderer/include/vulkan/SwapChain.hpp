@@ -4,8 +4,11 @@
 #include "common/non_copyable.hpp"
 #include <vector>
 
+#include <vulkan/RenderTarget.hpp>
+
 namespace vulkan
 {
+class DeletionQueue;
 class Device;
 class Window;
 
@@ -16,28 +19,28 @@ struct SwapChainSupportDetails
 	std::vector<VkPresentModeKHR> presentModes;
 };
 
-class SwapChain : public NonCopyable
+class SwapChain : public NonCopyable, public RenderTarget
 {
 public:
-	explicit SwapChain( const Device& device, const Window& window );
+	// Replaced swap chains go through deletion, or are destroyed right away without it
+	explicit SwapChain( const Device& device, const Window& window, DeletionQueue* deletion = nullptr );
 	~SwapChain();
 
 	auto recreate() -> void;
-	auto cleanupOld() -> void;
 
 	inline const VkSwapchainKHR& handle() const
 	{
 		return m_swap_chain;
 	}
-	inline const VkFormat& imageFormat() const
+	inline const VkFormat& imageFormat() const override
 	{
 		return m_imageFormat;
 	}
-	inline const VkExtent2D& extent() const
+	inline const VkExtent2D& extent() const override
 	{
 		return m_extent;
 	}
-	inline size_t numImages() const
+	inline size_t numImages() const override
 	{
 		return m_images.size();
 	}
@@ -50,10 +53,18 @@ public:
 	{
 		return m_supportDetails;
 	}
-	inline VkImageView imageView( uint32_t index ) const
+	inline VkImage image( uint32_t index ) const override
+	{
+		return m_images[index];
+	}
+	inline VkImageView imageView( uint32_t index ) const override
 	{
 		return m_imageViews[index];
 	}
+	inline VkImageLayout finalLayout() const override
+	{
+		return VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	}
 
 	static SwapChainSupportDetails QuerySwapChainSupport( const VkPhysicalDevice& device,
 														  const VkSurfaceKHR& surface );
@@ -63,6 +74,7 @@ public:
 private:
 	const Device& m_device;
 	const Window& m_window;
+	DeletionQueue* m_deletion;
 
 	SwapChainSupportDetails m_supportDetails;
 	VkSwapchainKHR m_swap_chain;
@@ -0,0 +1,128 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "common/non_copyable.hpp"
+#include "common/pointers.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include <vulkan/Buffer.hpp>
+#include <vulkan/CommandPool.hpp>
+#include <vulkan/FrameArena.hpp>
+
+namespace vulkan
+{
+class Device;
+class Image;
+
+// Copies to device memory without stalling the CPU or the queue.
+// Any thread can request uploads: data is copied into a persistently mapped staging ring
+// right away, and everything requested between two flushes goes out as one submission
+// that signals the next value on the manager's timeline semaphore. Requests return that
+// value, so loaders poll done() and frames wait on the timeline on the GPU.
+// Copies run on the dedicated transfer queue when the device has one, beside rendering.
+// The graphics queue then acquires the resources in a small submission of its own,
+// which waits for the copies and signals the batch's value
+class UploadManager : public NonCopyable
+{
+public:
+	using Commands = std::function<void( VkCommandBuffer cmd )>;
+
+	static constexpr VkDeviceSize DefaultStagingSize = 32ull << 20;
+
+	UploadManager( const Device& device, MemoryAllocator& allocator, VkDeviceSize stagingSize = DefaultStagingSize );
+	// Waits for submitted batches
+	~UploadManager();
+
+	// size bytes of data into dst at offset, dst needs TRANSFER_DST usage. data can be reused on return
+	uint64_t upload( const Buffer& dst, VkDeviceSize offset, const void* data, VkDeviceSize size );
+	// Mip 0 of a color image from tightly packed texels, left in SHADER_READ_ONLY_OPTIMAL
+	uint64_t upload( const Image& dst, const void* data, VkDeviceSize size );
+	// Recorded into the batch's graphics queue command buffer by flush(), for uploads that
+	// bring their own staging (ImGui fonts). They mustn't call back into the manager
+	uint64_t record( Commands commands );
+
+	// Submits everything requested since the last flush as one batch. Called once per frame
+	// by the thread that submits frames, nothing else uses the queue meanwhile
+	void flush();
+
+	bool done( uint64_t value ) const;
+	void wait( uint64_t value ) const;
+
+	// A frame waiting for this value on timeline() sees every flushed upload
+	inline uint64_t submitted() const
+	{
+		return m_submitted.load( std::memory_order_acquire );
+	}
+	inline const VkSemaphore& timeline() const
+	{
+		return m_timeline;
+	}
+	// Staging ring bytes held by batches still pending or in flight
+	VkDeviceSize stagingUsed() const;
+	inline VkDeviceSize stagingSize() const
+	{
+		return m_staging.capacity();
+	}
+
+private:
+	struct Copy
+	{
+		VkBuffer staging;
+		VkDeviceSize stagingOffset;
+		VkDeviceSize size;
+		// One of them
+		VkBuffer buffer;
+		VkDeviceSize offset;
+		VkImage image;
+		VkExtent3D extent;
+	};
+
+	struct Batch
+	{
+		uint64_t value;
+		// Either can be null
+		VkCommandBuffer copy;
+		VkCommandBuffer graphics;
+		// Staging of requests bigger than the ring
+		std::vector<Scope<Buffer>> staging;
+	};
+
+	const Device& m_device;
+	MemoryAllocator& m_allocator;
+	// Copies leave the transfer family for the graphics one, they're the same without a dedicated queue
+	bool m_dedicated;
+	CommandPool m_transferPool;
+	CommandPool m_graphicsPool;
+	VkSemaphore m_timeline;
+	// Copies done, the graphics queue's hand-off waits on it. Only with a dedicated queue
+	VkSemaphore m_copyTimeline;
+
+	mutable std::mutex m_mutex;
+	FrameArena m_staging;
+	// Batch being filled, it gets value submitted() + 1
+	std::vector<Copy> m_copies;
+	std::vector<Commands> m_commands;
+	std::vector<Scope<Buffer>> m_ownStaging;
+
+	std::deque<Batch> m_inFlight;
+	std::vector<VkCommandBuffer> m_freeTransfer;
+	std::vector<VkCommandBuffer> m_freeGraphics;
+	std::atomic<uint64_t> m_submitted;
+	mutable std::atomic<uint64_t> m_completed;
+
+	// Copies data into staging memory, m_mutex must be held
+	Copy stage( const void* data, VkDeviceSize size );
+	// Copies and their release barriers
+	VkCommandBuffer recordCopies();
+	// Acquire barriers and recorded commands
+	VkCommandBuffer recordGraphics();
+	// Recycles batches the GPU finished, m_mutex must be held
+	void retire();
+	void raiseCompleted( uint64_t value ) const;
+};
+}  // namespace vulkan
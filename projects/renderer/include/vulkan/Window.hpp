@@ -49,6 +49,11 @@ public:
 		glfwGetFramebufferSize( m_window, &size[0], &size[1] );
 	}
 
+	inline void pollEvents()
+	{
+		glfwPollEvents();
+	}
+
 	inline void setDrawFrameFunc( const std::function<void( bool& )>& func )
 	{
 		m_drawFrameFunc = func;
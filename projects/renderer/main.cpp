@@ -1,12 +1,84 @@
 
 #include <vulkan/Application.hpp>
+#include <vulkan/FrustumCuller.hpp>
+#include <vulkan/HeadlessApplication.hpp>
 
-int main()
+#include "common/trace.hpp"
+
+#include <charconv>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+int main( int argc, char** argv )
 {
+	bool headless = false;
+	bool validation = false;
+	bool lowLatency = false;
+	bool benchCulling = false;
+	uint32_t frames = 1000;
+	const char* tracePath = nullptr;
+	const char* meshPath = nullptr;
+	vulkan::VertexLayout meshLayout = vulkan::VertexLayout::Interleaved;
+	for( int i = 1; i < argc; i++ )
+	{
+		std::string_view arg = argv[i];
+		if( arg == "--headless" )
+			headless = true;
+		else if( arg == "--validation" )
+			validation = true;
+		else if( arg == "--low-latency" )
+			lowLatency = true;
+		else if( arg == "--frames" && i + 1 < argc )
+		{
+			std::string_view count = argv[++i];
+			auto [end, error] = std::from_chars( count.data(), count.data() + count.size(), frames );
+			if( error != std::errc() || end != count.data() + count.size() || frames == 0 )
+			{
+				std::cerr << "--frames takes a frame count above 0, got '" << count << "'" << std::endl;
+				return EXIT_FAILURE;
+			}
+		}
+		else if( arg == "--trace" && i + 1 < argc )
+			tracePath = argv[++i];
+		else if( arg == "--mesh" && i + 1 < argc )
+			meshPath = argv[++i];
+		else if( arg == "--split-streams" )
+			meshLayout = vulkan::VertexLayout::Split;
+		else if( arg == "--quantized-vertices" )
+			meshLayout = vulkan::VertexLayout::Quantized;
+		else if( arg == "--bench-culling" )
+			benchCulling = true;
+	}
+
+	// CPU only, no window or device
+	if( benchCulling )
+	{
+		for( const auto& result : vulkan::FrustumCuller::Benchmark( 1 << 20, 100 ) )
+			std::cout << vulkan::FrustumCuller::KernelName( result.kernel ) << ": "
+					  << result.nsPerSphere << " ns/sphere, "
+					  << result.visible << " visible, "
+					  << ( result.matchesScalar ? "matches scalar" : "DIFFERS from scalar" ) << std::endl;
+		return EXIT_SUCCESS;
+	}
+
 	try
 	{
-		vulkan::Application app;
-		app.run();
+		if( headless )
+		{
+			vulkan::HeadlessApplication app( { 800, 600 }, validation );
+			app.run( frames );
+		}
+		else
+		{
+			vulkan::Application app( lowLatency ? vulkan::LatencyMode::LowLatency : vulkan::LatencyMode::Throughput,
+									 meshPath ? meshPath : "",
+									 meshLayout );
+			app.run();
+		}
+		if( tracePath )
+			vulkan::Tracer::Get().flush( tracePath );
 	}
 	catch( std::exception& e )
 	{
@@ -14,4 +86,4 @@ int main()
 		return EXIT_FAILURE;
 	}
 	return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
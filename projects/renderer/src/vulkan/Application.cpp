@@ -1,111 +1,721 @@
 #include <vulkan/Application.hpp>
+#include <vulkan/MeshImporter.hpp>
+
+#include "common/trace.hpp"
+
+#include <cmath>
+
+#include <glm/gtc/matrix_transform.hpp>
 
 using namespace vulkan;
 
 const uint32_t WIDTH = 800;
 const uint32_t HEIGHT = 600;
-const int MAX_FRAMES_IN_FLIGHT = 2;
+// Frames in flight for each LatencyMode
+const uint32_t THROUGHPUT_FRAMES_IN_FLIGHT = 3;
+const uint32_t LOW_LATENCY_FRAMES_IN_FLIGHT = 1;
+
+static uint32_t FramesInFlight( LatencyMode mode )
+{
+	return mode == LatencyMode::LowLatency ? LOW_LATENCY_FRAMES_IN_FLIGHT : THROUGHPUT_FRAMES_IN_FLIGHT;
+}
+
+static const char* LatencyModeName( LatencyMode mode )
+{
+	return mode == LatencyMode::LowLatency ? "low latency" : "throughput";
+}
+
+static const char* SceneMaterialNames[] = { "Opaque", "Alpha blended", "Double sided", "Grayscale (runtime compiled)" };
+static const char* VertexLayoutNames[] = { "interleaved", "split", "quantized" };
+
+// Instanced stress scene: steps of the ramp, from the first count until past the last
+const uint32_t RAMP_STEP_FRAMES = 120;
+const uint32_t RAMP_FIRST_INSTANCES = 1024;
+const uint32_t RAMP_LAST_INSTANCES = 4u << 20;
+
+// Orbits around the bounds, looking at their center
+static glm::mat4 OrbitCamera( const glm::vec3& boundsMin, const glm::vec3& boundsMax, VkExtent2D extent )
+{
+	glm::vec3 center = ( boundsMin + boundsMax ) * 0.5f;
+	float radius = std::max( glm::length( boundsMax - boundsMin ) * 0.5f, 1e-3f );
+	float angle = static_cast<float>( glfwGetTime() ) * 0.5f;
+	glm::vec3 eye = center + radius * 2.5f * glm::vec3( std::sin( angle ), 0.5f, std::cos( angle ) );
+
+	glm::mat4 projection = glm::perspective( glm::radians( 45.0f ),
+											 extent.width / static_cast<float>( std::max( extent.height, 1u ) ),
+											 radius * 0.1f,
+											 radius * 10.0f );
+	// Vulkan's clip space y points down
+	projection[1][1] *= -1.0f;
+	return projection * glm::lookAt( eye, center, glm::vec3( 0.0f, 1.0f, 0.0f ) );
+}
+
+// Side of the cube grid holding count instances
+static uint32_t InstanceGridSide( uint32_t count )
+{
+	uint32_t side = std::max( static_cast<uint32_t>( std::cbrt( static_cast<double>( count ) ) ), 1u );
+	while( side * side * side < count )
+		side++;
+	return side;
+}
+
+// GPU driven scene: objects this far apart on its grid
+const float GPU_SCENE_SPACING = 4.0f;
 
-#include "base_vert.h"
-#include "base_frag.h"
-Shaders GetShaders()
+// Turns around in the middle of the scene, most of it is behind or beside the camera
+static glm::mat4 FlyCamera( float sceneSize, VkExtent2D extent )
 {
-	auto vert = CreateRef<Shader>( BASE_VERT, Shader::Type::Vert );
-	auto frag = CreateRef<Shader>( BASE_FRAG, Shader::Type::Frag );
-	return Shaders{ vert, frag };
+	float angle = static_cast<float>( glfwGetTime() ) * 0.2f;
+	glm::vec3 direction( std::sin( angle ), 0.2f * std::sin( angle * 0.7f ), std::cos( angle ) );
+
+	glm::mat4 projection = glm::perspective( glm::radians( 60.0f ),
+											 extent.width / static_cast<float>( std::max( extent.height, 1u ) ),
+											 0.5f,
+											 std::max( sceneSize, 1.0f ) );
+	projection[1][1] *= -1.0f;
+	return projection * glm::lookAt( glm::vec3( 0.0f ), direction, glm::vec3( 0.0f, 1.0f, 0.0f ) );
 }
 
+// From the near plane through the cursor, both in window coordinates. The projections flip y,
+// so the cursor's y already points the way normalized device coordinates do
+static void CursorRay( const glm::mat4& viewProjection, glm::vec2 cursor, glm::vec2 windowSize, glm::vec3& origin, glm::vec3& direction )
+{
+	glm::vec2 ndc = cursor / glm::max( windowSize, glm::vec2( 1.0f ) ) * 2.0f - 1.0f;
+	glm::mat4 inverse = glm::inverse( viewProjection );
+	glm::vec4 nearPoint = inverse * glm::vec4( ndc, -1.0f, 1.0f );
+	glm::vec4 farPoint = inverse * glm::vec4( ndc, 1.0f, 1.0f );
+	origin = glm::vec3( nearPoint ) / nearPoint.w;
+	direction = glm::normalize( glm::vec3( farPoint ) / farPoint.w - origin );
+}
+
+// Flat shaded, counter clockwise seen from outside, of half extent 1
+static MeshData CubeMesh()
+{
+	MeshData data;
+	for( int axis = 0; axis < 3; axis++ )
+	{
+		for( float sign : { -1.0f, 1.0f } )
+		{
+			glm::vec3 normal( 0.0f ), u( 0.0f ), v( 0.0f );
+			normal[axis] = sign;
+			u[( axis + 1 ) % 3] = 1.0f;
+			v[( axis + 2 ) % 3] = 1.0f;
+
+			uint32_t first = static_cast<uint32_t>( data.positions.size() );
+			for( glm::vec2 corner : { glm::vec2( -1.0f, -1.0f ), glm::vec2( 1.0f, -1.0f ), glm::vec2( 1.0f, 1.0f ), glm::vec2( -1.0f, 1.0f ) } )
+			{
+				data.positions.push_back( normal + u * corner.x + v * corner.y );
+				data.normals.push_back( normal );
+				data.uvs.push_back( corner * 0.5f + 0.5f );
+			}
+			// u x v is the positive axis, the negative side winds the other way
+			if( sign > 0.0f )
+				data.indices.insert( data.indices.end(), { first, first + 1, first + 2, first, first + 2, first + 3 } );
+			else
+				data.indices.insert( data.indices.end(), { first, first + 2, first + 1, first, first + 3, first + 2 } );
+		}
+	}
+	data.computeBounds();
+	return data;
+}
+
+// Flat shaded, one face per octant
+static MeshData OctahedronMesh()
+{
+	MeshData data;
+	for( int octant = 0; octant < 8; octant++ )
+	{
+		glm::vec3 sign( octant & 1 ? -1.0f : 1.0f, octant & 2 ? -1.0f : 1.0f, octant & 4 ? -1.0f : 1.0f );
+		glm::vec3 corners[3] = { glm::vec3( sign.x, 0.0f, 0.0f ), glm::vec3( 0.0f, sign.y, 0.0f ), glm::vec3( 0.0f, 0.0f, sign.z ) };
+		// x, y, z is counter clockwise from outside in octants with an even number of negative axes
+		if( sign.x * sign.y * sign.z < 0.0f )
+			std::swap( corners[1], corners[2] );
+
+		uint32_t first = static_cast<uint32_t>( data.positions.size() );
+		for( const glm::vec3& corner : corners )
+		{
+			data.positions.push_back( corner );
+			data.normals.push_back( glm::normalize( sign ) );
+			data.uvs.push_back( glm::vec2( corner.x, corner.y ) * 0.5f + 0.5f );
+		}
+		data.indices.insert( data.indices.end(), { first, first + 1, first + 2 } );
+	}
+	data.computeBounds();
+	return data;
+}
 
-Application::Application()
+Application::Application( LatencyMode mode, std::filesystem::path meshFile, VertexLayout meshLayout )
 	: window( { WIDTH, HEIGHT }, "Vulkan" ),
 	instance( window, "Hello Triangle", "No Engine", true ),
 	debugMessenger( instance ),
 	device( instance, window, Instance::DeviceExtensions ),
-	swap_chain( device, window ),
-	command_pool( device, 0 ),
-	syncObjects( device, swap_chain.numImages(), MAX_FRAMES_IN_FLIGHT ),
-	
-	render_pass( device, swap_chain ),
-	graphicsPipeline( device, swap_chain, render_pass, GetShaders() ),
-	commandBuffers( device, render_pass, swap_chain, graphicsPipeline, command_pool ),
+	allocator( device ),
+	swap_chain( device, window, &deletion ),
+	// Scene buffers are re-recorded every frame
+	command_pool( device, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT ),
+	frames( device, static_cast<uint32_t>( swap_chain.numImages() ), FramesInFlight( mode ) ),
+	profiler( device, static_cast<uint32_t>( swap_chain.numImages() ), &deletion ),
+	pipelineCache( device ),
+	uploads( device, allocator ),
+	instances( device, allocator, 1u << 16, THROUGHPUT_FRAMES_IN_FLIGHT, &deletion ),
+
+	render_graph( device, describeFrame(), &profiler, &deletion ),
+	graphicsPipeline( device, render_graph, ScenePass, PipelineDesc{ GetBaseShaders() }, &pipelineCache, &deletion ),
+	// Triangles seen from both sides as they spin
+	instancedPipeline( device, render_graph, ScenePass,
+					   [] { PipelineDesc desc{ GetInstancedShaders() }; desc.cullMode = VK_CULL_MODE_NONE; return desc; }(),
+					   &pipelineCache, &deletion ),
+	commandBuffers( device, command_pool, static_cast<uint32_t>( swap_chain.numImages() ), &deletion ),
+
+	interface( instance, window, device, swap_chain, render_graph, UiPass, uploads, &pipelineCache ),
+	meshPath( std::move( meshFile ) ),
+	recorder( device, jobs ),
+	pipelines( device, jobs, &pipelineCache, &deletion ),
+	shaderCompiler( jobs ),
+	shaderWatcher( shaderCompiler, jobs ),
+
+	latencyMode( mode ),
+	requestedLatencyMode( mode )
+{
+	shaderWatcher.add( graphicsPipeline );
+	shaderWatcher.add( instancedPipeline );
+	if( !meshPath.empty() )
+		loadMesh( meshLayout );
+	buildFrameGraph();
+}
+
+// Parsed on the job system and uploaded from the loading job, frames keep drawing meanwhile
+void Application::loadMesh( VertexLayout layout )
+{
+	PipelineDesc desc{ layout == VertexLayout::Quantized ? GetQuantizedMeshShaders() : GetMeshShaders() };
+	Mesh::DescribeVertexInput( layout, desc );
+	// Right handed, counter clockwise geometry seen through a projection with y flipped
+	desc.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+	meshPipeline = CreateScope<GraphicsPipeline>( device, render_graph, ScenePass, desc, &pipelineCache, &deletion );
+	shaderWatcher.add( *meshPipeline );
+
+	jobs.runBackground( [this, layout]
+	{
+		TRACE_ZONE( "LoadMesh" );
+		uint64_t start = Tracer::Now();
+		try
+		{
+			MeshData data = MeshImporter::Load( meshPath, jobs );
+			if( layout == VertexLayout::Quantized && data.tangents.empty() )
+				data.computeTangents();
+			mesh = CreateScope<Mesh>( device, allocator, uploads, data, layout, &deletion );
+		}
+		catch( const std::exception& e )
+		{
+			meshError = e.what();
+		}
+		meshLoadMs = ( Tracer::Now() - start ) / 1e6;
+	}, &meshLoad );
+}
 
-	interface( instance, window, device, swap_chain, graphicsPipeline )
+// Objects on a grid around the origin, alternating between the meshes. Meshes and pipelines
+// are made the first time, rebuilding only replaces the objects
+void Application::buildGpuScene( uint32_t objectCount )
 {
+	TRACE_ZONE( "BuildGpuScene" );
+	if( !cullPipeline )
+	{
+		cullPipeline = CreateScope<ComputePipeline>( device, GetCullShader(), &pipelineCache );
+
+		PipelineDesc desc{ GetMeshIndirectShaders() };
+		Mesh::DescribeVertexInput( VertexLayout::Interleaved, desc );
+		desc.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+		indirectPipeline = CreateScope<GraphicsPipeline>( device, render_graph, ScenePass, desc, &pipelineCache, &deletion );
+		shaderWatcher.add( *indirectPipeline );
+
+		for( const MeshData& data : { CubeMesh(), OctahedronMesh() } )
+			gpuSceneMeshes.push_back( CreateScope<Mesh>( device, allocator, uploads, data, VertexLayout::Interleaved, &deletion ) );
+	}
+
+	std::vector<const Mesh*> meshes;
+	for( const Scope<Mesh>& sceneMesh : gpuSceneMeshes )
+		meshes.push_back( sceneMesh.get() );
+
+	uint32_t side = InstanceGridSide( objectCount );
+	std::vector<GpuScene::Object> objects( objectCount );
+	jobs.parallelFor( objectCount, 4096, [&objects, &meshes, side]( uint32_t first, uint32_t count )
+	{
+		for( uint32_t i = first; i < first + count; i++ )
+		{
+			glm::vec3 cell( i % side, ( i / side ) % side, i / ( side * side ) );
+			float phase = static_cast<float>( i ) * 0.618034f;
+			glm::vec3 axis = glm::normalize( glm::vec3( std::sin( phase ), std::cos( phase * 1.3f ), 0.5f ) );
+			objects[i].instance = InstanceBuffer::Instance::Pack( ( cell - glm::vec3( side * 0.5f ) ) * GPU_SCENE_SPACING,
+																  1.0f,
+																  glm::angleAxis( phase, axis ),
+																  glm::vec4( cell / static_cast<float>( side ), 1.0f ) );
+			objects[i].mesh = i % static_cast<uint32_t>( meshes.size() );
+		}
+	} );
+
+	// Boxes around the meshes' bounding spheres, whatever the rotation. The tree is built in
+	// the background by the next update(), queries test the objects one by one until then
+	std::vector<float> radii;
+	for( const Mesh* sceneMesh : meshes )
+		radii.push_back( glm::length( sceneMesh->boundsMax() - sceneMesh->boundsMin() ) * 0.5f );
+	sceneBvh.clear();
+	sceneBvh.reserve( objectCount );
+	for( const GpuScene::Object& object : objects )
+	{
+		glm::vec3 extent( radii[object.mesh] * object.instance.scale );
+		sceneBvh.add( { object.instance.position - extent, object.instance.position + extent } );
+	}
+	pickedObject.reset();
+
+	// The scene it replaces is still read by frames in flight, its buffers go through deletion
+	gpuScene = CreateScope<GpuScene>( device,
+									  allocator,
+									  uploads,
+									  std::move( meshes ),
+									  objects,
+									  cullPipeline->setLayout( 0 ),
+									  indirectPipeline->setLayout( 0 ),
+									  &deletion );
+}
+
+// Doubles the instance count every step, a step's timings are averaged over its second half
+void Application::updateInstanceRamp()
+{
+	if( !instanceRamp )
+		return;
+
+	rampFrame++;
+	if( rampFrame > RAMP_STEP_FRAMES / 2 )
+	{
+		rampSum.updateMs += instanceUpdateMs;
+		rampSum.frameMs += 1000.0 / ImGui::GetIO().Framerate;
+		rampSum.gpuMs += profiler.lastDurationMs( GpuZone::Scene );
+	}
+	if( rampFrame < RAMP_STEP_FRAMES )
+		return;
+
+	double frames = RAMP_STEP_FRAMES - RAMP_STEP_FRAMES / 2;
+	InstanceSample sample = { static_cast<uint32_t>( instanceCount ),
+							  rampSum.updateMs / frames,
+							  rampSum.frameMs / frames,
+							  rampSum.gpuMs / frames };
+	rampSamples.push_back( sample );
+	std::cout << "Instances " << sample.instances << ": update " << sample.updateMs << " ms, frame "
+			  << sample.frameMs << " ms, GPU scene " << sample.gpuMs << " ms" << std::endl;
+
+	rampFrame = 0;
+	rampSum = {};
+	if( static_cast<uint32_t>( instanceCount ) >= RAMP_LAST_INSTANCES )
+		instanceRamp = false;
+	else
+		instanceCount *= 2;
+}
+
+// Scene and UI draw to the swap chain image one after the other, with render passes
+// they become two subpasses of a single one
+RenderGraph::Desc Application::describeFrame()
+{
+	RenderGraph::Desc desc;
+	desc.resources = { &swap_chain };
+
+	RenderGraph::Pass scene;
+	scene.name = "Scene";
+	scene.colorWrites = { 0 };
+	scene.clear = true;
+	// Recorded ahead by the frame graph
+	scene.contents = VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS;
+	scene.zone = GpuZone::Scene;
+	scene.execute = [this]( VkCommandBuffer cmd, uint32_t )
+	{
+		vkCmdExecuteCommands( cmd, static_cast<uint32_t>( sceneCommands->size() ), sceneCommands->data() );
+	};
+
+	RenderGraph::Pass ui;
+	ui.name = "ImGui";
+	ui.colorWrites = { 0 };
+	ui.zone = GpuZone::Ui;
+	ui.execute = [this]( VkCommandBuffer cmd, uint32_t )
+	{
+		interface.record( cmd );
+	};
+
+	desc.passes = { scene, ui };
+
+	// Culling of the GPU driven scene, its draws in the scene pass read what it wrote
+	desc.prologue = [this]( VkCommandBuffer cmd, uint32_t )
+	{
+		if( frameParams.gpuScene )
+			frameParams.gpuScene->cull( cmd, *cullPipeline, frameParams.viewProjection );
+	};
+	desc.prologueZone = GpuZone::Cull;
+	return desc;
+}
+
+// Scene pipeline state picked in the UI, on top of the base pipeline's
+std::optional<PipelineDesc> Application::describeSceneMaterial()
+{
+	PipelineDesc desc = graphicsPipeline.desc();
+	if( sceneMaterial == 1 )
+		desc.alphaBlend = true;
+	else if( sceneMaterial == 2 )
+		desc.cullMode = VK_CULL_MODE_NONE;
+	else if( sceneMaterial == 3 )
+	{
+		if( !grayscaleRequest.valid() )
+			grayscaleRequest = shaderCompiler.request( std::filesystem::path( BUBBLE_SHADER_DIR ) / "base.frag",
+													   Shader::Type::Frag,
+													   { { "GRAYSCALE", "1" } } );
+		if( !grayscaleShader && shaderError.empty() &&
+			grayscaleRequest.wait_for( std::chrono::seconds( 0 ) ) == std::future_status::ready )
+		{
+			try
+			{
+				grayscaleShader = grayscaleRequest.get();
+			}
+			catch( const std::exception& e )
+			{
+				shaderError = e.what();
+			}
+		}
+		if( !grayscaleShader )
+			return std::nullopt;
+		desc.shaders.Frag = grayscaleShader;
+		// Its resources may differ from base.frag's
+		desc.layout = VK_NULL_HANDLE;
+	}
+	return desc;
+}
+
+// Per frame work that doesn't need the main thread, runs while it builds the UI
+void Application::buildFrameGraph()
+{
+	// Instances stay in their grid cell, only the spheres of a new count are set up again
+	JobGraph::NodeId cullInstances = frameGraph.add( "CullInstances", [this]
+	{
+		uint32_t count = static_cast<uint32_t>( frameParams.instances.size() );
+		if( count == 0 )
+			return;
+
+		uint64_t start = Tracer::Now();
+		if( instanceCuller.size() != count )
+		{
+			uint32_t side = InstanceGridSide( count );
+			instanceCuller.clear();
+			instanceCuller.reserve( count );
+			for( uint32_t i = 0; i < count; i++ )
+			{
+				glm::vec3 cell( i % side, ( i / side ) % side, i / ( side * side ) );
+				// instanced.vert's triangle reaches sqrt( 0.5 ) from its center, at scale 0.8
+				instanceCuller.add( cell - glm::vec3( side * 0.5f ), 0.8f * 0.7072f );
+			}
+		}
+		instanceCuller.cull( Frustum::FromViewProjection( frameParams.viewProjection ), instanceVisible );
+		frameResults.instanceVisibleCount = static_cast<uint32_t>( instanceVisible.size() );
+		frameResults.instanceCullMs = ( Tracer::Now() - start ) / 1e6;
+	} );
+
+	// Straight into the mapped instance buffer, no copy on either side. Only the visible
+	// instances are written, packed at the front in the culler's order
+	frameGraph.add( "UpdateInstances", [this]
+	{
+		std::span<InstanceBuffer::Instance> data = frameParams.instances;
+		if( data.empty() )
+			return;
+
+		uint64_t start = Tracer::Now();
+		uint32_t side = InstanceGridSide( static_cast<uint32_t>( data.size() ) );
+		float time = frameParams.time;
+		const std::vector<uint32_t>& visible = instanceVisible;
+		jobs.parallelFor( static_cast<uint32_t>( visible.size() ), 4096, [data, &visible, side, time]( uint32_t first, uint32_t count )
+		{
+			for( uint32_t slot = first; slot < first + count; slot++ )
+			{
+				uint32_t i = visible[slot];
+				glm::vec3 cell( i % side, ( i / side ) % side, i / ( side * side ) );
+				// Every instance spins at its own phase around its own axis
+				float phase = static_cast<float>( i ) * 0.618034f;
+				glm::vec3 axis = glm::normalize( glm::vec3( std::sin( phase ), std::cos( phase * 1.3f ), 0.5f ) );
+				glm::quat rotation = glm::angleAxis( time + phase, axis );
+				data[slot] = InstanceBuffer::Instance::Pack( cell - glm::vec3( side * 0.5f ),
+														  0.8f,
+														  rotation,
+														  glm::vec4( cell / static_cast<float>( side ), 1.0f ) );
+			}
+		} );
+		frameResults.instanceUpdateMs = ( Tracer::Now() - start ) / 1e6;
+	}, { cullInstances } );
+
+	// The GPU culls what's drawn, this is the CPU side of it to compare against
+	frameGraph.add( "CullBvh", [this]
+	{
+		if( !frameParams.gpuScene )
+			return;
+
+		uint64_t start = Tracer::Now();
+		bvhVisible.clear();
+		sceneBvh.cull( Frustum::FromViewProjection( frameParams.viewProjection ), bvhVisible );
+		frameResults.bvhVisibleCount = static_cast<uint32_t>( bvhVisible.size() );
+		frameResults.bvhCullMs = ( Tracer::Now() - start ) / 1e6;
+	} );
+
+	frameGraph.add( "RecordScene", [this]
+	{
+		FrameParams params = frameParams;
+		// Draws the instances the culler kept, UpdateInstances fills them meanwhile
+		uint32_t visibleInstances = static_cast<uint32_t>( instanceVisible.size() );
+		const InstanceBuffer* instanceBuffer = &instances;
+		VkPipeline instanced = instancedPipeline.pipeline();
+		VkPipelineLayout instancedLayout = instancedPipeline.layout();
+		sceneCommands = &recorder.record( frameParams.frameSlot,
+										  render_graph.inheritance( ScenePass, frameParams.imageIndex ),
+										  // A single instanced draw, or a few indirect ones
+										  params.instances.empty() && !params.gpuScene ? frameParams.drawCount : 1,
+										  [params, visibleInstances, instanceBuffer, instanced, instancedLayout]( VkCommandBuffer cmd, uint32_t, uint32_t count )
+										  {
+											  // Secondary buffers inherit no state
+											  RenderGraph::SetViewport( cmd, params.extent );
+											  if( params.gpuScene )
+											  {
+												  vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, params.indirectPipeline );
+												  vkCmdPushConstants( cmd, params.indirectLayout, VK_SHADER_STAGE_VERTEX_BIT, 0,
+																	  sizeof( glm::mat4 ), &params.viewProjection );
+												  params.gpuScene->draw( cmd, params.indirectLayout );
+												  return;
+											  }
+											  if( !params.instances.empty() )
+											  {
+												  vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, instanced );
+												  instanceBuffer->bind( cmd, instancedLayout );
+												  vkCmdPushConstants( cmd, instancedLayout, VK_SHADER_STAGE_VERTEX_BIT, 0,
+																	  sizeof( glm::mat4 ), &params.viewProjection );
+												  vkCmdDraw( cmd, 3, visibleInstances, 0, 0 );
+												  return;
+											  }
+											  if( params.mesh )
+											  {
+												  vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, params.meshPipeline );
+												  vkCmdPushConstants( cmd, params.meshLayout, VK_SHADER_STAGE_VERTEX_BIT, 0,
+																	  sizeof( glm::mat4 ), &params.viewProjection );
+												  if( params.mesh->layout() == VertexLayout::Quantized )
+													  vkCmdPushConstants( cmd, params.meshLayout, VK_SHADER_STAGE_VERTEX_BIT, sizeof( glm::mat4 ),
+																		  sizeof( Mesh::Dequantization ), &params.mesh->dequantization() );
+												  params.mesh->bind( cmd );
+												  for( uint32_t draw = 0; draw < count; draw++ )
+													  params.mesh->draw( cmd );
+												  return;
+											  }
+											  vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, params.scenePipeline );
+											  for( uint32_t draw = 0; draw < count; draw++ )
+												  vkCmdDraw( cmd, 3, 1, 0, 0 );
+										  },
+										  // Serial recording is a single slice on one job
+										  frameParams.parallelRecording ? UINT32_MAX : 1 );
+	}, { cullInstances } );
 }
 
 void Application::mainLoop()
 {
 	window.setDrawFrameFunc( [this]( bool& framebufferResized )
 	{
-		drawImGui();
+		// Window polled input right before calling us
+		inputSampleTime = Tracer::Now();
 		drawFrame( framebufferResized );
 	} );
 	window.mainLoop();
 	vkDeviceWaitIdle( device.logical() );
+
+	for( LatencyMode mode : { LatencyMode::Throughput, LatencyMode::LowLatency } )
+	{
+		if( latency.latencyMs( mode ) > 0.0 )
+			std::cout << "Input to GPU completion latency, " << LatencyModeName( mode ) << " mode ("
+					  << FramesInFlight( mode ) << " frames in flight): "
+					  << latency.latencyMs( mode ) << " ms" << std::endl;
+	}
+}
+
+// Switches queue depth at a frame boundary, the device and swap chain are kept
+void Application::applyLatencyMode()
+{
+	if( requestedLatencyMode == latencyMode )
+		return;
+
+	TRACE_ZONE( "ApplyLatencyMode" );
+	latencyMode = requestedLatencyMode;
+	frames.setMaxFramesInFlight( FramesInFlight( latencyMode ) );
 }
 
 void Application::drawFrame( bool& framebufferResized )
 {
-	vkWaitForFences( device.logical(), 1, &syncObjects.inFlightFence( currentFrame ), VK_TRUE, UINT64_MAX );
+	TRACE_ZONE( "Frame" );
+	applyLatencyMode();
+	{
+		TRACE_ZONE( "WaitFrameSlot" );
+		frames.beginFrame();
+	}
+	// Low latency: the previous frame is already retired, so sample input again right
+	// after the wait, before the cameras and the frame parameters are built from it
+	if( latencyMode == LatencyMode::LowLatency )
+	{
+		TRACE_ZONE( "LateInputSample" );
+		window.pollEvents();
+		inputSampleTime = Tracer::Now();
+	}
+	deletion.beginFrame( frames );
+	latency.update( frames );
+	// One submission for everything requested since the last frame, recorded before the frame uses it
+	uploads.flush();
+
+	// Frame boundary, nothing records with the pipelines: swap in hot reloaded ones
+	if( shaderWatcher.update() )
+	{
+		// Built from the old shaders
+		pipelines.clear();
+		grayscaleRequest = {};
+		grayscaleShader = nullptr;
+		shaderError.clear();
+	}
 
 	// Get image from swap chain
 	uint32_t imageIndex;
-	VkResult result = vkAcquireNextImageKHR( device.logical(), 
-											 swap_chain.handle(),
-											 UINT64_MAX,
-											 syncObjects.imageAvailable( currentFrame ),
-											 VK_NULL_HANDLE,
-											 &imageIndex );
+	VkResult result;
+	{
+		TRACE_ZONE( "AcquireNextImage" );
+		result = vkAcquireNextImageKHR( device.logical(),
+										swap_chain.handle(),
+										UINT64_MAX,
+										frames.imageAvailable(),
+										VK_NULL_HANDLE,
+										&imageIndex );
+	}
 	// Create new swap chain if needed
 	if( result == VK_ERROR_OUT_OF_DATE_KHR )
 	{
+		frames.skipFrame( device.graphicsQueue() );
 		recreateSwapChain( framebufferResized );
 		return;
 	}
 	else if( result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR )
 		throw std::runtime_error( "Failed to acquire swapchain image" );
 
-	if( syncObjects.imageInFlight( imageIndex ) != VK_NULL_HANDLE )
-		vkWaitForFences( device.logical(), 1, &syncObjects.imageInFlight( imageIndex ), VK_TRUE, UINT64_MAX );
+	{
+		TRACE_ZONE( "WaitImageInFlight" );
+		frames.useImage( imageIndex );
+	}
+
+	// Last submission of this image is done, its timestamps can be read
+	profiler.collect( imageIndex );
+
+	frameParams.imageIndex = imageIndex;
+	frameParams.frameSlot = frames.frameSlot();
+	frameParams.extent = swap_chain.extent();
+	frameParams.drawCount = static_cast<uint32_t>( drawCount );
+	frameParams.parallelRecording = parallelRecording;
+	// Material variants compile in the background, the base pipeline stands in meanwhile
+	std::optional<PipelineDesc> material = describeSceneMaterial();
+	frameParams.scenePipeline = material ? pipelines.get( *material, graphicsPipeline.pipeline() ) : graphicsPipeline.pipeline();
+	// Flushed uploads are waited for by this frame's submission
+	frameParams.mesh = meshLoad.done() && mesh && mesh->ready( uploads ) ? mesh.get() : nullptr;
+	frameParams.instances = {};
+	frameParams.gpuScene = nullptr;
+	frameParams.time = static_cast<float>( glfwGetTime() );
+	if( gpuDrivenScene && device.drawIndirectCount() && ( !gpuScene || gpuSceneDirty ) )
+	{
+		buildGpuScene( static_cast<uint32_t>( gpuSceneObjects ) );
+		gpuSceneDirty = false;
+	}
+	if( gpuDrivenScene && gpuScene && gpuScene->ready( uploads ) )
+	{
+		frameParams.gpuScene = gpuScene.get();
+		frameParams.indirectPipeline = indirectPipeline->pipeline();
+		frameParams.indirectLayout = indirectPipeline->layout();
+		float size = InstanceGridSide( gpuScene->objectCount() ) * GPU_SCENE_SPACING;
+		frameParams.viewProjection = FlyCamera( size, frameParams.extent );
+		// Before the frame graph reads it
+		sceneBvh.update( jobs );
+	}
+	else if( instancedScene )
+	{
+		updateInstanceRamp();
+		uint32_t count = static_cast<uint32_t>( instanceCount );
+		frameParams.instances = instances.begin( frames, count, instancedPipeline.setLayout( 0 ) );
+		float side = static_cast<float>( InstanceGridSide( count ) );
+		frameParams.viewProjection = OrbitCamera( glm::vec3( -side * 0.5f ), glm::vec3( side * 0.5f ), frameParams.extent );
+	}
+	else if( frameParams.mesh )
+	{
+		frameParams.meshPipeline = meshPipeline->pipeline();
+		frameParams.meshLayout = meshPipeline->layout();
+		frameParams.viewProjection = OrbitCamera( mesh->boundsMin(), mesh->boundsMax(), frameParams.extent );
+	}
 
-	syncObjects.imageInFlight( imageIndex ) = syncObjects.inFlightFence( currentFrame );
+	JobCounter frameJobs;
+	frameGraph.dispatch( jobs, frameJobs );
 
-	// Record UI draw data
-	interface.recordCommandBuffers( imageIndex );
+	// GLFW and ImGui stay on the main thread, overlapping the frame graph
+	drawImGui();
+
+	{
+		TRACE_ZONE( "WaitFrameJobs" );
+		jobs.wait( frameJobs );
+	}
+	instanceUpdateMs = frameResults.instanceUpdateMs;
+	instanceVisibleCount = frameResults.instanceVisibleCount;
+	instanceCullMs = frameResults.instanceCullMs;
+	bvhVisibleCount = frameResults.bvhVisibleCount;
+	bvhCullMs = frameResults.bvhCullMs;
+
+	// Scene secondaries and UI draw data are ready, one primary buffer for the whole graph
+	{
+		TRACE_ZONE( "RecordFrame" );
+		commandBuffers.begin( imageIndex, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT );
+		render_graph.record( commandBuffers.command( imageIndex ), imageIndex );
+		commandBuffers.end( imageIndex );
+	}
 
 	VkSubmitInfo submitInfo{};
 	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-	VkSemaphore waitSemaphores[] = { syncObjects.imageAvailable( currentFrame ) };
-	VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-	submitInfo.waitSemaphoreCount = 1;
+	// Uploads flushed so far land before anything in the frame reads them
+	VkSemaphore waitSemaphores[] = { frames.imageAvailable(), uploads.timeline() };
+	VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT };
+	uint64_t waitValues[] = { 0, uploads.submitted() };
+	submitInfo.waitSemaphoreCount = 2;
 	submitInfo.pWaitSemaphores = waitSemaphores;
 	submitInfo.pWaitDstStageMask = waitStages;
 
-	VkCommandBuffer cmdBuffers[] = { commandBuffers.command( imageIndex ), interface.command( imageIndex ) };
-	submitInfo.commandBufferCount = 2;
-	submitInfo.pCommandBuffers = cmdBuffers;
-
-	VkSemaphore signalSemaphores[] = { syncObjects.renderFinished( currentFrame ) };
-	submitInfo.signalSemaphoreCount = 1;
-	submitInfo.pSignalSemaphores = signalSemaphores;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffers.command( imageIndex );
 
-	vkResetFences( device.logical(), 1, &syncObjects.inFlightFence( currentFrame ) );
+	// Present waits on the binary semaphore, the timeline value retires the frame
+	std::vector<VkSemaphore> signalSemaphores = { frames.renderFinished() };
+	std::vector<uint64_t> signalValues;
+	VkTimelineSemaphoreSubmitInfo timelineInfo{};
+	frames.fillSubmit( submitInfo, timelineInfo, signalSemaphores, signalValues );
+	timelineInfo.waitSemaphoreValueCount = 2;
+	timelineInfo.pWaitSemaphoreValues = waitValues;
 
-	if( vkQueueSubmit( device.graphicsQueue(), 1, &submitInfo, syncObjects.inFlightFence( currentFrame ) ) != VK_SUCCESS )
-		throw std::runtime_error( "failed to submit draw command buffer!" );
+	{
+		TRACE_ZONE( "QueueSubmit" );
+		profiler.submitted( imageIndex, Tracer::Now() );
+		if( vkQueueSubmit( device.graphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE ) != VK_SUCCESS )
+			throw std::runtime_error( "failed to submit draw command buffer!" );
+	}
+	latency.submitted( frames.currentFrame(), inputSampleTime, latencyMode );
 
 	VkPresentInfoKHR presentInfo{};
 	presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 	presentInfo.waitSemaphoreCount = 1;
-	presentInfo.pWaitSemaphores = signalSemaphores;
+	presentInfo.pWaitSemaphores = &frames.renderFinished();
 
 	VkSwapchainKHR swap_chains[] = { swap_chain.handle() };
 	presentInfo.swapchainCount = 1;
 	presentInfo.pSwapchains = swap_chains;
 	presentInfo.pImageIndices = &imageIndex;
 
-	result = vkQueuePresentKHR( device.presentQueue(), &presentInfo );
+	{
+		TRACE_ZONE( "QueuePresent" );
+		result = vkQueuePresentKHR( device.presentQueue(), &presentInfo );
+	}
 	if( result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || framebufferResized )
 	{
 		recreateSwapChain( framebufferResized );
@@ -113,12 +723,12 @@ void Application::drawFrame( bool& framebufferResized )
 	}
 	else if( result != VK_SUCCESS )
 		throw std::runtime_error( "Failed to present swap chain image" );
-
-	currentFrame = ( currentFrame + 1 ) % MAX_FRAMES_IN_FLIGHT;
 }
 
 void Application::drawImGui()
 {
+	TRACE_ZONE( "BuildImGui" );
+
 	// Start the Dear ImGui frame
 	ImGui_ImplVulkan_NewFrame();
 	ImGui_ImplGlfw_NewFrame();
@@ -138,6 +748,146 @@ void Application::drawImGui()
 	ImGui::Text( "counter = %d", counter );
 
 	ImGui::Text( "Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate );
+
+	int mode = static_cast<int>( requestedLatencyMode );
+	ImGui::RadioButton( "Throughput", &mode, static_cast<int>( LatencyMode::Throughput ) );
+	ImGui::SameLine();
+	ImGui::RadioButton( "Low latency", &mode, static_cast<int>( LatencyMode::LowLatency ) );
+	requestedLatencyMode = static_cast<LatencyMode>( mode );
+	ImGui::Text( "Input to GPU completion: throughput %.2f ms, low latency %.2f ms",
+				 latency.latencyMs( LatencyMode::Throughput ),
+				 latency.latencyMs( LatencyMode::LowLatency ) );
+
+	ImGui::Checkbox( "Parallel recording", &parallelRecording );
+	ImGui::SameLine();
+	ImGui::Text( "(%u threads)", recorder.numThreads() );
+	ImGui::SliderInt( "Draws", &drawCount, 1, 100000, "%d", ImGuiSliderFlags_Logarithmic );
+
+	ImGui::Checkbox( "Instanced stress scene", &instancedScene );
+	if( instancedScene )
+	{
+		ImGui::SliderInt( "Instances", &instanceCount, 1, static_cast<int>( RAMP_LAST_INSTANCES ), "%d", ImGuiSliderFlags_Logarithmic );
+		ImGui::Text( "Instance update %.3f ms, %.1f MB instance ring",
+					 instanceUpdateMs,
+					 instances.capacity() / ( 1024.0 * 1024.0 ) );
+		ImGui::Text( "%u of %d instances visible, %s cull %.3f ms",
+					 instanceVisibleCount,
+					 instanceCount,
+					 FrustumCuller::KernelName( FrustumCuller::DefaultKernel() ),
+					 instanceCullMs );
+		if( ImGui::Button( instanceRamp ? "Stop ramp" : "Ramp instances" ) )
+		{
+			instanceRamp = !instanceRamp;
+			instanceCount = static_cast<int>( RAMP_FIRST_INSTANCES );
+			rampFrame = 0;
+			rampSum = {};
+			rampSamples.clear();
+		}
+		for( const InstanceSample& sample : rampSamples )
+			ImGui::Text( "  %8u instances: update %.3f ms, frame %.3f ms, GPU scene %.3f ms",
+						 sample.instances,
+						 sample.updateMs,
+						 sample.frameMs,
+						 sample.gpuMs );
+	}
+
+	if( device.drawIndirectCount() )
+	{
+		ImGui::Checkbox( "GPU driven scene", &gpuDrivenScene );
+		if( gpuDrivenScene )
+		{
+			ImGui::SliderInt( "Objects", &gpuSceneObjects, 1, 1 << 21, "%d", ImGuiSliderFlags_Logarithmic );
+			// Rebuilt once the slider is let go
+			gpuSceneDirty |= ImGui::IsItemDeactivatedAfterEdit();
+			if( gpuScene )
+				ImGui::Text( "%u objects, %zu meshes: GPU cull %.3f ms, scene %.3f ms",
+							 gpuScene->objectCount(),
+							 gpuScene->meshCount(),
+							 profiler.lastDurationMs( GpuZone::Cull ),
+							 profiler.lastDurationMs( GpuZone::Scene ) );
+			ImGui::Text( "BVH: %zu nodes, %u pending, %.2fx build cost%s, CPU cull %u visible in %.3f ms",
+						 sceneBvh.nodes().size(),
+						 sceneBvh.pendingCount(),
+						 sceneBvh.degradation(),
+						 sceneBvh.rebuilding() ? ", rebuilding" : "",
+						 bvhVisibleCount,
+						 bvhCullMs );
+
+			// Clicks on the scene, not on a window
+			const ImGuiIO& io = ImGui::GetIO();
+			if( frameParams.gpuScene && ImGui::IsMouseClicked( 0 ) && !io.WantCaptureMouse )
+			{
+				glm::vec3 origin, direction;
+				CursorRay( frameParams.viewProjection,
+						   glm::vec2( io.MousePos.x, io.MousePos.y ),
+						   glm::vec2( io.DisplaySize.x, io.DisplaySize.y ),
+						   origin,
+						   direction );
+				pickedObject = sceneBvh.raycast( origin, direction );
+			}
+			if( pickedObject )
+				ImGui::Text( "Picked object %u, %.1f away", pickedObject->object, pickedObject->distance );
+			else
+				ImGui::TextDisabled( "Click an object to pick it" );
+		}
+	}
+	else
+		ImGui::TextDisabled( "GPU driven scene needs drawIndirectCount" );
+
+	ImGui::Combo( "Scene material", &sceneMaterial, SceneMaterialNames, IM_ARRAYSIZE( SceneMaterialNames ) );
+	if( !meshPath.empty() )
+	{
+		if( !meshLoad.done() )
+			ImGui::Text( "Loading %s", meshPath.filename().string().c_str() );
+		else if( !meshError.empty() )
+			ImGui::TextWrapped( "Mesh load failed: %s", meshError.c_str() );
+		else
+			ImGui::Text( "Mesh: %u vertices, %u triangles, %.1f MB %s, loaded in %.0f ms",
+						 mesh->vertexCount(),
+						 mesh->indexCount() / 3,
+						 mesh->memorySize() / ( 1024.0 * 1024.0 ),
+						 VertexLayoutNames[static_cast<uint32_t>( mesh->layout() )],
+						 meshLoadMs );
+	}
+	if( !graphicsPipeline.reloadError().empty() )
+		ImGui::TextWrapped( "Shader reload failed: %s", graphicsPipeline.reloadError().c_str() );
+	if( !shaderError.empty() )
+		ImGui::TextWrapped( "Shader compile failed: %s", shaderError.c_str() );
+	else if( shaderCompiler.compiling() > 0 )
+		ImGui::Text( "Compiling %u shaders", shaderCompiler.compiling() );
+	ImGui::Text( "Pipeline cache: %s start, %zu pipelines, %u compiling, %zu shader modules, %zu layouts",
+				 pipelineCache.warm() ? "warm" : "cold",
+				 pipelines.size(),
+				 pipelines.compiling(),
+				 pipelineCache.shaderModules().size(),
+				 pipelineCache.pipelineLayouts().size() );
+
+	ImGui::Text( "Uploads: %s queue, %.1f of %.1f MB staging",
+				 device.transferFamily() != device.graphicsFamily() ? "transfer" : "graphics",
+				 uploads.stagingUsed() / ( 1024.0 * 1024.0 ),
+				 uploads.stagingSize() / ( 1024.0 * 1024.0 ) );
+
+	MemoryAllocator::Stats memory = allocator.stats();
+	ImGui::Text( "Device memory: %u of %u allocations", memory.deviceAllocations, memory.maxDeviceAllocations );
+	for( size_t h = 0; h < memory.heaps.size(); h++ )
+	{
+		const MemoryAllocator::HeapStats& heap = memory.heaps[h];
+		if( heap.blocks == 0 && heap.dedicated == 0 )
+			continue;
+		ImGui::Text( "  heap %zu: %.1f of %.1f MB in %u blocks, %u allocations, %u dedicated, %.0f%% fragmented",
+					 h,
+					 heap.usedBytes / ( 1024.0 * 1024.0 ),
+					 heap.blockBytes / ( 1024.0 * 1024.0 ),
+					 heap.blocks,
+					 heap.allocations,
+					 heap.dedicated,
+					 heap.fragmentation * 100.0f );
+	}
+
+	if( profiler.supported() )
+		ImGui::Text( "GPU scene %.3f ms, ImGui %.3f ms",
+					 profiler.lastDurationMs( GpuZone::Scene ),
+					 profiler.lastDurationMs( GpuZone::Ui ) );
 	ImGui::End();
 
 	ImGui::ShowDemoWindow();
@@ -148,6 +898,7 @@ void Application::drawImGui()
 // for resize window
 void Application::recreateSwapChain( bool& framebufferResized )
 {
+	TRACE_ZONE( "RecreateSwapChain" );
 	framebufferResized = true;
 
 	glm::ivec2 size;
@@ -158,15 +909,24 @@ void Application::recreateSwapChain( bool& framebufferResized )
 		glfwWaitEvents();
 	}
 
-	vkDeviceWaitIdle( device.logical() );
-
+	// No device wait: frames in flight keep the old swap chain and whatever else gets replaced,
+	// those are destroyed through the deletion queue once the frames retire
 	swap_chain.recreate();
-	render_pass.recreate();
-	graphicsPipeline.recreate();
-	commandBuffers.recreate();
-
-	interface.recreate();
-
-	render_pass.cleanupOld();
-	swap_chain.cleanupOld();
+	frames.resizeImages( static_cast<uint32_t>( swap_chain.numImages() ) );
+	profiler.recreate( static_cast<uint32_t>( swap_chain.numImages() ) );
+	// Pipelines use dynamic viewport and scissor, only a new image format invalidates them.
+	// With dynamic rendering nothing else depends on the swap chain images either
+	if( render_graph.resize() )
+	{
+		graphicsPipeline.recreate();
+		instancedPipeline.recreate();
+		if( meshPipeline )
+			meshPipeline->recreate();
+		if( indirectPipeline )
+			indirectPipeline->recreate();
+		pipelines.clear();
+	}
+	// Re-recorded every frame, only the number of images matters
+	if( commandBuffers.size() != swap_chain.numImages() )
+		commandBuffers.recreate( static_cast<uint32_t>( swap_chain.numImages() ) );
 }
\ No newline at end of file
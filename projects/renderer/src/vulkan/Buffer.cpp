@@ -0,0 +1,56 @@
+#include <vulkan/Buffer.hpp>
+#include <vulkan/DeletionQueue.hpp>
+#include <vulkan/Device.hpp>
+
+#include <stdexcept>
+
+using namespace vulkan;
+
+Buffer::Buffer( const Device& device,
+				MemoryAllocator& allocator,
+				VkDeviceSize size,
+				VkBufferUsageFlags usage,
+				VkMemoryPropertyFlags properties,
+				DeletionQueue* deletion )
+	: m_device( device ),
+	m_allocator( allocator ),
+	m_deletion( deletion ),
+	m_buffer( VK_NULL_HANDLE ),
+	m_size( size )
+{
+	VkBufferCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	createInfo.size = size;
+	createInfo.usage = usage;
+	createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	if( vkCreateBuffer( m_device.logical(), &createInfo, nullptr, &m_buffer ) != VK_SUCCESS )
+		throw std::runtime_error( "failed to create buffer!" );
+
+	VkMemoryRequirements memRequirements;
+	vkGetBufferMemoryRequirements( m_device.logical(), m_buffer, &memRequirements );
+
+	try
+	{
+		m_memory = m_allocator.allocate( memRequirements, properties, MemoryAllocator::Kind::Linear );
+	}
+	catch( ... )
+	{
+		vkDestroyBuffer( m_device.logical(), m_buffer, nullptr );
+		throw;
+	}
+	vkBindBufferMemory( m_device.logical(), m_buffer, m_memory.memory, m_memory.offset );
+}
+
+Buffer::~Buffer()
+{
+	VkDevice device = m_device.logical();
+	VkBuffer buffer = m_buffer;
+	MemoryAllocator* allocator = &m_allocator;
+	MemoryAllocator::Allocation memory = m_memory;
+	DeletionQueue::Defer( m_deletion, [device, buffer, allocator, memory]() mutable
+	{
+		vkDestroyBuffer( device, buffer, nullptr );
+		allocator->free( memory );
+	} );
+}
@@ -0,0 +1,707 @@
+#include <vulkan/Bvh.hpp>
+
+#include "common/trace.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <functional>
+
+#if defined( __x86_64__ ) || defined( _M_X64 ) || defined( __i386__ ) || defined( _M_IX86 )
+#define BUBBLE_BVH_SSE
+#include <immintrin.h>
+#endif
+
+using namespace vulkan;
+
+namespace
+{
+// Most objects in a leaf, the heuristic makes smaller ones when they're cheaper
+const uint32_t MaxLeafSize = 8;
+const uint32_t SahBins = 16;
+// Visiting a node against testing an object, in the cost of the tree
+const float TraversalCost = 1.0f;
+// Marks stack entries of nodes known to be inside the frustum
+const uint32_t InsideBit = 1u << 31;
+
+const Aabb EmptyBounds = { glm::vec3( std::numeric_limits<float>::max() ), glm::vec3( -std::numeric_limits<float>::max() ) };
+
+inline bool Empty( const glm::vec3& boundsMin, const glm::vec3& boundsMax )
+{
+	return boundsMin.x > boundsMax.x;
+}
+
+inline void Grow( Aabb& bounds, const glm::vec3& boundsMin, const glm::vec3& boundsMax )
+{
+	bounds.min = glm::min( bounds.min, boundsMin );
+	bounds.max = glm::max( bounds.max, boundsMax );
+}
+
+inline float Area( const glm::vec3& boundsMin, const glm::vec3& boundsMax )
+{
+	if( Empty( boundsMin, boundsMax ) )
+		return 0.0f;
+	glm::vec3 size = boundsMax - boundsMin;
+	return 2.0f * ( size.x * size.y + size.y * size.z + size.z * size.x );
+}
+
+// Surface area heuristic: the odds a query reaching the root visits a node go with its area
+inline float NodeCost( const Bvh::Node& node )
+{
+	return Area( node.boundsMin, node.boundsMax ) * ( node.leaf() ? static_cast<float>( node.count ) : TraversalCost );
+}
+
+inline glm::vec3 Centroid( const Bvh::Primitive& primitive )
+{
+	return ( primitive.boundsMin + primitive.boundsMax ) * 0.5f;
+}
+
+enum class Overlap
+{
+	Outside,
+	Intersects,
+	Inside
+};
+
+// Box against the frustum planes, 4 planes at a time with SSE. Planes 6 and 7 pass everything
+class FrustumTest
+{
+public:
+	explicit FrustumTest( const Frustum& frustum )
+	{
+#ifdef BUBBLE_BVH_SSE
+		alignas( 16 ) float lanes[7][8];
+		for( int p = 0; p < 8; p++ )
+		{
+			glm::vec4 plane = p < 6 ? frustum.planes[p] : glm::vec4( 0.0f, 0.0f, 0.0f, 1.0f );
+			for( int c = 0; c < 4; c++ )
+				lanes[c][p] = plane[c];
+			for( int c = 0; c < 3; c++ )
+				lanes[4 + c][p] = std::abs( plane[c] );
+		}
+		for( int g = 0; g < 2; g++ )
+			for( int c = 0; c < 7; c++ )
+				m_lanes[c][g] = _mm_load_ps( &lanes[c][g * 4] );
+#else
+		m_frustum = frustum;
+#endif
+	}
+
+	// Outside when the box is behind a plane, inside when it's in front of all of them
+	inline Overlap test( const glm::vec3& boundsMin, const glm::vec3& boundsMax ) const
+	{
+		glm::vec3 center = ( boundsMin + boundsMax ) * 0.5f;
+		glm::vec3 extent = ( boundsMax - boundsMin ) * 0.5f;
+#ifdef BUBBLE_BVH_SSE
+		__m128 cx = _mm_set1_ps( center.x ), cy = _mm_set1_ps( center.y ), cz = _mm_set1_ps( center.z );
+		__m128 ex = _mm_set1_ps( extent.x ), ey = _mm_set1_ps( extent.y ), ez = _mm_set1_ps( extent.z );
+		__m128 zero = _mm_setzero_ps();
+		int outside = 0;
+		int inside = 0xF;
+		for( int g = 0; g < 2; g++ )
+		{
+			__m128 distance = _mm_add_ps( _mm_add_ps( _mm_mul_ps( m_lanes[0][g], cx ), _mm_mul_ps( m_lanes[1][g], cy ) ),
+										  _mm_add_ps( _mm_mul_ps( m_lanes[2][g], cz ), m_lanes[3][g] ) );
+			// Of the box's corner furthest along the plane's normal
+			__m128 radius = _mm_add_ps( _mm_add_ps( _mm_mul_ps( m_lanes[4][g], ex ), _mm_mul_ps( m_lanes[5][g], ey ) ),
+										_mm_mul_ps( m_lanes[6][g], ez ) );
+			outside |= _mm_movemask_ps( _mm_cmplt_ps( _mm_add_ps( distance, radius ), zero ) );
+			inside &= _mm_movemask_ps( _mm_cmpge_ps( _mm_sub_ps( distance, radius ), zero ) );
+		}
+		if( outside )
+			return Overlap::Outside;
+		return inside == 0xF ? Overlap::Inside : Overlap::Intersects;
+#else
+		bool inside = true;
+		for( const glm::vec4& plane : m_frustum.planes )
+		{
+			float distance = glm::dot( glm::vec3( plane ), center ) + plane.w;
+			float radius = glm::dot( glm::abs( glm::vec3( plane ) ), extent );
+			if( distance + radius < 0.0f )
+				return Overlap::Outside;
+			inside &= distance - radius >= 0.0f;
+		}
+		return inside ? Overlap::Inside : Overlap::Intersects;
+#endif
+	}
+
+private:
+#ifdef BUBBLE_BVH_SSE
+	// Normal x, y, z, distance and the normal's absolute x, y, z, of planes 0-3 and 4-7
+	__m128 m_lanes[7][2];
+#else
+	Frustum m_frustum;
+#endif
+};
+
+// Slab test of the ray against a box, all three axes at once with SSE.
+// Bounds point at a node's or primitive's vec3 followed by its uint, which fills the fourth lane
+class RayTest
+{
+public:
+	RayTest( const glm::vec3& origin, const glm::vec3& direction )
+	{
+		glm::vec3 inverse = 1.0f / direction;
+#ifdef BUBBLE_BVH_SSE
+		m_origin = _mm_setr_ps( origin.x, origin.y, origin.z, 0.0f );
+		m_inverse = _mm_setr_ps( inverse.x, inverse.y, inverse.z, 0.0f );
+		m_xyz = _mm_castsi128_ps( _mm_setr_epi32( -1, -1, -1, 0 ) );
+#else
+		m_origin = origin;
+		m_inverse = inverse;
+#endif
+	}
+
+	// Distance the ray enters the box at, from 0, or infinity when it misses it before maxDistance
+	inline float test( const glm::vec3& boundsMin, const glm::vec3& boundsMax, float maxDistance ) const
+	{
+#ifdef BUBBLE_BVH_SSE
+		__m128 t0 = _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( &boundsMin.x ), m_origin ), m_inverse );
+		__m128 t1 = _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( &boundsMax.x ), m_origin ), m_inverse );
+		// The fourth lane becomes the ray's own range
+		__m128 enter = _mm_and_ps( _mm_min_ps( t0, t1 ), m_xyz );
+		__m128 exit = _mm_or_ps( _mm_and_ps( _mm_max_ps( t0, t1 ), m_xyz ), _mm_andnot_ps( m_xyz, _mm_set1_ps( maxDistance ) ) );
+		enter = _mm_max_ps( enter, _mm_shuffle_ps( enter, enter, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+		enter = _mm_max_ps( enter, _mm_shuffle_ps( enter, enter, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+		exit = _mm_min_ps( exit, _mm_shuffle_ps( exit, exit, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+		exit = _mm_min_ps( exit, _mm_shuffle_ps( exit, exit, _MM_SHUFFLE( 2, 3, 0, 1 ) ) );
+		float enterDistance = _mm_cvtss_f32( enter );
+		float exitDistance = _mm_cvtss_f32( exit );
+#else
+		glm::vec3 t0 = ( boundsMin - m_origin ) * m_inverse;
+		glm::vec3 t1 = ( boundsMax - m_origin ) * m_inverse;
+		glm::vec3 enters = glm::min( t0, t1 );
+		glm::vec3 exits = glm::max( t0, t1 );
+		float enterDistance = std::max( std::max( enters.x, enters.y ), std::max( enters.z, 0.0f ) );
+		float exitDistance = std::min( std::min( exits.x, exits.y ), std::min( exits.z, maxDistance ) );
+#endif
+		return enterDistance <= exitDistance ? enterDistance : std::numeric_limits<float>::infinity();
+	}
+
+private:
+#ifdef BUBBLE_BVH_SSE
+	__m128 m_origin;
+	__m128 m_inverse;
+	__m128 m_xyz;
+#else
+	glm::vec3 m_origin;
+	glm::vec3 m_inverse;
+#endif
+};
+}  // namespace
+
+Bvh::~Bvh()
+{
+	if( m_jobs && !m_rebuild.done() )
+	{
+		// A job's exception can't leave a destructor, the tree is dropped anyway
+		try
+		{
+			m_jobs->wait( m_rebuild );
+		}
+		catch( ... )
+		{
+		}
+	}
+}
+
+uint32_t Bvh::add( const Aabb& bounds )
+{
+	uint32_t object;
+	if( !m_free.empty() )
+	{
+		object = m_free.back();
+		m_free.pop_back();
+		m_removed[object] = false;
+	}
+	else
+	{
+		object = static_cast<uint32_t>( m_bounds.size() );
+		m_bounds.push_back( bounds );
+		m_removed.push_back( false );
+		m_leaf.push_back( NotInTree );
+		m_primitive.push_back( NotInTree );
+	}
+
+	// A removed object's primitive is still in the tree until the next build, the new one takes it
+	if( m_leaf[object] != NotInTree )
+	{
+		m_stale--;
+		set( object, bounds );
+	}
+	else
+	{
+		m_bounds[object] = bounds;
+		m_pending.push_back( object );
+	}
+	return object;
+}
+
+void Bvh::set( uint32_t object, const Aabb& bounds )
+{
+	m_bounds[object] = bounds;
+	uint32_t primitive = m_primitive[object];
+	if( primitive == NotInTree )
+		return;
+	m_primitives[primitive].boundsMin = bounds.min;
+	m_primitives[primitive].boundsMax = bounds.max;
+	markMoved( object );
+}
+
+void Bvh::remove( uint32_t object )
+{
+	// Removing twice would free the index twice, and two later add()s would share it
+	if( object >= m_removed.size() || m_removed[object] )
+		return;
+
+	if( m_leaf[object] != NotInTree )
+	{
+		set( object, EmptyBounds );
+		m_stale++;
+	}
+	else
+	{
+		m_bounds[object] = EmptyBounds;
+		auto pending = std::find( m_pending.begin(), m_pending.end(), object );
+		if( pending != m_pending.end() )
+		{
+			*pending = m_pending.back();
+			m_pending.pop_back();
+		}
+	}
+	m_removed[object] = true;
+	m_free.push_back( object );
+}
+
+void Bvh::reserve( uint32_t count )
+{
+	m_bounds.reserve( count );
+	m_removed.reserve( count );
+	m_leaf.reserve( count );
+	m_primitive.reserve( count );
+}
+
+void Bvh::clear()
+{
+	m_generation++;
+	m_bounds.clear();
+	m_removed.clear();
+	m_free.clear();
+	m_leaf.clear();
+	m_primitive.clear();
+	m_pending.clear();
+	m_nodes.clear();
+	m_primitives.clear();
+	m_parents.clear();
+	m_moved.clear();
+	m_refit.clear();
+	m_builtCost = 0.0f;
+	m_cost = 0.0f;
+	m_stale = 0;
+}
+
+void Bvh::build()
+{
+	TRACE_ZONE( "BuildBvh" );
+	// A rebuild still running started from older bounds
+	m_generation++;
+	Tree tree = Build( snapshot() );
+	tree.generation = m_generation;
+	install( std::move( tree ) );
+}
+
+void Bvh::refit()
+{
+	if( m_moved.empty() )
+		return;
+
+	// Moved leaves and every node above them, once. Children come after their parent
+	// in the array, so going from the back refits bottom up
+	std::vector<uint32_t> nodes;
+	for( uint32_t leaf : m_moved )
+	{
+		nodes.push_back( leaf );
+		for( uint32_t node = m_parents[leaf]; node != NotInTree && !m_refit[node]; node = m_parents[node] )
+		{
+			m_refit[node] = true;
+			nodes.push_back( node );
+		}
+	}
+	m_moved.clear();
+
+	std::sort( nodes.begin(), nodes.end(), std::greater<uint32_t>() );
+	for( uint32_t node : nodes )
+	{
+		refitNode( node );
+		m_refit[node] = false;
+	}
+}
+
+void Bvh::update( JobSystem& jobs, float rebuildThreshold )
+{
+	m_jobs = &jobs;
+	if( m_rebuild.done() && m_rebuilt )
+	{
+		Scope<Tree> tree = std::move( m_rebuilt );
+		if( tree->generation == m_generation )
+			install( std::move( *tree ) );
+	}
+
+	refit();
+
+	// Removed objects linger in the tree as empty boxes
+	bool stale = m_stale > m_primitives.size() / 4;
+	if( !m_rebuild.done() || ( m_pending.empty() && !stale && degradation() <= rebuildThreshold ) )
+		return;
+
+	uint64_t generation = m_generation;
+	jobs.runBackground( [this, primitives = snapshot(), generation]() mutable
+	{
+		TRACE_ZONE( "RebuildBvh" );
+		Tree tree = Build( std::move( primitives ) );
+		tree.generation = generation;
+		m_rebuilt = CreateScope<Tree>( std::move( tree ) );
+	}, &m_rebuild );
+}
+
+void Bvh::cull( const Frustum& frustum, std::vector<uint32_t>& visible ) const
+{
+	FrustumTest test( frustum );
+	for( uint32_t object : m_pending )
+		if( test.test( m_bounds[object].min, m_bounds[object].max ) != Overlap::Outside )
+			visible.push_back( object );
+	if( m_nodes.empty() )
+		return;
+
+	std::vector<uint32_t> stack;
+	stack.reserve( 64 );
+	stack.push_back( 0 );
+	while( !stack.empty() )
+	{
+		uint32_t entry = stack.back();
+		stack.pop_back();
+		const Node& node = m_nodes[entry & ~InsideBit];
+
+		bool inside = entry & InsideBit;
+		if( !inside )
+		{
+			Overlap overlap = test.test( node.boundsMin, node.boundsMax );
+			if( overlap == Overlap::Outside )
+				continue;
+			inside = overlap == Overlap::Inside;
+		}
+
+		if( !node.leaf() )
+		{
+			// Nothing under a node inside the frustum is tested again
+			uint32_t flag = inside ? InsideBit : 0;
+			stack.push_back( ( node.first + 1 ) | flag );
+			stack.push_back( node.first | flag );
+			continue;
+		}
+		for( uint32_t i = node.first; i < node.first + node.count; i++ )
+		{
+			const Primitive& primitive = m_primitives[i];
+			if( Empty( primitive.boundsMin, primitive.boundsMax ) )
+				continue;
+			if( inside || test.test( primitive.boundsMin, primitive.boundsMax ) != Overlap::Outside )
+				visible.push_back( primitive.object );
+		}
+	}
+}
+
+std::optional<Bvh::Hit> Bvh::raycast( const glm::vec3& origin, const glm::vec3& direction, float maxDistance ) const
+{
+	RayTest test( origin, direction );
+	Hit hit = { NotInTree, maxDistance };
+	for( uint32_t object : m_pending )
+	{
+		// Padded for the test's loads
+		Primitive bounds = { m_bounds[object].min, object, m_bounds[object].max, 0 };
+		float distance = test.test( bounds.boundsMin, bounds.boundsMax, hit.distance );
+		if( distance < hit.distance )
+			hit = { object, distance };
+	}
+
+	// Nodes with the distance the ray enters them at, nearer children are visited first
+	// and further ones skipped once something closer was hit
+	std::vector<std::pair<uint32_t, float>> stack;
+	stack.reserve( 64 );
+	if( !m_nodes.empty() )
+	{
+		float distance = test.test( m_nodes[0].boundsMin, m_nodes[0].boundsMax, hit.distance );
+		if( distance < hit.distance )
+			stack.push_back( { 0, distance } );
+	}
+	while( !stack.empty() )
+	{
+		auto [index, enter] = stack.back();
+		stack.pop_back();
+		if( enter >= hit.distance )
+			continue;
+
+		const Node& node = m_nodes[index];
+		if( node.leaf() )
+		{
+			for( uint32_t i = node.first; i < node.first + node.count; i++ )
+			{
+				const Primitive& primitive = m_primitives[i];
+				if( Empty( primitive.boundsMin, primitive.boundsMax ) )
+					continue;
+				float distance = test.test( primitive.boundsMin, primitive.boundsMax, hit.distance );
+				if( distance < hit.distance )
+					hit = { primitive.object, distance };
+			}
+			continue;
+		}
+
+		const Node& left = m_nodes[node.first];
+		const Node& right = m_nodes[node.first + 1];
+		float leftDistance = test.test( left.boundsMin, left.boundsMax, hit.distance );
+		float rightDistance = test.test( right.boundsMin, right.boundsMax, hit.distance );
+		std::pair<uint32_t, float> nearer = { node.first, leftDistance };
+		std::pair<uint32_t, float> further = { node.first + 1, rightDistance };
+		if( further.second < nearer.second )
+			std::swap( nearer, further );
+		if( further.second < hit.distance )
+			stack.push_back( further );
+		if( nearer.second < hit.distance )
+			stack.push_back( nearer );
+	}
+
+	if( hit.object == NotInTree )
+		return std::nullopt;
+	return hit;
+}
+
+float Bvh::degradation() const
+{
+	if( m_nodes.empty() || m_builtCost <= 0.0f )
+		return 1.0f;
+	float rootArea = Area( m_nodes[0].boundsMin, m_nodes[0].boundsMax );
+	if( rootArea <= 0.0f )
+		return 1.0f;
+	return m_cost / rootArea / m_builtCost;
+}
+
+// Binned: the centroids of a node's objects fall into bins along each axis, and the split
+// between two bins with the lowest area times object count on both sides wins
+Bvh::Tree Bvh::Build( std::vector<Primitive> primitives )
+{
+	Tree tree;
+	tree.primitives = std::move( primitives );
+	uint32_t count = static_cast<uint32_t>( tree.primitives.size() );
+	if( count == 0 )
+		return tree;
+
+	// Children are added in pairs, at most one inner node per object
+	tree.nodes.reserve( 2 * count );
+	tree.nodes.push_back( { glm::vec3( 0.0f ), 0, glm::vec3( 0.0f ), count } );
+
+	std::vector<uint32_t> stack = { 0 };
+	while( !stack.empty() )
+	{
+		uint32_t index = stack.back();
+		stack.pop_back();
+		uint32_t first = tree.nodes[index].first;
+		uint32_t nodeCount = tree.nodes[index].count;
+
+		Aabb bounds = EmptyBounds;
+		Aabb centroids = EmptyBounds;
+		for( uint32_t i = first; i < first + nodeCount; i++ )
+		{
+			const Primitive& primitive = tree.primitives[i];
+			Grow( bounds, primitive.boundsMin, primitive.boundsMax );
+			glm::vec3 centroid = Centroid( primitive );
+			Grow( centroids, centroid, centroid );
+		}
+		tree.nodes[index].boundsMin = bounds.min;
+		tree.nodes[index].boundsMax = bounds.max;
+		if( nodeCount <= 2 )
+			continue;
+
+		// Every axis binned in one pass over the objects
+		glm::vec3 extent = centroids.max - centroids.min;
+		glm::vec3 scale;
+		for( int axis = 0; axis < 3; axis++ )
+			scale[axis] = extent[axis] > 0.0f ? SahBins / extent[axis] : 0.0f;
+		std::array<std::array<Aabb, SahBins>, 3> binBounds;
+		std::array<std::array<uint32_t, SahBins>, 3> binCounts = {};
+		for( std::array<Aabb, SahBins>& axisBounds : binBounds )
+			axisBounds.fill( EmptyBounds );
+		for( uint32_t i = first; i < first + nodeCount; i++ )
+		{
+			const Primitive& primitive = tree.primitives[i];
+			glm::vec3 position = ( Centroid( primitive ) - centroids.min ) * scale;
+			for( int axis = 0; axis < 3; axis++ )
+			{
+				uint32_t bin = std::min( SahBins - 1, static_cast<uint32_t>( position[axis] ) );
+				Grow( binBounds[axis][bin], primitive.boundsMin, primitive.boundsMax );
+				binCounts[axis][bin]++;
+			}
+		}
+
+		// Cost of the best split, in objects tested: a leaf costs nodeCount
+		float bestCost = std::numeric_limits<float>::max();
+		int bestAxis = -1;
+		uint32_t bestBin = 0;
+		float nodeArea = std::max( Area( bounds.min, bounds.max ), std::numeric_limits<float>::min() );
+		for( int axis = 0; axis < 3; axis++ )
+		{
+			if( extent[axis] <= 0.0f )
+				continue;
+
+			// Area and count of everything right of each split, then sweep from the left
+			std::array<float, SahBins> rightArea;
+			std::array<uint32_t, SahBins> rightCount;
+			Aabb right = EmptyBounds;
+			uint32_t rightObjects = 0;
+			for( uint32_t bin = SahBins - 1; bin > 0; bin-- )
+			{
+				Grow( right, binBounds[axis][bin].min, binBounds[axis][bin].max );
+				rightObjects += binCounts[axis][bin];
+				rightArea[bin] = Area( right.min, right.max );
+				rightCount[bin] = rightObjects;
+			}
+			Aabb left = EmptyBounds;
+			uint32_t leftObjects = 0;
+			for( uint32_t bin = 0; bin < SahBins - 1; bin++ )
+			{
+				Grow( left, binBounds[axis][bin].min, binBounds[axis][bin].max );
+				leftObjects += binCounts[axis][bin];
+				if( leftObjects == 0 || rightCount[bin + 1] == 0 )
+					continue;
+				float cost = TraversalCost + ( Area( left.min, left.max ) * leftObjects + rightArea[bin + 1] * rightCount[bin + 1] ) / nodeArea;
+				if( cost < bestCost )
+				{
+					bestCost = cost;
+					bestAxis = axis;
+					bestBin = bin;
+				}
+			}
+		}
+
+		if( bestCost >= nodeCount && nodeCount <= MaxLeafSize )
+			continue;
+
+		uint32_t middle;
+		if( bestAxis >= 0 )
+		{
+			// Same binning as above, so both sides get the objects they were costed with
+			float axisScale = scale[bestAxis];
+			float minimum = centroids.min[bestAxis];
+			auto split = std::partition( tree.primitives.begin() + first,
+										 tree.primitives.begin() + first + nodeCount,
+										 [bestAxis, bestBin, axisScale, minimum]( const Primitive& primitive )
+			{
+				return std::min( SahBins - 1, static_cast<uint32_t>( ( Centroid( primitive )[bestAxis] - minimum ) * axisScale ) ) <= bestBin;
+			} );
+			middle = static_cast<uint32_t>( split - tree.primitives.begin() );
+		}
+		else
+		{
+			// Every centroid in one point, too many of them for a leaf
+			middle = first + nodeCount / 2;
+		}
+
+		uint32_t left = static_cast<uint32_t>( tree.nodes.size() );
+		tree.nodes.push_back( { glm::vec3( 0.0f ), first, glm::vec3( 0.0f ), middle - first } );
+		tree.nodes.push_back( { glm::vec3( 0.0f ), middle, glm::vec3( 0.0f ), first + nodeCount - middle } );
+		tree.nodes[index].first = left;
+		tree.nodes[index].count = 0;
+		stack.push_back( left + 1 );
+		stack.push_back( left );
+	}
+	return tree;
+}
+
+std::vector<Bvh::Primitive> Bvh::snapshot() const
+{
+	std::vector<Primitive> primitives;
+	primitives.reserve( objectCount() );
+	for( uint32_t object = 0; object < m_bounds.size(); object++ )
+		if( !m_removed[object] )
+			primitives.push_back( { m_bounds[object].min, object, m_bounds[object].max, 0 } );
+	return primitives;
+}
+
+// The tree may come from older bounds: objects moved since take their current ones and
+// the whole tree is refit, objects added since stay pending
+void Bvh::install( Tree tree )
+{
+	m_nodes = std::move( tree.nodes );
+	m_primitives = std::move( tree.primitives );
+
+	m_leaf.assign( m_bounds.size(), NotInTree );
+	m_primitive.assign( m_bounds.size(), NotInTree );
+	m_stale = 0;
+	for( uint32_t node = 0; node < m_nodes.size(); node++ )
+	{
+		if( !m_nodes[node].leaf() )
+			continue;
+		for( uint32_t i = m_nodes[node].first; i < m_nodes[node].first + m_nodes[node].count; i++ )
+		{
+			Primitive& primitive = m_primitives[i];
+			m_leaf[primitive.object] = node;
+			m_primitive[primitive.object] = i;
+			primitive.boundsMin = m_bounds[primitive.object].min;
+			primitive.boundsMax = m_bounds[primitive.object].max;
+			m_stale += m_removed[primitive.object] ? 1 : 0;
+		}
+	}
+
+	m_pending.clear();
+	for( uint32_t object = 0; object < m_bounds.size(); object++ )
+		if( !m_removed[object] && m_leaf[object] == NotInTree )
+			m_pending.push_back( object );
+
+	m_parents.assign( m_nodes.size(), NotInTree );
+	for( uint32_t node = 0; node < m_nodes.size(); node++ )
+	{
+		if( !m_nodes[node].leaf() )
+		{
+			m_parents[m_nodes[node].first] = node;
+			m_parents[m_nodes[node].first + 1] = node;
+		}
+	}
+
+	m_moved.clear();
+	m_refit.assign( m_nodes.size(), false );
+	m_cost = 0.0f;
+	for( const Node& node : m_nodes )
+		m_cost += NodeCost( node );
+	for( uint32_t node = static_cast<uint32_t>( m_nodes.size() ); node-- > 0; )
+		refitNode( node );
+	m_builtCost = 1.0f;
+	m_builtCost = degradation();
+}
+
+void Bvh::markMoved( uint32_t object )
+{
+	uint32_t leaf = m_leaf[object];
+	if( m_refit[leaf] )
+		return;
+	m_refit[leaf] = true;
+	m_moved.push_back( leaf );
+}
+
+void Bvh::refitNode( uint32_t index )
+{
+	Node& node = m_nodes[index];
+	m_cost -= NodeCost( node );
+
+	Aabb bounds = EmptyBounds;
+	if( node.leaf() )
+	{
+		for( uint32_t i = node.first; i < node.first + node.count; i++ )
+			Grow( bounds, m_primitives[i].boundsMin, m_primitives[i].boundsMax );
+	}
+	else
+	{
+		for( uint32_t child = node.first; child < node.first + 2; child++ )
+			Grow( bounds, m_nodes[child].boundsMin, m_nodes[child].boundsMax );
+	}
+	node.boundsMin = bounds.min;
+	node.boundsMax = bounds.max;
+	m_cost += NodeCost( node );
+}
@@ -1,37 +1,40 @@
 #include <vulkan/CommandBuffers.hpp>
+#include <vulkan/Buffer.hpp>
 #include <vulkan/CommandPool.hpp>
+#include <vulkan/DeletionQueue.hpp>
 #include <vulkan/Device.hpp>
-#include <vulkan/GraphicsPipeline.hpp>
-#include <vulkan/RenderPass.hpp>
-#include <vulkan/SwapChain.hpp>
 
 #include <stdexcept>
 
 using namespace vulkan;
 
 CommandBuffers::CommandBuffers( const Device& device,
-								const RenderPass& render_pass,
-								const SwapChain& swap_chain,
-								const GraphicsPipeline& graphical_pipeline,
-								const CommandPool& command_pool )
+								const CommandPool& command_pool,
+								uint32_t count,
+								DeletionQueue* deletion )
 	: m_device( device ),
-	m_render_pass( render_pass ),
-	m_swap_chain( swap_chain ),
-	m_graphicsPipeline( graphical_pipeline ),
-	m_command_pool( command_pool )
+	m_command_pool( command_pool ),
+	m_deletion( deletion )
 {
-	createCommandBuffers();
+	createCommandBuffers( count );
 }
 
-void CommandBuffers::recreate()
+void CommandBuffers::recreate( uint32_t count )
 {
-	destroyCommandBuffers();
-	createCommandBuffers();
+	// Frames in flight may still execute the old buffers
+	VkDevice device = m_device.logical();
+	VkCommandPool pool = m_command_pool.handle();
+	DeletionQueue::Defer( m_deletion, [device, pool, buffers = std::move( m_commandBuffers )]
+	{
+		vkFreeCommandBuffers( device, pool, static_cast<uint32_t>( buffers.size() ), buffers.data() );
+	} );
+	m_commandBuffers.clear();
+	createCommandBuffers( count );
 }
 
-void CommandBuffers::createCommandBuffers()
+void CommandBuffers::createCommandBuffers( uint32_t count )
 {
-	m_commandBuffers.resize( m_render_pass.size() );
+	m_commandBuffers.resize( count );
 
 	VkCommandBufferAllocateInfo allocInfo{};
 	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -41,37 +44,23 @@ void CommandBuffers::createCommandBuffers()
 
 	if( vkAllocateCommandBuffers( m_device.logical(), &allocInfo, m_commandBuffers.data() ) != VK_SUCCESS )
 		throw std::runtime_error( "failed to allocate command buffers!" );
-
-	for( size_t i = 0; i < m_commandBuffers.size(); i++ )
-	{
-		VkCommandBufferBeginInfo beginInfo{};
-		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-
-		if( vkBeginCommandBuffer( m_commandBuffers[i], &beginInfo ) != VK_SUCCESS )
-			throw std::runtime_error( "failed to begin recording command buffer!" );
-
-		VkRenderPassBeginInfo render_passInfo{};
-		render_passInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-		render_passInfo.renderPass = m_render_pass.handle();
-		render_passInfo.framebuffer = m_render_pass.frameBuffer( i );
-		render_passInfo.renderArea.offset = { 0, 0 };
-		render_passInfo.renderArea.extent = m_swap_chain.extent();
-
-		VkClearValue clearColor = { 0.0f, 0.0f, 0.0f, 1.0f };
-		render_passInfo.clearValueCount = 1;
-		render_passInfo.pClearValues = &clearColor;
-
-		vkCmdBeginRenderPass( m_commandBuffers[i], &render_passInfo, VK_SUBPASS_CONTENTS_INLINE );
-		vkCmdBindPipeline( m_commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, m_graphicsPipeline.pipeline() );
-		vkCmdDraw( m_commandBuffers[i], 3, 1, 0, 0 );
-		vkCmdEndRenderPass( m_commandBuffers[i] );
-
-		if( vkEndCommandBuffer( m_commandBuffers[i] ) != VK_SUCCESS )
-			throw std::runtime_error( "failed to record command buffer!" );
-	}
 }
 
+void CommandBuffers::begin( uint32_t index, VkCommandBufferUsageFlags flags )
+{
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = flags;
 
+	if( vkBeginCommandBuffer( m_commandBuffers[index], &beginInfo ) != VK_SUCCESS )
+		throw std::runtime_error( "failed to begin recording command buffer!" );
+}
+
+void CommandBuffers::end( uint32_t index )
+{
+	if( vkEndCommandBuffer( m_commandBuffers[index] ) != VK_SUCCESS )
+		throw std::runtime_error( "failed to record command buffer!" );
+}
 
 CommandBuffers::~CommandBuffers()
 {
@@ -117,8 +106,62 @@ void CommandBuffers::SingleTimeCommands( const Device& device,
 	submitInfo.commandBufferCount = 1;
 	submitInfo.pCommandBuffers = &commandBuffer;
 
-	vkQueueSubmit( device.graphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE );
-	vkQueueWaitIdle( device.graphicsQueue() );
+	// Waits for this submission only, frames in flight on the queue keep going
+	VkFenceCreateInfo fenceInfo = {};
+	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
 
+	VkFence fence = VK_NULL_HANDLE;
+	if( vkCreateFence( device.logical(), &fenceInfo, nullptr, &fence ) != VK_SUCCESS )
+		throw std::runtime_error( "failed to create fence!" );
+
+	VkResult result = vkQueueSubmit( device.graphicsQueue(), 1, &submitInfo, fence );
+	if( result == VK_SUCCESS )
+		result = vkWaitForFences( device.logical(), 1, &fence, VK_TRUE, UINT64_MAX );
+
+	vkDestroyFence( device.logical(), fence, nullptr );
 	vkFreeCommandBuffers( device.logical(), cmdPool.handle(), 1, &commandBuffer );
-}
\ No newline at end of file
+	if( result != VK_SUCCESS )
+		throw std::runtime_error( "failed to submit one-time command buffer!" );
+}
+void CommandBuffers::DrawIndexedIndirectCount( VkCommandBuffer cmd,
+											   const Buffer& commands,
+											   VkDeviceSize offset,
+											   const Buffer& count,
+											   VkDeviceSize countOffset,
+											   uint32_t maxDraws )
+{
+	vkCmdDrawIndexedIndirectCount( cmd,
+								   commands.handle(),
+								   offset,
+								   count.handle(),
+								   countOffset,
+								   maxDraws,
+								   sizeof( VkDrawIndexedIndirectCommand ) );
+}
+
+void CommandBuffers::ComputeToIndirectBarrier( VkCommandBuffer cmd )
+{
+	VkMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+	vkCmdPipelineBarrier( cmd,
+						  VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+						  VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+						  0,
+						  1, &barrier,
+						  0, nullptr,
+						  0, nullptr );
+}
+
+void CommandBuffers::IndirectReuseBarrier( VkCommandBuffer cmd )
+{
+	// Write after read, an execution dependency is enough
+	vkCmdPipelineBarrier( cmd,
+						  VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+						  VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+						  0,
+						  0, nullptr,
+						  0, nullptr,
+						  0, nullptr );
+}
@@ -5,13 +5,15 @@
 
 using namespace vulkan;
 
-CommandPool::CommandPool( const Device& device, const VkCommandPoolCreateFlags& flags )
+CommandPool::CommandPool( const Device& device,
+						  const VkCommandPoolCreateFlags& flags,
+						  std::optional<uint32_t> queueFamily )
 	: m_device( device ),
 	m_flags( flags )
 {
 	VkCommandPoolCreateInfo poolInfo = {};
 	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-	poolInfo.queueFamilyIndex = m_device.queueFamilyIndices().graphicsFamily.value();
+	poolInfo.queueFamilyIndex = queueFamily.value_or( m_device.graphicsFamily() );
 	poolInfo.flags = flags;
 
 	if( vkCreateCommandPool( m_device.logical(), &poolInfo, nullptr, &m_pool ) != VK_SUCCESS )
@@ -21,4 +23,10 @@ CommandPool::CommandPool( const Device& device, const VkCommandPoolCreateFlags&
 CommandPool::~CommandPool()
 {
 	vkDestroyCommandPool( m_device.logical(), m_pool, nullptr );
+}
+
+void CommandPool::reset() const
+{
+	if( vkResetCommandPool( m_device.logical(), m_pool, 0 ) != VK_SUCCESS )
+		throw std::runtime_error( "failed to reset command pool!" );
 }
\ No newline at end of file
@@ -0,0 +1,93 @@
+#include <vulkan/ComputePipeline.hpp>
+#include <vulkan/Device.hpp>
+#include <vulkan/PipelineCache.hpp>
+#include <vulkan/PipelineLayoutCache.hpp>
+
+#include <stdexcept>
+#include <string>
+
+#include "common/trace.hpp"
+
+using namespace vulkan;
+
+ComputePipeline::ComputePipeline( const Device& device,
+								  Ref<Shader> shader,
+								  const PipelineCache* cache )
+	: m_device( device ),
+	m_shader( std::move( shader ) ),
+	m_cache( cache ),
+	m_layout( VK_NULL_HANDLE ),
+	m_pipeline( VK_NULL_HANDLE )
+{
+	if( m_shader->GetType() != Shader::Type::Comp )
+		throw std::runtime_error( "compute pipelines need a compute shader!" );
+
+	if( !m_cache )
+		m_ownLayouts = CreateScope<PipelineLayoutCache>( m_device );
+	const Ref<Shader> stages[] = { m_shader };
+	m_layout = layouts().get( stages ).layout;
+	m_pipeline = Create( m_device, m_shader, m_layout, m_cache );
+}
+
+ComputePipeline::~ComputePipeline()
+{
+	vkDestroyPipeline( m_device.logical(), m_pipeline, nullptr );
+}
+
+VkPipeline ComputePipeline::Create( const Device& device, const Ref<Shader>& shader, VkPipelineLayout layout, const PipelineCache* cache )
+{
+	TRACE_ZONE( "CreateComputePipeline" );
+
+	// Shared module when there is a cache, otherwise it only lives for this call
+	VkShaderModule module = VK_NULL_HANDLE;
+	if( cache )
+		module = cache->shaderModules().get( shader );
+	else
+	{
+		std::span<const uint32_t> code = shader->GetShaderData();
+		VkShaderModuleCreateInfo moduleInfo = {};
+		moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		moduleInfo.codeSize = code.size_bytes();
+		moduleInfo.pCode = code.data();
+		if( vkCreateShaderModule( device.logical(), &moduleInfo, nullptr, &module ) != VK_SUCCESS )
+			throw std::runtime_error( "failed to create shader module!" );
+	}
+
+	VkComputePipelineCreateInfo pipelineInfo = {};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipelineInfo.stage.module = module;
+	pipelineInfo.stage.pName = "main";
+	pipelineInfo.layout = layout;
+	pipelineInfo.basePipelineIndex = -1;
+
+	VkPipeline pipeline = VK_NULL_HANDLE;
+	VkPipelineCache pipelineCache = cache ? cache->handle() : VK_NULL_HANDLE;
+	VkResult result = vkCreateComputePipelines( device.logical(), pipelineCache, 1, &pipelineInfo, nullptr, &pipeline );
+	if( !cache )
+		vkDestroyShaderModule( device.logical(), module, nullptr );
+
+	if( result != VK_SUCCESS )
+		throw std::runtime_error( "Compute Pipeline creation failed" );
+	return pipeline;
+}
+
+void ComputePipeline::bind( VkCommandBuffer cmd ) const
+{
+	vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline );
+}
+
+VkDescriptorSetLayout ComputePipeline::setLayout( uint32_t set ) const
+{
+	const Ref<Shader> stages[] = { m_shader };
+	const std::vector<VkDescriptorSetLayout>& sets = layouts().get( stages ).sets;
+	if( set >= sets.size() )
+		throw std::runtime_error( "shader doesn't use descriptor set " + std::to_string( set ) + "!" );
+	return sets[set];
+}
+
+PipelineLayoutCache& ComputePipeline::layouts() const
+{
+	return m_cache ? m_cache->pipelineLayouts() : *m_ownLayouts;
+}
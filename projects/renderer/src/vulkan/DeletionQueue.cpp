@@ -0,0 +1,58 @@
+#include <vulkan/DeletionQueue.hpp>
+#include <vulkan/FrameScheduler.hpp>
+
+using namespace vulkan;
+
+DeletionQueue::~DeletionQueue()
+{
+	flush();
+}
+
+void DeletionQueue::beginFrame( const FrameScheduler& frames )
+{
+	std::deque<Entry> retired;
+	{
+		std::lock_guard lock( m_mutex );
+		m_frame = frames.currentFrame();
+		while( !m_entries.empty() && frames.retired( m_entries.front().frame ) )
+		{
+			retired.push_back( std::move( m_entries.front() ) );
+			m_entries.pop_front();
+		}
+	}
+
+	// Outside the lock, deleters may push more
+	for( Entry& entry : retired )
+		entry.deleter();
+}
+
+void DeletionQueue::push( Deleter deleter )
+{
+	std::lock_guard lock( m_mutex );
+	m_entries.push_back( { m_frame, std::move( deleter ) } );
+}
+
+void DeletionQueue::flush()
+{
+	// Deleters may push more
+	for( ;; )
+	{
+		std::deque<Entry> entries;
+		{
+			std::lock_guard lock( m_mutex );
+			entries.swap( m_entries );
+		}
+		if( entries.empty() )
+			break;
+		for( Entry& entry : entries )
+			entry.deleter();
+	}
+}
+
+void DeletionQueue::Defer( DeletionQueue* queue, Deleter deleter )
+{
+	if( queue )
+		queue->push( std::move( deleter ) );
+	else
+		deleter();
+}
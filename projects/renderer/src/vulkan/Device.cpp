@@ -15,18 +15,38 @@ using namespace vulkan;
 Device::Device( const Instance& instance,
 				const Window& window,
 				const std::vector<const char*>& extensions )
+	: Device( instance, &window, extensions )
+{}
+
+Device::Device( const Instance& instance,
+				const std::vector<const char*>& extensions )
+	: Device( instance, nullptr, extensions )
+{}
+
+Device::Device( const Instance& instance,
+				const Window* window,
+				const std::vector<const char*>& extensions )
 	: m_physical( VK_NULL_HANDLE ),
 	m_logical( VK_NULL_HANDLE ),
 	m_window( window ),
 	m_instance( instance ),
 	m_graphicsQueue( VK_NULL_HANDLE ),
-	m_presentQueue( VK_NULL_HANDLE )
+	m_presentQueue( VK_NULL_HANDLE ),
+	m_transferQueue( VK_NULL_HANDLE ),
+	m_cmdBeginRendering( nullptr ),
+	m_cmdEndRendering( nullptr ),
+	m_drawIndirectCount( false )
 {
-	m_physical = PickPhysicalDevice( m_instance.handle(), m_window.surface(), extensions );
-	m_indices = QueueFamily::FindQueueFamilies( m_physical, m_window.surface() );
+	VkSurfaceKHR surface = m_window ? m_window->surface() : VK_NULL_HANDLE;
+	m_physical = PickPhysicalDevice( m_instance.handle(), surface, extensions );
+	m_indices = QueueFamily::FindQueueFamilies( m_physical, surface );
 
 	// Setup queue families for device
-	std::set<uint32_t> uniqueQueueFamilies = { m_indices.graphicsFamily.value(), m_indices.presentFamily.value() };
+	std::set<uint32_t> uniqueQueueFamilies = { m_indices.graphicsFamily.value() };
+	if( m_indices.presentFamily.has_value() )
+		uniqueQueueFamilies.insert( m_indices.presentFamily.value() );
+	if( m_indices.transferFamily.has_value() )
+		uniqueQueueFamilies.insert( m_indices.transferFamily.value() );
 	std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
 
 	float priority = 1.0f;
@@ -42,17 +62,44 @@ Device::Device( const Instance& instance,
 
 	VkPhysicalDeviceFeatures deviceFeatures = {};
 
+	// Frames are paced on a timeline semaphore
+	VkPhysicalDeviceVulkan12Features features12 = {};
+	features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+	features12.timelineSemaphore = VK_TRUE;
+
+	// Draws written by compute shaders, optional
+	m_drawIndirectCount = CheckDrawIndirectCountSupport( m_physical );
+	if( m_drawIndirectCount )
+	{
+		deviceFeatures.multiDrawIndirect = VK_TRUE;
+		deviceFeatures.drawIndirectFirstInstance = VK_TRUE;
+		features12.drawIndirectCount = VK_TRUE;
+	}
+
+	// Render without render pass and framebuffer objects where possible
+	std::vector<const char*> enabledExtensions = extensions;
+	bool dynamicRendering = CheckDynamicRenderingSupport( m_physical );
+	VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeatures = {};
+	dynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+	dynamicRenderingFeatures.dynamicRendering = VK_TRUE;
+	if( dynamicRendering )
+	{
+		enabledExtensions.push_back( VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME );
+		features12.pNext = &dynamicRenderingFeatures;
+	}
+
 	// Setup logical device
 	VkDeviceCreateInfo createInfo = {};
 	createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+	createInfo.pNext = &features12;
 
 	createInfo.queueCreateInfoCount = static_cast<uint32_t>( queueCreateInfos.size() );
 	createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
 	createInfo.pEnabledFeatures = &deviceFeatures;
 
-	createInfo.enabledExtensionCount = static_cast<uint32_t>( extensions.size() );
-	createInfo.ppEnabledExtensionNames = extensions.data();
+	createInfo.enabledExtensionCount = static_cast<uint32_t>( enabledExtensions.size() );
+	createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
 	if( m_instance.validationLayersEnabled() )
 	{
@@ -67,7 +114,17 @@ Device::Device( const Instance& instance,
 
 	// Get handles for graphics and presentation queues
 	vkGetDeviceQueue( m_logical, m_indices.graphicsFamily.value(), 0, &m_graphicsQueue );
-	vkGetDeviceQueue( m_logical, m_indices.presentFamily.value(), 0, &m_presentQueue );
+	if( m_indices.presentFamily.has_value() )
+		vkGetDeviceQueue( m_logical, m_indices.presentFamily.value(), 0, &m_presentQueue );
+	vkGetDeviceQueue( m_logical, transferFamily(), 0, &m_transferQueue );
+
+	if( dynamicRendering )
+	{
+		m_cmdBeginRendering = reinterpret_cast<PFN_vkCmdBeginRenderingKHR>(
+			vkGetDeviceProcAddr( m_logical, "vkCmdBeginRenderingKHR" ) );
+		m_cmdEndRendering = reinterpret_cast<PFN_vkCmdEndRenderingKHR>(
+			vkGetDeviceProcAddr( m_logical, "vkCmdEndRenderingKHR" ) );
+	}
 }
 
 Device::~Device()
@@ -75,6 +132,30 @@ Device::~Device()
 	vkDestroyDevice( m_logical, nullptr );
 }
 
+void Device::cmdBeginRendering( VkCommandBuffer cmd, const VkRenderingInfoKHR& info ) const
+{
+	m_cmdBeginRendering( cmd, &info );
+}
+
+void Device::cmdEndRendering( VkCommandBuffer cmd ) const
+{
+	m_cmdEndRendering( cmd );
+}
+
+uint32_t Device::findMemoryType( uint32_t typeFilter, VkMemoryPropertyFlags properties ) const
+{
+	VkPhysicalDeviceMemoryProperties memProperties;
+	vkGetPhysicalDeviceMemoryProperties( m_physical, &memProperties );
+
+	for( uint32_t i = 0; i < memProperties.memoryTypeCount; i++ )
+	{
+		if( ( typeFilter & ( 1 << i ) ) &&
+			( memProperties.memoryTypes[i].propertyFlags & properties ) == properties )
+			return i;
+	}
+	throw std::runtime_error( "failed to find suitable memory type!" );
+}
+
 bool Device::CheckDeviceExtensionSupport( const VkPhysicalDevice& device,
 										  const std::vector<const char*>& extensions )
 {
@@ -82,7 +163,7 @@ bool Device::CheckDeviceExtensionSupport( const VkPhysicalDevice& device,
 	uint32_t extensionCount;
 	vkEnumerateDeviceExtensionProperties( device, nullptr, &extensionCount, nullptr );
 
-	if( extensionCount < 1 ) return false;
+	if( extensionCount < 1 ) return extensions.empty();
 
 	// Get supported extensions
 	std::vector<VkExtensionProperties> availableExtensions( extensionCount );
@@ -98,6 +179,56 @@ bool Device::CheckDeviceExtensionSupport( const VkPhysicalDevice& device,
 	return requiredExtensions.empty();
 }
 
+bool Device::CheckFeatureSupport( const VkPhysicalDevice& device )
+{
+	// Vulkan 1.2 structures can't be queried on older devices
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties( device, &properties );
+	if( properties.apiVersion < VK_API_VERSION_1_2 )
+		return false;
+
+	VkPhysicalDeviceVulkan12Features features12 = {};
+	features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+	VkPhysicalDeviceFeatures2 features = {};
+	features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	features.pNext = &features12;
+	vkGetPhysicalDeviceFeatures2( device, &features );
+
+	return features12.timelineSemaphore == VK_TRUE;
+}
+
+bool Device::CheckDynamicRenderingSupport( const VkPhysicalDevice& device )
+{
+	if( !CheckDeviceExtensionSupport( device, { VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME } ) )
+		return false;
+
+	VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRendering = {};
+	dynamicRendering.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+
+	VkPhysicalDeviceFeatures2 features = {};
+	features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	features.pNext = &dynamicRendering;
+	vkGetPhysicalDeviceFeatures2( device, &features );
+
+	return dynamicRendering.dynamicRendering == VK_TRUE;
+}
+
+bool Device::CheckDrawIndirectCountSupport( const VkPhysicalDevice& device )
+{
+	VkPhysicalDeviceVulkan12Features features12 = {};
+	features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+	VkPhysicalDeviceFeatures2 features = {};
+	features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	features.pNext = &features12;
+	vkGetPhysicalDeviceFeatures2( device, &features );
+
+	return features12.drawIndirectCount == VK_TRUE &&
+		features.features.multiDrawIndirect == VK_TRUE &&
+		features.features.drawIndirectFirstInstance == VK_TRUE;
+}
+
 VkPhysicalDevice Device::PickPhysicalDevice( const VkInstance& instance,
 											 const VkSurfaceKHR& surface,
 											 const std::vector<const char*>& requiredExtensions )
@@ -116,7 +247,7 @@ VkPhysicalDevice Device::PickPhysicalDevice( const VkInstance& instance,
 	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
 	for( const auto& device : devices )
 	{
-		if( IsDeviceSuitable( device, surface ) )
+		if( IsDeviceSuitable( device, surface, requiredExtensions ) )
 		{
 			physicalDevice = device;
 			break;
@@ -127,11 +258,19 @@ VkPhysicalDevice Device::PickPhysicalDevice( const VkInstance& instance,
 	return physicalDevice;
 }
 
-bool Device::IsDeviceSuitable( const VkPhysicalDevice& device, const VkSurfaceKHR& surface )
+bool Device::IsDeviceSuitable( const VkPhysicalDevice& device,
+							   const VkSurfaceKHR& surface,
+							   const std::vector<const char*>& requiredExtensions )
 {
 	QueueFamilyIndices indices = QueueFamily::FindQueueFamilies( device, surface );
 
-	bool extensionsSupported = CheckDeviceExtensionSupport( device, Instance::DeviceExtensions );
+	bool extensionsSupported = CheckDeviceExtensionSupport( device, requiredExtensions );
+
+	bool featuresSupported = CheckFeatureSupport( device );
+
+	// Nothing to present to in headless mode
+	if( surface == VK_NULL_HANDLE )
+		return indices.isComplete( false ) && extensionsSupported && featuresSupported;
 
 	bool swap_chainAdequate = false;
 	if( extensionsSupported )
@@ -140,5 +279,5 @@ bool Device::IsDeviceSuitable( const VkPhysicalDevice& device, const VkSurfaceKH
 		swap_chainAdequate = !swap_chainSupport.formats.empty() && !swap_chainSupport.presentModes.empty();
 	}
 
-	return indices.isComplete() && extensionsSupported && swap_chainAdequate;
+	return indices.isComplete() && extensionsSupported && featuresSupported && swap_chainAdequate;
 }
@@ -0,0 +1,78 @@
+#include <vulkan/FrameArena.hpp>
+#include <vulkan/FrameScheduler.hpp>
+
+using namespace vulkan;
+
+FrameArena::FrameArena( const Device& device,
+						MemoryAllocator& allocator,
+						VkDeviceSize capacity,
+						VkBufferUsageFlags usage,
+						DeletionQueue* deletion )
+	: m_buffer( device,
+				allocator,
+				capacity,
+				usage,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+				deletion ),
+	m_head( 0 ),
+	m_tail( 0 ),
+	m_used( 0 ),
+	m_frame( 0 ),
+	m_frameBytes( 0 )
+{}
+
+void FrameArena::beginFrame( const FrameScheduler& frames )
+{
+	begin( frames.currentFrame(), [&frames]( uint64_t frame )
+	{
+		return frames.retired( frame );
+	} );
+}
+
+void FrameArena::begin( uint64_t value, const std::function<bool( uint64_t value )>& retired )
+{
+	if( m_frameBytes > 0 )
+		m_frames.push_back( { m_frame, m_head, m_frameBytes } );
+	m_frame = value;
+	m_frameBytes = 0;
+
+	while( !m_frames.empty() && retired( m_frames.front().frame ) )
+	{
+		m_tail = m_frames.front().end;
+		m_used -= m_frames.front().bytes;
+		m_frames.pop_front();
+	}
+}
+
+std::optional<FrameArena::Slice> FrameArena::allocate( VkDeviceSize size, VkDeviceSize alignment )
+{
+	if( m_used == 0 )
+		m_head = m_tail = 0;
+
+	// Live bytes are [tail, head), or [tail, capacity) and [0, head) once wrapped.
+	// head never catches up with tail, equal means empty
+	VkDeviceSize offset = ( m_head + alignment - 1 ) & ~( alignment - 1 );
+	VkDeviceSize taken = 0;
+	if( m_head >= m_tail )
+	{
+		if( offset + size <= capacity() )
+			taken = offset + size - m_head;
+		else if( size < m_tail )
+		{
+			// Skip the end of the ring, it's given back with the frame
+			taken = capacity() - m_head + size;
+			offset = 0;
+		}
+		else
+			return std::nullopt;
+	}
+	else if( offset + size < m_tail )
+		taken = offset + size - m_head;
+	else
+		return std::nullopt;
+
+	m_head = offset + size;
+	m_used += taken;
+	m_frameBytes += taken;
+	return Slice{ m_buffer.handle(), offset, static_cast<char*>( m_buffer.mapped() ) + offset };
+}
@@ -0,0 +1,171 @@
+#include <vulkan/Device.hpp>
+#include <vulkan/FrameScheduler.hpp>
+
+#include <stdexcept>
+
+using namespace vulkan;
+
+FrameScheduler::FrameScheduler( const Device& device, uint32_t numImages, uint32_t maxFramesInFlight )
+	: m_device( device ),
+	m_maxFramesInFlight( maxFramesInFlight ),
+	m_frame( 0 ),
+	m_completed( 0 ),
+	m_timeline( VK_NULL_HANDLE ),
+	m_imageFrames( numImages, 0 )
+{
+	VkSemaphoreTypeCreateInfo typeInfo = {};
+	typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+	typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+	typeInfo.initialValue = 0;
+
+	VkSemaphoreCreateInfo semaphoreInfo = {};
+	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	semaphoreInfo.pNext = &typeInfo;
+
+	if( vkCreateSemaphore( m_device.logical(), &semaphoreInfo, nullptr, &m_timeline ) != VK_SUCCESS )
+		throw std::runtime_error( "failed to create timeline semaphore!" );
+
+	createSemaphores();
+}
+
+FrameScheduler::~FrameScheduler()
+{
+	destroySemaphores();
+	vkDestroySemaphore( m_device.logical(), m_timeline, nullptr );
+}
+
+void FrameScheduler::createSemaphores()
+{
+	size_t first = m_imageAvailable.size();
+	if( first >= m_maxFramesInFlight )
+		return;
+	m_imageAvailable.resize( m_maxFramesInFlight );
+	m_renderFinished.resize( m_maxFramesInFlight );
+
+	VkSemaphoreCreateInfo semaphoreInfo = {};
+	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+	for( size_t i = first; i < m_maxFramesInFlight; i++ )
+	{
+		if( vkCreateSemaphore( m_device.logical(), &semaphoreInfo, nullptr, &m_imageAvailable[i] ) != VK_SUCCESS ||
+			vkCreateSemaphore( m_device.logical(), &semaphoreInfo, nullptr, &m_renderFinished[i] ) != VK_SUCCESS )
+			throw std::runtime_error( "failed to create synchronization objects for a frame!" );
+	}
+}
+
+void FrameScheduler::destroySemaphores()
+{
+	for( size_t i = 0; i < m_imageAvailable.size(); ++i )
+	{
+		vkDestroySemaphore( m_device.logical(), m_renderFinished[i], nullptr );
+		vkDestroySemaphore( m_device.logical(), m_imageAvailable[i], nullptr );
+	}
+	m_imageAvailable.clear();
+	m_renderFinished.clear();
+}
+
+uint64_t FrameScheduler::beginFrame()
+{
+	m_frame++;
+	// The slot was last used maxFramesInFlight frames ago
+	if( m_frame > m_maxFramesInFlight )
+		wait( m_frame - m_maxFramesInFlight );
+	return m_frame;
+}
+
+void FrameScheduler::useImage( uint32_t imageIndex )
+{
+	wait( m_imageFrames[imageIndex] );
+	m_imageFrames[imageIndex] = m_frame;
+}
+
+void FrameScheduler::skipFrame( VkQueue queue )
+{
+	std::vector<VkSemaphore> signalSemaphores;
+	std::vector<uint64_t> signalValues;
+	VkTimelineSemaphoreSubmitInfo timelineInfo = {};
+	VkSubmitInfo submitInfo = {};
+	fillSubmit( submitInfo, timelineInfo, signalSemaphores, signalValues );
+
+	// Goes through the queue so values keep being signaled in order
+	if( vkQueueSubmit( queue, 1, &submitInfo, VK_NULL_HANDLE ) != VK_SUCCESS )
+		throw std::runtime_error( "failed to signal skipped frame!" );
+}
+
+void FrameScheduler::fillSubmit( VkSubmitInfo& submitInfo,
+								 VkTimelineSemaphoreSubmitInfo& timelineInfo,
+								 std::vector<VkSemaphore>& signalSemaphores,
+								 std::vector<uint64_t>& signalValues ) const
+{
+	// Binary semaphores ignore their value
+	signalValues.assign( signalSemaphores.size(), 0 );
+	signalSemaphores.push_back( m_timeline );
+	signalValues.push_back( m_frame );
+
+	timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+	timelineInfo.pNext = submitInfo.pNext;
+	// Callers waiting on timelines fill in their wait values after this
+	timelineInfo.waitSemaphoreValueCount = 0;
+	timelineInfo.pWaitSemaphoreValues = nullptr;
+	timelineInfo.signalSemaphoreValueCount = static_cast<uint32_t>( signalValues.size() );
+	timelineInfo.pSignalSemaphoreValues = signalValues.data();
+
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.pNext = &timelineInfo;
+	submitInfo.signalSemaphoreCount = static_cast<uint32_t>( signalSemaphores.size() );
+	submitInfo.pSignalSemaphores = signalSemaphores.data();
+}
+
+bool FrameScheduler::retired( uint64_t value ) const
+{
+	if( value <= m_completed.load( std::memory_order_acquire ) )
+		return true;
+
+	uint64_t counter = 0;
+	vkGetSemaphoreCounterValue( m_device.logical(), m_timeline, &counter );
+	raiseCompleted( counter );
+	return value <= counter;
+}
+
+void FrameScheduler::wait( uint64_t value ) const
+{
+	if( retired( value ) )
+		return;
+
+	VkSemaphoreWaitInfo waitInfo = {};
+	waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+	waitInfo.semaphoreCount = 1;
+	waitInfo.pSemaphores = &m_timeline;
+	waitInfo.pValues = &value;
+
+	if( vkWaitSemaphores( m_device.logical(), &waitInfo, UINT64_MAX ) != VK_SUCCESS )
+		throw std::runtime_error( "failed to wait for frame timeline!" );
+
+	// Counter may have moved further, but value is a valid lower bound
+	raiseCompleted( value );
+}
+
+void FrameScheduler::raiseCompleted( uint64_t value ) const
+{
+	uint64_t completed = m_completed.load( std::memory_order_relaxed );
+	while( completed < value && !m_completed.compare_exchange_weak( completed, value, std::memory_order_release ) )
+	{}
+}
+
+void FrameScheduler::resizeImages( uint32_t numImages )
+{
+	// Per image resources (command buffers, query slots) are indexed by image and outlive
+	// the swap chain, so an index still waits for the last frame that used it
+	m_imageFrames.resize( numImages, 0 );
+}
+
+void FrameScheduler::setMaxFramesInFlight( uint32_t maxFramesInFlight )
+{
+	if( maxFramesInFlight == m_maxFramesInFlight )
+		return;
+
+	// Slot mapping changes, so nothing may still use the old slots
+	wait( m_frame );
+	m_maxFramesInFlight = maxFramesInFlight;
+	createSemaphores();
+}
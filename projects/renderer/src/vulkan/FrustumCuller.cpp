@@ -0,0 +1,386 @@
+#include <vulkan/FrustumCuller.hpp>
+
+#include "common/trace.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#if defined( __x86_64__ ) || defined( _M_X64 ) || defined( __i386__ ) || defined( _M_IX86 )
+#define BUBBLE_CULL_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+// MSVC compiles any intrinsic, callers check the CPU first
+#define BUBBLE_TARGET_AVX2
+#else
+#define BUBBLE_TARGET_AVX2 __attribute__( ( target( "avx2" ) ) )
+#endif
+#elif defined( __aarch64__ ) || defined( _M_ARM64 ) || defined( __ARM_NEON )
+#define BUBBLE_CULL_NEON
+#include <arm_neon.h>
+#endif
+
+using namespace vulkan;
+
+namespace
+{
+// Arrays of FrustumCuller
+struct Spheres
+{
+	const float* x;
+	const float* y;
+	const float* z;
+	const float* radius;
+};
+
+// Indices are written unconditionally and kept by advancing the count, no branch to mispredict
+uint32_t CullScalar( const Spheres& spheres, const Frustum& frustum, uint32_t first, uint32_t end, uint32_t* visible )
+{
+	uint32_t count = 0;
+	for( uint32_t i = first; i < end; i++ )
+	{
+		bool inside = true;
+		for( const glm::vec4& plane : frustum.planes )
+		{
+			float distance = plane.x * spheres.x[i] + plane.y * spheres.y[i] + plane.z * spheres.z[i] + plane.w;
+			inside &= distance >= -spheres.radius[i];
+		}
+		visible[count] = i;
+		count += inside ? 1 : 0;
+	}
+	return count;
+}
+
+#ifdef BUBBLE_CULL_X86
+uint32_t CullSse( const Spheres& spheres, const Frustum& frustum, uint32_t first, uint32_t end, uint32_t* visible )
+{
+	__m128 planes[6][4];
+	for( int p = 0; p < 6; p++ )
+		for( int c = 0; c < 4; c++ )
+			planes[p][c] = _mm_set1_ps( frustum.planes[p][c] );
+
+	uint32_t count = 0;
+	uint32_t i = first;
+	for( ; i + 4 <= end; i += 4 )
+	{
+		__m128 x = _mm_loadu_ps( spheres.x + i );
+		__m128 y = _mm_loadu_ps( spheres.y + i );
+		__m128 z = _mm_loadu_ps( spheres.z + i );
+		__m128 negRadius = _mm_sub_ps( _mm_setzero_ps(), _mm_loadu_ps( spheres.radius + i ) );
+
+		__m128 inside = _mm_castsi128_ps( _mm_set1_epi32( -1 ) );
+		for( int p = 0; p < 6; p++ )
+		{
+			__m128 distance = _mm_add_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( planes[p][0], x ),
+																  _mm_mul_ps( planes[p][1], y ) ),
+													  _mm_mul_ps( planes[p][2], z ) ),
+										  planes[p][3] );
+			inside = _mm_and_ps( inside, _mm_cmpge_ps( distance, negRadius ) );
+		}
+
+		int mask = _mm_movemask_ps( inside );
+		for( uint32_t lane = 0; lane < 4; lane++ )
+		{
+			visible[count] = i + lane;
+			count += ( mask >> lane ) & 1;
+		}
+	}
+	return count + CullScalar( spheres, frustum, i, end, visible + count );
+}
+
+// Lanes to gather for every 8 bit visibility mask, the visible ones first
+struct CompactTable
+{
+	alignas( 32 ) uint32_t lanes[256][8];
+
+	CompactTable()
+	{
+		for( uint32_t mask = 0; mask < 256; mask++ )
+		{
+			uint32_t count = 0;
+			for( uint32_t lane = 0; lane < 8; lane++ )
+				if( mask & ( 1u << lane ) )
+					lanes[mask][count++] = lane;
+			while( count < 8 )
+				lanes[mask][count++] = 0;
+		}
+	}
+};
+const CompactTable Compact;
+
+// Compacts 8 indices at once with a lane permutation, stores all 8 and keeps the visible ones.
+// The store stays inside the range's room: at most i - first indices were kept before it
+BUBBLE_TARGET_AVX2 uint32_t CullAvx2( const Spheres& spheres, const Frustum& frustum, uint32_t first, uint32_t end, uint32_t* visible )
+{
+	__m256 planes[6][4];
+	for( int p = 0; p < 6; p++ )
+		for( int c = 0; c < 4; c++ )
+			planes[p][c] = _mm256_set1_ps( frustum.planes[p][c] );
+
+	const __m256i laneOffsets = _mm256_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7 );
+	uint32_t count = 0;
+	uint32_t i = first;
+	for( ; i + 8 <= end; i += 8 )
+	{
+		__m256 x = _mm256_loadu_ps( spheres.x + i );
+		__m256 y = _mm256_loadu_ps( spheres.y + i );
+		__m256 z = _mm256_loadu_ps( spheres.z + i );
+		__m256 negRadius = _mm256_sub_ps( _mm256_setzero_ps(), _mm256_loadu_ps( spheres.radius + i ) );
+
+		__m256 inside = _mm256_castsi256_ps( _mm256_set1_epi32( -1 ) );
+		for( int p = 0; p < 6; p++ )
+		{
+			__m256 distance = _mm256_add_ps( _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( planes[p][0], x ),
+																		   _mm256_mul_ps( planes[p][1], y ) ),
+															_mm256_mul_ps( planes[p][2], z ) ),
+											 planes[p][3] );
+			inside = _mm256_and_ps( inside, _mm256_cmp_ps( distance, negRadius, _CMP_GE_OQ ) );
+		}
+
+		uint32_t mask = static_cast<uint32_t>( _mm256_movemask_ps( inside ) );
+		__m256i indices = _mm256_add_epi32( _mm256_set1_epi32( static_cast<int>( i ) ), laneOffsets );
+		__m256i permutation = _mm256_load_si256( reinterpret_cast<const __m256i*>( Compact.lanes[mask] ) );
+		_mm256_storeu_si256( reinterpret_cast<__m256i*>( visible + count ), _mm256_permutevar8x32_epi32( indices, permutation ) );
+		count += std::popcount( mask );
+	}
+	return count + CullScalar( spheres, frustum, i, end, visible + count );
+}
+
+bool CpuHasAvx2()
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid( info, 0 );
+	if( info[0] < 7 )
+		return false;
+	__cpuid( info, 1 );
+	// The OS saves the AVX registers
+	bool osAvx = ( info[2] & ( 1 << 27 ) ) && ( info[2] & ( 1 << 28 ) ) && ( _xgetbv( 0 ) & 6 ) == 6;
+	__cpuidex( info, 7, 0 );
+	return osAvx && ( info[1] & ( 1 << 5 ) );
+#else
+	return __builtin_cpu_supports( "avx2" );
+#endif
+}
+#endif
+
+#ifdef BUBBLE_CULL_NEON
+uint32_t CullNeon( const Spheres& spheres, const Frustum& frustum, uint32_t first, uint32_t end, uint32_t* visible )
+{
+	float32x4_t planes[6][4];
+	for( int p = 0; p < 6; p++ )
+		for( int c = 0; c < 4; c++ )
+			planes[p][c] = vdupq_n_f32( frustum.planes[p][c] );
+
+	uint32_t count = 0;
+	uint32_t i = first;
+	for( ; i + 4 <= end; i += 4 )
+	{
+		float32x4_t x = vld1q_f32( spheres.x + i );
+		float32x4_t y = vld1q_f32( spheres.y + i );
+		float32x4_t z = vld1q_f32( spheres.z + i );
+		float32x4_t negRadius = vnegq_f32( vld1q_f32( spheres.radius + i ) );
+
+		uint32x4_t inside = vdupq_n_u32( ~0u );
+		for( int p = 0; p < 6; p++ )
+		{
+			float32x4_t distance = vaddq_f32( vaddq_f32( vaddq_f32( vmulq_f32( planes[p][0], x ),
+																	vmulq_f32( planes[p][1], y ) ),
+														 vmulq_f32( planes[p][2], z ) ),
+											  planes[p][3] );
+			inside = vandq_u32( inside, vcgeq_f32( distance, negRadius ) );
+		}
+
+		// Lanes are all ones or all zeros
+		uint32_t lanes[4];
+		vst1q_u32( lanes, inside );
+		for( uint32_t lane = 0; lane < 4; lane++ )
+		{
+			visible[count] = i + lane;
+			count += lanes[lane] & 1;
+		}
+	}
+	return count + CullScalar( spheres, frustum, i, end, visible + count );
+}
+#endif
+
+// Deterministic across runs, the benchmark compares like with like
+uint32_t NextRandom( uint32_t& state )
+{
+	state = state * 1664525u + 1013904223u;
+	return state >> 8;
+}
+
+float RandomFloat( uint32_t& state, float min, float max )
+{
+	return min + ( max - min ) * ( NextRandom( state ) / static_cast<float>( 1u << 24 ) );
+}
+}  // namespace
+
+Frustum Frustum::FromViewProjection( const glm::mat4& viewProjection )
+{
+	glm::vec4 rows[4];
+	for( int i = 0; i < 4; i++ )
+		rows[i] = glm::vec4( viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i] );
+
+	// Left, right, bottom, top, near and far of -w <= x, y, z <= w
+	Frustum frustum;
+	frustum.planes = { rows[3] + rows[0], rows[3] - rows[0],
+					   rows[3] + rows[1], rows[3] - rows[1],
+					   rows[3] + rows[2], rows[3] - rows[2] };
+	for( glm::vec4& plane : frustum.planes )
+		plane /= glm::length( glm::vec3( plane ) );
+	return frustum;
+}
+
+FrustumCuller::Kernel FrustumCuller::DefaultKernel()
+{
+	static const Kernel kernel = []
+	{
+		for( Kernel candidate : { Kernel::Avx2, Kernel::Neon, Kernel::Sse } )
+			if( Supported( candidate ) )
+				return candidate;
+		return Kernel::Scalar;
+	}();
+	return kernel;
+}
+
+bool FrustumCuller::Supported( Kernel kernel )
+{
+	switch( kernel )
+	{
+		case Kernel::Scalar:
+			return true;
+#ifdef BUBBLE_CULL_X86
+		case Kernel::Sse:
+			return true;
+		case Kernel::Avx2:
+		{
+			static const bool avx2 = CpuHasAvx2();
+			return avx2;
+		}
+#endif
+#ifdef BUBBLE_CULL_NEON
+		case Kernel::Neon:
+			return true;
+#endif
+		default:
+			return false;
+	}
+}
+
+const char* FrustumCuller::KernelName( Kernel kernel )
+{
+	switch( kernel )
+	{
+		case Kernel::Scalar: return "scalar";
+		case Kernel::Sse: return "SSE";
+		case Kernel::Avx2: return "AVX2";
+		case Kernel::Neon: return "NEON";
+	}
+	return "";
+}
+
+uint32_t FrustumCuller::add( const glm::vec3& center, float radius )
+{
+	m_x.push_back( center.x );
+	m_y.push_back( center.y );
+	m_z.push_back( center.z );
+	m_radius.push_back( radius );
+	return size() - 1;
+}
+
+void FrustumCuller::set( uint32_t index, const glm::vec3& center, float radius )
+{
+	m_x[index] = center.x;
+	m_y[index] = center.y;
+	m_z[index] = center.z;
+	m_radius[index] = radius;
+}
+
+void FrustumCuller::reserve( uint32_t count )
+{
+	for( std::vector<float>* array : { &m_x, &m_y, &m_z, &m_radius } )
+		array->reserve( count );
+}
+
+void FrustumCuller::clear()
+{
+	for( std::vector<float>* array : { &m_x, &m_y, &m_z, &m_radius } )
+		array->clear();
+}
+
+uint32_t FrustumCuller::cull( const Frustum& frustum, uint32_t first, uint32_t count, uint32_t* visible, Kernel kernel ) const
+{
+	Spheres spheres = { m_x.data(), m_y.data(), m_z.data(), m_radius.data() };
+	uint32_t end = first + count;
+	switch( kernel )
+	{
+#ifdef BUBBLE_CULL_X86
+		case Kernel::Sse:
+			return CullSse( spheres, frustum, first, end, visible );
+		case Kernel::Avx2:
+			if( Supported( Kernel::Avx2 ) )
+				return CullAvx2( spheres, frustum, first, end, visible );
+			return CullSse( spheres, frustum, first, end, visible );
+#endif
+#ifdef BUBBLE_CULL_NEON
+		case Kernel::Neon:
+			return CullNeon( spheres, frustum, first, end, visible );
+#endif
+		default:
+			return CullScalar( spheres, frustum, first, end, visible );
+	}
+}
+
+void FrustumCuller::cull( const Frustum& frustum, std::vector<uint32_t>& visible, Kernel kernel ) const
+{
+	visible.resize( size() );
+	visible.resize( cull( frustum, 0, size(), visible.data(), kernel ) );
+}
+
+std::vector<FrustumCuller::BenchmarkResult> FrustumCuller::Benchmark( uint32_t objectCount, uint32_t iterations )
+{
+	// Spheres filling a cube around a camera at its center, about a sixth of them in view
+	const float extent = 100.0f;
+	uint32_t state = 1;
+	FrustumCuller culler;
+	culler.reserve( objectCount );
+	for( uint32_t i = 0; i < objectCount; i++ )
+	{
+		glm::vec3 center( RandomFloat( state, -extent, extent ), RandomFloat( state, -extent, extent ), RandomFloat( state, -extent, extent ) );
+		culler.add( center, RandomFloat( state, 0.5f, 2.0f ) );
+	}
+	glm::mat4 projection = glm::perspective( glm::radians( 60.0f ), 16.0f / 9.0f, 0.5f, extent * 1.5f );
+	glm::mat4 view = glm::lookAt( glm::vec3( 0.0f ), glm::vec3( 0.3f, 0.1f, 1.0f ), glm::vec3( 0.0f, 1.0f, 0.0f ) );
+	Frustum frustum = Frustum::FromViewProjection( projection * view );
+
+	std::vector<uint32_t> reference;
+	culler.cull( frustum, reference, Kernel::Scalar );
+
+	std::vector<BenchmarkResult> results;
+	std::vector<uint32_t> visible;
+	for( Kernel kernel : { Kernel::Scalar, Kernel::Sse, Kernel::Avx2, Kernel::Neon } )
+	{
+		if( !Supported( kernel ) )
+			continue;
+
+		// The first run warms the caches and the output
+		culler.cull( frustum, visible, kernel );
+		uint64_t best = std::numeric_limits<uint64_t>::max();
+		for( uint32_t iteration = 0; iteration < iterations; iteration++ )
+		{
+			uint64_t start = Tracer::Now();
+			culler.cull( frustum, visible, kernel );
+			best = std::min( best, Tracer::Now() - start );
+		}
+		results.push_back( { kernel,
+							 static_cast<double>( best ) / std::max( objectCount, 1u ),
+							 static_cast<uint32_t>( visible.size() ),
+							 visible == reference } );
+	}
+	return results;
+}
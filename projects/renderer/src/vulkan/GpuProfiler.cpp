@@ -0,0 +1,162 @@
+#include <vulkan/GpuProfiler.hpp>
+#include <vulkan/DeletionQueue.hpp>
+#include <vulkan/Device.hpp>
+
+#include "common/trace.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+
+using namespace vulkan;
+
+static const char* GpuZoneNames[] = { "GPU Scene", "GPU ImGui", "GPU Cull" };
+
+GpuProfiler::GpuProfiler( const Device& device, uint32_t numSlots, DeletionQueue* deletion )
+	: m_device( device ),
+	m_deletion( deletion ),
+	m_pool( VK_NULL_HANDLE ),
+	m_supported( false ),
+	m_timestampPeriod( 1.0f ),
+	m_timestampMask( ~0ull ),
+	m_lastDurationMs{},
+	m_anchored( false ),
+	m_gpuAnchor( 0 ),
+	m_cpuAnchor( 0 )
+{
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties( m_device.physical(), &properties );
+
+	uint32_t familyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties( m_device.physical(), &familyCount, nullptr );
+	std::vector<VkQueueFamilyProperties> families( familyCount );
+	vkGetPhysicalDeviceQueueFamilyProperties( m_device.physical(), &familyCount, families.data() );
+
+	uint32_t validBits = families[m_device.queueFamilyIndices().graphicsFamily.value()].timestampValidBits;
+	m_supported = properties.limits.timestampComputeAndGraphics && validBits > 0;
+	m_timestampPeriod = properties.limits.timestampPeriod;
+	if( validBits > 0 && validBits < 64 )
+		m_timestampMask = ( 1ull << validBits ) - 1;
+
+	createQueryPool( numSlots );
+}
+
+GpuProfiler::~GpuProfiler()
+{
+	destroyQueryPool();
+}
+
+void GpuProfiler::recreate( uint32_t numSlots )
+{
+	// Same slots, queries of frames in flight stay valid
+	if( numSlots == m_pending.size() )
+		return;
+
+	VkDevice device = m_device.logical();
+	VkQueryPool oldPool = m_pool;
+	m_pool = VK_NULL_HANDLE;
+	if( oldPool != VK_NULL_HANDLE )
+		DeletionQueue::Defer( m_deletion, [device, oldPool]
+		{
+			vkDestroyQueryPool( device, oldPool, nullptr );
+		} );
+	createQueryPool( numSlots );
+}
+
+void GpuProfiler::createQueryPool( uint32_t numSlots )
+{
+	m_pending.assign( numSlots, false );
+	m_submitTimes.assign( numSlots, 0 );
+
+	if( !m_supported )
+		return;
+
+	VkQueryPoolCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	createInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	createInfo.queryCount = numSlots * QueriesPerSlot;
+
+	if( vkCreateQueryPool( m_device.logical(), &createInfo, nullptr, &m_pool ) != VK_SUCCESS )
+		throw std::runtime_error( "failed to create timestamp query pool!" );
+}
+
+void GpuProfiler::destroyQueryPool()
+{
+	if( m_pool != VK_NULL_HANDLE )
+	{
+		vkDestroyQueryPool( m_device.logical(), m_pool, nullptr );
+		m_pool = VK_NULL_HANDLE;
+	}
+}
+
+void GpuProfiler::reset( VkCommandBuffer cmd, uint32_t slot ) const
+{
+	if( m_supported )
+		vkCmdResetQueryPool( cmd, m_pool, slot * QueriesPerSlot, QueriesPerSlot );
+}
+
+void GpuProfiler::beginZone( VkCommandBuffer cmd, uint32_t slot, GpuZone zone ) const
+{
+	if( m_supported )
+		vkCmdWriteTimestamp( cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_pool,
+							 slot * QueriesPerSlot + 2 * static_cast<uint32_t>( zone ) );
+}
+
+void GpuProfiler::endZone( VkCommandBuffer cmd, uint32_t slot, GpuZone zone ) const
+{
+	if( m_supported )
+		vkCmdWriteTimestamp( cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_pool,
+							 slot * QueriesPerSlot + 2 * static_cast<uint32_t>( zone ) + 1 );
+}
+
+void GpuProfiler::submitted( uint32_t slot, uint64_t cpuTime )
+{
+	m_pending[slot] = true;
+	m_submitTimes[slot] = cpuTime;
+}
+
+void GpuProfiler::collect( uint32_t slot )
+{
+	if( !m_supported || !m_pending[slot] )
+		return;
+
+	uint64_t ticks[QueriesPerSlot];
+	VkResult result = vkGetQueryPoolResults( m_device.logical(), m_pool,
+											 slot * QueriesPerSlot, QueriesPerSlot,
+											 sizeof( ticks ), ticks, sizeof( uint64_t ),
+											 VK_QUERY_RESULT_64_BIT );
+	// Still in flight, try again next time the slot comes around
+	if( result != VK_SUCCESS )
+		return;
+	m_pending[slot] = false;
+
+	auto toNs = [this]( uint64_t tick )
+	{
+		return static_cast<uint64_t>( static_cast<double>( tick & m_timestampMask ) * m_timestampPeriod );
+	};
+
+	// Re-anchor whenever drift would put GPU work before its own submission. On the earliest
+	// zone of the slot: zones aren't written in enum order (the Cull prologue comes first)
+	uint64_t first = UINT64_MAX;
+	for( uint32_t zone = 0; zone < static_cast<uint32_t>( GpuZone::Count ); zone++ )
+		first = std::min( first, toNs( ticks[2 * zone] ) );
+	if( !m_anchored || m_cpuAnchor + ( first - m_gpuAnchor ) < m_submitTimes[slot] || first < m_gpuAnchor )
+	{
+		m_gpuAnchor = first;
+		m_cpuAnchor = m_submitTimes[slot];
+		m_anchored = true;
+	}
+
+	Tracer& tracer = Tracer::Get();
+	for( uint32_t zone = 0; zone < static_cast<uint32_t>( GpuZone::Count ); zone++ )
+	{
+		uint64_t begin = toNs( ticks[2 * zone] );
+		uint64_t end = toNs( ticks[2 * zone + 1] );
+		if( end < begin || begin < m_gpuAnchor )
+			continue;
+
+		m_lastDurationMs[zone] = ( end - begin ) / 1e6;
+		if( tracer.enabled() )
+			tracer.record( GpuZoneNames[zone], "gpu", m_cpuAnchor + ( begin - m_gpuAnchor ), end - begin, Tracer::GpuThread );
+	}
+}
@@ -0,0 +1,216 @@
+#include <vulkan/GpuScene.hpp>
+#include <vulkan/CommandBuffers.hpp>
+#include <vulkan/ComputePipeline.hpp>
+#include <vulkan/DeletionQueue.hpp>
+#include <vulkan/Device.hpp>
+#include <vulkan/FrustumCuller.hpp>
+#include <vulkan/Mesh.hpp>
+#include <vulkan/UploadManager.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+
+using namespace vulkan;
+
+// cull.comp's local size
+const uint32_t CullGroupSize = 64;
+
+GpuScene::GpuScene( const Device& device,
+					MemoryAllocator& allocator,
+					UploadManager& uploads,
+					std::vector<const Mesh*> meshes,
+					std::span<const Object> objects,
+					VkDescriptorSetLayout cullSetLayout,
+					VkDescriptorSetLayout drawSetLayout,
+					DeletionQueue* deletion )
+	: m_device( device ),
+	m_deletion( deletion ),
+	m_meshes( std::move( meshes ) ),
+	m_meshObjects( m_meshes.size(), 0 ),
+	m_firstCommands( m_meshes.size(), 0 ),
+	m_objectCount( static_cast<uint32_t>( objects.size() ) ),
+	m_uploadValue( 0 ),
+	m_pool( VK_NULL_HANDLE ),
+	m_cullSet( VK_NULL_HANDLE ),
+	m_drawSet( VK_NULL_HANDLE )
+{
+	if( m_meshes.empty() || objects.empty() )
+		throw std::runtime_error( "gpu scene has nothing to draw!" );
+	for( const Mesh* mesh : m_meshes )
+		if( mesh->layout() != VertexLayout::Interleaved )
+			throw std::runtime_error( "gpu scene meshes must be interleaved!" );
+
+	// Split in the two arrays cull.comp reads, counting the objects of every mesh
+	std::vector<InstanceBuffer::Instance> instances( objects.size() );
+	std::vector<uint32_t> objectMeshes( objects.size() );
+	for( size_t i = 0; i < objects.size(); i++ )
+	{
+		if( objects[i].mesh >= m_meshes.size() )
+			throw std::runtime_error( "gpu scene object of an unknown mesh!" );
+		instances[i] = objects[i].instance;
+		objectMeshes[i] = objects[i].mesh;
+		m_meshObjects[objects[i].mesh]++;
+	}
+
+	// Every object of a mesh may be visible, its range holds that many commands
+	std::vector<MeshInfo> meshInfos( m_meshes.size() );
+	uint32_t firstCommand = 0;
+	for( size_t i = 0; i < m_meshes.size(); i++ )
+	{
+		const Mesh& mesh = *m_meshes[i];
+		glm::vec3 center = ( mesh.boundsMin() + mesh.boundsMax() ) * 0.5f;
+		float radius = glm::length( mesh.boundsMax() - mesh.boundsMin() ) * 0.5f;
+		meshInfos[i] = { glm::vec4( center, radius ), mesh.indexCount(), firstCommand, { 0, 0 } };
+		m_firstCommands[i] = firstCommand;
+		firstCommand += m_meshObjects[i];
+	}
+
+	auto createBuffer = [&]( VkDeviceSize size, VkBufferUsageFlags usage )
+	{
+		return CreateScope<Buffer>( m_device,
+									allocator,
+									size,
+									usage | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+									VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+									m_deletion );
+	};
+	m_instances = createBuffer( instances.size() * sizeof( InstanceBuffer::Instance ), VK_BUFFER_USAGE_TRANSFER_DST_BIT );
+	m_objectMeshes = createBuffer( objectMeshes.size() * sizeof( uint32_t ), VK_BUFFER_USAGE_TRANSFER_DST_BIT );
+	m_meshInfos = createBuffer( meshInfos.size() * sizeof( MeshInfo ), VK_BUFFER_USAGE_TRANSFER_DST_BIT );
+	m_commands = createBuffer( m_objectCount * sizeof( VkDrawIndexedIndirectCommand ), VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT );
+	// Cleared by cull() every frame
+	m_counts = createBuffer( m_meshes.size() * sizeof( uint32_t ),
+							 VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT );
+
+	// A flush in between can split them over two batches, the later one counts
+	auto upload = [&]( const Buffer& buffer, const auto& data )
+	{
+		m_uploadValue = std::max( m_uploadValue, uploads.upload( buffer, 0, data.data(), data.size() * sizeof( data[0] ) ) );
+	};
+	upload( *m_instances, instances );
+	upload( *m_objectMeshes, objectMeshes );
+	upload( *m_meshInfos, meshInfos );
+
+	createDescriptorSets( cullSetLayout, drawSetLayout );
+}
+
+GpuScene::~GpuScene()
+{
+	// Sets go with the pool, frames in flight may still use them
+	VkDevice device = m_device.logical();
+	VkDescriptorPool pool = m_pool;
+	DeletionQueue::Defer( m_deletion, [device, pool]()
+	{
+		vkDestroyDescriptorPool( device, pool, nullptr );
+	} );
+}
+
+bool GpuScene::ready( const UploadManager& uploads ) const
+{
+	if( m_uploadValue > uploads.submitted() )
+		return false;
+	return std::all_of( m_meshes.begin(), m_meshes.end(), [&uploads]( const Mesh* mesh )
+	{
+		return mesh->ready( uploads );
+	} );
+}
+
+void GpuScene::cull( VkCommandBuffer cmd, const ComputePipeline& pipeline, const glm::mat4& viewProjection ) const
+{
+	// The previous frame's draws are done reading the commands and counts about to be rewritten
+	CommandBuffers::IndirectReuseBarrier( cmd );
+	vkCmdFillBuffer( cmd, m_counts->handle(), 0, VK_WHOLE_SIZE, 0 );
+
+	VkMemoryBarrier cleared = {};
+	cleared.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	cleared.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	cleared.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	vkCmdPipelineBarrier( cmd,
+						  VK_PIPELINE_STAGE_TRANSFER_BIT,
+						  VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+						  0,
+						  1, &cleared,
+						  0, nullptr,
+						  0, nullptr );
+
+	CullConstants constants = {};
+	Frustum frustum = Frustum::FromViewProjection( viewProjection );
+	std::copy( frustum.planes.begin(), frustum.planes.end(), constants.planes );
+	constants.objectCount = m_objectCount;
+
+	pipeline.bind( cmd );
+	vkCmdBindDescriptorSets( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.layout(), 0, 1, &m_cullSet, 0, nullptr );
+	// Up to the last member, the block has no tail padding
+	vkCmdPushConstants( cmd, pipeline.layout(), VK_SHADER_STAGE_COMPUTE_BIT, 0,
+						offsetof( CullConstants, objectCount ) + sizeof( uint32_t ), &constants );
+	vkCmdDispatch( cmd, ComputePipeline::GroupCount( m_objectCount, CullGroupSize ), 1, 1 );
+
+	CommandBuffers::ComputeToIndirectBarrier( cmd );
+}
+
+void GpuScene::draw( VkCommandBuffer cmd, VkPipelineLayout layout ) const
+{
+	vkCmdBindDescriptorSets( cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 0, 1, &m_drawSet, 0, nullptr );
+	for( size_t i = 0; i < m_meshes.size(); i++ )
+	{
+		if( m_meshObjects[i] == 0 )
+			continue;
+		m_meshes[i]->bind( cmd );
+		CommandBuffers::DrawIndexedIndirectCount( cmd,
+												  *m_commands,
+												  m_firstCommands[i] * sizeof( VkDrawIndexedIndirectCommand ),
+												  *m_counts,
+												  i * sizeof( uint32_t ),
+												  m_meshObjects[i] );
+	}
+}
+
+void GpuScene::createDescriptorSets( VkDescriptorSetLayout cullSetLayout, VkDescriptorSetLayout drawSetLayout )
+{
+	// Five buffers for culling, the instances again for drawing
+	VkDescriptorPoolSize poolSize = {};
+	poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	poolSize.descriptorCount = 6;
+
+	VkDescriptorPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.maxSets = 2;
+	poolInfo.poolSizeCount = 1;
+	poolInfo.pPoolSizes = &poolSize;
+	if( vkCreateDescriptorPool( m_device.logical(), &poolInfo, nullptr, &m_pool ) != VK_SUCCESS )
+		throw std::runtime_error( "failed to create gpu scene descriptor pool!" );
+
+	VkDescriptorSetLayout layouts[] = { cullSetLayout, drawSetLayout };
+	VkDescriptorSet sets[2];
+	VkDescriptorSetAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = m_pool;
+	allocInfo.descriptorSetCount = 2;
+	allocInfo.pSetLayouts = layouts;
+	if( vkAllocateDescriptorSets( m_device.logical(), &allocInfo, sets ) != VK_SUCCESS )
+	{
+		vkDestroyDescriptorPool( m_device.logical(), m_pool, nullptr );
+		throw std::runtime_error( "failed to allocate gpu scene descriptor sets!" );
+	}
+	m_cullSet = sets[0];
+	m_drawSet = sets[1];
+
+	// Bindings 0 to 4 of cull.comp, binding 0 of the draw set
+	const Buffer* cullBuffers[] = { m_instances.get(), m_objectMeshes.get(), m_meshInfos.get(), m_commands.get(), m_counts.get() };
+	VkDescriptorBufferInfo infos[6];
+	VkWriteDescriptorSet writes[6] = {};
+	for( uint32_t i = 0; i < 6; i++ )
+	{
+		const Buffer& buffer = i < 5 ? *cullBuffers[i] : *m_instances;
+		infos[i] = { buffer.handle(), 0, VK_WHOLE_SIZE };
+
+		writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[i].dstSet = i < 5 ? m_cullSet : m_drawSet;
+		writes[i].dstBinding = i < 5 ? i : 0;
+		writes[i].descriptorCount = 1;
+		writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		writes[i].pBufferInfo = &infos[i];
+	}
+	vkUpdateDescriptorSets( m_device.logical(), 6, writes, 0, nullptr );
+}
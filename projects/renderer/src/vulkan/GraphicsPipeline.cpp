@@ -1,50 +1,271 @@
 #include <vulkan/GraphicsPipeline.hpp>
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <fstream>
+#include <vulkan/DeletionQueue.hpp>
 #include <vulkan/Device.hpp>
-#include <vulkan/RenderPass.hpp>
-#include <vulkan/SwapChain.hpp>
+#include <vulkan/PipelineCache.hpp>
+#include <vulkan/PipelineLayoutCache.hpp>
+#include <vulkan/RenderGraph.hpp>
 #include <vulkan/Shader.hpp>
+#include <vulkan/ShaderCompiler.hpp>
 
-#include "base_frag.h"
-#include "base_vert.h"
+#include "common/hash.hpp"
+#include "common/job_system.hpp"
+#include "common/trace.hpp"
 
 using namespace vulkan;
 
+void PipelineDesc::setTarget( const RenderGraph& graph, uint32_t pass )
+{
+	RenderGraph::PipelineTarget target = graph.pipelineTarget( pass );
+	renderPass = target.renderPass;
+	subpass = target.subpass;
+	colorFormats = graph.colorFormats( pass );
+}
+
+uint64_t PipelineDesc::hash() const
+{
+	uint64_t hash = HashSeed;
+	hash = HashValue( shaders.Vert->GetHash(), hash );
+	hash = HashValue( shaders.Frag->GetHash(), hash );
+	for( const auto& binding : vertexBindings )
+		hash = HashValue( binding, hash );
+	hash = HashValue( vertexBindings.size(), hash );
+	for( const auto& attribute : vertexAttributes )
+		hash = HashValue( attribute, hash );
+	hash = HashValue( vertexAttributes.size(), hash );
+
+	hash = HashValue( topology, hash );
+	hash = HashValue( polygonMode, hash );
+	hash = HashValue( cullMode, hash );
+	hash = HashValue( frontFace, hash );
+	hash = HashValue( alphaBlend, hash );
+	hash = HashValue( depthTest, hash );
+	hash = HashValue( depthWrite, hash );
+	hash = HashValue( depthCompare, hash );
+
+	hash = HashValue( layout, hash );
+	hash = HashValue( renderPass, hash );
+	hash = HashValue( subpass, hash );
+	for( VkFormat format : colorFormats )
+		hash = HashValue( format, hash );
+	hash = HashValue( colorFormats.size(), hash );
+	return HashValue( depthFormat, hash );
+}
+
+bool PipelineDesc::operator==( const PipelineDesc& other ) const
+{
+	auto sameBindings = []( const auto& a, const auto& b )
+	{
+		return a.size() == b.size() && std::equal( a.begin(), a.end(), b.begin(), []( const auto& x, const auto& y )
+		{
+			return std::memcmp( &x, &y, sizeof( x ) ) == 0;
+		} );
+	};
+
+	auto sameCode = []( const Ref<Shader>& a, const Ref<Shader>& b )
+	{
+		std::span<const uint32_t> codeA = a->GetShaderData();
+		std::span<const uint32_t> codeB = b->GetShaderData();
+		return a == b || std::equal( codeA.begin(), codeA.end(), codeB.begin(), codeB.end() );
+	};
+
+	return sameCode( shaders.Vert, other.shaders.Vert ) &&
+		sameCode( shaders.Frag, other.shaders.Frag ) &&
+		sameBindings( vertexBindings, other.vertexBindings ) &&
+		sameBindings( vertexAttributes, other.vertexAttributes ) &&
+		topology == other.topology &&
+		polygonMode == other.polygonMode &&
+		cullMode == other.cullMode &&
+		frontFace == other.frontFace &&
+		alphaBlend == other.alphaBlend &&
+		depthTest == other.depthTest &&
+		depthWrite == other.depthWrite &&
+		depthCompare == other.depthCompare &&
+		layout == other.layout &&
+		renderPass == other.renderPass &&
+		subpass == other.subpass &&
+		colorFormats == other.colorFormats &&
+		depthFormat == other.depthFormat;
+}
+
 GraphicsPipeline::GraphicsPipeline( const Device& device,
-									const SwapChain& swap_chain,
-									const RenderPass& render_pass,
-									Shaders shaders )
+									const RenderGraph& graph,
+									uint32_t pass,
+									PipelineDesc desc,
+									const PipelineCache* cache,
+									DeletionQueue* deletion )
 	: m_pipeline( VK_NULL_HANDLE ),
-	m_layout( VK_NULL_HANDLE ),
-	m_oldLayout( VK_NULL_HANDLE ),
 	m_device( device ),
-	m_swap_chain( swap_chain ),
-	m_render_pass( render_pass ),
-	mShaders( shaders )
+	m_cache( cache ),
+	m_deletion( deletion ),
+	m_graph( graph ),
+	m_pass( pass ),
+	m_desc( std::move( desc ) ),
+	m_reflectLayout( m_desc.layout == VK_NULL_HANDLE ),
+	m_generation( 0 ),
+	m_reloadStale( false )
 {
+	if( !m_cache )
+		m_ownLayouts = CreateScope<PipelineLayoutCache>( m_device );
+	if( m_reflectLayout )
+		m_desc.layout = layouts().get( m_desc.shaders ).layout;
+
 	createPipeline();
 }
 
 GraphicsPipeline::~GraphicsPipeline()
 {
+	m_reload.drain();
+	if( m_reloaded )
+		vkDestroyPipeline( m_device.logical(), m_reloaded->pipeline, nullptr );
+
 	vkDestroyPipeline( m_device.logical(), m_pipeline, nullptr );
-	vkDestroyPipelineLayout( m_device.logical(), m_layout, nullptr );
 }
 
 void GraphicsPipeline::recreate()
 {
-	vkDestroyPipeline( m_device.logical(), m_pipeline, nullptr );
-	vkDestroyPipelineLayout( m_device.logical(), m_layout, nullptr );
+	// Frames in flight may still be drawing with the old pipeline, layouts don't depend on the targets
+	VkDevice device = m_device.logical();
+	VkPipeline oldPipeline = m_pipeline;
+	DeletionQueue::Defer( m_deletion, [device, oldPipeline]
+	{
+		vkDestroyPipeline( device, oldPipeline, nullptr );
+	} );
+	m_generation++;
 	createPipeline();
 }
 
+void GraphicsPipeline::reload( ShaderCompiler& compiler, JobSystem& jobs )
+{
+	if( !m_reload.done() )
+		return;
+	m_reloadStale = false;
+
+	Reload reload;
+	reload.desc = m_desc;
+	reload.generation = m_generation;
+	jobs.runBackground( [this, &compiler, reload = std::move( reload )]() mutable
+	{
+		TRACE_ZONE( "ReloadPipeline" );
+		auto recompile = [&compiler]( const Ref<Shader>& shader )
+		{
+			if( shader->GetSource().empty() )
+				return shader;
+			return compiler.compile( shader->GetSource(), shader->GetType(), shader->GetDefines() );
+		};
+
+		try
+		{
+			reload.desc.shaders.Vert = recompile( reload.desc.shaders.Vert );
+			reload.desc.shaders.Frag = recompile( reload.desc.shaders.Frag );
+			if( m_reflectLayout )
+				reload.desc.layout = layouts().get( reload.desc.shaders ).layout;
+			reload.pipeline = Create( m_device, reload.desc, m_cache );
+		}
+		catch( const std::exception& e )
+		{
+			reload.error = e.what();
+		}
+
+		{
+			std::lock_guard lock( m_reloadMutex );
+			// An older result nobody swapped in, never drawn with
+			if( m_reloaded )
+				vkDestroyPipeline( m_device.logical(), m_reloaded->pipeline, nullptr );
+			m_reloaded = std::move( reload );
+		}
+	}, &m_reload );
+}
+
+bool GraphicsPipeline::swapReloaded()
+{
+	Reload reload;
+	{
+		std::lock_guard lock( m_reloadMutex );
+		if( !m_reloaded )
+			return false;
+		reload = std::move( *m_reloaded );
+		m_reloaded.reset();
+	}
+
+	m_reloadError = reload.error;
+	if( reload.pipeline == VK_NULL_HANDLE )
+		return false;
+
+	// Targets changed while it was built, never drawn with. The edit isn't lost, it's reloaded again
+	if( reload.generation != m_generation )
+	{
+		vkDestroyPipeline( m_device.logical(), reload.pipeline, nullptr );
+		m_reloadStale = true;
+		return false;
+	}
+
+	VkDevice device = m_device.logical();
+	VkPipeline oldPipeline = m_pipeline;
+	DeletionQueue::Defer( m_deletion, [device, oldPipeline]
+	{
+		vkDestroyPipeline( device, oldPipeline, nullptr );
+	} );
+	m_pipeline = reload.pipeline;
+	m_desc = std::move( reload.desc );
+	// The replaced shaders' modules, unless other pipelines still use them
+	if( m_cache )
+		m_cache->shaderModules().release();
+	return true;
+}
+
+std::vector<std::filesystem::path> GraphicsPipeline::sources() const
+{
+	std::vector<std::filesystem::path> files;
+	for( const Ref<Shader>& shader : { m_desc.shaders.Vert, m_desc.shaders.Frag } )
+		files.insert( files.end(), shader->GetDependencies().begin(), shader->GetDependencies().end() );
+	return files;
+}
 
 void GraphicsPipeline::createPipeline()
 {
-	VkShaderModule vertShaderModule = createShaderModule( mShaders.Vert->GetShaderData() );
-	VkShaderModule fragShaderModule = createShaderModule( mShaders.Frag->GetShaderData() );
+	m_desc.setTarget( m_graph, m_pass );
+	m_pipeline = Create( m_device, m_desc, m_cache );
+}
+
+PipelineLayoutCache& GraphicsPipeline::layouts() const
+{
+	return m_cache ? m_cache->pipelineLayouts() : *m_ownLayouts;
+}
+
+VkDescriptorSetLayout GraphicsPipeline::setLayout( uint32_t set ) const
+{
+	const std::vector<VkDescriptorSetLayout>& sets = layouts().get( m_desc.shaders ).sets;
+	if( set >= sets.size() )
+		throw std::runtime_error( "shaders don't use descriptor set " + std::to_string( set ) + "!" );
+	return sets[set];
+}
+
+VkPipeline GraphicsPipeline::Create( const Device& device, const PipelineDesc& desc, const PipelineCache* cache )
+{
+	TRACE_ZONE( "CreatePipeline" );
+
+	// Shared modules when there is a cache, otherwise they only live for this call, however it ends
+	struct CallModules
+	{
+		VkDevice device;
+		VkShaderModule vert = VK_NULL_HANDLE;
+		VkShaderModule frag = VK_NULL_HANDLE;
+		~CallModules()
+		{
+			for( VkShaderModule module : { vert, frag } )
+				if( module != VK_NULL_HANDLE )
+					vkDestroyShaderModule( device, module, nullptr );
+		}
+	} callModules{ device.logical() };
+	VkShaderModule vertShaderModule = cache ? cache->shaderModules().get( desc.shaders.Vert )
+											: ( callModules.vert = CreateShaderModule( device, *desc.shaders.Vert ) );
+	VkShaderModule fragShaderModule = cache ? cache->shaderModules().get( desc.shaders.Frag )
+											: ( callModules.frag = CreateShaderModule( device, *desc.shaders.Frag ) );
 
 	VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
 	vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -58,42 +279,47 @@ void GraphicsPipeline::createPipeline()
 	fragShaderStageInfo.module = fragShaderModule;
 	fragShaderStageInfo.pName = "main";
 
+	// Without an explicit vertex layout, the vertex shader's inputs packed in location order in binding 0
+	std::vector<VkVertexInputBindingDescription> vertexBindings = desc.vertexBindings;
+	std::vector<VkVertexInputAttributeDescription> vertexAttributes = desc.vertexAttributes;
+	const auto& inputs = desc.shaders.Vert->GetReflection().inputs;
+	if( vertexBindings.empty() && vertexAttributes.empty() && !inputs.empty() )
+	{
+		uint32_t offset = 0;
+		for( const ShaderReflection::Input& input : inputs )
+		{
+			vertexAttributes.push_back( { input.location, 0, input.format, offset } );
+			offset += input.size;
+		}
+		vertexBindings.push_back( { 0, offset, VK_VERTEX_INPUT_RATE_VERTEX } );
+	}
+
 	VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
 	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-	vertexInputInfo.vertexBindingDescriptionCount = 0;
-	vertexInputInfo.vertexAttributeDescriptionCount = 0;
+	vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>( vertexBindings.size() );
+	vertexInputInfo.pVertexBindingDescriptions = vertexBindings.data();
+	vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>( vertexAttributes.size() );
+	vertexInputInfo.pVertexAttributeDescriptions = vertexAttributes.data();
 
 	VkPipelineShaderStageCreateInfo shaderStages[] = { vertShaderStageInfo, fragShaderStageInfo };
 
 	// Create information struct about input assembly
-	// We'll be organizing our vertices in triangles and the GPU should treat the data accordingly
 	VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
 	inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-	inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	inputAssembly.topology = desc.topology;
 	inputAssembly.primitiveRestartEnable = VK_FALSE;
 
-	// Pipeline viewport
-	VkViewport viewport = {};
-	viewport.x = 0.0f;
-	viewport.y = 0.0f;
-	viewport.width = static_cast<float>( m_swap_chain.extent().width );
-	viewport.height = static_cast<float>( m_swap_chain.extent().height );
-	// Depth buffer range
-	viewport.minDepth = 0.0f;
-	viewport.maxDepth = 1.0f;
-
-	// Pixel boundary cutoff
-	VkRect2D scissor = {};
-	scissor.offset = { 0, 0 };
-	scissor.extent = m_swap_chain.extent();
-
-	// Combine viewport(s) and scissor(s) (some graphics cards allow multiple of each)
+	// Viewport and scissor are set while recording, so the pipeline survives resizes
 	VkPipelineViewportStateCreateInfo viewportState = {};
 	viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
 	viewportState.viewportCount = 1;
-	viewportState.pViewports = &viewport;
 	viewportState.scissorCount = 1;
-	viewportState.pScissors = &scissor;
+
+	VkDynamicState dynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+	VkPipelineDynamicStateCreateInfo dynamicState = {};
+	dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+	dynamicState.dynamicStateCount = 2;
+	dynamicState.pDynamicStates = dynamicStates;
 
 	// Rasterizer
 	VkPipelineRasterizationStateCreateInfo rasterizer = {};
@@ -102,11 +328,10 @@ void GraphicsPipeline::createPipeline()
 	rasterizer.depthClampEnable = VK_FALSE;
 	// Don't allow the rasterizer to discard geometry
 	rasterizer.rasterizerDiscardEnable = VK_FALSE;
-	// Fill fragments
-	rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+	rasterizer.polygonMode = desc.polygonMode;
 	rasterizer.lineWidth = 1.0f;
-	rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
-	rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
+	rasterizer.cullMode = desc.cullMode;
+	rasterizer.frontFace = desc.frontFace;
 	// Bias depth values
 	// This is good for shadow mapping, but we're not doing that currently
 	// so we'll disable for now
@@ -119,38 +344,52 @@ void GraphicsPipeline::createPipeline()
 	multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
 	multisampling.minSampleShading = 1.0f;
 
-	// Color Blending
+	VkPipelineDepthStencilStateCreateInfo depthStencil = {};
+	depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+	depthStencil.depthTestEnable = desc.depthTest ? VK_TRUE : VK_FALSE;
+	depthStencil.depthWriteEnable = desc.depthWrite ? VK_TRUE : VK_FALSE;
+	depthStencil.depthCompareOp = desc.depthCompare;
+	depthStencil.depthBoundsTestEnable = VK_FALSE;
+	depthStencil.stencilTestEnable = VK_FALSE;
+
+	// Color Blending, the same for every color attachment
 	VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
 	colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | 
 										  VK_COLOR_COMPONENT_G_BIT | 
 										  VK_COLOR_COMPONENT_B_BIT | 
 										  VK_COLOR_COMPONENT_A_BIT;
-	// Disable blending
-	colorBlendAttachment.blendEnable = VK_FALSE;
+	colorBlendAttachment.blendEnable = desc.alphaBlend ? VK_TRUE : VK_FALSE;
+	colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+	colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+	colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+	colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+	colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+	colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+	std::vector<VkPipelineColorBlendAttachmentState> colorBlendAttachments( desc.colorFormats.size(), colorBlendAttachment );
 
 	VkPipelineColorBlendStateCreateInfo colorBlending = {};
 	colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
 	// Disable bitwise combination blending
 	colorBlending.logicOpEnable = VK_FALSE;
 	colorBlending.logicOp = VK_LOGIC_OP_COPY;
-	colorBlending.attachmentCount = 1;
-	colorBlending.pAttachments = &colorBlendAttachment;
+	colorBlending.attachmentCount = static_cast<uint32_t>( colorBlendAttachments.size() );
+	colorBlending.pAttachments = colorBlendAttachments.data();
 	// Which color channels in framebuffer will be affected
 	colorBlending.blendConstants[0] = 0.0f;
 	colorBlending.blendConstants[1] = 0.0f;
 	colorBlending.blendConstants[2] = 0.0f;
 	colorBlending.blendConstants[3] = 0.0f;
 
-	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-	pipelineLayoutInfo.setLayoutCount = 0;
-	pipelineLayoutInfo.pushConstantRangeCount = 0;
-
-	if( vkCreatePipelineLayout( m_device.logical(), &pipelineLayoutInfo, nullptr, &m_layout ) != VK_SUCCESS )
-		throw std::runtime_error( "Pipeline Layout creation failed" );
+	// Attachment formats stand in for the render pass with dynamic rendering
+	VkPipelineRenderingCreateInfoKHR rendering = {};
+	rendering.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+	rendering.colorAttachmentCount = static_cast<uint32_t>( desc.colorFormats.size() );
+	rendering.pColorAttachmentFormats = desc.colorFormats.data();
+	rendering.depthAttachmentFormat = desc.depthFormat;
 
 	VkGraphicsPipelineCreateInfo pipelineInfo = {};
 	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	pipelineInfo.pNext = desc.renderPass == VK_NULL_HANDLE ? &rendering : nullptr;
 	pipelineInfo.stageCount = 2;
 	pipelineInfo.pStages = shaderStages;
 	pipelineInfo.pVertexInputState = &vertexInputInfo;
@@ -159,33 +398,33 @@ void GraphicsPipeline::createPipeline()
 	pipelineInfo.pRasterizationState = &rasterizer;
 	pipelineInfo.pColorBlendState = &colorBlending;
 	pipelineInfo.pMultisampleState = &multisampling;
-	pipelineInfo.pDepthStencilState = nullptr;
-	pipelineInfo.pDynamicState = nullptr;
-	pipelineInfo.layout = m_layout;
-	pipelineInfo.renderPass = m_render_pass.handle();
-	pipelineInfo.subpass = 0;
+	pipelineInfo.pDepthStencilState = desc.depthTest || desc.depthWrite ? &depthStencil : nullptr;
+	pipelineInfo.pDynamicState = &dynamicState;
+	pipelineInfo.layout = desc.layout;
+	pipelineInfo.renderPass = desc.renderPass;
+	pipelineInfo.subpass = desc.subpass;
 	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 	pipelineInfo.basePipelineIndex = -1;
 
-	if( vkCreateGraphicsPipelines( m_device.logical(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_pipeline ) != VK_SUCCESS )
+	VkPipeline pipeline = VK_NULL_HANDLE;
+	VkPipelineCache pipelineCache = cache ? cache->handle() : VK_NULL_HANDLE;
+	VkResult result = vkCreateGraphicsPipelines( device.logical(), pipelineCache, 1, &pipelineInfo, nullptr, &pipeline );
+	if( result != VK_SUCCESS )
 		throw std::runtime_error( "Graphics Pipeline creation failed" );
-
-	for( auto& shader : shaderStages )
-		vkDestroyShaderModule( m_device.logical(), shader.module, nullptr );
+	return pipeline;
 }
 
-VkShaderModule GraphicsPipeline::createShaderModule( const std::vector<unsigned char>& code )
+VkShaderModule GraphicsPipeline::CreateShaderModule( const Device& device, const Shader& shader )
 {
+	std::span<const uint32_t> code = shader.GetShaderData();
+
 	VkShaderModuleCreateInfo createInfo = {};
 	createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-	createInfo.codeSize = code.size();
-
-	// Vector class already ensures that the data is correctly aligned,
-	// so no need to manually do it
-	createInfo.pCode = reinterpret_cast<const uint32_t*>( code.data() );
+	createInfo.codeSize = code.size_bytes();
+	createInfo.pCode = code.data();
 
 	VkShaderModule module;
-	if( vkCreateShaderModule( m_device.logical(), &createInfo, nullptr, &module ) != VK_SUCCESS )
+	if( vkCreateShaderModule( device.logical(), &createInfo, nullptr, &module ) != VK_SUCCESS )
 		throw std::runtime_error( "failed to create shader module!" );
 
 	return module;
@@ -0,0 +1,87 @@
+#include <vulkan/HeadlessApplication.hpp>
+
+#include <chrono>
+
+using namespace vulkan;
+
+// One offscreen image per frame in flight, so image index == frame index
+const int HEADLESS_FRAMES_IN_FLIGHT = 2;
+
+HeadlessApplication::HeadlessApplication( VkExtent2D extent, bool validationLayers )
+	: instance( "Hello Triangle", "No Engine", validationLayers ),
+	debugMessenger( instance ),
+	device( instance, {} ),
+	allocator( device ),
+	target( device, allocator, extent, VK_FORMAT_R8G8B8A8_UNORM, HEADLESS_FRAMES_IN_FLIGHT ),
+	command_pool( device, 0 ),
+	frames( device, HEADLESS_FRAMES_IN_FLIGHT, HEADLESS_FRAMES_IN_FLIGHT ),
+	pipelineCache( device ),
+
+	render_graph( device, describeFrame() ),
+	graphicsPipeline( device, render_graph, 0, PipelineDesc{ GetBaseShaders() }, &pipelineCache ),
+	commandBuffers( device, command_pool, HEADLESS_FRAMES_IN_FLIGHT )
+{
+	// Nothing changes between frames, record every image once
+	for( uint32_t i = 0; i < commandBuffers.size(); i++ )
+	{
+		commandBuffers.begin( i );
+		render_graph.record( commandBuffers.command( i ), i );
+		commandBuffers.end( i );
+	}
+}
+
+RenderGraph::Desc HeadlessApplication::describeFrame()
+{
+	RenderGraph::Pass scene;
+	scene.name = "Scene";
+	scene.colorWrites = { 0 };
+	scene.clear = true;
+	scene.execute = [this]( VkCommandBuffer cmd, uint32_t )
+	{
+		vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline.pipeline() );
+		vkCmdDraw( cmd, 3, 1, 0, 0 );
+	};
+
+	RenderGraph::Desc desc;
+	desc.resources = { &target };
+	desc.passes = { scene };
+	return desc;
+}
+
+void HeadlessApplication::mainLoop( uint32_t frameCount )
+{
+	// The timings below divide by it
+	if( frameCount == 0 )
+		throw std::runtime_error( "headless run needs at least one frame!" );
+
+	auto start = std::chrono::steady_clock::now();
+
+	for( uint32_t frame = 0; frame < frameCount; frame++ )
+		drawFrame();
+	vkDeviceWaitIdle( device.logical() );
+
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	double seconds = elapsed.count();
+	std::cout << "Rendered " << frameCount << " frames in " << seconds << " s ("
+			  << frameCount / seconds << " FPS, "
+			  << 1000.0 * seconds / frameCount << " ms/frame)" << std::endl;
+}
+
+void HeadlessApplication::drawFrame()
+{
+	frames.beginFrame();
+
+	// Nothing to acquire or present, the image is owned by the frame slot
+	VkSubmitInfo submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffers.command( frames.frameSlot() );
+
+	std::vector<VkSemaphore> signalSemaphores;
+	std::vector<uint64_t> signalValues;
+	VkTimelineSemaphoreSubmitInfo timelineInfo{};
+	frames.fillSubmit( submitInfo, timelineInfo, signalSemaphores, signalValues );
+
+	if( vkQueueSubmit( device.graphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE ) != VK_SUCCESS )
+		throw std::runtime_error( "failed to submit draw command buffer!" );
+}
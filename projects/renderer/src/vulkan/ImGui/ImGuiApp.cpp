@@ -6,13 +6,15 @@ ImGuiApp::ImGuiApp( const Instance& instance,
 					Window& window,
 					const Device& device,
 					const SwapChain& swap_chain,
-					const GraphicsPipeline& graphical_pipeline )
+					const RenderGraph& graph,
+					uint32_t pass,
+					UploadManager& uploads,
+					const PipelineCache* cache )
 	: m_instance( instance ),
 	m_device( device ),
 	m_swap_chain( swap_chain ),
-	render_pass( device, swap_chain ),
-	command_pool( device, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT ),
-	commandBuffers( device, render_pass, swap_chain, graphical_pipeline, command_pool ),
+	m_uploads( uploads ),
+	m_fontUpload( 0 ),
 	imGuiDescriptorPool( VK_NULL_HANDLE )
 {
 	// Setup Dear ImGui context
@@ -36,17 +38,26 @@ ImGuiApp::ImGuiApp( const Instance& instance,
 	init_info.Device = m_device.logical();
 	init_info.QueueFamily = indices.graphicsFamily.value();
 	init_info.Queue = m_device.graphicsQueue();
+	init_info.PipelineCache = cache ? cache->handle() : VK_NULL_HANDLE;
 	init_info.DescriptorPool = imGuiDescriptorPool;
 	init_info.MinImageCount = swap_chain.numImages();
 	init_info.ImageCount = swap_chain.numImages();
-	ImGui_ImplVulkan_Init( &init_info, render_pass.handle() );
 
-	CommandBuffers::SingleTimeCommands( m_device, command_pool, []( const VkCommandBuffer& commandBuffer )
+	// Same target the graph creates our own pipelines against
+	RenderGraph::PipelineTarget target = graph.pipelineTarget( pass );
+	init_info.Subpass = target.subpass;
+	if( target.rendering )
+	{
+		init_info.UseDynamicRendering = true;
+		init_info.ColorAttachmentFormat = target.rendering->pColorAttachmentFormats[0];
+	}
+	ImGui_ImplVulkan_Init( &init_info, target.renderPass );
+
+	// Upload the fonts for DearImgui with the first frame's uploads
+	m_fontUpload = m_uploads.record( []( VkCommandBuffer commandBuffer )
 	{
-		// Upload the fonts for DearImgui
 		ImGui_ImplVulkan_CreateFontsTexture( commandBuffer );
 	} );
-	ImGui_ImplVulkan_DestroyFontUploadObjects();
 }
 
 ImGuiApp::~ImGuiApp()
@@ -58,13 +69,17 @@ ImGuiApp::~ImGuiApp()
 	vkDestroyDescriptorPool( m_device.logical(), imGuiDescriptorPool, nullptr );
 }
 
-void ImGuiApp::recreate()
+void ImGuiApp::record( VkCommandBuffer cmd )
 {
-	render_pass.recreate();
-	commandBuffers.recreate();
+	if( m_fontUpload != 0 && m_uploads.done( m_fontUpload ) )
+	{
+		ImGui_ImplVulkan_DestroyFontUploadObjects();
+		m_fontUpload = 0;
+	}
 
-	render_pass.cleanupOld();
-};
+	// Grab and record the draw data for Dear Imgui
+	ImGui_ImplVulkan_RenderDrawData( ImGui::GetDrawData(), cmd );
+}
 
 void ImGuiApp::createImGuiDescriptorPool()
 {
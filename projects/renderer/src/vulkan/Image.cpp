@@ -0,0 +1,88 @@
+#include <vulkan/Image.hpp>
+#include <vulkan/DeletionQueue.hpp>
+#include <vulkan/Device.hpp>
+
+#include <stdexcept>
+
+using namespace vulkan;
+
+static VkImageViewType ViewType( const VkImageCreateInfo& createInfo )
+{
+	switch( createInfo.imageType )
+	{
+		case VK_IMAGE_TYPE_1D: return createInfo.arrayLayers > 1 ? VK_IMAGE_VIEW_TYPE_1D_ARRAY : VK_IMAGE_VIEW_TYPE_1D;
+		case VK_IMAGE_TYPE_3D: return VK_IMAGE_VIEW_TYPE_3D;
+		default: break;
+	}
+	if( createInfo.flags & VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT )
+		return createInfo.arrayLayers > 6 ? VK_IMAGE_VIEW_TYPE_CUBE_ARRAY : VK_IMAGE_VIEW_TYPE_CUBE;
+	return createInfo.arrayLayers > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+}
+
+Image::Image( const Device& device,
+			  MemoryAllocator& allocator,
+			  const VkImageCreateInfo& createInfo,
+			  VkImageAspectFlags aspect,
+			  VkMemoryPropertyFlags properties,
+			  DeletionQueue* deletion )
+	: m_device( device ),
+	m_allocator( allocator ),
+	m_deletion( deletion ),
+	m_image( VK_NULL_HANDLE ),
+	m_view( VK_NULL_HANDLE ),
+	m_format( createInfo.format ),
+	m_extent( createInfo.extent )
+{
+	if( vkCreateImage( m_device.logical(), &createInfo, nullptr, &m_image ) != VK_SUCCESS )
+		throw std::runtime_error( "failed to create image!" );
+
+	VkMemoryRequirements memRequirements;
+	vkGetImageMemoryRequirements( m_device.logical(), m_image, &memRequirements );
+
+	// Optimal tiling images keep to their own blocks, see bufferImageGranularity
+	MemoryAllocator::Kind kind = createInfo.tiling == VK_IMAGE_TILING_OPTIMAL ? MemoryAllocator::Kind::Optimal
+																			  : MemoryAllocator::Kind::Linear;
+	try
+	{
+		m_memory = m_allocator.allocate( memRequirements, properties, kind );
+	}
+	catch( ... )
+	{
+		vkDestroyImage( m_device.logical(), m_image, nullptr );
+		throw;
+	}
+	vkBindImageMemory( m_device.logical(), m_image, m_memory.memory, m_memory.offset );
+
+	VkImageViewCreateInfo viewInfo = {};
+	viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	viewInfo.image = m_image;
+	viewInfo.viewType = ViewType( createInfo );
+	viewInfo.format = createInfo.format;
+	viewInfo.subresourceRange.aspectMask = aspect;
+	viewInfo.subresourceRange.baseMipLevel = 0;
+	viewInfo.subresourceRange.levelCount = createInfo.mipLevels;
+	viewInfo.subresourceRange.baseArrayLayer = 0;
+	viewInfo.subresourceRange.layerCount = createInfo.arrayLayers;
+
+	if( vkCreateImageView( m_device.logical(), &viewInfo, nullptr, &m_view ) != VK_SUCCESS )
+	{
+		vkDestroyImage( m_device.logical(), m_image, nullptr );
+		m_allocator.free( m_memory );
+		throw std::runtime_error( "failed to create image view!" );
+	}
+}
+
+Image::~Image()
+{
+	VkDevice device = m_device.logical();
+	VkImage image = m_image;
+	VkImageView view = m_view;
+	MemoryAllocator* allocator = &m_allocator;
+	MemoryAllocator::Allocation memory = m_memory;
+	DeletionQueue::Defer( m_deletion, [device, image, view, allocator, memory]() mutable
+	{
+		vkDestroyImageView( device, view, nullptr );
+		vkDestroyImage( device, image, nullptr );
+		allocator->free( memory );
+	} );
+}
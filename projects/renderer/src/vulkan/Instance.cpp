@@ -12,6 +12,19 @@ Instance::Instance( Window& window,
 					const char* appName,
 					const char* engineName,
 					bool validationLayers )
+	: Instance( &window, appName, engineName, validationLayers )
+{}
+
+Instance::Instance( const char* appName,
+					const char* engineName,
+					bool validationLayers )
+	: Instance( nullptr, appName, engineName, validationLayers )
+{}
+
+Instance::Instance( Window* window,
+					const char* appName,
+					const char* engineName,
+					bool validationLayers )
 	: mWindow( window ),
 	m_instance( VK_NULL_HANDLE ),
 	m_enableValidationLayers( validationLayers )
@@ -25,7 +38,7 @@ Instance::Instance( Window& window,
 	appInfo.applicationVersion = VK_MAKE_VERSION( 1, 0, 0 );
 	appInfo.pEngineName = engineName;
 	appInfo.engineVersion = VK_MAKE_VERSION( 1, 0, 0 );
-	appInfo.apiVersion = VK_API_VERSION_1_0;
+	appInfo.apiVersion = VK_API_VERSION_1_2;
 
 	VkInstanceCreateInfo createInfo{};
 	createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -51,12 +64,14 @@ Instance::Instance( Window& window,
 	if( vkCreateInstance( &createInfo, nullptr, &m_instance ) != VK_SUCCESS )
 		throw std::runtime_error( "failed to create instance!" );
 
-	mWindow.CreateSurface( *this );
+	if( mWindow )
+		mWindow->CreateSurface( *this );
 }
 
 Instance::~Instance()
 {
-	mWindow.DestroySurface( *this );
+	if( mWindow )
+		mWindow->DestroySurface( *this );
 	vkDestroyInstance( m_instance, nullptr );
 }
 
@@ -92,7 +107,9 @@ bool Instance::CheckValidationLayerSupport()
 
 std::vector<const char*> Instance::GetRequiredExtensions( bool validationLayers )
 {
-	auto extensions = mWindow.GetRequiredExtensions();
+	std::vector<const char*> extensions;
+	if( mWindow )
+		extensions = mWindow->GetRequiredExtensions();
 	if( validationLayers )
 		extensions.push_back( VK_EXT_DEBUG_UTILS_EXTENSION_NAME );
 	return extensions;
@@ -0,0 +1,123 @@
+#include <vulkan/InstanceBuffer.hpp>
+#include <vulkan/DeletionQueue.hpp>
+#include <vulkan/Device.hpp>
+#include <vulkan/FrameScheduler.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace vulkan;
+
+InstanceBuffer::InstanceBuffer( const Device& device,
+								MemoryAllocator& allocator,
+								uint32_t maxInstances,
+								uint32_t numSlots,
+								DeletionQueue* deletion )
+	: m_device( device ),
+	m_allocator( allocator ),
+	m_deletion( deletion ),
+	m_pool( VK_NULL_HANDLE ),
+	m_slots( numSlots ),
+	m_currentSlot( 0 ),
+	m_alignment( 16 )
+{
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties( m_device.physical(), &properties );
+	m_alignment = std::max( m_alignment, properties.limits.minStorageBufferOffsetAlignment );
+
+	m_arena = createArena( std::max( maxInstances, 1u ) * VkDeviceSize( sizeof( Instance ) ) );
+
+	VkDescriptorPoolSize poolSize = {};
+	poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	poolSize.descriptorCount = numSlots;
+
+	// Sets are freed one by one when a reloaded shader changes the set layout
+	VkDescriptorPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+	poolInfo.maxSets = numSlots;
+	poolInfo.poolSizeCount = 1;
+	poolInfo.pPoolSizes = &poolSize;
+
+	if( vkCreateDescriptorPool( m_device.logical(), &poolInfo, nullptr, &m_pool ) != VK_SUCCESS )
+		throw std::runtime_error( "failed to create instance descriptor pool!" );
+}
+
+InstanceBuffer::~InstanceBuffer()
+{
+	VkDevice device = m_device.logical();
+	VkDescriptorPool pool = m_pool;
+	DeletionQueue::Defer( m_deletion, [device, pool]()
+	{
+		vkDestroyDescriptorPool( device, pool, nullptr );
+	} );
+}
+
+std::span<InstanceBuffer::Instance> InstanceBuffer::begin( const FrameScheduler& frames,
+														   uint32_t count,
+														   VkDescriptorSetLayout setLayout )
+{
+	m_currentSlot = frames.frameSlot();
+	if( m_currentSlot >= m_slots.size() )
+		throw std::runtime_error( "more frames in flight than instance buffer slots!" );
+
+	// Storage buffer ranges can't be empty
+	VkDeviceSize bytes = std::max( count, 1u ) * VkDeviceSize( sizeof( Instance ) );
+	m_arena->beginFrame( frames );
+	std::optional<FrameArena::Slice> slice = m_arena->allocate( bytes, m_alignment );
+	if( !slice )
+	{
+		// The old ring is destroyed through deletion, frames in flight still read it
+		m_arena = createArena( std::max( bytes, m_arena->capacity() / ( m_slots.size() + 1 ) * 2 ) );
+		m_arena->beginFrame( frames );
+		slice = m_arena->allocate( bytes, m_alignment );
+	}
+
+	// The slot's last frame retired, its set is free to change
+	Slot& slot = m_slots[m_currentSlot];
+	if( slot.layout != setLayout )
+	{
+		if( slot.set != VK_NULL_HANDLE )
+			vkFreeDescriptorSets( m_device.logical(), m_pool, 1, &slot.set );
+
+		VkDescriptorSetAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool = m_pool;
+		allocInfo.descriptorSetCount = 1;
+		allocInfo.pSetLayouts = &setLayout;
+		if( vkAllocateDescriptorSets( m_device.logical(), &allocInfo, &slot.set ) != VK_SUCCESS )
+			throw std::runtime_error( "failed to allocate instance descriptor set!" );
+		slot.layout = setLayout;
+	}
+
+	VkDescriptorBufferInfo bufferInfo = {};
+	bufferInfo.buffer = slice->buffer;
+	bufferInfo.offset = slice->offset;
+	bufferInfo.range = bytes;
+
+	VkWriteDescriptorSet write = {};
+	write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.dstSet = slot.set;
+	write.dstBinding = 0;
+	write.descriptorCount = 1;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	write.pBufferInfo = &bufferInfo;
+	vkUpdateDescriptorSets( m_device.logical(), 1, &write, 0, nullptr );
+
+	return { static_cast<Instance*>( slice->data ), count };
+}
+
+void InstanceBuffer::bind( VkCommandBuffer cmd, VkPipelineLayout layout, uint32_t set ) const
+{
+	vkCmdBindDescriptorSets( cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, set, 1, &m_slots[m_currentSlot].set, 0, nullptr );
+}
+
+// Frames in flight each hold their range, one more covers what's skipped when the ring wraps
+Scope<FrameArena> InstanceBuffer::createArena( VkDeviceSize perFrame ) const
+{
+	return CreateScope<FrameArena>( m_device,
+									m_allocator,
+									( perFrame + m_alignment ) * ( m_slots.size() + 1 ),
+									VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+									m_deletion );
+}
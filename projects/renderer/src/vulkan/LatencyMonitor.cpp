@@ -0,0 +1,26 @@
+#include <vulkan/LatencyMonitor.hpp>
+#include <vulkan/FrameScheduler.hpp>
+
+#include "common/trace.hpp"
+
+using namespace vulkan;
+
+void LatencyMonitor::submitted( uint64_t frame, uint64_t inputTime, LatencyMode mode )
+{
+	m_pending.push_back( { frame, inputTime, mode } );
+}
+
+void LatencyMonitor::update( const FrameScheduler& frames )
+{
+	uint64_t now = Tracer::Now();
+	while( !m_pending.empty() && frames.retired( m_pending.front().frame ) )
+	{
+		const Sample& sample = m_pending.front();
+		double latency = ( now - sample.inputTime ) / 1e6;
+
+		double& average = m_latencyMs[static_cast<size_t>( sample.mode )];
+		average = average == 0.0 ? latency : average * 0.95 + latency * 0.05;
+
+		m_pending.pop_front();
+	}
+}
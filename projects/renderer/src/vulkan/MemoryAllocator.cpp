@@ -0,0 +1,209 @@
+#include <vulkan/MemoryAllocator.hpp>
+#include <vulkan/Device.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace vulkan;
+
+MemoryAllocator::MemoryAllocator( const Device& device, VkDeviceSize blockSize )
+	: m_device( device ),
+	m_blockSize( blockSize ),
+	m_properties{},
+	m_maxAllocations( 0 ),
+	m_deviceAllocations( 0 )
+{
+	vkGetPhysicalDeviceMemoryProperties( m_device.physical(), &m_properties );
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties( m_device.physical(), &properties );
+	m_maxAllocations = properties.limits.maxMemoryAllocationCount;
+
+	m_pools.resize( m_properties.memoryTypeCount * 2 );
+	m_dedicated.resize( m_properties.memoryTypeCount, 0 );
+}
+
+MemoryAllocator::~MemoryAllocator()
+{
+	for( uint32_t i = 0; i < m_pools.size(); i++ )
+		for( Block& block : m_pools[i].blocks )
+			if( block.memory != VK_NULL_HANDLE )
+				freeMemory( block.memory, block.mapped );
+}
+
+MemoryAllocator::Allocation MemoryAllocator::allocate( const VkMemoryRequirements& requirements,
+													   VkMemoryPropertyFlags properties,
+													   Kind kind )
+{
+	std::lock_guard lock( m_mutex );
+
+	// Types are ordered by preference, a full heap falls back to the next suitable one
+	for( uint32_t type = 0; type < m_properties.memoryTypeCount; type++ )
+	{
+		if( !( requirements.memoryTypeBits & ( 1u << type ) ) ||
+			( m_properties.memoryTypes[type].propertyFlags & properties ) != properties )
+			continue;
+
+		Allocation allocation;
+		allocation.memoryType = type;
+		allocation.kind = kind;
+		allocation.size = requirements.size;
+
+		// Small heaps (the host visible part of VRAM) would go in a couple of blocks
+		VkDeviceSize heapSize = m_properties.memoryHeaps[m_properties.memoryTypes[type].heapIndex].size;
+		VkDeviceSize blockSize = std::min( m_blockSize, heapSize / 8 );
+
+		if( requirements.size > blockSize / 2 )
+		{
+			void* mapped = nullptr;
+			allocation.memory = allocateMemory( type, requirements.size, mapped );
+			if( allocation.memory == VK_NULL_HANDLE )
+				continue;
+			allocation.mapped = mapped;
+			allocation.dedicated = true;
+			m_dedicated[type]++;
+			return allocation;
+		}
+
+		Pool& blocks = pool( type, kind );
+		for( uint32_t b = 0; b < blocks.blocks.size(); b++ )
+		{
+			Block& block = blocks.blocks[b];
+			if( block.memory == VK_NULL_HANDLE )
+				continue;
+			Tlsf::Allocation range = block.ranges->allocate( requirements.size, requirements.alignment );
+			if( range.offset == Tlsf::InvalidOffset )
+				continue;
+
+			allocation.memory = block.memory;
+			allocation.offset = range.offset;
+			allocation.mapped = block.mapped ? static_cast<char*>( block.mapped ) + range.offset : nullptr;
+			allocation.block = b;
+			allocation.range = range.id;
+			return allocation;
+		}
+
+		Block block;
+		block.memory = allocateMemory( type, blockSize, block.mapped );
+		if( block.memory == VK_NULL_HANDLE )
+			continue;
+		block.ranges = CreateScope<Tlsf>( blockSize );
+		Tlsf::Allocation range = block.ranges->allocate( requirements.size, requirements.alignment );
+
+		// Reuse the slot of a freed block
+		auto slot = std::find_if( blocks.blocks.begin(), blocks.blocks.end(), []( const Block& b )
+		{
+			return b.memory == VK_NULL_HANDLE;
+		} );
+		if( slot == blocks.blocks.end() )
+			slot = blocks.blocks.insert( slot, Block{} );
+		*slot = std::move( block );
+
+		allocation.memory = slot->memory;
+		allocation.offset = range.offset;
+		allocation.mapped = slot->mapped ? static_cast<char*>( slot->mapped ) + range.offset : nullptr;
+		allocation.block = static_cast<uint32_t>( slot - blocks.blocks.begin() );
+		allocation.range = range.id;
+		return allocation;
+	}
+	throw std::runtime_error( "failed to allocate device memory!" );
+}
+
+void MemoryAllocator::free( Allocation& allocation )
+{
+	if( !allocation )
+		return;
+
+	std::lock_guard lock( m_mutex );
+	if( allocation.dedicated )
+	{
+		freeMemory( allocation.memory, allocation.mapped );
+		m_dedicated[allocation.memoryType]--;
+	}
+	else
+	{
+		Pool& blocks = pool( allocation.memoryType, allocation.kind );
+		Block& block = blocks.blocks[allocation.block];
+		block.ranges->free( allocation.range );
+
+		// The first block stays, so a pool that empties and refills doesn't hit the driver each time
+		if( block.ranges->empty() && allocation.block > 0 )
+		{
+			freeMemory( block.memory, block.mapped );
+			block = Block{};
+		}
+	}
+	allocation = Allocation{};
+}
+
+MemoryAllocator::Stats MemoryAllocator::stats() const
+{
+	std::lock_guard lock( m_mutex );
+
+	Stats stats;
+	stats.deviceAllocations = m_deviceAllocations;
+	stats.maxDeviceAllocations = m_maxAllocations;
+	stats.heaps.resize( m_properties.memoryHeapCount );
+	for( uint32_t h = 0; h < m_properties.memoryHeapCount; h++ )
+		stats.heaps[h].heapSize = m_properties.memoryHeaps[h].size;
+
+	std::vector<VkDeviceSize> freeBytes( m_properties.memoryHeapCount, 0 );
+	for( uint32_t i = 0; i < m_pools.size(); i++ )
+	{
+		HeapStats& heap = stats.heaps[m_properties.memoryTypes[i / 2].heapIndex];
+		for( const Block& block : m_pools[i].blocks )
+		{
+			if( block.memory == VK_NULL_HANDLE )
+				continue;
+			heap.blocks++;
+			heap.blockBytes += block.ranges->size();
+			heap.usedBytes += block.ranges->used();
+			heap.allocations += block.ranges->allocations();
+			heap.largestFree = std::max( heap.largestFree, block.ranges->largestFree() );
+			freeBytes[m_properties.memoryTypes[i / 2].heapIndex] += block.ranges->size() - block.ranges->used();
+		}
+	}
+	for( uint32_t type = 0; type < m_properties.memoryTypeCount; type++ )
+		stats.heaps[m_properties.memoryTypes[type].heapIndex].dedicated += m_dedicated[type];
+
+	for( uint32_t h = 0; h < m_properties.memoryHeapCount; h++ )
+		if( freeBytes[h] > 0 )
+			stats.heaps[h].fragmentation = 1.0f - static_cast<float>( stats.heaps[h].largestFree ) / freeBytes[h];
+	return stats;
+}
+
+VkDeviceMemory MemoryAllocator::allocateMemory( uint32_t memoryType, VkDeviceSize size, void*& mapped )
+{
+	if( m_deviceAllocations >= m_maxAllocations )
+		throw std::runtime_error( "maxMemoryAllocationCount reached!" );
+
+	VkMemoryAllocateInfo allocInfo = {};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize = size;
+	allocInfo.memoryTypeIndex = memoryType;
+
+	// Out of memory in this heap, the caller tries the next type
+	VkDeviceMemory memory = VK_NULL_HANDLE;
+	if( vkAllocateMemory( m_device.logical(), &allocInfo, nullptr, &memory ) != VK_SUCCESS )
+		return VK_NULL_HANDLE;
+	m_deviceAllocations++;
+
+	mapped = nullptr;
+	if( m_properties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT )
+	{
+		if( vkMapMemory( m_device.logical(), memory, 0, VK_WHOLE_SIZE, 0, &mapped ) != VK_SUCCESS )
+		{
+			freeMemory( memory, nullptr );
+			throw std::runtime_error( "failed to map device memory!" );
+		}
+	}
+	return memory;
+}
+
+void MemoryAllocator::freeMemory( VkDeviceMemory memory, void* mapped )
+{
+	if( mapped )
+		vkUnmapMemory( m_device.logical(), memory );
+	vkFreeMemory( m_device.logical(), memory, nullptr );
+	m_deviceAllocations--;
+}
@@ -0,0 +1,297 @@
+#include <vulkan/Mesh.hpp>
+#include <vulkan/Device.hpp>
+#include <vulkan/GraphicsPipeline.hpp>
+#include <vulkan/UploadManager.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+
+#include <glm/gtc/packing.hpp>
+
+using namespace vulkan;
+
+namespace
+{
+struct InterleavedVertex
+{
+	glm::vec3 position;
+	glm::vec3 normal;
+	glm::vec2 uv;
+};
+static_assert( sizeof( InterleavedVertex ) == 32 );
+
+// VertexLayout::Quantized
+struct QuantizedVertex
+{
+	uint64_t position;
+	uint32_t normalTangent;
+	uint32_t uv;
+};
+static_assert( sizeof( QuantizedVertex ) == 16 );
+
+// Vertices or indices converted per upload, bounds the temporary copy for any mesh size
+const size_t ConvertChunk = 1 << 16;
+
+// Unit vector folded onto the octahedron and flattened to [-1, 1]^2,
+// undone by decodeOctahedral in lib/vertex_decode.glsl
+glm::vec2 EncodeOctahedral( const glm::vec3& n )
+{
+	glm::vec2 p = glm::vec2( n.x, n.y ) / ( std::abs( n.x ) + std::abs( n.y ) + std::abs( n.z ) );
+	if( n.z < 0.0f )
+		p = glm::vec2( ( 1.0f - std::abs( p.y ) ) * ( p.x >= 0.0f ? 1.0f : -1.0f ),
+					   ( 1.0f - std::abs( p.x ) ) * ( p.y >= 0.0f ? 1.0f : -1.0f ) );
+	return p;
+}
+
+QuantizedVertex Quantize( const MeshData& data, size_t v, const Mesh::Dequantization& dequantization )
+{
+	glm::vec3 position = ( data.positions[v] - glm::vec3( dequantization.boundsMin ) ) / glm::vec3( dequantization.boundsExtent );
+	const glm::vec4& tangent = data.tangents[v];
+
+	QuantizedVertex vertex;
+	vertex.position = glm::packUnorm4x16( glm::vec4( position, tangent.w < 0.0f ? 0.0f : 1.0f ) );
+	vertex.normalTangent = glm::packSnorm4x8( glm::vec4( EncodeOctahedral( data.normals[v] ), EncodeOctahedral( glm::vec3( tangent ) ) ) );
+	vertex.uv = glm::packHalf2x16( data.uvs[v] );
+	return vertex;
+}
+}  // namespace
+
+void MeshData::computeBounds()
+{
+	boundsMin = glm::vec3( std::numeric_limits<float>::max() );
+	boundsMax = glm::vec3( std::numeric_limits<float>::lowest() );
+	for( const glm::vec3& position : positions )
+	{
+		boundsMin = glm::min( boundsMin, position );
+		boundsMax = glm::max( boundsMax, position );
+	}
+	if( positions.empty() )
+		boundsMin = boundsMax = glm::vec3( 0.0f );
+}
+
+void MeshData::computeNormals()
+{
+	normals.resize( positions.size(), glm::vec3( 0.0f ) );
+
+	// Unnormalized cross products are twice the triangle area, big triangles weigh more
+	std::vector<glm::vec3> accumulated( positions.size(), glm::vec3( 0.0f ) );
+	for( size_t i = 0; i + 2 < indices.size(); i += 3 )
+	{
+		uint32_t a = indices[i], b = indices[i + 1], c = indices[i + 2];
+		glm::vec3 face = glm::cross( positions[b] - positions[a], positions[c] - positions[a] );
+		accumulated[a] += face;
+		accumulated[b] += face;
+		accumulated[c] += face;
+	}
+
+	for( size_t v = 0; v < normals.size(); v++ )
+	{
+		if( normals[v] != glm::vec3( 0.0f ) )
+			continue;
+		float length = glm::length( accumulated[v] );
+		normals[v] = length > 0.0f ? accumulated[v] / length : glm::vec3( 0.0f, 0.0f, 1.0f );
+	}
+}
+
+void MeshData::computeTangents()
+{
+	tangents.resize( positions.size(), glm::vec4( 0.0f ) );
+
+	// Directions of increasing u and v over each triangle, accumulated per vertex
+	std::vector<glm::vec3> uDirections( positions.size(), glm::vec3( 0.0f ) );
+	std::vector<glm::vec3> vDirections( positions.size(), glm::vec3( 0.0f ) );
+	for( size_t i = 0; i + 2 < indices.size(); i += 3 )
+	{
+		uint32_t a = indices[i], b = indices[i + 1], c = indices[i + 2];
+		glm::vec3 edge1 = positions[b] - positions[a];
+		glm::vec3 edge2 = positions[c] - positions[a];
+		glm::vec2 duv1 = uvs[b] - uvs[a];
+		glm::vec2 duv2 = uvs[c] - uvs[a];
+		float determinant = duv1.x * duv2.y - duv2.x * duv1.y;
+		if( determinant == 0.0f )
+			continue;
+		glm::vec3 u = ( edge1 * duv2.y - edge2 * duv1.y ) / determinant;
+		glm::vec3 v = ( edge2 * duv1.x - edge1 * duv2.x ) / determinant;
+		for( uint32_t vertex : { a, b, c } )
+		{
+			uDirections[vertex] += u;
+			vDirections[vertex] += v;
+		}
+	}
+
+	for( size_t v = 0; v < tangents.size(); v++ )
+	{
+		if( tangents[v] != glm::vec4( 0.0f ) )
+			continue;
+		const glm::vec3& normal = normals[v];
+		// Orthogonal to the normal, any direction will do without a usable uv mapping
+		glm::vec3 tangent = uDirections[v] - normal * glm::dot( normal, uDirections[v] );
+		if( glm::length( tangent ) < 1e-12f )
+			tangent = glm::cross( normal, std::abs( normal.x ) < 0.9f ? glm::vec3( 1.0f, 0.0f, 0.0f ) : glm::vec3( 0.0f, 1.0f, 0.0f ) );
+		tangent = glm::normalize( tangent );
+		float handedness = glm::dot( glm::cross( normal, tangent ), vDirections[v] ) < 0.0f ? -1.0f : 1.0f;
+		tangents[v] = glm::vec4( tangent, handedness );
+	}
+}
+
+Mesh::Mesh( const Device& device,
+			MemoryAllocator& allocator,
+			UploadManager& uploads,
+			const MeshData& data,
+			VertexLayout layout,
+			DeletionQueue* deletion )
+	: m_layout( layout ),
+	m_vertexCount( static_cast<uint32_t>( data.vertexCount() ) ),
+	m_indexCount( static_cast<uint32_t>( data.indices.size() ) ),
+	m_indexType( data.vertexCount() <= std::numeric_limits<uint16_t>::max() ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32 ),
+	m_boundsMin( data.boundsMin ),
+	m_boundsMax( data.boundsMax ),
+	m_uploadValue( 0 )
+{
+	if( data.positions.empty() || data.indices.empty() )
+		throw std::runtime_error( "mesh has no geometry!" );
+	if( data.normals.size() != data.vertexCount() || data.uvs.size() != data.vertexCount() )
+		throw std::runtime_error( "mesh attributes differ in length!" );
+	if( layout == VertexLayout::Quantized && data.tangents.size() != data.vertexCount() )
+		throw std::runtime_error( "quantized meshes need tangents!" );
+
+	// Flat meshes have a zero extent on some axis, their positions all quantize to 0 there
+	m_dequantization.boundsMin = glm::vec4( m_boundsMin, 0.0f );
+	m_dequantization.boundsExtent = glm::vec4( glm::max( m_boundsMax - m_boundsMin, glm::vec3( 1e-20f ) ), 0.0f );
+
+	VkDeviceSize vertexBytes = m_vertexCount * VertexSize( m_layout );
+	VkDeviceSize indexBytes = m_indexCount * VkDeviceSize( m_indexType == VK_INDEX_TYPE_UINT16 ? 2 : 4 );
+	if( m_layout != VertexLayout::Split )
+		m_streamOffsets = { 0 };
+	else
+		m_streamOffsets = { 0, m_vertexCount * VkDeviceSize( sizeof( glm::vec3 ) ), m_vertexCount * VkDeviceSize( 2 * sizeof( glm::vec3 ) ) };
+
+	m_vertices = CreateScope<Buffer>( device,
+									  allocator,
+									  vertexBytes,
+									  VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+									  VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+									  deletion );
+	m_indices = CreateScope<Buffer>( device,
+									 allocator,
+									 indexBytes,
+									 VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+									 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+									 deletion );
+
+	uploadVertices( uploads, data );
+	uploadIndices( uploads, data );
+}
+
+void Mesh::DescribeVertexInput( VertexLayout layout, PipelineDesc& desc )
+{
+	if( layout == VertexLayout::Interleaved )
+	{
+		desc.vertexBindings = { { 0, sizeof( InterleavedVertex ), VK_VERTEX_INPUT_RATE_VERTEX } };
+		desc.vertexAttributes = { { 0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof( InterleavedVertex, position ) },
+								  { 1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof( InterleavedVertex, normal ) },
+								  { 2, 0, VK_FORMAT_R32G32_SFLOAT, offsetof( InterleavedVertex, uv ) } };
+	}
+	else if( layout == VertexLayout::Quantized )
+	{
+		desc.vertexBindings = { { 0, sizeof( QuantizedVertex ), VK_VERTEX_INPUT_RATE_VERTEX } };
+		desc.vertexAttributes = { { 0, 0, VK_FORMAT_R16G16B16A16_UNORM, offsetof( QuantizedVertex, position ) },
+								  { 1, 0, VK_FORMAT_R8G8B8A8_SNORM, offsetof( QuantizedVertex, normalTangent ) },
+								  { 2, 0, VK_FORMAT_R16G16_SFLOAT, offsetof( QuantizedVertex, uv ) } };
+	}
+	else
+	{
+		desc.vertexBindings = { { 0, sizeof( glm::vec3 ), VK_VERTEX_INPUT_RATE_VERTEX },
+								{ 1, sizeof( glm::vec3 ), VK_VERTEX_INPUT_RATE_VERTEX },
+								{ 2, sizeof( glm::vec2 ), VK_VERTEX_INPUT_RATE_VERTEX } };
+		desc.vertexAttributes = { { 0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0 },
+								  { 1, 1, VK_FORMAT_R32G32B32_SFLOAT, 0 },
+								  { 2, 2, VK_FORMAT_R32G32_SFLOAT, 0 } };
+	}
+}
+
+VkDeviceSize Mesh::VertexSize( VertexLayout layout )
+{
+	return layout == VertexLayout::Quantized ? sizeof( QuantizedVertex ) : sizeof( InterleavedVertex );
+}
+
+bool Mesh::ready( const UploadManager& uploads ) const
+{
+	return m_uploadValue <= uploads.submitted();
+}
+
+void Mesh::bind( VkCommandBuffer cmd ) const
+{
+	// Every stream lives in the one buffer
+	VkBuffer buffers[] = { m_vertices->handle(), m_vertices->handle(), m_vertices->handle() };
+	vkCmdBindVertexBuffers( cmd, 0, static_cast<uint32_t>( m_streamOffsets.size() ), buffers, m_streamOffsets.data() );
+	vkCmdBindIndexBuffer( cmd, m_indices->handle(), 0, m_indexType );
+}
+
+void Mesh::draw( VkCommandBuffer cmd, uint32_t instanceCount, uint32_t firstInstance ) const
+{
+	vkCmdDrawIndexed( cmd, m_indexCount, instanceCount, 0, 0, firstInstance );
+}
+
+// The streams are uploaded straight from the arrays, interleaving goes through a small
+// chunk at a time: the staging copy is the only other copy of the mesh
+void Mesh::uploadVertices( UploadManager& uploads, const MeshData& data )
+{
+	// A flush on the main thread can split the uploads over two batches, the later one counts
+	auto upload = [&]( VkDeviceSize offset, const void* bytes, VkDeviceSize size )
+	{
+		m_uploadValue = std::max( m_uploadValue, uploads.upload( *m_vertices, offset, bytes, size ) );
+	};
+
+	if( m_layout == VertexLayout::Split )
+	{
+		upload( m_streamOffsets[0], data.positions.data(), m_vertexCount * sizeof( glm::vec3 ) );
+		upload( m_streamOffsets[1], data.normals.data(), m_vertexCount * sizeof( glm::vec3 ) );
+		upload( m_streamOffsets[2], data.uvs.data(), m_vertexCount * sizeof( glm::vec2 ) );
+		return;
+	}
+
+	if( m_layout == VertexLayout::Quantized )
+	{
+		std::vector<QuantizedVertex> chunk( std::min<size_t>( ConvertChunk, m_vertexCount ) );
+		for( size_t first = 0; first < m_vertexCount; first += chunk.size() )
+		{
+			size_t count = std::min( chunk.size(), m_vertexCount - first );
+			for( size_t v = 0; v < count; v++ )
+				chunk[v] = Quantize( data, first + v, m_dequantization );
+			upload( first * sizeof( QuantizedVertex ), chunk.data(), count * sizeof( QuantizedVertex ) );
+		}
+		return;
+	}
+
+	std::vector<InterleavedVertex> chunk( std::min<size_t>( ConvertChunk, m_vertexCount ) );
+	for( size_t first = 0; first < m_vertexCount; first += chunk.size() )
+	{
+		size_t count = std::min( chunk.size(), m_vertexCount - first );
+		for( size_t v = 0; v < count; v++ )
+			chunk[v] = { data.positions[first + v], data.normals[first + v], data.uvs[first + v] };
+		upload( first * sizeof( InterleavedVertex ), chunk.data(), count * sizeof( InterleavedVertex ) );
+	}
+}
+
+void Mesh::uploadIndices( UploadManager& uploads, const MeshData& data )
+{
+	if( m_indexType == VK_INDEX_TYPE_UINT32 )
+	{
+		m_uploadValue = std::max( m_uploadValue,
+								  uploads.upload( *m_indices, 0, data.indices.data(), m_indexCount * sizeof( uint32_t ) ) );
+		return;
+	}
+
+	std::vector<uint16_t> chunk( std::min<size_t>( ConvertChunk, m_indexCount ) );
+	for( size_t first = 0; first < m_indexCount; first += chunk.size() )
+	{
+		size_t count = std::min( chunk.size(), m_indexCount - first );
+		for( size_t i = 0; i < count; i++ )
+			chunk[i] = static_cast<uint16_t>( data.indices[first + i] );
+		m_uploadValue = std::max( m_uploadValue,
+								  uploads.upload( *m_indices, first * sizeof( uint16_t ), chunk.data(), count * sizeof( uint16_t ) ) );
+	}
+}
@@ -0,0 +1,794 @@
+#include <vulkan/MeshImporter.hpp>
+
+#include "common/job_system.hpp"
+#include "common/json.hpp"
+#include "common/mapped_file.hpp"
+#include "common/trace.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+using namespace vulkan;
+
+namespace
+{
+
+// OBJ
+
+// Lines of text parsed by one job. Counts of the first pass turn into the global index
+// of the chunk's first position, uv and normal, then faces can be resolved in parallel
+struct ObjChunk
+{
+	std::string_view text;
+
+	uint32_t positions = 0;
+	uint32_t uvs = 0;
+	uint32_t normals = 0;
+	uint32_t firstPosition = 0;
+	uint32_t firstUv = 0;
+	uint32_t firstNormal = 0;
+
+	// Triangulated face corners, zero based position, uv and normal, -1 when absent
+	std::vector<glm::ivec3> corners;
+	// Distinct corners become the chunk's vertices, indices are local to the chunk
+	std::vector<glm::ivec3> vertices;
+	std::vector<uint32_t> indices;
+	uint32_t firstVertex = 0;
+	uint32_t firstIndex = 0;
+};
+
+struct CornerHash
+{
+	inline size_t operator()( const glm::ivec3& corner ) const
+	{
+		uint64_t hash = static_cast<uint32_t>( corner.x ) * 0x9E3779B97F4A7C15ull;
+		hash ^= ( static_cast<uint32_t>( corner.y ) + 0x7F4A7C15ull + ( hash << 6 ) + ( hash >> 2 ) );
+		hash ^= ( static_cast<uint32_t>( corner.z ) + 0x9E3779B9ull + ( hash << 6 ) + ( hash >> 2 ) );
+		return static_cast<size_t>( hash );
+	}
+};
+
+class ObjLine
+{
+public:
+	explicit ObjLine( std::string_view line )
+		: m_pos( line.data() ),
+		m_end( line.data() + line.size() )
+	{}
+
+	// Next whitespace separated token, empty at the end of the line
+	std::string_view token()
+	{
+		while( m_pos < m_end && ( *m_pos == ' ' || *m_pos == '\t' || *m_pos == '\r' ) )
+			m_pos++;
+		const char* start = m_pos;
+		while( m_pos < m_end && *m_pos != ' ' && *m_pos != '\t' && *m_pos != '\r' )
+			m_pos++;
+		return { start, static_cast<size_t>( m_pos - start ) };
+	}
+
+	float number()
+	{
+		std::string_view text = token();
+		float value = 0.0f;
+		if( text.empty() )
+			return value;
+		// from_chars takes no leading plus
+		if( text.front() == '+' )
+			text.remove_prefix( 1 );
+		if( std::from_chars( text.data(), text.data() + text.size(), value ).ec != std::errc() )
+			throw std::runtime_error( "OBJ has an invalid number: " + std::string( text ) );
+		return value;
+	}
+
+private:
+	const char* m_pos;
+	const char* m_end;
+};
+
+template <typename Func>
+void ForEachLine( std::string_view text, Func&& func )
+{
+	size_t pos = 0;
+	while( pos < text.size() )
+	{
+		size_t end = text.find( '\n', pos );
+		if( end == std::string_view::npos )
+			end = text.size();
+		std::string_view line = text.substr( pos, end - pos );
+		size_t start = line.find_first_not_of( " \t" );
+		if( start != std::string_view::npos )
+			func( line.substr( start ) );
+		pos = end + 1;
+	}
+}
+
+inline bool Keyword( std::string_view line, std::string_view keyword )
+{
+	return line.size() > keyword.size() && line.compare( 0, keyword.size(), keyword ) == 0 &&
+		   ( line[keyword.size()] == ' ' || line[keyword.size()] == '\t' );
+}
+
+// One based, or negative counting back from the elements read so far. -1 when absent
+int32_t ResolveObjIndex( std::string_view text, uint32_t readSoFar, uint32_t total )
+{
+	if( text.empty() )
+		return -1;
+	int32_t index = 0;
+	if( std::from_chars( text.data(), text.data() + text.size(), index ).ec != std::errc() || index == 0 )
+		throw std::runtime_error( "OBJ has an invalid face index: " + std::string( text ) );
+	int64_t resolved = index > 0 ? int64_t( index ) - 1 : int64_t( readSoFar ) + index;
+	if( resolved < 0 || resolved >= total )
+		throw std::runtime_error( "OBJ face index out of range: " + std::string( text ) );
+	return static_cast<int32_t>( resolved );
+}
+
+void ParseObjChunk( ObjChunk& chunk, MeshData& mesh, uint32_t totalPositions, uint32_t totalUvs, uint32_t totalNormals )
+{
+	uint32_t position = chunk.firstPosition;
+	uint32_t uv = chunk.firstUv;
+	uint32_t normal = chunk.firstNormal;
+	std::vector<glm::ivec3> face;
+
+	ForEachLine( chunk.text, [&]( std::string_view line )
+	{
+		ObjLine tokens( line );
+		if( Keyword( line, "v" ) )
+		{
+			tokens.token();
+			glm::vec3& p = mesh.positions[position++];
+			p.x = tokens.number();
+			p.y = tokens.number();
+			p.z = tokens.number();
+		}
+		else if( Keyword( line, "vt" ) )
+		{
+			tokens.token();
+			glm::vec2& t = mesh.uvs[uv++];
+			t.x = tokens.number();
+			// OBJ puts the origin at the bottom left, Vulkan samples from the top left
+			t.y = 1.0f - tokens.number();
+		}
+		else if( Keyword( line, "vn" ) )
+		{
+			tokens.token();
+			glm::vec3& n = mesh.normals[normal++];
+			n.x = tokens.number();
+			n.y = tokens.number();
+			n.z = tokens.number();
+		}
+		else if( Keyword( line, "f" ) )
+		{
+			tokens.token();
+			face.clear();
+			// v, v/vt, v//vn or v/vt/vn
+			for( std::string_view corner = tokens.token(); !corner.empty(); corner = tokens.token() )
+			{
+				size_t slash1 = corner.find( '/' );
+				size_t slash2 = slash1 == std::string_view::npos ? slash1 : corner.find( '/', slash1 + 1 );
+				std::string_view v = corner.substr( 0, slash1 );
+				std::string_view vt = slash1 == std::string_view::npos ? std::string_view() : corner.substr( slash1 + 1, slash2 - slash1 - 1 );
+				std::string_view vn = slash2 == std::string_view::npos ? std::string_view() : corner.substr( slash2 + 1 );
+				face.push_back( { ResolveObjIndex( v, position, totalPositions ),
+								  ResolveObjIndex( vt, uv, totalUvs ),
+								  ResolveObjIndex( vn, normal, totalNormals ) } );
+				if( face.back().x < 0 )
+					throw std::runtime_error( "OBJ face corner without a position!" );
+			}
+			// Polygons as triangle fans
+			for( size_t i = 2; i < face.size(); i++ )
+			{
+				chunk.corners.push_back( face[0] );
+				chunk.corners.push_back( face[i - 1] );
+				chunk.corners.push_back( face[i] );
+			}
+		}
+	} );
+}
+
+// Corners sharing position, uv and normal share a vertex. Only inside the chunk, the few
+// vertices repeated at chunk borders aren't worth a global map
+void WeldObjChunk( ObjChunk& chunk )
+{
+	std::unordered_map<glm::ivec3, uint32_t, CornerHash> welded;
+	welded.reserve( chunk.corners.size() / 2 );
+	chunk.indices.reserve( chunk.corners.size() );
+	for( const glm::ivec3& corner : chunk.corners )
+	{
+		auto [found, inserted] = welded.try_emplace( corner, static_cast<uint32_t>( chunk.vertices.size() ) );
+		if( inserted )
+			chunk.vertices.push_back( corner );
+		chunk.indices.push_back( found->second );
+	}
+	chunk.corners = {};
+}
+
+// glTF
+
+enum GltfComponent : uint32_t
+{
+	Byte = 5120,
+	UnsignedByte = 5121,
+	Short = 5122,
+	UnsignedShort = 5123,
+	UnsignedInt = 5125,
+	Float = 5126
+};
+
+const uint32_t GlbMagic = 0x46546C67;  // "glTF"
+const uint32_t GlbJsonChunk = 0x4E4F534A;
+const uint32_t GlbBinChunk = 0x004E4942;
+
+struct GltfFile
+{
+	Scope<MappedFile> file;
+	std::vector<Scope<MappedFile>> external;
+	Json json;
+	std::vector<std::span<const std::byte>> buffers;
+};
+
+// Elements of an accessor inside a mapped buffer
+struct GltfAccessor
+{
+	const std::byte* data = nullptr;
+	size_t count = 0;
+	size_t stride = 0;
+	uint32_t componentType = 0;
+	uint32_t components = 0;
+	bool normalized = false;
+};
+
+// Node placing a primitive, the mesh's vertices and indices start at the bases
+struct GltfDraw
+{
+	const Json* primitive;
+	glm::mat4 transform;
+	uint32_t firstVertex;
+	uint32_t firstIndex;
+};
+
+uint32_t ComponentSize( uint32_t componentType )
+{
+	switch( componentType )
+	{
+		case Byte:
+		case UnsignedByte: return 1;
+		case Short:
+		case UnsignedShort: return 2;
+		case UnsignedInt:
+		case Float: return 4;
+		default: throw std::runtime_error( "glTF accessor has an unknown component type!" );
+	}
+}
+
+// Index, count or offset of a glTF property. Missing (without a fallback), negative and
+// fractional values throw error, a plain cast of those to size_t is undefined
+size_t GltfUnsigned( const Json& value, const char* error, double fallback = -1.0 )
+{
+	double number = value.number( fallback );
+	// Past 2^53 doubles no longer hold every integer, far beyond any real file
+	if( !( number >= 0.0 ) || number != std::floor( number ) || number > 9007199254740992.0 )
+		throw std::runtime_error( error );
+	return static_cast<size_t>( number );
+}
+
+uint32_t ComponentCount( const std::string& type )
+{
+	if( type == "SCALAR" )
+		return 1;
+	if( type == "VEC2" )
+		return 2;
+	if( type == "VEC3" )
+		return 3;
+	if( type == "VEC4" )
+		return 4;
+	throw std::runtime_error( "glTF accessor type " + type + " isn't supported!" );
+}
+
+// %20 and friends, URIs of buffers are percent encoded
+std::string DecodeUri( const std::string& uri )
+{
+	std::string decoded;
+	for( size_t i = 0; i < uri.size(); i++ )
+	{
+		unsigned value = 0;
+		if( uri[i] == '%' && i + 2 < uri.size() &&
+			std::from_chars( uri.data() + i + 1, uri.data() + i + 3, value, 16 ).ptr == uri.data() + i + 3 )
+		{
+			decoded += static_cast<char>( value );
+			i += 2;
+		}
+		else
+			decoded += uri[i];
+	}
+	return decoded;
+}
+
+uint32_t ReadU32( const std::byte* data )
+{
+	uint32_t value;
+	std::memcpy( &value, data, sizeof( value ) );
+	return value;
+}
+
+GltfFile OpenGltf( const std::filesystem::path& path )
+{
+	GltfFile gltf;
+	gltf.file = CreateScope<MappedFile>( path );
+	std::span<const std::byte> bytes = gltf.file->bytes();
+
+	std::string_view jsonText;
+	std::span<const std::byte> bin;
+	if( bytes.size() >= 12 && ReadU32( bytes.data() ) == GlbMagic )
+	{
+		if( ReadU32( bytes.data() + 4 ) != 2 )
+			throw std::runtime_error( "only glTF 2.0 binaries are supported!" );
+		size_t length = std::min<size_t>( ReadU32( bytes.data() + 8 ), bytes.size() );
+		for( size_t pos = 12; pos + 8 <= length; )
+		{
+			size_t chunkLength = ReadU32( bytes.data() + pos );
+			uint32_t chunkType = ReadU32( bytes.data() + pos + 4 );
+			if( pos + 8 + chunkLength > length )
+				throw std::runtime_error( "glTF binary chunk runs past the file!" );
+			if( chunkType == GlbJsonChunk )
+				jsonText = { reinterpret_cast<const char*>( bytes.data() + pos + 8 ), chunkLength };
+			else if( chunkType == GlbBinChunk && bin.empty() )
+				bin = bytes.subspan( pos + 8, chunkLength );
+			// Chunks are 4 byte aligned
+			pos += 8 + ( ( chunkLength + 3 ) & ~size_t( 3 ) );
+		}
+	}
+	else
+		jsonText = { reinterpret_cast<const char*>( bytes.data() ), bytes.size() };
+
+	gltf.json = Json::Parse( jsonText );
+
+	const Json::Array& buffers = gltf.json["buffers"].array();
+	for( size_t i = 0; i < buffers.size(); i++ )
+	{
+		const Json& buffer = buffers[i];
+		size_t byteLength = GltfUnsigned( buffer["byteLength"], "glTF buffer without a valid byteLength!" );
+		std::span<const std::byte> data;
+		if( !buffer.contains( "uri" ) )
+		{
+			// Buffer 0 of a binary glTF is its BIN chunk
+			if( i != 0 || bin.empty() )
+				throw std::runtime_error( "glTF buffer without data!" );
+			data = bin;
+		}
+		else
+		{
+			const std::string& uri = buffer["uri"].string();
+			if( uri.rfind( "data:", 0 ) == 0 )
+				throw std::runtime_error( "glTF buffers embedded as data URIs aren't supported, export .glb or separate .bin files!" );
+			gltf.external.push_back( CreateScope<MappedFile>( path.parent_path() / std::filesystem::u8path( DecodeUri( uri ) ) ) );
+			data = gltf.external.back()->bytes();
+		}
+		if( data.size() < byteLength )
+			throw std::runtime_error( "glTF buffer is shorter than its byteLength!" );
+		gltf.buffers.push_back( data.first( byteLength ) );
+	}
+	return gltf;
+}
+
+GltfAccessor GetAccessor( const GltfFile& gltf, const Json& index )
+{
+	const Json& accessor = gltf.json["accessors"][GltfUnsigned( index, "glTF references a missing accessor!" )];
+	if( !accessor.isObject() )
+		throw std::runtime_error( "glTF references a missing accessor!" );
+	if( accessor.contains( "sparse" ) )
+		throw std::runtime_error( "sparse glTF accessors aren't supported!" );
+
+	GltfAccessor view;
+	view.count = GltfUnsigned( accessor["count"], "glTF accessor without a valid count!" );
+	view.componentType = static_cast<uint32_t>( GltfUnsigned( accessor["componentType"], "glTF accessor has an unknown component type!", 0.0 ) );
+	view.components = ComponentCount( accessor["type"].string() );
+	view.normalized = accessor["normalized"].boolean();
+	size_t elementSize = ComponentSize( view.componentType ) * view.components;
+
+	const Json& bufferView = gltf.json["bufferViews"][GltfUnsigned( accessor["bufferView"], "glTF accessor without a buffer view!" )];
+	if( !bufferView.isObject() )
+		throw std::runtime_error( "glTF accessor without a buffer view!" );
+	size_t buffer = GltfUnsigned( bufferView["buffer"], "glTF buffer view references a missing buffer!" );
+	if( buffer >= gltf.buffers.size() )
+		throw std::runtime_error( "glTF buffer view references a missing buffer!" );
+
+	size_t viewOffset = GltfUnsigned( bufferView["byteOffset"], "glTF accessor runs past its buffer!", 0.0 );
+	size_t viewLength = GltfUnsigned( bufferView["byteLength"], "glTF accessor runs past its buffer!" );
+	size_t offset = GltfUnsigned( accessor["byteOffset"], "glTF accessor runs past its buffer!", 0.0 );
+	view.stride = elementSize;
+	if( bufferView.contains( "byteStride" ) )
+	{
+		// Limits of the glTF spec, they also keep the bounds check below from overflowing
+		view.stride = GltfUnsigned( bufferView["byteStride"], "glTF buffer view has an invalid byteStride!" );
+		if( view.stride < elementSize || view.stride > 252 || view.stride % 4 != 0 )
+			throw std::runtime_error( "glTF buffer view has an invalid byteStride!" );
+	}
+
+	// Written so that no sum or product can wrap around
+	size_t bufferSize = gltf.buffers[buffer].size();
+	if( viewLength > bufferSize || viewOffset > bufferSize - viewLength || offset > viewLength )
+		throw std::runtime_error( "glTF accessor runs past its buffer!" );
+	if( view.count > 0 && ( elementSize > viewLength - offset ||
+							view.count - 1 > ( viewLength - offset - elementSize ) / view.stride ) )
+		throw std::runtime_error( "glTF accessor runs past its buffer!" );
+	view.data = gltf.buffers[buffer].data() + viewOffset + offset;
+	return view;
+}
+
+// Components of element i as floats, normalized integers are scaled to [0, 1] or [-1, 1]
+template <uint32_t N>
+glm::vec<N, float> ReadFloats( const GltfAccessor& view, size_t i )
+{
+	glm::vec<N, float> value( 0.0f );
+	const std::byte* element = view.data + i * view.stride;
+	for( uint32_t c = 0; c < std::min( N, view.components ); c++ )
+	{
+		switch( view.componentType )
+		{
+			case Float: std::memcpy( &value[c], element + c * 4, 4 ); break;
+			case UnsignedByte: value[c] = static_cast<float>( std::to_integer<uint8_t>( element[c] ) ) / 255.0f; break;
+			case Byte: value[c] = std::max( static_cast<float>( static_cast<int8_t>( element[c] ) ) / 127.0f, -1.0f ); break;
+			case UnsignedShort:
+			{
+				uint16_t v;
+				std::memcpy( &v, element + c * 2, 2 );
+				value[c] = v / 65535.0f;
+				break;
+			}
+			case Short:
+			{
+				int16_t v;
+				std::memcpy( &v, element + c * 2, 2 );
+				value[c] = std::max( v / 32767.0f, -1.0f );
+				break;
+			}
+			default: throw std::runtime_error( "glTF attribute has an unsupported component type!" );
+		}
+	}
+	return value;
+}
+
+uint32_t ReadIndex( const GltfAccessor& view, size_t i )
+{
+	const std::byte* element = view.data + i * view.stride;
+	switch( view.componentType )
+	{
+		case UnsignedByte: return std::to_integer<uint8_t>( *element );
+		case UnsignedShort:
+		{
+			uint16_t v;
+			std::memcpy( &v, element, 2 );
+			return v;
+		}
+		case UnsignedInt: return ReadU32( element );
+		default: throw std::runtime_error( "glTF indices have an unsupported component type!" );
+	}
+}
+
+glm::mat4 NodeTransform( const Json& node )
+{
+	if( node.contains( "matrix" ) )
+	{
+		// Column major, like glm
+		float values[16];
+		for( size_t i = 0; i < 16; i++ )
+			values[i] = static_cast<float>( node["matrix"][i].number( i % 5 == 0 ? 1.0 : 0.0 ) );
+		return glm::make_mat4( values );
+	}
+
+	const Json& t = node["translation"];
+	const Json& r = node["rotation"];
+	const Json& s = node["scale"];
+	glm::vec3 translation( t[0].number(), t[1].number(), t[2].number() );
+	glm::quat rotation( static_cast<float>( r[3].number( 1.0 ) ),
+						static_cast<float>( r[0].number() ),
+						static_cast<float>( r[1].number() ),
+						static_cast<float>( r[2].number() ) );
+	glm::vec3 scale( s[0].number( 1.0 ), s[1].number( 1.0 ), s[2].number( 1.0 ) );
+	return glm::translate( glm::mat4( 1.0f ), translation ) * glm::mat4_cast( rotation ) * glm::scale( glm::mat4( 1.0f ), scale );
+}
+
+void CollectGltfDraws( const GltfFile& gltf, size_t nodeIndex, const glm::mat4& parent, uint32_t depth, std::vector<GltfDraw>& draws )
+{
+	const Json& node = gltf.json["nodes"][nodeIndex];
+	if( !node.isObject() || depth > 64 )
+		throw std::runtime_error( "glTF node hierarchy is invalid!" );
+
+	glm::mat4 transform = parent * NodeTransform( node );
+	if( node.contains( "mesh" ) )
+	{
+		const Json& mesh = gltf.json["meshes"][GltfUnsigned( node["mesh"], "glTF node references a missing mesh!" )];
+		for( const Json& primitive : mesh["primitives"].array() )
+		{
+			// Triangle lists only, points and lines have nothing to shade
+			if( primitive["mode"].number( 4.0 ) != 4.0 || !primitive["attributes"].contains( "POSITION" ) )
+				continue;
+			draws.push_back( { &primitive, transform, 0, 0 } );
+		}
+	}
+	for( const Json& child : node["children"].array() )
+		CollectGltfDraws( gltf, GltfUnsigned( child, "glTF node hierarchy is invalid!" ), transform, depth + 1, draws );
+}
+
+// Writes the primitive's vertices and indices at the draw's bases, returns whether it had normals
+bool ReadGltfDraw( const GltfFile& gltf, const GltfDraw& draw, MeshData& mesh )
+{
+	const Json& attributes = ( *draw.primitive )["attributes"];
+	GltfAccessor positions = GetAccessor( gltf, attributes["POSITION"] );
+	size_t count = positions.count;
+
+	glm::mat3 normalMatrix = glm::transpose( glm::inverse( glm::mat3( draw.transform ) ) );
+	for( size_t v = 0; v < count; v++ )
+		mesh.positions[draw.firstVertex + v] = glm::vec3( draw.transform * glm::vec4( ReadFloats<3>( positions, v ), 1.0f ) );
+
+	bool hasNormals = attributes.contains( "NORMAL" );
+	if( hasNormals )
+	{
+		GltfAccessor normals = GetAccessor( gltf, attributes["NORMAL"] );
+		if( normals.count != count )
+			throw std::runtime_error( "glTF attributes differ in length!" );
+		for( size_t v = 0; v < count; v++ )
+		{
+			glm::vec3 normal = normalMatrix * ReadFloats<3>( normals, v );
+			float length = glm::length( normal );
+			mesh.normals[draw.firstVertex + v] = length > 0.0f ? normal / length : glm::vec3( 0.0f, 0.0f, 1.0f );
+		}
+	}
+
+	if( attributes.contains( "TEXCOORD_0" ) )
+	{
+		GltfAccessor uvs = GetAccessor( gltf, attributes["TEXCOORD_0"] );
+		if( uvs.count != count )
+			throw std::runtime_error( "glTF attributes differ in length!" );
+		for( size_t v = 0; v < count; v++ )
+			mesh.uvs[draw.firstVertex + v] = ReadFloats<2>( uvs, v );
+	}
+
+	// Mirroring transforms turn the winding and the tangent frames' handedness around
+	bool flip = glm::determinant( glm::mat3( draw.transform ) ) < 0.0f;
+
+	// Only allocated when some primitive has them, the others are generated
+	if( attributes.contains( "TANGENT" ) && !mesh.tangents.empty() )
+	{
+		GltfAccessor tangents = GetAccessor( gltf, attributes["TANGENT"] );
+		if( tangents.count != count )
+			throw std::runtime_error( "glTF attributes differ in length!" );
+		for( size_t v = 0; v < count; v++ )
+		{
+			glm::vec4 tangent = ReadFloats<4>( tangents, v );
+			glm::vec3 direction = glm::mat3( draw.transform ) * glm::vec3( tangent );
+			float length = glm::length( direction );
+			if( length > 0.0f )
+				mesh.tangents[draw.firstVertex + v] = glm::vec4( direction / length, ( tangent.w < 0.0f ) != flip ? -1.0f : 1.0f );
+		}
+	}
+	uint32_t* indices = mesh.indices.data() + draw.firstIndex;
+	const Json& indexAccessor = ( *draw.primitive )["indices"];
+	size_t indexCount = count;
+	if( indexAccessor.isNumber() )
+	{
+		GltfAccessor view = GetAccessor( gltf, indexAccessor );
+		indexCount = view.count;
+		for( size_t i = 0; i < view.count; i++ )
+		{
+			uint32_t index = ReadIndex( view, i );
+			if( index >= count )
+				throw std::runtime_error( "glTF index out of range!" );
+			indices[i] = draw.firstVertex + index;
+		}
+	}
+	else
+	{
+		for( size_t i = 0; i < count; i++ )
+			indices[i] = draw.firstVertex + static_cast<uint32_t>( i );
+	}
+
+	if( flip )
+		for( size_t i = 0; i + 2 < indexCount; i += 3 )
+			std::swap( indices[i + 1], indices[i + 2] );
+	return hasNormals;
+}
+
+}  // namespace
+
+MeshData MeshImporter::Load( const std::filesystem::path& path, JobSystem& jobs )
+{
+	std::string extension = path.extension().string();
+	std::transform( extension.begin(), extension.end(), extension.begin(), []( unsigned char c )
+	{
+		return static_cast<char>( std::tolower( c ) );
+	} );
+
+	if( extension == ".obj" )
+		return LoadObj( path, jobs );
+	if( extension == ".gltf" || extension == ".glb" )
+		return LoadGltf( path, jobs );
+	throw std::runtime_error( "unknown mesh format: " + path.string() );
+}
+
+MeshData MeshImporter::LoadObj( const std::filesystem::path& path, JobSystem& jobs )
+{
+	TRACE_ZONE( "LoadObj" );
+	MappedFile file( path );
+	std::string_view text( reinterpret_cast<const char*>( file.data() ), file.size() );
+
+	// A few chunks per thread so uneven ones balance out, none smaller than 256 KB
+	size_t numChunks = std::clamp<size_t>( text.size() >> 18, 1, jobs.numThreads() * 4 );
+	std::vector<ObjChunk> chunks( numChunks );
+	size_t start = 0;
+	for( size_t c = 0; c < numChunks; c++ )
+	{
+		size_t end = c + 1 == numChunks ? text.size() : std::max( start, text.size() * ( c + 1 ) / numChunks );
+		// Chunks end after a line
+		end = std::min( text.find( '\n', end ), text.size() );
+		if( end < text.size() )
+			end++;
+		chunks[c].text = text.substr( start, end - start );
+		start = end;
+	}
+
+	// Pass 1: counts, to place every chunk's elements in the global arrays
+	jobs.parallelFor( static_cast<uint32_t>( numChunks ), 1, [&]( uint32_t first, uint32_t count )
+	{
+		for( uint32_t c = first; c < first + count; c++ )
+		{
+			ForEachLine( chunks[c].text, [&]( std::string_view line )
+			{
+				if( Keyword( line, "v" ) )
+					chunks[c].positions++;
+				else if( Keyword( line, "vt" ) )
+					chunks[c].uvs++;
+				else if( Keyword( line, "vn" ) )
+					chunks[c].normals++;
+			} );
+		}
+	} );
+
+	uint32_t totalPositions = 0, totalUvs = 0, totalNormals = 0;
+	for( ObjChunk& chunk : chunks )
+	{
+		chunk.firstPosition = totalPositions;
+		chunk.firstUv = totalUvs;
+		chunk.firstNormal = totalNormals;
+		totalPositions += chunk.positions;
+		totalUvs += chunk.uvs;
+		totalNormals += chunk.normals;
+	}
+
+	// Pass 2: elements straight into their place, faces into corners, then welded per chunk
+	MeshData elements;
+	elements.positions.resize( totalPositions );
+	elements.uvs.resize( totalUvs );
+	elements.normals.resize( totalNormals );
+	jobs.parallelFor( static_cast<uint32_t>( numChunks ), 1, [&]( uint32_t first, uint32_t count )
+	{
+		for( uint32_t c = first; c < first + count; c++ )
+		{
+			ParseObjChunk( chunks[c], elements, totalPositions, totalUvs, totalNormals );
+			WeldObjChunk( chunks[c] );
+		}
+	} );
+
+	uint32_t totalVertices = 0, totalIndices = 0;
+	for( ObjChunk& chunk : chunks )
+	{
+		chunk.firstVertex = totalVertices;
+		chunk.firstIndex = totalIndices;
+		totalVertices += static_cast<uint32_t>( chunk.vertices.size() );
+		totalIndices += static_cast<uint32_t>( chunk.indices.size() );
+	}
+
+	// Pass 3: gather the welded vertices
+	MeshData mesh;
+	mesh.positions.resize( totalVertices );
+	mesh.normals.resize( totalVertices );
+	mesh.uvs.resize( totalVertices );
+	mesh.indices.resize( totalIndices );
+	jobs.parallelFor( static_cast<uint32_t>( numChunks ), 1, [&]( uint32_t first, uint32_t count )
+	{
+		for( uint32_t c = first; c < first + count; c++ )
+		{
+			ObjChunk& chunk = chunks[c];
+			for( size_t v = 0; v < chunk.vertices.size(); v++ )
+			{
+				const glm::ivec3& corner = chunk.vertices[v];
+				mesh.positions[chunk.firstVertex + v] = elements.positions[corner.x];
+				mesh.uvs[chunk.firstVertex + v] = corner.y >= 0 ? elements.uvs[corner.y] : glm::vec2( 0.0f );
+				// Zero normals are generated below
+				mesh.normals[chunk.firstVertex + v] = corner.z >= 0 ? elements.normals[corner.z] : glm::vec3( 0.0f );
+			}
+			for( size_t i = 0; i < chunk.indices.size(); i++ )
+				mesh.indices[chunk.firstIndex + i] = chunk.firstVertex + chunk.indices[i];
+			chunk.vertices = {};
+			chunk.indices = {};
+		}
+	} );
+	elements = {};
+
+	mesh.computeNormals();
+	mesh.computeBounds();
+	return mesh;
+}
+
+MeshData MeshImporter::LoadGltf( const std::filesystem::path& path, JobSystem& jobs )
+{
+	TRACE_ZONE( "LoadGltf" );
+	GltfFile gltf = OpenGltf( path );
+
+	// The default scene, or every root node when there's no scene
+	std::vector<GltfDraw> draws;
+	const Json& scenes = gltf.json["scenes"];
+	if( scenes.size() > 0 )
+	{
+		const Json& scene = scenes[GltfUnsigned( gltf.json["scene"], "glTF references a missing scene!", 0.0 )];
+		for( const Json& node : scene["nodes"].array() )
+			CollectGltfDraws( gltf, GltfUnsigned( node, "glTF node hierarchy is invalid!" ), glm::mat4( 1.0f ), 0, draws );
+	}
+	else
+	{
+		std::vector<bool> isChild( gltf.json["nodes"].size(), false );
+		for( const Json& node : gltf.json["nodes"].array() )
+			for( const Json& child : node["children"].array() )
+			{
+				size_t index = GltfUnsigned( child, "glTF node hierarchy is invalid!" );
+				if( index < isChild.size() )
+					isChild[index] = true;
+			}
+		for( size_t n = 0; n < isChild.size(); n++ )
+			if( !isChild[n] )
+				CollectGltfDraws( gltf, n, glm::mat4( 1.0f ), 0, draws );
+	}
+
+	// Accessor counts size the mesh, every draw then fills its own range
+	uint64_t totalVertices = 0, totalIndices = 0;
+	for( GltfDraw& draw : draws )
+	{
+		size_t vertices = GetAccessor( gltf, ( *draw.primitive )["attributes"]["POSITION"] ).count;
+		const Json& indices = ( *draw.primitive )["indices"];
+		draw.firstVertex = static_cast<uint32_t>( totalVertices );
+		draw.firstIndex = static_cast<uint32_t>( totalIndices );
+		totalVertices += vertices;
+		totalIndices += indices.isNumber() ? GetAccessor( gltf, indices ).count : vertices;
+	}
+	if( totalVertices > UINT32_MAX || totalIndices > UINT32_MAX )
+		throw std::runtime_error( "glTF scene has too many vertices!" );
+
+	MeshData mesh;
+	mesh.positions.resize( totalVertices );
+	mesh.normals.resize( totalVertices, glm::vec3( 0.0f ) );
+	mesh.uvs.resize( totalVertices, glm::vec2( 0.0f ) );
+	mesh.indices.resize( totalIndices );
+	if( std::any_of( draws.begin(), draws.end(), []( const GltfDraw& draw )
+	{
+		return ( *draw.primitive )["attributes"].contains( "TANGENT" );
+	} ) )
+		mesh.tangents.resize( totalVertices, glm::vec4( 0.0f ) );
+
+	std::atomic<bool> missingNormals = false;
+	jobs.parallelFor( static_cast<uint32_t>( draws.size() ), 1, [&]( uint32_t first, uint32_t count )
+	{
+		for( uint32_t d = first; d < first + count; d++ )
+			if( !ReadGltfDraw( gltf, draws[d], mesh ) )
+				missingNormals = true;
+	} );
+
+	if( missingNormals )
+		mesh.computeNormals();
+	if( !mesh.tangents.empty() )
+		mesh.computeTangents();
+	mesh.computeBounds();
+	return mesh;
+}
@@ -0,0 +1,31 @@
+#include <vulkan/OffscreenTarget.hpp>
+
+#include <vulkan/Device.hpp>
+
+using namespace vulkan;
+
+OffscreenTarget::OffscreenTarget( const Device& device,
+								  MemoryAllocator& allocator,
+								  VkExtent2D extent,
+								  VkFormat format,
+								  uint32_t numImages )
+	: m_imageFormat( format ),
+	m_extent( extent )
+{
+	VkImageCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	createInfo.imageType = VK_IMAGE_TYPE_2D;
+	createInfo.format = m_imageFormat;
+	createInfo.extent = { m_extent.width, m_extent.height, 1 };
+	createInfo.mipLevels = 1;
+	createInfo.arrayLayers = 1;
+	createInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	createInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	// Rendered to, then copied out by whoever consumes the frames
+	createInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+	createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	createInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+	for( uint32_t i = 0; i < numImages; i++ )
+		m_images.push_back( CreateScope<Image>( device, allocator, createInfo, VK_IMAGE_ASPECT_COLOR_BIT ) );
+}
@@ -0,0 +1,119 @@
+#include <vulkan/ParallelRecorder.hpp>
+#include <vulkan/Device.hpp>
+
+#include "common/trace.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace vulkan;
+
+ParallelRecorder::ParallelRecorder( const Device& device, JobSystem& jobs )
+	: m_device( device ),
+	m_jobs( jobs )
+{}
+
+ParallelRecorder::~ParallelRecorder()
+{
+	for( auto& frame : m_frames )
+		for( ThreadFrame& thread : frame )
+			if( !thread.buffers.empty() )
+				vkFreeCommandBuffers( m_device.logical(), thread.pool->handle(),
+									  static_cast<uint32_t>( thread.buffers.size() ), thread.buffers.data() );
+}
+
+void ParallelRecorder::ensureFrameSlot( uint32_t frameSlot )
+{
+	while( m_frames.size() <= frameSlot )
+	{
+		std::vector<ThreadFrame> frame( m_jobs.numThreads() );
+		for( ThreadFrame& thread : frame )
+			thread.pool = CreateScope<CommandPool>( m_device, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT );
+		m_frames.push_back( std::move( frame ) );
+	}
+}
+
+VkCommandBuffer ParallelRecorder::nextBuffer( ThreadFrame& frame )
+{
+	if( frame.used == frame.buffers.size() )
+	{
+		VkCommandBufferAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.commandPool = frame.pool->handle();
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+		allocInfo.commandBufferCount = 1;
+
+		VkCommandBuffer cmd;
+		if( vkAllocateCommandBuffers( m_device.logical(), &allocInfo, &cmd ) != VK_SUCCESS )
+			throw std::runtime_error( "failed to allocate secondary command buffer!" );
+		frame.buffers.push_back( cmd );
+	}
+	return frame.buffers[frame.used++];
+}
+
+const std::vector<VkCommandBuffer>& ParallelRecorder::record( uint32_t frameSlot,
+															  const VkCommandBufferInheritanceInfo& inheritance,
+															  uint32_t drawCount,
+															  const RecordSliceFunc& func,
+															  uint32_t maxSlices )
+{
+	ensureFrameSlot( frameSlot );
+
+	// Frame slot retired and no job runs yet, so the pools can be recycled from here
+	std::vector<ThreadFrame>& frame = m_frames[frameSlot];
+	for( ThreadFrame& thread : frame )
+	{
+		thread.pool->reset();
+		thread.used = 0;
+	}
+
+	uint32_t wanted = ( drawCount + MinDrawsPerSlice - 1 ) / MinDrawsPerSlice;
+	uint32_t slices = std::clamp( wanted, 1u, std::max( 1u, std::min( maxSlices, m_jobs.numThreads() ) ) );
+	uint32_t perSlice = ( drawCount + slices - 1 ) / slices;
+	m_recorded.assign( slices, VK_NULL_HANDLE );
+
+	auto recordSlice = [&, perSlice]( uint32_t slice )
+	{
+		TRACE_ZONE( "RecordSlice" );
+
+		// Slices running on the same thread share its pool, never across threads
+		VkCommandBuffer cmd = nextBuffer( frame[JobSystem::CurrentThreadIndex()] );
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		beginInfo.pInheritanceInfo = &inheritance;
+
+		if( vkBeginCommandBuffer( cmd, &beginInfo ) != VK_SUCCESS )
+			throw std::runtime_error( "failed to begin recording secondary command buffer!" );
+
+		uint32_t first = std::min( slice * perSlice, drawCount );
+		uint32_t count = std::min( perSlice, drawCount - first );
+		func( cmd, first, count );
+
+		if( vkEndCommandBuffer( cmd ) != VK_SUCCESS )
+			throw std::runtime_error( "failed to record secondary command buffer!" );
+
+		m_recorded[slice] = cmd;
+	};
+
+	JobCounter counter;
+	for( uint32_t slice = 1; slice < slices; slice++ )
+		m_jobs.run( [&recordSlice, slice] { recordSlice( slice ); }, &counter );
+
+	// Jobs reference this frame, let them finish even if the first slice fails
+	std::exception_ptr error;
+	try
+	{
+		recordSlice( 0 );
+	}
+	catch( ... )
+	{
+		error = std::current_exception();
+	}
+	m_jobs.wait( counter );
+	if( error )
+		std::rethrow_exception( error );
+
+	return m_recorded;
+}
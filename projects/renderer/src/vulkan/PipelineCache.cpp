@@ -0,0 +1,120 @@
+#include <vulkan/PipelineCache.hpp>
+#include <vulkan/Device.hpp>
+
+#include "common/file.hpp"
+
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+using namespace vulkan;
+
+PipelineCache::PipelineCache( const Device& device, std::filesystem::path path )
+	: m_device( device ),
+	m_path( std::move( path ) ),
+	m_cache( VK_NULL_HANDLE ),
+	m_loadedSize( 0 ),
+	m_shaderModules( device ),
+	m_pipelineLayouts( device )
+{
+	std::vector<char> data = load();
+
+	VkPipelineCacheCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	createInfo.initialDataSize = data.size();
+	createInfo.pInitialData = data.data();
+
+	if( vkCreatePipelineCache( m_device.logical(), &createInfo, nullptr, &m_cache ) == VK_SUCCESS )
+	{
+		m_loadedSize = data.size();
+		return;
+	}
+
+	// The driver may still refuse a blob that passed our checks
+	createInfo.initialDataSize = 0;
+	createInfo.pInitialData = nullptr;
+	if( vkCreatePipelineCache( m_device.logical(), &createInfo, nullptr, &m_cache ) != VK_SUCCESS )
+		throw std::runtime_error( "failed to create pipeline cache!" );
+}
+
+PipelineCache::~PipelineCache()
+{
+	try
+	{
+		save();
+	}
+	catch( std::exception& e )
+	{
+		std::cerr << "Pipeline cache not saved: " << e.what() << std::endl;
+	}
+	vkDestroyPipelineCache( m_device.logical(), m_cache, nullptr );
+}
+
+std::vector<char> PipelineCache::load() const
+{
+	std::error_code error;
+	if( !std::filesystem::exists( m_path, error ) )
+		return {};
+
+	std::vector<char> data;
+	try
+	{
+		data = LoadFile( m_path );
+	}
+	catch( std::exception& )
+	{
+		return {};
+	}
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties( m_device.physical(), &properties );
+	if( !IsCompatible( properties, data ) )
+		return {};
+	return data;
+}
+
+void PipelineCache::save()
+{
+	size_t size = 0;
+	if( vkGetPipelineCacheData( m_device.logical(), m_cache, &size, nullptr ) != VK_SUCCESS )
+		throw std::runtime_error( "failed to get pipeline cache size!" );
+
+	// The cache only grows, same size means nothing new was compiled
+	if( size == m_loadedSize )
+		return;
+
+	std::vector<char> data( size );
+	if( vkGetPipelineCacheData( m_device.logical(), m_cache, &size, data.data() ) != VK_SUCCESS )
+		throw std::runtime_error( "failed to get pipeline cache data!" );
+	data.resize( size );
+
+	SaveFileAtomic( m_path, data.data(), data.size() );
+	m_loadedSize = size;
+}
+
+bool PipelineCache::IsCompatible( const VkPhysicalDeviceProperties& properties, const std::vector<char>& data )
+{
+	// VkPipelineCacheHeaderVersionOne, the UUID changes with the driver version
+	struct Header
+	{
+		uint32_t headerSize;
+		uint32_t headerVersion;
+		uint32_t vendorID;
+		uint32_t deviceID;
+		uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+	};
+	static_assert( sizeof( Header ) == 16 + VK_UUID_SIZE );
+
+	if( data.size() < sizeof( Header ) )
+		return false;
+
+	Header header;
+	std::memcpy( &header, data.data(), sizeof( Header ) );
+
+	return header.headerSize >= sizeof( Header ) &&
+		   header.headerSize <= data.size() &&
+		   header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+		   header.vendorID == properties.vendorID &&
+		   header.deviceID == properties.deviceID &&
+		   std::memcmp( header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE ) == 0;
+}
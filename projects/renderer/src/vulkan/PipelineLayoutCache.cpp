@@ -0,0 +1,129 @@
+#include <vulkan/PipelineLayoutCache.hpp>
+#include <vulkan/Device.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace vulkan;
+
+PipelineLayoutCache::PipelineLayoutCache( const Device& device )
+	: m_device( device )
+{}
+
+PipelineLayoutCache::~PipelineLayoutCache()
+{
+	for( auto& [key, layout] : m_layouts )
+		vkDestroyPipelineLayout( m_device.logical(), layout.layout, nullptr );
+	for( auto& [key, setLayout] : m_setLayouts )
+		vkDestroyDescriptorSetLayout( m_device.logical(), setLayout, nullptr );
+}
+
+const PipelineLayoutCache::Layout& PipelineLayoutCache::get( const Shaders& shaders )
+{
+	const Ref<Shader> stages[] = { shaders.Vert, shaders.Frag };
+	return get( stages );
+}
+
+const PipelineLayoutCache::Layout& PipelineLayoutCache::get( std::span<const Ref<Shader>> stages )
+{
+	// Bindings of every stage by set, stage flags merged
+	std::vector<std::vector<VkDescriptorSetLayoutBinding>> sets;
+	VkPushConstantRange pushConstants = {};
+	for( const Ref<Shader>& shader : stages )
+	{
+		const ShaderReflection& reflection = shader->GetReflection();
+		for( const ShaderReflection::Binding& binding : reflection.bindings )
+		{
+			if( sets.size() <= binding.set )
+				sets.resize( binding.set + 1 );
+			std::vector<VkDescriptorSetLayoutBinding>& set = sets[binding.set];
+
+			auto existing = std::find_if( set.begin(), set.end(), [&binding]( const auto& b )
+			{
+				return b.binding == binding.binding;
+			} );
+			if( existing == set.end() )
+			{
+				VkDescriptorSetLayoutBinding layoutBinding = {};
+				layoutBinding.binding = binding.binding;
+				layoutBinding.descriptorType = binding.type;
+				layoutBinding.descriptorCount = binding.count;
+				layoutBinding.stageFlags = reflection.stage;
+				set.push_back( layoutBinding );
+			}
+			else if( existing->descriptorType != binding.type || existing->descriptorCount != binding.count )
+				throw std::runtime_error( "shader stages disagree on a descriptor binding" );
+			else
+				existing->stageFlags |= reflection.stage;
+		}
+
+		if( reflection.pushConstantSize > 0 )
+		{
+			// One range every stage can see, simpler than splitting the block by member use
+			pushConstants.stageFlags |= reflection.stage;
+			pushConstants.size = std::max( pushConstants.size, reflection.pushConstantSize );
+		}
+	}
+
+	std::lock_guard lock( m_mutex );
+
+	std::vector<VkDescriptorSetLayout> setLayouts;
+	std::vector<uint64_t> key;
+	for( auto& set : sets )
+	{
+		std::sort( set.begin(), set.end(), []( const auto& a, const auto& b ) { return a.binding < b.binding; } );
+		setLayouts.push_back( setLayout( set ) );
+		key.push_back( reinterpret_cast<uint64_t>( setLayouts.back() ) );
+	}
+	key.push_back( pushConstants.stageFlags );
+	key.push_back( pushConstants.size );
+
+	auto found = m_layouts.find( key );
+	if( found != m_layouts.end() )
+		return found->second;
+
+	VkPipelineLayoutCreateInfo layoutInfo = {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	layoutInfo.setLayoutCount = static_cast<uint32_t>( setLayouts.size() );
+	layoutInfo.pSetLayouts = setLayouts.data();
+	layoutInfo.pushConstantRangeCount = pushConstants.size > 0 ? 1 : 0;
+	layoutInfo.pPushConstantRanges = &pushConstants;
+
+	Layout layout = { VK_NULL_HANDLE, std::move( setLayouts ), pushConstants };
+	if( vkCreatePipelineLayout( m_device.logical(), &layoutInfo, nullptr, &layout.layout ) != VK_SUCCESS )
+		throw std::runtime_error( "Pipeline Layout creation failed" );
+	return m_layouts.emplace( std::move( key ), std::move( layout ) ).first->second;
+}
+
+size_t PipelineLayoutCache::size() const
+{
+	std::lock_guard lock( m_mutex );
+	return m_layouts.size();
+}
+
+VkDescriptorSetLayout PipelineLayoutCache::setLayout( const std::vector<VkDescriptorSetLayoutBinding>& bindings )
+{
+	std::vector<uint64_t> key;
+	for( const VkDescriptorSetLayoutBinding& binding : bindings )
+	{
+		key.push_back( binding.binding );
+		key.push_back( binding.descriptorType );
+		key.push_back( binding.descriptorCount );
+		key.push_back( binding.stageFlags );
+	}
+
+	auto found = m_setLayouts.find( key );
+	if( found != m_setLayouts.end() )
+		return found->second;
+
+	VkDescriptorSetLayoutCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	createInfo.bindingCount = static_cast<uint32_t>( bindings.size() );
+	createInfo.pBindings = bindings.data();
+
+	VkDescriptorSetLayout setLayout;
+	if( vkCreateDescriptorSetLayout( m_device.logical(), &createInfo, nullptr, &setLayout ) != VK_SUCCESS )
+		throw std::runtime_error( "failed to create descriptor set layout!" );
+	m_setLayouts.emplace( std::move( key ), setLayout );
+	return setLayout;
+}
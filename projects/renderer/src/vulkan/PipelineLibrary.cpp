@@ -0,0 +1,164 @@
+#include <vulkan/PipelineLibrary.hpp>
+#include <vulkan/DeletionQueue.hpp>
+#include <vulkan/Device.hpp>
+#include <vulkan/PipelineCache.hpp>
+#include <vulkan/PipelineLayoutCache.hpp>
+
+#include "common/job_system.hpp"
+#include "common/trace.hpp"
+
+#include <iostream>
+
+using namespace vulkan;
+
+PipelineLibrary::PipelineLibrary( const Device& device,
+								  JobSystem& jobs,
+								  const PipelineCache* cache,
+								  DeletionQueue* deletion )
+	: m_device( device ),
+	m_jobs( jobs ),
+	m_cache( cache ),
+	m_deletion( deletion )
+{
+	if( !m_cache )
+		m_ownLayouts = CreateScope<PipelineLayoutCache>( m_device );
+}
+
+PipelineLibrary::~PipelineLibrary()
+{
+	m_compiling.drain();
+
+	for( auto& [hash, bucket] : m_entries )
+		for( auto& entry : bucket )
+			vkDestroyPipeline( m_device.logical(), entry->pipeline.load(), nullptr );
+}
+
+VkPipeline PipelineLibrary::get( const PipelineDesc& unresolved, VkPipeline fallback )
+{
+	PipelineDesc desc = resolve( unresolved );
+	std::lock_guard lock( m_mutex );
+	bool created = false;
+	Ref<Entry>& entry = find( desc, created );
+	if( created )
+		compile( entry );
+
+	VkPipeline pipeline = entry->pipeline.load( std::memory_order_acquire );
+	return pipeline != VK_NULL_HANDLE ? pipeline : fallback;
+}
+
+VkPipeline PipelineLibrary::require( const PipelineDesc& unresolved )
+{
+	PipelineDesc desc = resolve( unresolved );
+	{
+		std::lock_guard lock( m_mutex );
+		bool created = false;
+		Ref<Entry>& entry = find( desc, created );
+		VkPipeline pipeline = entry->pipeline.load( std::memory_order_acquire );
+		if( pipeline != VK_NULL_HANDLE )
+			return pipeline;
+		// A background compile may be in flight, it loses the race and gets dropped
+		if( !created )
+		{
+			retire( *entry );
+			entry = CreateRef<Entry>();
+			entry->desc = desc;
+		}
+	}
+
+	VkPipeline pipeline = GraphicsPipeline::Create( m_device, desc, m_cache );
+
+	std::lock_guard lock( m_mutex );
+	bool created = false;
+	Ref<Entry>& entry = find( desc, created );
+	VkPipeline existing = entry->pipeline.load( std::memory_order_acquire );
+	if( existing != VK_NULL_HANDLE )
+	{
+		// Someone else required it meanwhile, nothing recorded with ours yet
+		vkDestroyPipeline( m_device.logical(), pipeline, nullptr );
+		return existing;
+	}
+	entry->pipeline.store( pipeline, std::memory_order_release );
+	return pipeline;
+}
+
+void PipelineLibrary::clear()
+{
+	std::lock_guard lock( m_mutex );
+	for( auto& [hash, bucket] : m_entries )
+		for( auto& entry : bucket )
+			retire( *entry );
+	m_entries.clear();
+}
+
+size_t PipelineLibrary::size() const
+{
+	std::lock_guard lock( m_mutex );
+	size_t count = 0;
+	for( const auto& [hash, bucket] : m_entries )
+		count += bucket.size();
+	return count;
+}
+
+Ref<PipelineLibrary::Entry>& PipelineLibrary::find( const PipelineDesc& desc, bool& created )
+{
+	std::vector<Ref<Entry>>& bucket = m_entries[desc.hash()];
+	for( Ref<Entry>& entry : bucket )
+		if( entry->desc == desc )
+			return entry;
+
+	created = true;
+	Ref<Entry>& entry = bucket.emplace_back( CreateRef<Entry>() );
+	entry->desc = desc;
+	return entry;
+}
+
+void PipelineLibrary::compile( Ref<Entry> entry )
+{
+	m_jobs.runBackground( [this, entry]
+	{
+		VkPipeline pipeline = VK_NULL_HANDLE;
+		try
+		{
+			pipeline = GraphicsPipeline::Create( m_device, entry->desc, m_cache );
+		}
+		catch( const std::exception& e )
+		{
+			// Stays on the fallback
+			std::cerr << "Pipeline compile failed: " << e.what() << std::endl;
+		}
+
+		{
+			std::lock_guard lock( m_mutex );
+			// Never handed out, no frame can be using it
+			if( entry->retired )
+				vkDestroyPipeline( m_device.logical(), pipeline, nullptr );
+			else
+				entry->pipeline.store( pipeline, std::memory_order_release );
+		}
+	}, &m_compiling );
+}
+
+PipelineDesc PipelineLibrary::resolve( const PipelineDesc& desc ) const
+{
+	PipelineDesc resolved = desc;
+	if( resolved.layout == VK_NULL_HANDLE )
+	{
+		PipelineLayoutCache& layouts = m_cache ? m_cache->pipelineLayouts() : *m_ownLayouts;
+		resolved.layout = layouts.get( resolved.shaders ).layout;
+	}
+	return resolved;
+}
+
+void PipelineLibrary::retire( Entry& entry )
+{
+	entry.retired = true;
+	VkPipeline pipeline = entry.pipeline.exchange( VK_NULL_HANDLE );
+	if( pipeline == VK_NULL_HANDLE )
+		return;
+
+	VkDevice device = m_device.logical();
+	DeletionQueue::Defer( m_deletion, [device, pipeline]
+	{
+		vkDestroyPipeline( device, pipeline, nullptr );
+	} );
+}
@@ -17,6 +17,7 @@ QueueFamilyIndices QueueFamily::FindQueueFamilies( const VkPhysicalDevice& devic
 	vkGetPhysicalDeviceQueueFamilyProperties( device, &familyCount, families.data() );
 
 	// Iterate through families until one that supports requirements is found
+	bool needPresent = surface != VK_NULL_HANDLE;
 	bool found = false;
 	for( int i = 0; !found && i < families.size(); i++ )
 	{
@@ -27,12 +28,26 @@ QueueFamilyIndices QueueFamily::FindQueueFamilies( const VkPhysicalDevice& devic
 			indices.graphicsFamily = i;
 
 		// Check for surface presentation support
-		VkBool32 presentSupport = false;
-		vkGetPhysicalDeviceSurfaceSupportKHR( device, i, surface, &presentSupport );
-		if( presentSupport )
-			indices.presentFamily = i;
+		if( needPresent )
+		{
+			VkBool32 presentSupport = false;
+			vkGetPhysicalDeviceSurfaceSupportKHR( device, i, surface, &presentSupport );
+			if( presentSupport )
+				indices.presentFamily = i;
+		}
+
+		found = indices.isComplete( needPresent );
+	}
+
+	// First family that only copies, compute families can copy too but aren't the copy engines
+	for( uint32_t i = 0; i < families.size(); i++ )
+	{
+		VkQueueFlags flags = families[i].queueFlags;
+		if( flags & VK_QUEUE_GRAPHICS_BIT )
+			continue;
 
-		found = indices.isComplete();
+		if( ( flags & VK_QUEUE_TRANSFER_BIT ) && !( flags & VK_QUEUE_COMPUTE_BIT ) && !indices.transferFamily.has_value() )
+			indices.transferFamily = i;
 	}
 	return indices;
 }
\ No newline at end of file
@@ -0,0 +1,88 @@
+#include <vulkan/QueueSync.hpp>
+
+#include <stdexcept>
+
+using namespace vulkan;
+
+VkBufferMemoryBarrier QueueSync::BufferTransfer( VkBuffer buffer,
+												 VkDeviceSize offset,
+												 VkDeviceSize size,
+												 uint32_t srcFamily,
+												 uint32_t dstFamily,
+												 VkAccessFlags srcAccess,
+												 VkAccessFlags dstAccess )
+{
+	bool transfer = srcFamily != dstFamily;
+
+	VkBufferMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	barrier.srcAccessMask = srcAccess;
+	barrier.dstAccessMask = dstAccess;
+	barrier.srcQueueFamilyIndex = transfer ? srcFamily : VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = transfer ? dstFamily : VK_QUEUE_FAMILY_IGNORED;
+	barrier.buffer = buffer;
+	barrier.offset = offset;
+	barrier.size = size;
+	return barrier;
+}
+
+VkImageMemoryBarrier QueueSync::ImageTransfer( VkImage image,
+											   const VkImageSubresourceRange& range,
+											   VkImageLayout oldLayout,
+											   VkImageLayout newLayout,
+											   uint32_t srcFamily,
+											   uint32_t dstFamily,
+											   VkAccessFlags srcAccess,
+											   VkAccessFlags dstAccess )
+{
+	bool transfer = srcFamily != dstFamily;
+
+	VkImageMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.srcAccessMask = srcAccess;
+	barrier.dstAccessMask = dstAccess;
+	barrier.oldLayout = oldLayout;
+	barrier.newLayout = newLayout;
+	barrier.srcQueueFamilyIndex = transfer ? srcFamily : VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = transfer ? dstFamily : VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image;
+	barrier.subresourceRange = range;
+	return barrier;
+}
+
+void TimelineSubmit::wait( VkSemaphore semaphore, uint64_t value, VkPipelineStageFlags stages )
+{
+	m_waits.push_back( semaphore );
+	m_waitValues.push_back( value );
+	m_waitStages.push_back( stages );
+}
+
+void TimelineSubmit::signal( VkSemaphore semaphore, uint64_t value )
+{
+	m_signals.push_back( semaphore );
+	m_signalValues.push_back( value );
+}
+
+void TimelineSubmit::submit( VkQueue queue, const std::vector<VkCommandBuffer>& commands, VkFence fence ) const
+{
+	VkTimelineSemaphoreSubmitInfo timelineInfo = {};
+	timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+	timelineInfo.waitSemaphoreValueCount = static_cast<uint32_t>( m_waitValues.size() );
+	timelineInfo.pWaitSemaphoreValues = m_waitValues.data();
+	timelineInfo.signalSemaphoreValueCount = static_cast<uint32_t>( m_signalValues.size() );
+	timelineInfo.pSignalSemaphoreValues = m_signalValues.data();
+
+	VkSubmitInfo submitInfo = {};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.pNext = &timelineInfo;
+	submitInfo.waitSemaphoreCount = static_cast<uint32_t>( m_waits.size() );
+	submitInfo.pWaitSemaphores = m_waits.data();
+	submitInfo.pWaitDstStageMask = m_waitStages.data();
+	submitInfo.commandBufferCount = static_cast<uint32_t>( commands.size() );
+	submitInfo.pCommandBuffers = commands.data();
+	submitInfo.signalSemaphoreCount = static_cast<uint32_t>( m_signals.size() );
+	submitInfo.pSignalSemaphores = m_signals.data();
+
+	if( vkQueueSubmit( queue, 1, &submitInfo, fence ) != VK_SUCCESS )
+		throw std::runtime_error( "failed to submit to queue!" );
+}
@@ -0,0 +1,591 @@
+#include <vulkan/RenderGraph.hpp>
+#include <vulkan/Device.hpp>
+#include <vulkan/RenderTarget.hpp>
+
+#include "common/trace.hpp"
+
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+
+using namespace vulkan;
+
+namespace
+{
+enum class Use
+{
+	None,
+	Write,
+	Read
+};
+
+bool Contains( const std::vector<uint32_t>& values, uint32_t value )
+{
+	return std::find( values.begin(), values.end(), value ) != values.end();
+}
+}  // namespace
+
+RenderGraph::RenderGraph( const Device& device,
+						  Desc desc,
+						  const GpuProfiler* profiler,
+						  DeletionQueue* deletion )
+	: m_device( device ),
+	m_profiler( profiler ),
+	m_deletion( deletion ),
+	m_desc( std::move( desc ) ),
+	m_backend( device.dynamicRendering() ? Backend::DynamicRendering : Backend::RenderPasses )
+{
+	for( const RenderTarget* target : m_desc.resources )
+		m_formats.push_back( target->imageFormat() );
+	compile();
+}
+
+void RenderGraph::compile()
+{
+	// Merge passes into the current render pass until one needs what it produced as a texture
+	// or wants a cleared attachment it already drew to, both need a render pass boundary
+	std::vector<uint32_t> groupReads;
+	for( uint32_t p = 0; p < m_desc.passes.size(); p++ )
+	{
+		const Pass& pass = m_desc.passes[p];
+		for( uint32_t r : pass.colorWrites )
+			if( r >= m_desc.resources.size() )
+				throw std::runtime_error( "Render graph pass writes an unknown resource" );
+		for( uint32_t r : pass.sampledReads )
+			if( r >= m_desc.resources.size() || Contains( pass.colorWrites, r ) )
+				throw std::runtime_error( "Render graph pass reads an unknown resource or its own attachment" );
+
+		bool split = m_groups.empty();
+		if( !split )
+		{
+			const Group& group = m_groups.back();
+			for( uint32_t r : pass.sampledReads )
+				split |= Contains( group.attachments, r );
+			for( uint32_t r : pass.colorWrites )
+				split |= Contains( groupReads, r ) || ( pass.clear && Contains( group.attachments, r ) );
+		}
+		if( split )
+		{
+			m_groups.emplace_back();
+			groupReads.clear();
+		}
+
+		Group& group = m_groups.back();
+		m_locations.push_back( { static_cast<uint32_t>( m_groups.size() - 1 ), static_cast<uint32_t>( group.passes.size() ) } );
+		group.passes.push_back( p );
+		groupReads.insert( groupReads.end(), pass.sampledReads.begin(), pass.sampledReads.end() );
+		for( uint32_t r : pass.colorWrites )
+		{
+			if( !Contains( group.attachments, r ) )
+			{
+				group.attachments.push_back( r );
+				VkClearValue clear{};
+				clear.color = pass.clearColor;
+				group.clearValues.push_back( clear );
+			}
+		}
+	}
+
+	for( const Group& group : m_groups )
+		if( group.attachments.empty() )
+			throw std::runtime_error( "Render graph pass has nothing to draw to" );
+
+	if( m_backend == Backend::DynamicRendering )
+	{
+		compileRendering();
+		return;
+	}
+
+	for( uint32_t g = 0; g < m_groups.size(); g++ )
+		m_renderPasses.push_back( CreateScope<RenderPass>( m_device, describeGroup( g ), m_deletion ) );
+}
+
+RenderPassDesc RenderGraph::describeGroup( uint32_t g ) const
+{
+	const Group& group = m_groups[g];
+
+	auto groupUse = [this]( uint32_t group, uint32_t r )
+	{
+		for( uint32_t p : m_groups[group].passes )
+		{
+			if( Contains( m_desc.passes[p].colorWrites, r ) )
+				return Use::Write;
+			if( Contains( m_desc.passes[p].sampledReads, r ) )
+				return Use::Read;
+		}
+		return Use::None;
+	};
+
+	RenderPassDesc desc;
+	desc.subpasses.resize( group.passes.size() );
+
+	// Dependencies from outside the render pass, merged per subpass
+	std::vector<VkSubpassDependency> external( group.passes.size() );
+	for( uint32_t s = 0; s < external.size(); s++ )
+	{
+		external[s].srcSubpass = VK_SUBPASS_EXTERNAL;
+		external[s].dstSubpass = s;
+	}
+	std::map<std::pair<uint32_t, uint32_t>, VkSubpassDependency> internal;
+
+	for( uint32_t a = 0; a < group.attachments.size(); a++ )
+	{
+		uint32_t r = group.attachments[a];
+
+		Use prev = Use::None;
+		for( uint32_t before = 0; before < g; before++ )
+			if( Use use = groupUse( before, r ); use != Use::None )
+				prev = use;
+		Use next = Use::None;
+		for( uint32_t after = g + 1; after < m_groups.size() && next == Use::None; after++ )
+			next = groupUse( after, r );
+
+		// Subpasses drawing to the attachment, in order
+		std::vector<uint32_t> writers;
+		for( uint32_t s = 0; s < group.passes.size(); s++ )
+			if( Contains( m_desc.passes[group.passes[s]].colorWrites, r ) )
+				writers.push_back( s );
+		const Pass& firstWriter = m_desc.passes[group.passes[writers.front()]];
+
+		VkAttachmentDescription attachment = {};
+		attachment.format = m_desc.resources[r]->imageFormat();
+		attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+		// Clear if asked, keep what earlier render passes drew, otherwise nothing worth loading
+		if( firstWriter.clear )
+			attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		else if( prev != Use::None )
+			attachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+		else
+			attachment.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		// Resources are targets whose images outlive the frame (presented or read back)
+		attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+
+		// Layout before is whatever the last user left, unless the contents are discarded anyway
+		if( attachment.loadOp != VK_ATTACHMENT_LOAD_OP_LOAD )
+			attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		else if( prev == Use::Read )
+			attachment.initialLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		else
+			attachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		// Layout after is whatever the next user needs, the target's own after the last one
+		if( next == Use::Read )
+			attachment.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		else if( next == Use::Write )
+			attachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		else
+			attachment.finalLayout = m_desc.resources[r]->finalLayout();
+
+		desc.attachments.push_back( attachment );
+		desc.targets.push_back( m_desc.resources[r] );
+
+		for( uint32_t s : writers )
+			desc.subpasses[s].colors.push_back( { a, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL } );
+		// Subpasses between two writers must keep the attachment
+		for( uint32_t s = writers.front() + 1; s < writers.back(); s++ )
+			if( !Contains( writers, s ) )
+				desc.subpasses[s].preserves.push_back( a );
+
+		// The first writer waits for the previous user (or the image acquire on the same stage),
+		// later ones for the writer before them
+		VkSubpassDependency& in = external[writers.front()];
+		in.srcStageMask |= prev == Use::Read ? VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT
+											 : VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		in.srcAccessMask |= prev == Use::Write ? VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT : 0;
+		in.dstStageMask |= VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		in.dstAccessMask |= VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		if( attachment.loadOp == VK_ATTACHMENT_LOAD_OP_LOAD )
+			in.dstAccessMask |= VK_ACCESS_COLOR_ATTACHMENT_READ_BIT;
+
+		for( size_t w = 1; w < writers.size(); w++ )
+		{
+			VkSubpassDependency& dep = internal[{ writers[w - 1], writers[w] }];
+			dep.srcSubpass = writers[w - 1];
+			dep.dstSubpass = writers[w];
+			dep.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+			dep.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+			dep.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+			dep.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+			dep.dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+		}
+
+		// A later render pass samples it, make the writes visible to its fragment shaders
+		if( next == Use::Read )
+		{
+			VkSubpassDependency out = {};
+			out.srcSubpass = writers.back();
+			out.dstSubpass = VK_SUBPASS_EXTERNAL;
+			out.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+			out.dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+			out.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+			out.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			desc.dependencies.push_back( out );
+		}
+	}
+
+	for( const VkSubpassDependency& in : external )
+		if( in.dstStageMask != 0 )
+			desc.dependencies.push_back( in );
+	for( const auto& [subpasses, dep] : internal )
+		desc.dependencies.push_back( dep );
+
+	return desc;
+}
+
+void RenderGraph::compileRendering()
+{
+	struct State
+	{
+		VkImageLayout layout;
+		VkPipelineStageFlags stage;
+		VkAccessFlags access;
+	};
+
+	// Swap chain images are acquired waiting at the color output stage, so first uses
+	// chain onto that wait. Contents from previous frames are never kept
+	std::vector<State> states( m_desc.resources.size(),
+							   { VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0 } );
+	std::vector<bool> used( m_desc.resources.size(), false );
+
+	auto use = [&]( std::vector<Transition>& transitions, uint32_t r, State next, bool keepContents )
+	{
+		State& prev = states[r];
+		// Two reads in the same layout need nothing between them
+		bool writes = ( prev.access | next.access ) & VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		if( !used[r] || writes || prev.layout != next.layout )
+			transitions.push_back( { r,
+									 keepContents ? prev.layout : VK_IMAGE_LAYOUT_UNDEFINED,
+									 next.layout,
+									 prev.stage,
+									 next.stage,
+									 prev.access & VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+									 next.access } );
+		prev = next;
+		used[r] = true;
+	};
+
+	m_renderingPasses.resize( m_desc.passes.size() );
+	for( uint32_t p = 0; p < m_desc.passes.size(); p++ )
+	{
+		const Pass& pass = m_desc.passes[p];
+		RenderingPass& rendering = m_renderingPasses[p];
+
+		for( uint32_t r : pass.sampledReads )
+			use( rendering.transitions, r,
+				 { VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT },
+				 true );
+
+		for( uint32_t r : pass.colorWrites )
+		{
+			// Clear if asked, keep what earlier passes drew, otherwise nothing worth loading
+			VkAttachmentLoadOp loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			if( pass.clear )
+				loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+			else if( states[r].layout != VK_IMAGE_LAYOUT_UNDEFINED )
+				loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+
+			VkAccessFlags access = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+			if( loadOp == VK_ATTACHMENT_LOAD_OP_LOAD )
+				access |= VK_ACCESS_COLOR_ATTACHMENT_READ_BIT;
+
+			use( rendering.transitions, r,
+				 { VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, access },
+				 loadOp == VK_ATTACHMENT_LOAD_OP_LOAD );
+			rendering.loadOps.push_back( loadOp );
+		}
+	}
+
+	// Hand the targets over in their own layout, presentation waits on a semaphore instead
+	for( uint32_t r = 0; r < m_desc.resources.size(); r++ )
+	{
+		if( !used[r] )
+			continue;
+		VkImageLayout layout = m_desc.resources[r]->finalLayout();
+		if( layout == VK_IMAGE_LAYOUT_PRESENT_SRC_KHR )
+			use( m_finalTransitions, r, { layout, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0 }, true );
+		else
+			use( m_finalTransitions, r, { layout, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_ACCESS_MEMORY_READ_BIT }, true );
+	}
+
+	updateRenderingFormats();
+}
+
+void RenderGraph::updateRenderingFormats()
+{
+	for( uint32_t p = 0; p < m_renderingPasses.size(); p++ )
+	{
+		RenderingPass& rendering = m_renderingPasses[p];
+		rendering.formats.clear();
+		for( uint32_t r : m_desc.passes[p].colorWrites )
+			rendering.formats.push_back( m_formats[r] );
+
+		rendering.pipelineRendering = {};
+		rendering.pipelineRendering.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+		rendering.pipelineRendering.colorAttachmentCount = static_cast<uint32_t>( rendering.formats.size() );
+		rendering.pipelineRendering.pColorAttachmentFormats = rendering.formats.data();
+
+		rendering.inheritanceRendering = {};
+		rendering.inheritanceRendering.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO_KHR;
+		rendering.inheritanceRendering.colorAttachmentCount = static_cast<uint32_t>( rendering.formats.size() );
+		rendering.inheritanceRendering.pColorAttachmentFormats = rendering.formats.data();
+		rendering.inheritanceRendering.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+	}
+}
+
+void RenderGraph::record( VkCommandBuffer cmd, uint32_t imageIndex ) const
+{
+	if( m_profiler )
+		m_profiler->reset( cmd, imageIndex );
+
+	// Its zone is written even when nothing is recorded, the slot's queries all become available
+	if( m_profiler && m_desc.prologueZone )
+		m_profiler->beginZone( cmd, imageIndex, *m_desc.prologueZone );
+	if( m_desc.prologue )
+		m_desc.prologue( cmd, imageIndex );
+	if( m_profiler && m_desc.prologueZone )
+		m_profiler->endZone( cmd, imageIndex, *m_desc.prologueZone );
+
+	if( m_backend == Backend::DynamicRendering )
+		recordRendering( cmd, imageIndex );
+	else
+		recordRenderPasses( cmd, imageIndex );
+}
+
+void RenderGraph::executePass( const Pass& pass, VkCommandBuffer cmd, uint32_t imageIndex, VkExtent2D extent ) const
+{
+	if( pass.contents == VK_SUBPASS_CONTENTS_INLINE )
+		SetViewport( cmd, extent );
+	if( pass.execute )
+	{
+		TRACE_ZONE( pass.name );
+		pass.execute( cmd, imageIndex );
+	}
+}
+
+void RenderGraph::transition( VkCommandBuffer cmd, uint32_t imageIndex, const std::vector<Transition>& transitions ) const
+{
+	if( transitions.empty() )
+		return;
+
+	VkPipelineStageFlags srcStages = 0;
+	VkPipelineStageFlags dstStages = 0;
+	std::vector<VkImageMemoryBarrier> barriers;
+	for( const Transition& t : transitions )
+	{
+		const RenderTarget& target = *m_desc.resources[t.resource];
+
+		VkImageMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcAccessMask = t.srcAccess;
+		barrier.dstAccessMask = t.dstAccess;
+		barrier.oldLayout = t.oldLayout;
+		barrier.newLayout = t.newLayout;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = target.image( static_cast<uint32_t>( imageIndex % target.numImages() ) );
+		barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+		barriers.push_back( barrier );
+
+		srcStages |= t.srcStage;
+		dstStages |= t.dstStage;
+	}
+
+	vkCmdPipelineBarrier( cmd, srcStages, dstStages, 0,
+						  0, nullptr, 0, nullptr,
+						  static_cast<uint32_t>( barriers.size() ), barriers.data() );
+}
+
+void RenderGraph::recordRendering( VkCommandBuffer cmd, uint32_t imageIndex ) const
+{
+	for( uint32_t p = 0; p < m_desc.passes.size(); p++ )
+	{
+		const Pass& pass = m_desc.passes[p];
+		const RenderingPass& rendering = m_renderingPasses[p];
+
+		transition( cmd, imageIndex, rendering.transitions );
+
+		if( m_profiler && pass.zone )
+			m_profiler->beginZone( cmd, imageIndex, *pass.zone );
+
+		std::vector<VkRenderingAttachmentInfoKHR> attachments( pass.colorWrites.size() );
+		for( size_t a = 0; a < attachments.size(); a++ )
+		{
+			const RenderTarget& target = *m_desc.resources[pass.colorWrites[a]];
+			attachments[a].sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+			attachments[a].imageView = target.imageView( static_cast<uint32_t>( imageIndex % target.numImages() ) );
+			attachments[a].imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			attachments[a].loadOp = rendering.loadOps[a];
+			attachments[a].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+			attachments[a].clearValue.color = pass.clearColor;
+		}
+
+		VkRenderingInfoKHR info = {};
+		info.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+		if( pass.contents == VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS )
+			info.flags = VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT_KHR;
+		info.renderArea.offset = { 0, 0 };
+		info.renderArea.extent = extent( p );
+		info.layerCount = 1;
+		info.colorAttachmentCount = static_cast<uint32_t>( attachments.size() );
+		info.pColorAttachments = attachments.data();
+
+		m_device.cmdBeginRendering( cmd, info );
+		executePass( pass, cmd, imageIndex, info.renderArea.extent );
+		m_device.cmdEndRendering( cmd );
+
+		if( m_profiler && pass.zone )
+			m_profiler->endZone( cmd, imageIndex, *pass.zone );
+	}
+
+	transition( cmd, imageIndex, m_finalTransitions );
+}
+
+void RenderGraph::recordRenderPasses( VkCommandBuffer cmd, uint32_t imageIndex ) const
+{
+	// Timestamps can't be written inside a subpass that executes secondary buffers,
+	// such a pass' time is attributed to the zone open before it
+	std::optional<GpuZone> openZone;
+	std::vector<GpuZone> untimed;
+	auto switchZone = [&]( std::optional<GpuZone> zone )
+	{
+		if( !m_profiler )
+			return;
+		if( openZone )
+			m_profiler->endZone( cmd, imageIndex, *openZone );
+		// Still written so the slot's queries all become available
+		for( GpuZone skipped : untimed )
+		{
+			m_profiler->beginZone( cmd, imageIndex, skipped );
+			m_profiler->endZone( cmd, imageIndex, skipped );
+		}
+		untimed.clear();
+		openZone = zone;
+		if( openZone )
+			m_profiler->beginZone( cmd, imageIndex, *openZone );
+	};
+
+	for( uint32_t g = 0; g < m_groups.size(); g++ )
+	{
+		const Group& group = m_groups[g];
+		const RenderPass& renderPass = *m_renderPasses[g];
+		const Pass& first = m_desc.passes[group.passes.front()];
+
+		switchZone( first.zone );
+
+		VkRenderPassBeginInfo render_passInfo{};
+		render_passInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		render_passInfo.renderPass = renderPass.handle();
+		render_passInfo.framebuffer = renderPass.frameBuffer( imageIndex );
+		render_passInfo.renderArea.offset = { 0, 0 };
+		render_passInfo.renderArea.extent = renderPass.extent();
+		render_passInfo.clearValueCount = static_cast<uint32_t>( group.clearValues.size() );
+		render_passInfo.pClearValues = group.clearValues.data();
+
+		vkCmdBeginRenderPass( cmd, &render_passInfo, first.contents );
+
+		for( uint32_t s = 0; s < group.passes.size(); s++ )
+		{
+			const Pass& pass = m_desc.passes[group.passes[s]];
+			if( s > 0 )
+			{
+				vkCmdNextSubpass( cmd, pass.contents );
+				if( pass.contents == VK_SUBPASS_CONTENTS_INLINE )
+					switchZone( pass.zone );
+				else if( pass.zone )
+					untimed.push_back( *pass.zone );
+			}
+			executePass( pass, cmd, imageIndex, renderPass.extent() );
+		}
+
+		vkCmdEndRenderPass( cmd );
+		switchZone( std::nullopt );
+	}
+}
+
+bool RenderGraph::resize()
+{
+	bool formatsChanged = false;
+	for( size_t r = 0; r < m_desc.resources.size(); r++ )
+	{
+		formatsChanged |= m_formats[r] != m_desc.resources[r]->imageFormat();
+		m_formats[r] = m_desc.resources[r]->imageFormat();
+	}
+
+	if( m_backend == Backend::DynamicRendering )
+	{
+		// Image views are looked up while recording, only pipeline formats can go stale
+		if( formatsChanged )
+			updateRenderingFormats();
+		return formatsChanged;
+	}
+
+	for( auto& renderPass : m_renderPasses )
+	{
+		if( formatsChanged )
+			renderPass->recreate();
+		else
+			renderPass->recreateFrameBuffers();
+	}
+	return formatsChanged;
+}
+
+RenderGraph::PipelineTarget RenderGraph::pipelineTarget( uint32_t pass ) const
+{
+	if( m_backend == Backend::DynamicRendering )
+		return { VK_NULL_HANDLE, 0, &m_renderingPasses[pass].pipelineRendering };
+
+	const PassLocation& location = m_locations[pass];
+	return { m_renderPasses[location.group]->handle(), location.subpass, nullptr };
+}
+
+std::vector<VkFormat> RenderGraph::colorFormats( uint32_t pass ) const
+{
+	std::vector<VkFormat> formats;
+	for( uint32_t r : m_desc.passes[pass].colorWrites )
+		formats.push_back( m_formats[r] );
+	return formats;
+}
+
+VkCommandBufferInheritanceInfo RenderGraph::inheritance( uint32_t pass, uint32_t imageIndex ) const
+{
+	VkCommandBufferInheritanceInfo inheritance{};
+	inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+
+	if( m_backend == Backend::DynamicRendering )
+	{
+		inheritance.pNext = &m_renderingPasses[pass].inheritanceRendering;
+		return inheritance;
+	}
+
+	const PassLocation& location = m_locations[pass];
+	const RenderPass& render_pass = *m_renderPasses[location.group];
+	inheritance.renderPass = render_pass.handle();
+	inheritance.subpass = location.subpass;
+	inheritance.framebuffer = render_pass.frameBuffer( imageIndex );
+	return inheritance;
+}
+
+VkExtent2D RenderGraph::extent( uint32_t pass ) const
+{
+	const std::vector<uint32_t>& writes = m_desc.passes[pass].colorWrites;
+	return m_desc.resources[writes.empty() ? 0 : writes.front()]->extent();
+}
+
+void RenderGraph::SetViewport( VkCommandBuffer cmd, VkExtent2D extent )
+{
+	VkViewport viewport = {};
+	viewport.x = 0.0f;
+	viewport.y = 0.0f;
+	viewport.width = static_cast<float>( extent.width );
+	viewport.height = static_cast<float>( extent.height );
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+
+	VkRect2D scissor = {};
+	scissor.offset = { 0, 0 };
+	scissor.extent = extent;
+
+	vkCmdSetViewport( cmd, 0, 1, &viewport );
+	vkCmdSetScissor( cmd, 0, 1, &scissor );
+}
@@ -1,16 +1,18 @@
 
 #include <iostream>
+#include <stdexcept>
+#include <vulkan/DeletionQueue.hpp>
 #include <vulkan/Device.hpp>
 #include <vulkan/RenderPass.hpp>
-#include <vulkan/SwapChain.hpp>
+#include <vulkan/RenderTarget.hpp>
 
 using namespace vulkan;
 
-RenderPass::RenderPass( const Device& device, const SwapChain& swap_chain )
+RenderPass::RenderPass( const Device& device, RenderPassDesc desc, DeletionQueue* deletion )
 	: m_render_pass( VK_NULL_HANDLE ),
-	m_oldRenderPass( VK_NULL_HANDLE ),
 	m_device( device ),
-	m_swap_chain( swap_chain )
+	m_deletion( deletion ),
+	m_desc( std::move( desc ) )
 {
 	createRenderPass();
 	createFrameBuffers();
@@ -18,86 +20,63 @@ RenderPass::RenderPass( const Device& device, const SwapChain& swap_chain )
 
 RenderPass::~RenderPass()
 {
-	destroyFrameBuffers();
+	for( VkFramebuffer& fb : m_frameBuffers )
+		vkDestroyFramebuffer( m_device.logical(), fb, nullptr );
 	vkDestroyRenderPass( m_device.logical(), m_render_pass, nullptr );
 }
 
+const VkExtent2D& RenderPass::extent() const
+{
+	return m_desc.targets[0]->extent();
+}
+
 void RenderPass::recreate()
 {
-	destroyFrameBuffers();
-	m_oldRenderPass = m_render_pass;
+	retireFrameBuffers();
+
+	VkDevice device = m_device.logical();
+	VkRenderPass oldRenderPass = m_render_pass;
+	DeletionQueue::Defer( m_deletion, [device, oldRenderPass]
+	{
+		vkDestroyRenderPass( device, oldRenderPass, nullptr );
+	} );
+
 	createRenderPass();
 	createFrameBuffers();
 }
 
-void RenderPass::cleanupOld()
+void RenderPass::recreateFrameBuffers()
 {
-	if( m_oldRenderPass != VK_NULL_HANDLE )
-	{
-		vkDestroyRenderPass( m_device.logical(), m_oldRenderPass, nullptr );
-		m_oldRenderPass = VK_NULL_HANDLE;
-	}
+	retireFrameBuffers();
+	createFrameBuffers();
 }
 
 void RenderPass::createRenderPass()
 {
-	// Create a new render pass as a color attachment
-	VkAttachmentDescription colorAttachment = {};
-	// Format should match the format of the swap chain
-	colorAttachment.format = m_swap_chain.imageFormat();
-	// No multisampling
-	colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-	// Clear data before rendering, then store result after
-	colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-	colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-	// Not doing anything with stencils, so don't care about it
-	colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-	colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-	// Don't care about initial layout, but final layout should
-	// be same as the presentation source
-	colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-	// Post-rendering subpasses
-
-	// Subpass attachment reference
-	VkAttachmentReference colorRef = {};
-	// Index of 0 in color attachments description array (we're only using 1)
-	colorRef.attachment = 0;
-	// Use the optimal layout for color attachments
-	colorRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-	// Subpass description
-	VkSubpassDescription subpass = {};
-	// Using for graphics computation
-	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-	// Attach the color attachment
-	subpass.colorAttachmentCount = 1;
-	subpass.pColorAttachments = &colorRef;
-
-	// Subpass dependencies
-	VkSubpassDependency dependency = {};
-	// Implicit subpass
-	dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-	// Subpass depdency is in index 0
-	dependency.dstSubpass = 0;
-	// Wait for color attachment output before accessing image
-	// This prevents the image being accessed by subpass and swap chain at the same time
-	dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	dependency.srcAccessMask = 0;
-	// Prevent transistion from happening until after reading and writing of color attachment
-	dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	// Format should match the format of the target images, which may change on recreation
+	for( size_t i = 0; i < m_desc.attachments.size(); i++ )
+		m_desc.attachments[i].format = m_desc.targets[i]->imageFormat();
+
+	std::vector<VkSubpassDescription> subpasses( m_desc.subpasses.size() );
+	for( size_t i = 0; i < subpasses.size(); i++ )
+	{
+		// Using for graphics computation
+		subpasses[i].pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpasses[i].colorAttachmentCount = static_cast<uint32_t>( m_desc.subpasses[i].colors.size() );
+		subpasses[i].pColorAttachments = m_desc.subpasses[i].colors.data();
+		subpasses[i].preserveAttachmentCount = static_cast<uint32_t>( m_desc.subpasses[i].preserves.size() );
+		subpasses[i].pPreserveAttachments = m_desc.subpasses[i].preserves.data();
+	}
 
 	// Create the render pass
 	VkRenderPassCreateInfo createInfo = {};
 	createInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-	createInfo.attachmentCount = 1;
-	createInfo.pAttachments = &colorAttachment;
-	createInfo.subpassCount = 1;
-	createInfo.pSubpasses = &subpass;
-	createInfo.dependencyCount = 1;
-	createInfo.pDependencies = &dependency;
+	createInfo.attachmentCount = static_cast<uint32_t>( m_desc.attachments.size() );
+	createInfo.pAttachments = m_desc.attachments.data();
+	createInfo.subpassCount = static_cast<uint32_t>( subpasses.size() );
+	createInfo.pSubpasses = subpasses.data();
+	createInfo.dependencyCount = static_cast<uint32_t>( m_desc.dependencies.size() );
+	createInfo.pDependencies = m_desc.dependencies.data();
 
 	if( vkCreateRenderPass( m_device.logical(), &createInfo, nullptr, &m_render_pass ) != VK_SUCCESS )
 		throw std::runtime_error( "Render pass creation failed" );
@@ -105,21 +84,23 @@ void RenderPass::createRenderPass()
 
 void RenderPass::createFrameBuffers()
 {
-	size_t numImages = m_swap_chain.numImages();
+	size_t numImages = m_desc.targets[0]->numImages();
 	m_frameBuffers.resize( numImages );
 
-	// Create a framebuffer for each image view
+	// Create a framebuffer for each target image
+	std::vector<VkImageView> attachments( m_desc.targets.size() );
 	for( size_t i = 0; i < numImages; i++ )
 	{
-		VkImageView attachments[] = { m_swap_chain.imageView( i ) };
+		for( size_t a = 0; a < attachments.size(); a++ )
+			attachments[a] = m_desc.targets[a]->imageView( static_cast<uint32_t>( i % m_desc.targets[a]->numImages() ) );
 
 		VkFramebufferCreateInfo info = {};
 		info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
 		info.renderPass = m_render_pass;
-		info.attachmentCount = 1;
-		info.pAttachments = attachments;
-		info.width = m_swap_chain.extent().width;
-		info.height = m_swap_chain.extent().height;
+		info.attachmentCount = static_cast<uint32_t>( attachments.size() );
+		info.pAttachments = attachments.data();
+		info.width = extent().width;
+		info.height = extent().height;
 		info.layers = 1;
 
 		if( vkCreateFramebuffer( m_device.logical(), &info, nullptr, &m_frameBuffers[i] ) != VK_SUCCESS )
@@ -127,8 +108,14 @@ void RenderPass::createFrameBuffers()
 	}
 }
 
-void RenderPass::destroyFrameBuffers()
+void RenderPass::retireFrameBuffers()
 {
-	for( VkFramebuffer& fb : m_frameBuffers )
-		vkDestroyFramebuffer( m_device.logical(), fb, nullptr );
-}
\ No newline at end of file
+	// Frames in flight may still be rendering into them
+	VkDevice device = m_device.logical();
+	DeletionQueue::Defer( m_deletion, [device, frameBuffers = std::move( m_frameBuffers )]
+	{
+		for( VkFramebuffer fb : frameBuffers )
+			vkDestroyFramebuffer( device, fb, nullptr );
+	} );
+	m_frameBuffers.clear();
+}
@@ -1,24 +1,176 @@
 #include "vulkan/Shader.hpp"
 
+#include "common/hash.hpp"
+
+#include <stdexcept>
+#include <string>
+
+#include "base_vert.h"
+#include "base_frag.h"
+#include "mesh_vert.h"
+#include "mesh_quantized_vert.h"
+#include "instanced_vert.h"
+#include "mesh_indirect_vert.h"
+#include "cull_comp.h"
+
 namespace vulkan
 {
-Shader::Shader( std::vector<unsigned char> compiled_shader, Type type )
+static constexpr uint32_t SpirvMagic = 0x07230203;
+
+Shader::Shader( std::span<const uint32_t> static_code, Type type )
+	: mType( type )
+{
+	setCode( static_code.data(), static_code.size_bytes(), "embedded shader" );
+}
+
+Shader::Shader( const std::vector<unsigned char>& compiled_shader, Type type )
 	: mType( type ),
-	mData( std::move( compiled_shader ) )
-{}
+	mData( compiled_shader )
+{
+	setCode( mData.data(), mData.size(), "shader" );
+}
 
 Shader::Shader( std::vector<unsigned char>&& compiled_shader, Type type )
 	: mType( type ),
-	  mData( std::move( compiled_shader ) )
-{}
+	mData( std::move( compiled_shader ) )
+{
+	setCode( mData.data(), mData.size(), "shader" );
+}
 
 Shader::Shader( const std::filesystem::path& path, Type type )
+	: mType( type ),
+	mMapped( CreateScope<MappedFile>( path ) )
+{
+	setCode( mMapped->data(), mMapped->size(), path.string().c_str() );
+}
+
+void Shader::setCode( const void* data, size_t size, const char* source )
+{
+	// Vulkan reads the code as words. Mappings are page aligned, vectors allocate aligned
+	// for any fundamental type and embedded code is a word array, but check instead of relying on it
+	if( reinterpret_cast<uintptr_t>( data ) % alignof( uint32_t ) != 0 )
+		throw std::runtime_error( std::string( "failed to load shader " ) + source + ", its SPIR-V is misaligned!" );
+	if( size == 0 || size % sizeof( uint32_t ) != 0 )
+		throw std::runtime_error( std::string( "failed to load shader " ) + source + ", its size isn't a whole number of words!" );
+
+	mCode = { static_cast<const uint32_t*>( data ), size / sizeof( uint32_t ) };
+	if( mCode[0] != SpirvMagic )
+		throw std::runtime_error( std::string( "failed to load shader " ) + source + ", it isn't SPIR-V!" );
+
+	mHash = HashBytes( data, size );
+	mReflection = ShaderReflection::Reflect( mCode );
+}
+
+void Shader::SetSource( std::filesystem::path source, ShaderDefines defines, std::vector<std::filesystem::path> dependencies )
 {
+	mSource = std::move( source );
+	mDefines = std::move( defines );
+	mDependencies = std::move( dependencies );
 }
 
-std::vector<unsigned char> Shader::GetShaderData()
+std::span<const uint32_t> Shader::GetShaderData() const
 {
-	return mData;
+	return mCode;
 }
 
-}
\ No newline at end of file
+uint64_t Shader::GetHash() const
+{
+	return mHash;
+}
+
+Shaders GetBaseShaders()
+{
+	// Shared, every pipeline of the base shaders hits the same shader modules.
+	// The code stays in the binary's read-only data
+	static const Shaders shaders = []
+	{
+		Shaders base = { CreateRef<Shader>( BASE_VERT, Shader::Type::Vert ),
+						 CreateRef<Shader>( BASE_FRAG, Shader::Type::Frag ) };
+#ifdef BUBBLE_SHADER_DIR
+		// Built from the repository's shaders, hot reload picks up edits to them
+		std::filesystem::path directory = BUBBLE_SHADER_DIR;
+		base.Vert->SetSource( directory / "base.vert", {}, { directory / "base.vert" } );
+		base.Frag->SetSource( directory / "base.frag", {}, { directory / "base.frag" } );
+#endif
+		return base;
+	}();
+	return shaders;
+}
+
+Shaders GetMeshShaders()
+{
+	static const Shaders shaders = []
+	{
+		Shaders mesh = { CreateRef<Shader>( MESH_VERT, Shader::Type::Vert ), GetBaseShaders().Frag };
+#ifdef BUBBLE_SHADER_DIR
+		std::filesystem::path directory = BUBBLE_SHADER_DIR;
+		mesh.Vert->SetSource( directory / "mesh.vert", {}, { directory / "mesh.vert" } );
+#endif
+		return mesh;
+	}();
+	return shaders;
+}
+
+Shaders GetQuantizedMeshShaders()
+{
+	static const Shaders shaders = []
+	{
+		Shaders mesh = { CreateRef<Shader>( MESH_QUANTIZED_VERT, Shader::Type::Vert ), GetBaseShaders().Frag };
+#ifdef BUBBLE_SHADER_DIR
+		std::filesystem::path directory = BUBBLE_SHADER_DIR;
+		mesh.Vert->SetSource( directory / "mesh_quantized.vert",
+							  {},
+							  { directory / "mesh_quantized.vert", directory / "lib" / "vertex_decode.glsl" } );
+#endif
+		return mesh;
+	}();
+	return shaders;
+}
+
+Shaders GetInstancedShaders()
+{
+	static const Shaders shaders = []
+	{
+		Shaders instanced = { CreateRef<Shader>( INSTANCED_VERT, Shader::Type::Vert ), GetBaseShaders().Frag };
+#ifdef BUBBLE_SHADER_DIR
+		std::filesystem::path directory = BUBBLE_SHADER_DIR;
+		instanced.Vert->SetSource( directory / "instanced.vert",
+								   {},
+								   { directory / "instanced.vert", directory / "lib" / "instance.glsl" } );
+#endif
+		return instanced;
+	}();
+	return shaders;
+}
+
+Shaders GetMeshIndirectShaders()
+{
+	static const Shaders shaders = []
+	{
+		Shaders mesh = { CreateRef<Shader>( MESH_INDIRECT_VERT, Shader::Type::Vert ), GetBaseShaders().Frag };
+#ifdef BUBBLE_SHADER_DIR
+		std::filesystem::path directory = BUBBLE_SHADER_DIR;
+		mesh.Vert->SetSource( directory / "mesh_indirect.vert",
+							  {},
+							  { directory / "mesh_indirect.vert", directory / "lib" / "instance.glsl" } );
+#endif
+		return mesh;
+	}();
+	return shaders;
+}
+
+Ref<Shader> GetCullShader()
+{
+	static const Ref<Shader> shader = []
+	{
+		Ref<Shader> cull = CreateRef<Shader>( CULL_COMP, Shader::Type::Comp );
+#ifdef BUBBLE_SHADER_DIR
+		std::filesystem::path directory = BUBBLE_SHADER_DIR;
+		cull->SetSource( directory / "cull.comp", {}, { directory / "cull.comp", directory / "lib" / "instance.glsl" } );
+#endif
+		return cull;
+	}();
+	return shader;
+}
+
+}
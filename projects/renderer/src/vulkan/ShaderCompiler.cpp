@@ -0,0 +1,328 @@
+#include <vulkan/ShaderCompiler.hpp>
+
+#include "common/file.hpp"
+#include "common/hash.hpp"
+#include "common/job_system.hpp"
+#include "common/trace.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef BUBBLE_SHADERC
+#include <shaderc/shaderc.hpp>
+#endif
+
+using namespace vulkan;
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#endif
+
+static std::string ReadText( const std::filesystem::path& path )
+{
+	std::vector<char> text = LoadFile( path );
+	return std::string( text.begin(), text.end() );
+}
+
+// Source with every #include "file" pasted in, only hashed, the compiler resolves includes itself
+static void ExpandIncludes( const std::filesystem::path& path,
+							std::string& out,
+							std::vector<std::filesystem::path>& files,
+							uint32_t depth = 0 )
+{
+	if( depth > 32 )
+		throw std::runtime_error( "shader includes nest too deep: " + path.string() );
+	files.push_back( path.lexically_normal() );
+
+	std::istringstream source( ReadText( path ) );
+	std::string line;
+	while( std::getline( source, line ) )
+	{
+		size_t directive = line.find_first_not_of( " \t" );
+		if( directive != std::string::npos && line.compare( directive, 8, "#include" ) == 0 )
+		{
+			size_t open = line.find( '"', directive );
+			size_t close = open == std::string::npos ? open : line.find( '"', open + 1 );
+			if( close != std::string::npos )
+			{
+				ExpandIncludes( path.parent_path() / line.substr( open + 1, close - open - 1 ), out, files, depth + 1 );
+				continue;
+			}
+		}
+		out += line;
+		out += '\n';
+	}
+}
+
+// Names are identifiers and values plain tokens, so neither can break out of the compiler's command line
+static void ValidateDefines( const ShaderCompiler::Defines& defines )
+{
+	auto identifier = []( char c ) { return std::isalnum( static_cast<unsigned char>( c ) ) || c == '_'; };
+	for( const auto& [define, value] : defines )
+	{
+		if( define.empty() || std::isdigit( static_cast<unsigned char>( define[0] ) ) ||
+			!std::all_of( define.begin(), define.end(), identifier ) )
+			throw std::runtime_error( "invalid shader define name '" + define + "'!" );
+		if( !std::all_of( value.begin(), value.end(), [&]( char c ) { return identifier( c ) || c == '.' || c == '+' || c == '-'; } ) )
+			throw std::runtime_error( "invalid value '" + value + "' of shader define " + define + "!" );
+	}
+}
+
+#ifndef BUBBLE_SHADERC
+static const char* StageName( Shader::Type type )
+{
+	switch( type )
+	{
+		case Shader::Type::Vert: return "vert";
+		case Shader::Type::Frag: return "frag";
+		case Shader::Type::Comp: return "comp";
+	}
+	return "";
+}
+
+// Exit code of a shell command, stdout and stderr go to output
+static int RunCommand( const std::string& command, std::string& output )
+{
+	FILE* pipe = popen( ( command + " 2>&1" ).c_str(), "r" );
+	if( !pipe )
+		return -1;
+
+	char buffer[256];
+	while( fgets( buffer, sizeof( buffer ), pipe ) )
+		output += buffer;
+	return pclose( pipe );
+}
+
+static std::string Quote( const std::filesystem::path& path )
+{
+	return "\"" + path.string() + "\"";
+}
+#endif
+
+#ifdef BUBBLE_SHADERC
+// Resolves #include "file" next to the including file
+class ShaderIncluder : public shaderc::CompileOptions::IncluderInterface
+{
+	struct Include
+	{
+		std::string name;
+		std::string content;
+		shaderc_include_result result;
+	};
+
+	shaderc_include_result* GetInclude( const char* requested_source,
+										shaderc_include_type type,
+										const char* requesting_source,
+										size_t ) override
+	{
+		Include* include = new Include();
+		std::filesystem::path path = requested_source;
+		if( type == shaderc_include_type_relative )
+			path = std::filesystem::path( requesting_source ).parent_path() / requested_source;
+
+		try
+		{
+			include->content = ReadText( path );
+			include->name = path.string();
+		}
+		catch( const std::exception& )
+		{
+			// Empty name tells shaderc the content is the error
+			include->content = "can't read " + path.string();
+		}
+
+		include->result.source_name = include->name.c_str();
+		include->result.source_name_length = include->name.size();
+		include->result.content = include->content.c_str();
+		include->result.content_length = include->content.size();
+		include->result.user_data = include;
+		return &include->result;
+	}
+
+	void ReleaseInclude( shaderc_include_result* data ) override
+	{
+		delete static_cast<Include*>( data->user_data );
+	}
+};
+#endif
+
+ShaderCompiler::ShaderCompiler( JobSystem& jobs, std::filesystem::path cacheDir )
+	: m_jobs( jobs ),
+	m_cacheDir( std::move( cacheDir ) )
+{
+	std::filesystem::create_directories( m_cacheDir );
+
+#ifdef BUBBLE_SHADERC
+	unsigned int version = 0;
+	unsigned int revision = 0;
+	shaderc_get_spv_version( &version, &revision );
+	m_version = "shaderc spv " + std::to_string( version ) + "." + std::to_string( revision );
+#else
+	// Part of the cache key, an updated SDK recompiles everything
+	if( RunCommand( "glslangValidator --version", m_version ) != 0 )
+		std::cerr << "glslangValidator not found, runtime shader compiles will fail" << std::endl;
+#endif
+}
+
+ShaderCompiler::~ShaderCompiler()
+{
+	m_compiling.drain();
+}
+
+std::shared_future<Ref<Shader>> ShaderCompiler::request( const std::filesystem::path& source,
+														 Shader::Type type,
+														 const Defines& defines )
+{
+	// Keyed by name here, the content hash is taken on the worker
+	std::string path = source.string();
+	uint64_t name = HashBytes( path.data(), path.size() );
+	name = HashValue( type, name );
+	for( const auto& [define, value] : defines )
+	{
+		name = HashBytes( define.c_str(), define.size() + 1, name );
+		name = HashBytes( value.c_str(), value.size() + 1, name );
+	}
+
+	std::lock_guard lock( m_mutex );
+	auto found = m_requests.find( name );
+	if( found != m_requests.end() )
+		return found->second;
+
+	auto promise = CreateRef<std::promise<Ref<Shader>>>();
+	std::shared_future<Ref<Shader>> future = promise->get_future().share();
+	m_requests.emplace( name, future );
+
+	m_jobs.runBackground( [this, promise, source, type, defines]
+	{
+		try
+		{
+			promise->set_value( compile( source, type, defines ) );
+		}
+		catch( ... )
+		{
+			promise->set_exception( std::current_exception() );
+		}
+	}, &m_compiling );
+	return future;
+}
+
+void ShaderCompiler::invalidate()
+{
+	std::lock_guard lock( m_mutex );
+	m_requests.clear();
+}
+
+Ref<Shader> ShaderCompiler::compile( const std::filesystem::path& source, Shader::Type type, const Defines& defines ) const
+{
+	TRACE_ZONE( "CompileShader" );
+	ValidateDefines( defines );
+	std::vector<std::filesystem::path> dependencies;
+	std::filesystem::path cached = cachePath( key( source, type, defines, dependencies ) );
+
+	Ref<Shader> shader;
+	if( std::filesystem::exists( cached ) )
+	{
+		try
+		{
+			shader = CreateRef<Shader>( cached, type );
+		}
+		catch( const std::exception& e )
+		{
+			// Truncated or otherwise broken, compile it again
+			std::cerr << "Dropping cached shader " << cached << ": " << e.what() << std::endl;
+		}
+	}
+
+	if( !shader )
+	{
+		compileToFile( source, type, defines, cached );
+		shader = CreateRef<Shader>( cached, type );
+	}
+	shader->SetSource( source, defines, std::move( dependencies ) );
+	return shader;
+}
+
+uint64_t ShaderCompiler::key( const std::filesystem::path& source,
+							  Shader::Type type,
+							  const Defines& defines,
+							  std::vector<std::filesystem::path>& dependencies ) const
+{
+	std::string text;
+	ExpandIncludes( source, text, dependencies );
+
+	uint64_t hash = HashBytes( text.data(), text.size() );
+	hash = HashValue( type, hash );
+	for( const auto& [define, value] : defines )
+	{
+		// Terminators keep "A" "BC" and "AB" "C" apart
+		hash = HashBytes( define.c_str(), define.size() + 1, hash );
+		hash = HashBytes( value.c_str(), value.size() + 1, hash );
+	}
+	return HashBytes( m_version.data(), m_version.size(), hash );
+}
+
+std::filesystem::path ShaderCompiler::cachePath( uint64_t key ) const
+{
+	char name[32];
+	std::snprintf( name, sizeof( name ), "%016llx.spv", static_cast<unsigned long long>( key ) );
+	return m_cacheDir / name;
+}
+
+void ShaderCompiler::compileToFile( const std::filesystem::path& source,
+									Shader::Type type,
+									const Defines& defines,
+									const std::filesystem::path& output ) const
+{
+#ifdef BUBBLE_SHADERC
+	shaderc::CompileOptions options;
+	options.SetTargetEnvironment( shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_2 );
+	options.SetOptimizationLevel( shaderc_optimization_level_performance );
+	options.SetIncluder( std::make_unique<ShaderIncluder>() );
+	for( const auto& [define, value] : defines )
+		options.AddMacroDefinition( define, value );
+
+	shaderc_shader_kind kind = type == Shader::Type::Vert   ? shaderc_vertex_shader
+							   : type == Shader::Type::Frag ? shaderc_fragment_shader
+															: shaderc_compute_shader;
+
+	// A compiler per call, they are cheap and not thread safe to share
+	shaderc::Compiler compiler;
+	shaderc::SpvCompilationResult result = compiler.CompileGlslToSpv( ReadText( source ), kind, source.string().c_str(), options );
+	if( result.GetCompilationStatus() != shaderc_compilation_status_success )
+		throw std::runtime_error( result.GetErrorMessage() );
+
+	std::vector<uint32_t> code( result.cbegin(), result.cend() );
+	SaveFileAtomic( output, code.data(), code.size() * sizeof( uint32_t ) );
+#else
+	// Other processes, or a hot reload next to a request, may compile the same shader at once
+	std::filesystem::path temp = UniqueTempPath( output );
+
+	std::string command = "glslangValidator -V --target-env vulkan1.2 -S ";
+	command += StageName( type );
+	for( const auto& [define, value] : defines )
+		command += " \"-D" + define + "=" + value + "\"";
+	command += " -o " + Quote( temp ) + " " + Quote( source );
+
+	std::string log;
+	std::error_code ignored;
+	if( RunCommand( command, log ) != 0 )
+	{
+		std::filesystem::remove( temp, ignored );
+		throw std::runtime_error( "failed to compile " + source.string() + ":\n" + log );
+	}
+
+	// Readers only ever see whole files, a concurrent compile replaces it with the same code
+	std::error_code error;
+	std::filesystem::rename( temp, output, error );
+	if( error )
+	{
+		std::filesystem::remove( temp, ignored );
+		throw std::runtime_error( "failed to write " + output.string() + "!" );
+	}
+#endif
+}
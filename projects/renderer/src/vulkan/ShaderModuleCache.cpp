@@ -0,0 +1,82 @@
+#include <vulkan/ShaderModuleCache.hpp>
+#include <vulkan/Device.hpp>
+#include <vulkan/Shader.hpp>
+
+#include "common/trace.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+using namespace vulkan;
+
+ShaderModuleCache::ShaderModuleCache( const Device& device )
+	: m_device( device )
+{}
+
+ShaderModuleCache::~ShaderModuleCache()
+{
+	for( auto& [hash, bucket] : m_modules )
+		for( Module& module : bucket )
+			vkDestroyShaderModule( m_device.logical(), module.module, nullptr );
+}
+
+VkShaderModule ShaderModuleCache::get( const Ref<Shader>& shader )
+{
+	std::lock_guard lock( m_mutex );
+	std::vector<Module>& bucket = m_modules[shader->GetHash()];
+	for( Module& module : bucket )
+	{
+		if( std::find( module.shaders.begin(), module.shaders.end(), shader ) != module.shaders.end() )
+			return module.module;
+		std::span<const uint32_t> a = module.shaders.front()->GetShaderData();
+		std::span<const uint32_t> b = shader->GetShaderData();
+		if( std::equal( a.begin(), a.end(), b.begin(), b.end() ) )
+		{
+			// Same code compiled again, the module lives on while this one is held
+			module.shaders.push_back( shader );
+			return module.module;
+		}
+	}
+
+	TRACE_ZONE( "CreateShaderModule" );
+	std::span<const uint32_t> code = shader->GetShaderData();
+
+	VkShaderModuleCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	createInfo.codeSize = code.size_bytes();
+	createInfo.pCode = code.data();
+
+	VkShaderModule module;
+	if( vkCreateShaderModule( m_device.logical(), &createInfo, nullptr, &module ) != VK_SUCCESS )
+		throw std::runtime_error( "failed to create shader module!" );
+
+	bucket.push_back( { { shader }, module } );
+	return module;
+}
+
+void ShaderModuleCache::release()
+{
+	// Only copies handed out before can be held elsewhere, so a count of 1 can't go up meanwhile
+	std::lock_guard lock( m_mutex );
+	for( auto it = m_modules.begin(); it != m_modules.end(); )
+	{
+		std::vector<Module>& bucket = it->second;
+		for( Module& module : bucket )
+			std::erase_if( module.shaders, []( const Ref<Shader>& shader ) { return shader.use_count() == 1; } );
+		for( const Module& module : bucket )
+			if( module.shaders.empty() )
+				vkDestroyShaderModule( m_device.logical(), module.module, nullptr );
+		std::erase_if( bucket, []( const Module& module ) { return module.shaders.empty(); } );
+		it = bucket.empty() ? m_modules.erase( it ) : std::next( it );
+	}
+}
+
+size_t ShaderModuleCache::size() const
+{
+	std::lock_guard lock( m_mutex );
+	size_t count = 0;
+	for( const auto& [hash, bucket] : m_modules )
+		count += bucket.size();
+	return count;
+}
@@ -0,0 +1,370 @@
+#include <vulkan/ShaderReflection.hpp>
+
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+
+using namespace vulkan;
+
+namespace
+{
+// The few opcodes, decorations and storage classes reflection reads, from the SPIR-V spec
+enum Op : uint32_t
+{
+	OpEntryPoint = 15,
+	OpTypeBool = 20,
+	OpTypeInt = 21,
+	OpTypeFloat = 22,
+	OpTypeVector = 23,
+	OpTypeMatrix = 24,
+	OpTypeImage = 25,
+	OpTypeSampler = 26,
+	OpTypeSampledImage = 27,
+	OpTypeArray = 28,
+	OpTypeRuntimeArray = 29,
+	OpTypeStruct = 30,
+	OpTypePointer = 32,
+	OpConstant = 43,
+	OpVariable = 59,
+	OpDecorate = 71,
+	OpMemberDecorate = 72
+};
+
+enum Decoration : uint32_t
+{
+	DecorationBlock = 2,
+	DecorationBufferBlock = 3,
+	DecorationArrayStride = 6,
+	DecorationMatrixStride = 7,
+	DecorationBuiltIn = 11,
+	DecorationLocation = 30,
+	DecorationBinding = 33,
+	DecorationDescriptorSet = 34,
+	DecorationOffset = 35
+};
+
+enum StorageClass : uint32_t
+{
+	StorageUniformConstant = 0,
+	StorageInput = 1,
+	StorageUniform = 2,
+	StoragePushConstant = 9,
+	StorageStorageBuffer = 12
+};
+
+enum ExecutionModel : uint32_t
+{
+	ModelVertex = 0,
+	ModelFragment = 4,
+	ModelGLCompute = 5
+};
+
+constexpr uint32_t SpirvMagic = 0x07230203;
+constexpr uint32_t DimBuffer = 5;
+constexpr uint32_t DimSubpassData = 6;
+
+struct Type
+{
+	uint32_t op = 0;
+	// Operands after the result id
+	std::vector<uint32_t> operands;
+};
+
+struct Decorations
+{
+	std::optional<uint32_t> set;
+	std::optional<uint32_t> binding;
+	std::optional<uint32_t> location;
+	std::optional<uint32_t> arrayStride;
+	bool block = false;
+	bool bufferBlock = false;
+	bool builtIn = false;
+	// Per struct member
+	std::vector<uint32_t> offsets;
+	std::vector<uint32_t> matrixStrides;
+	std::vector<bool> memberBuiltIn;
+};
+
+struct Variable
+{
+	uint32_t id;
+	uint32_t pointerType;
+	uint32_t storage;
+};
+
+class Module
+{
+public:
+	explicit Module( std::span<const uint32_t> code )
+	{
+		if( code.size() < 5 || code[0] != SpirvMagic )
+			throw std::runtime_error( "reflection: not SPIR-V" );
+
+		for( size_t i = 5; i < code.size(); )
+		{
+			uint32_t count = code[i] >> 16;
+			uint32_t op = code[i] & 0xFFFF;
+			if( count == 0 || i + count > code.size() )
+				throw std::runtime_error( "reflection: truncated SPIR-V" );
+			parse( op, code.subspan( i + 1, count - 1 ) );
+			i += count;
+		}
+	}
+
+	ShaderReflection reflect() const
+	{
+		ShaderReflection reflection;
+		reflection.stage = m_stage;
+
+		for( const Variable& variable : m_variables )
+		{
+			const Type& pointer = type( variable.pointerType );
+			uint32_t pointee = pointer.operands.at( 1 );
+			const Decorations* decorations = find( variable.id );
+
+			switch( variable.storage )
+			{
+				case StorageUniformConstant:
+				case StorageUniform:
+				case StorageStorageBuffer:
+					reflection.bindings.push_back( binding( variable, pointee, decorations ) );
+					break;
+				case StoragePushConstant:
+					reflection.pushConstantSize = std::max( reflection.pushConstantSize, size( pointee ) );
+					break;
+				case StorageInput:
+					if( m_stage == VK_SHADER_STAGE_VERTEX_BIT && decorations && !decorations->builtIn &&
+						decorations->location && type( pointee ).op != OpTypeStruct )
+						reflection.inputs.push_back( { *decorations->location, format( pointee ), size( pointee ) } );
+					break;
+			}
+		}
+
+		std::sort( reflection.bindings.begin(), reflection.bindings.end(), []( const auto& a, const auto& b )
+		{
+			return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+		} );
+		std::sort( reflection.inputs.begin(), reflection.inputs.end(), []( const auto& a, const auto& b )
+		{
+			return a.location < b.location;
+		} );
+		return reflection;
+	}
+
+private:
+	VkShaderStageFlagBits m_stage = VK_SHADER_STAGE_ALL;
+	std::unordered_map<uint32_t, Type> m_types;
+	std::unordered_map<uint32_t, uint32_t> m_constants;
+	std::unordered_map<uint32_t, Decorations> m_decorations;
+	std::vector<Variable> m_variables;
+
+	void parse( uint32_t op, std::span<const uint32_t> operands )
+	{
+		switch( op )
+		{
+			case OpEntryPoint:
+				if( operands[0] == ModelVertex )
+					m_stage = VK_SHADER_STAGE_VERTEX_BIT;
+				else if( operands[0] == ModelFragment )
+					m_stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+				else if( operands[0] == ModelGLCompute )
+					m_stage = VK_SHADER_STAGE_COMPUTE_BIT;
+				break;
+			case OpTypeBool:
+			case OpTypeInt:
+			case OpTypeFloat:
+			case OpTypeVector:
+			case OpTypeMatrix:
+			case OpTypeImage:
+			case OpTypeSampler:
+			case OpTypeSampledImage:
+			case OpTypeArray:
+			case OpTypeRuntimeArray:
+			case OpTypeStruct:
+			case OpTypePointer:
+				m_types[operands[0]] = { op, { operands.begin() + 1, operands.end() } };
+				break;
+			case OpConstant:
+				// Low word is enough for array lengths
+				m_constants[operands[1]] = operands[2];
+				break;
+			case OpVariable:
+				m_variables.push_back( { operands[1], operands[0], operands[2] } );
+				break;
+			case OpDecorate:
+				decorate( m_decorations[operands[0]], operands[1], operands.size() > 2 ? operands[2] : 0 );
+				break;
+			case OpMemberDecorate:
+				decorateMember( m_decorations[operands[0]], operands[1], operands[2], operands.size() > 3 ? operands[3] : 0 );
+				break;
+		}
+	}
+
+	static void decorate( Decorations& decorations, uint32_t decoration, uint32_t value )
+	{
+		switch( decoration )
+		{
+			case DecorationBlock: decorations.block = true; break;
+			case DecorationBufferBlock: decorations.bufferBlock = true; break;
+			case DecorationArrayStride: decorations.arrayStride = value; break;
+			case DecorationBuiltIn: decorations.builtIn = true; break;
+			case DecorationLocation: decorations.location = value; break;
+			case DecorationBinding: decorations.binding = value; break;
+			case DecorationDescriptorSet: decorations.set = value; break;
+		}
+	}
+
+	static void decorateMember( Decorations& decorations, uint32_t member, uint32_t decoration, uint32_t value )
+	{
+		if( decorations.offsets.size() <= member )
+		{
+			decorations.offsets.resize( member + 1, 0 );
+			decorations.matrixStrides.resize( member + 1, 0 );
+			decorations.memberBuiltIn.resize( member + 1, false );
+		}
+		if( decoration == DecorationOffset )
+			decorations.offsets[member] = value;
+		else if( decoration == DecorationMatrixStride )
+			decorations.matrixStrides[member] = value;
+		else if( decoration == DecorationBuiltIn )
+			decorations.memberBuiltIn[member] = true;
+	}
+
+	const Type& type( uint32_t id ) const
+	{
+		auto found = m_types.find( id );
+		if( found == m_types.end() )
+			throw std::runtime_error( "reflection: undefined type" );
+		return found->second;
+	}
+
+	const Decorations* find( uint32_t id ) const
+	{
+		auto found = m_decorations.find( id );
+		return found != m_decorations.end() ? &found->second : nullptr;
+	}
+
+	ShaderReflection::Binding binding( const Variable& variable, uint32_t pointee, const Decorations* decorations ) const
+	{
+		if( !decorations || !decorations->binding )
+			throw std::runtime_error( "reflection: resource without a binding" );
+
+		ShaderReflection::Binding binding = {};
+		binding.set = decorations->set.value_or( 0 );
+		binding.binding = *decorations->binding;
+		binding.count = 1;
+
+		// Arrays of resources
+		const Type* resource = &type( pointee );
+		if( resource->op == OpTypeRuntimeArray )
+			throw std::runtime_error( "reflection: runtime sized descriptor arrays need descriptor indexing" );
+		if( resource->op == OpTypeArray )
+		{
+			binding.count = m_constants.at( resource->operands[1] );
+			pointee = resource->operands[0];
+			resource = &type( pointee );
+		}
+
+		const Decorations* typeDecorations = find( pointee );
+		switch( resource->op )
+		{
+			case OpTypeStruct:
+				// Uniform storage with BufferBlock is how older GLSL declares storage buffers
+				binding.type = variable.storage == StorageStorageBuffer || ( typeDecorations && typeDecorations->bufferBlock )
+					? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER
+					: VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+				break;
+			case OpTypeSampler:
+				binding.type = VK_DESCRIPTOR_TYPE_SAMPLER;
+				break;
+			case OpTypeSampledImage:
+				binding.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+				break;
+			case OpTypeImage:
+			{
+				// Sampled type, dim, depth, arrayed, multisampled, sampled
+				uint32_t dim = resource->operands[1];
+				bool storage = resource->operands[5] == 2;
+				if( dim == DimSubpassData )
+					binding.type = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+				else if( dim == DimBuffer )
+					binding.type = storage ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+				else
+					binding.type = storage ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+				break;
+			}
+			default:
+				throw std::runtime_error( "reflection: unsupported resource type" );
+		}
+		return binding;
+	}
+
+	// Bytes the type takes in a block, by its explicit layout decorations
+	uint32_t size( uint32_t id, uint32_t matrixStride = 0 ) const
+	{
+		const Type& t = type( id );
+		switch( t.op )
+		{
+			case OpTypeBool:
+				return 4;
+			case OpTypeInt:
+			case OpTypeFloat:
+				return t.operands[0] / 8;
+			case OpTypeVector:
+				return t.operands[1] * size( t.operands[0] );
+			case OpTypeMatrix:
+				return t.operands[1] * ( matrixStride ? matrixStride : size( t.operands[0] ) );
+			case OpTypeArray:
+			{
+				const Decorations* decorations = find( id );
+				uint32_t stride = decorations && decorations->arrayStride ? *decorations->arrayStride : size( t.operands[0] );
+				return m_constants.at( t.operands[1] ) * stride;
+			}
+			case OpTypeStruct:
+			{
+				const Decorations* decorations = find( id );
+				uint32_t end = 0;
+				for( uint32_t member = 0; member < t.operands.size(); member++ )
+				{
+					uint32_t offset = decorations && member < decorations->offsets.size() ? decorations->offsets[member] : end;
+					uint32_t stride = decorations && member < decorations->matrixStrides.size() ? decorations->matrixStrides[member] : 0;
+					end = std::max( end, offset + size( t.operands[member], stride ) );
+				}
+				return end;
+			}
+		}
+		// Runtime arrays and opaque types add nothing to a fixed size
+		return 0;
+	}
+
+	VkFormat format( uint32_t id ) const
+	{
+		const Type& t = type( id );
+		uint32_t components = 1;
+		const Type* scalar = &t;
+		if( t.op == OpTypeVector )
+		{
+			components = t.operands[1];
+			scalar = &type( t.operands[0] );
+		}
+
+		static const VkFormat floats[] = { VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT };
+		static const VkFormat sints[] = { VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT };
+		static const VkFormat uints[] = { VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT };
+
+		if( components < 1 || components > 4 || scalar->operands[0] != 32 )
+			throw std::runtime_error( "reflection: unsupported vertex input type" );
+		if( scalar->op == OpTypeFloat )
+			return floats[components - 1];
+		if( scalar->op == OpTypeInt )
+			return scalar->operands[1] ? sints[components - 1] : uints[components - 1];
+		throw std::runtime_error( "reflection: unsupported vertex input type" );
+	}
+};
+}  // namespace
+
+ShaderReflection ShaderReflection::Reflect( std::span<const uint32_t> code )
+{
+	return Module( code ).reflect();
+}
@@ -0,0 +1,73 @@
+#include <vulkan/ShaderWatcher.hpp>
+#include <vulkan/GraphicsPipeline.hpp>
+#include <vulkan/ShaderCompiler.hpp>
+
+#include "common/trace.hpp"
+
+#include <algorithm>
+
+using namespace vulkan;
+
+ShaderWatcher::ShaderWatcher( ShaderCompiler& compiler, JobSystem& jobs )
+	: m_compiler( compiler ),
+	m_jobs( jobs )
+{}
+
+ShaderWatcher::~ShaderWatcher()
+{
+	for( GraphicsPipeline* pipeline : m_pipelines )
+		pipeline->waitReload();
+}
+
+void ShaderWatcher::add( GraphicsPipeline& pipeline )
+{
+	m_pipelines.push_back( &pipeline );
+	watch( pipeline );
+}
+
+void ShaderWatcher::watch( const GraphicsPipeline& pipeline )
+{
+	// Sources that aren't there (run away from the repository) just aren't watched
+	for( const auto& file : pipeline.sources() )
+		m_files.watch( file );
+}
+
+bool ShaderWatcher::update()
+{
+	TRACE_ZONE( "ShaderWatcher" );
+
+	std::vector<std::filesystem::path> changed = m_files.poll();
+	if( !changed.empty() )
+	{
+		m_compiler.invalidate();
+		for( GraphicsPipeline* pipeline : m_pipelines )
+			for( const auto& file : pipeline->sources() )
+				if( std::find( changed.begin(), changed.end(), FileWatcher::Normalize( file ) ) != changed.end() )
+					m_dirty.insert( pipeline );
+	}
+
+	bool swapped = false;
+	for( GraphicsPipeline* pipeline : m_pipelines )
+	{
+		if( pipeline->swapReloaded() )
+		{
+			// Includes may have changed
+			watch( *pipeline );
+			swapped = true;
+		}
+		else if( pipeline->reloadStale() )
+			m_dirty.insert( pipeline );
+	}
+
+	for( auto it = m_dirty.begin(); it != m_dirty.end(); )
+	{
+		if( ( *it )->reloading() )
+		{
+			it++;
+			continue;
+		}
+		( *it )->reload( m_compiler, m_jobs );
+		it = m_dirty.erase( it );
+	}
+	return swapped || !changed.empty();
+}
@@ -1,5 +1,6 @@
 #include <vulkan/SwapChain.hpp>
 
+#include <vulkan/DeletionQueue.hpp>
 #include <vulkan/Device.hpp>
 #include <vulkan/Window.hpp>
 
@@ -7,13 +8,14 @@
 
 using namespace vulkan;
 
-SwapChain::SwapChain( const Device& device, const Window& window )
+SwapChain::SwapChain( const Device& device, const Window& window, DeletionQueue* deletion )
 	: m_swap_chain( VK_NULL_HANDLE ),
 	m_oldSwapChain( VK_NULL_HANDLE ),
 	m_extent(),
 	m_imageFormat(),
 	m_device( device ),
-	m_window( window )
+	m_window( window ),
+	m_deletion( deletion )
 {
 	createSwapChain();
 	createImageViews();
@@ -21,20 +23,22 @@ SwapChain::SwapChain( const Device& device, const Window& window )
 
 void SwapChain::recreate()
 {
-	destroyImageViews();
+	// Frames in flight still render to and present the old images
+	std::vector<VkImageView> oldViews = std::move( m_imageViews );
+	m_imageViews.clear();
 	m_oldSwapChain = m_swap_chain;
 	createSwapChain();
 	createImageViews();
-}
 
-void SwapChain::cleanupOld()
-{
-	// Destroy old swap chain if it exists
-	if( m_oldSwapChain != VK_NULL_HANDLE )
+	VkDevice device = m_device.logical();
+	VkSwapchainKHR oldSwapChain = m_oldSwapChain;
+	m_oldSwapChain = VK_NULL_HANDLE;
+	DeletionQueue::Defer( m_deletion, [device, oldSwapChain, oldViews]
 	{
-		vkDestroySwapchainKHR( m_device.logical(), m_oldSwapChain, nullptr );
-		m_oldSwapChain = VK_NULL_HANDLE;
-	}
+		for( VkImageView view : oldViews )
+			vkDestroyImageView( device, view, nullptr );
+		vkDestroySwapchainKHR( device, oldSwapChain, nullptr );
+	} );
 }
 
 void SwapChain::createSwapChain()
@@ -0,0 +1,414 @@
+#include <vulkan/UploadManager.hpp>
+#include <vulkan/Device.hpp>
+#include <vulkan/Image.hpp>
+#include <vulkan/QueueSync.hpp>
+
+#include "common/trace.hpp"
+
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+using namespace vulkan;
+
+static VkSemaphore CreateTimeline( const Device& device )
+{
+	VkSemaphoreTypeCreateInfo typeInfo = {};
+	typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+	typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+	typeInfo.initialValue = 0;
+
+	VkSemaphoreCreateInfo semaphoreInfo = {};
+	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	semaphoreInfo.pNext = &typeInfo;
+
+	VkSemaphore semaphore = VK_NULL_HANDLE;
+	if( vkCreateSemaphore( device.logical(), &semaphoreInfo, nullptr, &semaphore ) != VK_SUCCESS )
+		throw std::runtime_error( "failed to create timeline semaphore!" );
+	return semaphore;
+}
+
+static VkCommandBuffer BeginCommands( const Device& device, const CommandPool& pool, std::vector<VkCommandBuffer>& free )
+{
+	VkCommandBuffer cmd = VK_NULL_HANDLE;
+	if( !free.empty() )
+	{
+		cmd = free.back();
+		free.pop_back();
+	}
+	else
+	{
+		VkCommandBufferAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.commandPool = pool.handle();
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandBufferCount = 1;
+
+		if( vkAllocateCommandBuffers( device.logical(), &allocInfo, &cmd ) != VK_SUCCESS )
+			throw std::runtime_error( "failed to allocate command buffers!" );
+	}
+
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	if( vkBeginCommandBuffer( cmd, &beginInfo ) != VK_SUCCESS )
+		throw std::runtime_error( "failed to begin recording command buffer!" );
+	return cmd;
+}
+
+static void FreeCommands( const Device& device, const CommandPool& pool, const std::vector<VkCommandBuffer>& commands )
+{
+	if( !commands.empty() )
+		vkFreeCommandBuffers( device.logical(), pool.handle(), static_cast<uint32_t>( commands.size() ), commands.data() );
+}
+
+UploadManager::UploadManager( const Device& device, MemoryAllocator& allocator, VkDeviceSize stagingSize )
+	: m_device( device ),
+	m_allocator( allocator ),
+	m_dedicated( device.transferFamily() != device.graphicsFamily() ),
+	m_transferPool( device,
+					VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+					device.transferFamily() ),
+	m_graphicsPool( device, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT ),
+	m_timeline( CreateTimeline( device ) ),
+	m_copyTimeline( m_dedicated ? CreateTimeline( device ) : VK_NULL_HANDLE ),
+	m_staging( device, allocator, stagingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT ),
+	m_submitted( 0 ),
+	m_completed( 0 )
+{
+	// Staging written before the first flush belongs to batch 1
+	m_staging.begin( 1, [this]( uint64_t value )
+	{
+		return done( value );
+	} );
+}
+
+UploadManager::~UploadManager()
+{
+	wait( submitted() );
+	for( const Batch& batch : m_inFlight )
+	{
+		if( batch.copy != VK_NULL_HANDLE )
+			m_freeTransfer.push_back( batch.copy );
+		if( batch.graphics != VK_NULL_HANDLE )
+			m_freeGraphics.push_back( batch.graphics );
+	}
+	m_inFlight.clear();
+
+	FreeCommands( m_device, m_transferPool, m_freeTransfer );
+	FreeCommands( m_device, m_graphicsPool, m_freeGraphics );
+	vkDestroySemaphore( m_device.logical(), m_timeline, nullptr );
+	if( m_copyTimeline != VK_NULL_HANDLE )
+		vkDestroySemaphore( m_device.logical(), m_copyTimeline, nullptr );
+}
+
+uint64_t UploadManager::upload( const Buffer& dst, VkDeviceSize offset, const void* data, VkDeviceSize size )
+{
+	std::lock_guard lock( m_mutex );
+	Copy copy = stage( data, size );
+	copy.buffer = dst.handle();
+	copy.offset = offset;
+	m_copies.push_back( copy );
+	return submitted() + 1;
+}
+
+uint64_t UploadManager::upload( const Image& dst, const void* data, VkDeviceSize size )
+{
+	std::lock_guard lock( m_mutex );
+	Copy copy = stage( data, size );
+	copy.image = dst.handle();
+	copy.extent = dst.extent();
+	m_copies.push_back( copy );
+	return submitted() + 1;
+}
+
+uint64_t UploadManager::record( Commands commands )
+{
+	std::lock_guard lock( m_mutex );
+	m_commands.push_back( std::move( commands ) );
+	return submitted() + 1;
+}
+
+void UploadManager::flush()
+{
+	TRACE_ZONE( "FlushUploads" );
+	std::lock_guard lock( m_mutex );
+	retire();
+	if( m_copies.empty() && m_commands.empty() )
+		return;
+
+	uint64_t value = submitted() + 1;
+	Batch batch = { value, VK_NULL_HANDLE, VK_NULL_HANDLE, std::move( m_ownStaging ) };
+	if( !m_copies.empty() )
+		batch.copy = recordCopies();
+	// Without a dedicated queue the copies leave nothing to acquire
+	if( !m_commands.empty() || ( m_dedicated && batch.copy != VK_NULL_HANDLE ) )
+		batch.graphics = recordGraphics();
+
+	if( !m_dedicated )
+	{
+		std::vector<VkCommandBuffer> commands;
+		if( batch.copy != VK_NULL_HANDLE )
+			commands.push_back( batch.copy );
+		if( batch.graphics != VK_NULL_HANDLE )
+			commands.push_back( batch.graphics );
+
+		TimelineSubmit submit;
+		submit.signal( m_timeline, value );
+		submit.submit( m_device.graphicsQueue(), commands );
+	}
+	else
+	{
+		// Copies overlap rendering, the graphics queue only waits where it takes the resources over
+		if( batch.copy != VK_NULL_HANDLE )
+		{
+			TimelineSubmit submit;
+			submit.signal( m_copyTimeline, value );
+			submit.submit( m_device.transferQueue(), { batch.copy } );
+		}
+
+		TimelineSubmit submit;
+		if( batch.copy != VK_NULL_HANDLE )
+			submit.wait( m_copyTimeline, value, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT );
+		submit.signal( m_timeline, value );
+		submit.submit( m_device.graphicsQueue(), { batch.graphics } );
+	}
+
+	m_inFlight.push_back( std::move( batch ) );
+	m_ownStaging.clear();
+	m_copies.clear();
+	m_commands.clear();
+	m_submitted.store( value, std::memory_order_release );
+
+	m_staging.begin( value + 1, [this]( uint64_t batch )
+	{
+		return done( batch );
+	} );
+}
+
+VkCommandBuffer UploadManager::recordCopies()
+{
+	VkCommandBuffer cmd = BeginCommands( m_device, m_transferPool, m_freeTransfer );
+	uint32_t src = m_device.transferFamily();
+	uint32_t dst = m_device.graphicsFamily();
+
+	// Images are transitioned together, before and after all the copies
+	std::vector<VkImageMemoryBarrier> toTransfer;
+	std::vector<VkImageMemoryBarrier> releaseImages;
+	std::vector<VkBufferMemoryBarrier> releaseBuffers;
+	for( const Copy& copy : m_copies )
+	{
+		if( copy.image != VK_NULL_HANDLE )
+		{
+			VkImageSubresourceRange range = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+			toTransfer.push_back( QueueSync::ImageTransfer( copy.image,
+															range,
+															VK_IMAGE_LAYOUT_UNDEFINED,
+															VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+															src,
+															src,
+															0,
+															VK_ACCESS_TRANSFER_WRITE_BIT ) );
+			// Made visible to the frame by its wait on the timeline
+			releaseImages.push_back( QueueSync::ImageTransfer( copy.image,
+															   range,
+															   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+															   VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+															   src,
+															   dst,
+															   VK_ACCESS_TRANSFER_WRITE_BIT,
+															   0 ) );
+		}
+		else if( m_dedicated )
+			releaseBuffers.push_back( QueueSync::BufferTransfer( copy.buffer,
+																 copy.offset,
+																 copy.size,
+																 src,
+																 dst,
+																 VK_ACCESS_TRANSFER_WRITE_BIT,
+																 0 ) );
+	}
+
+	if( !toTransfer.empty() )
+		vkCmdPipelineBarrier( cmd,
+							  VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+							  VK_PIPELINE_STAGE_TRANSFER_BIT,
+							  0, 0, nullptr, 0, nullptr,
+							  static_cast<uint32_t>( toTransfer.size() ), toTransfer.data() );
+
+	for( const Copy& copy : m_copies )
+	{
+		if( copy.buffer != VK_NULL_HANDLE )
+		{
+			VkBufferCopy region = { copy.stagingOffset, copy.offset, copy.size };
+			vkCmdCopyBuffer( cmd, copy.staging, copy.buffer, 1, &region );
+		}
+		else
+		{
+			VkBufferImageCopy region = {};
+			region.bufferOffset = copy.stagingOffset;
+			region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+			region.imageExtent = copy.extent;
+			vkCmdCopyBufferToImage( cmd, copy.staging, copy.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region );
+		}
+	}
+
+	if( !releaseImages.empty() || !releaseBuffers.empty() )
+		vkCmdPipelineBarrier( cmd,
+							  VK_PIPELINE_STAGE_TRANSFER_BIT,
+							  VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+							  0, 0, nullptr,
+							  static_cast<uint32_t>( releaseBuffers.size() ), releaseBuffers.data(),
+							  static_cast<uint32_t>( releaseImages.size() ), releaseImages.data() );
+
+	if( vkEndCommandBuffer( cmd ) != VK_SUCCESS )
+		throw std::runtime_error( "failed to record command buffer!" );
+	return cmd;
+}
+
+VkCommandBuffer UploadManager::recordGraphics()
+{
+	VkCommandBuffer cmd = BeginCommands( m_device, m_graphicsPool, m_freeGraphics );
+
+	if( m_dedicated )
+	{
+		// Same barriers as the releases, with the access on this side
+		uint32_t src = m_device.transferFamily();
+		uint32_t dst = m_device.graphicsFamily();
+		std::vector<VkImageMemoryBarrier> acquireImages;
+		std::vector<VkBufferMemoryBarrier> acquireBuffers;
+		for( const Copy& copy : m_copies )
+		{
+			if( copy.image != VK_NULL_HANDLE )
+				acquireImages.push_back( QueueSync::ImageTransfer( copy.image,
+																   { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 },
+																   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+																   VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+																   src,
+																   dst,
+																   0,
+																   VK_ACCESS_SHADER_READ_BIT ) );
+			else
+				acquireBuffers.push_back( QueueSync::BufferTransfer( copy.buffer,
+																	 copy.offset,
+																	 copy.size,
+																	 src,
+																	 dst,
+																	 0,
+																	 VK_ACCESS_MEMORY_READ_BIT ) );
+		}
+
+		if( !acquireImages.empty() || !acquireBuffers.empty() )
+			vkCmdPipelineBarrier( cmd,
+								  VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+								  VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+								  0, 0, nullptr,
+								  static_cast<uint32_t>( acquireBuffers.size() ), acquireBuffers.data(),
+								  static_cast<uint32_t>( acquireImages.size() ), acquireImages.data() );
+	}
+
+	for( const Commands& commands : m_commands )
+		commands( cmd );
+
+	if( vkEndCommandBuffer( cmd ) != VK_SUCCESS )
+		throw std::runtime_error( "failed to record command buffer!" );
+	return cmd;
+}
+
+bool UploadManager::done( uint64_t value ) const
+{
+	if( value <= m_completed.load( std::memory_order_acquire ) )
+		return true;
+
+	uint64_t counter = 0;
+	vkGetSemaphoreCounterValue( m_device.logical(), m_timeline, &counter );
+	raiseCompleted( counter );
+	return value <= counter;
+}
+
+void UploadManager::wait( uint64_t value ) const
+{
+	if( done( value ) )
+		return;
+
+	VkSemaphoreWaitInfo waitInfo = {};
+	waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+	waitInfo.semaphoreCount = 1;
+	waitInfo.pSemaphores = &m_timeline;
+	waitInfo.pValues = &value;
+
+	if( vkWaitSemaphores( m_device.logical(), &waitInfo, UINT64_MAX ) != VK_SUCCESS )
+		throw std::runtime_error( "failed to wait for upload timeline!" );
+	raiseCompleted( value );
+}
+
+VkDeviceSize UploadManager::stagingUsed() const
+{
+	std::lock_guard lock( m_mutex );
+	return m_staging.used();
+}
+
+UploadManager::Copy UploadManager::stage( const void* data, VkDeviceSize size )
+{
+	// Image copies need texel aligned offsets, 16 covers every format
+	const VkDeviceSize alignment = 16;
+	uint64_t value = submitted() + 1;
+
+	std::optional<FrameArena::Slice> slice = m_staging.allocate( size, alignment );
+	if( !slice )
+	{
+		// Batches may have finished since the last flush
+		m_staging.begin( value, [this]( uint64_t batch )
+		{
+			return done( batch );
+		} );
+		slice = m_staging.allocate( size, alignment );
+	}
+
+	Copy copy = {};
+	copy.size = size;
+	if( slice )
+	{
+		std::memcpy( slice->data, data, size );
+		copy.staging = slice->buffer;
+		copy.stagingOffset = slice->offset;
+		return copy;
+	}
+
+	// Too big for what's left of the ring, a staging buffer of its own lives as long as the batch
+	Scope<Buffer> staging = CreateScope<Buffer>( m_device,
+												 m_allocator,
+												 size,
+												 VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+												 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT );
+	std::memcpy( staging->mapped(), data, size );
+	copy.staging = staging->handle();
+	copy.stagingOffset = 0;
+	m_ownStaging.push_back( std::move( staging ) );
+	return copy;
+}
+
+void UploadManager::retire()
+{
+	while( !m_inFlight.empty() && done( m_inFlight.front().value ) )
+	{
+		const Batch& batch = m_inFlight.front();
+		for( auto [cmd, free] : { std::pair{ batch.copy, &m_freeTransfer }, std::pair{ batch.graphics, &m_freeGraphics } } )
+		{
+			if( cmd == VK_NULL_HANDLE )
+				continue;
+			if( vkResetCommandBuffer( cmd, 0 ) != VK_SUCCESS )
+				throw std::runtime_error( "failed to reset command buffer!" );
+			free->push_back( cmd );
+		}
+		// Own staging buffers go with it, nothing uses them anymore
+		m_inFlight.pop_front();
+	}
+}
+
+void UploadManager::raiseCompleted( uint64_t value ) const
+{
+	uint64_t completed = m_completed.load( std::memory_order_relaxed );
+	while( completed < value && !m_completed.compare_exchange_weak( completed, value, std::memory_order_release ) )
+	{}
+}
@@ -6,5 +6,10 @@ layout(location = 0) in vec3 fragColor;
 layout(location = 0) out vec4 outColor;
 
 void main() {
+#ifdef GRAYSCALE
+    float luma = dot(fragColor, vec3(0.2126, 0.7152, 0.0722));
+    outColor = vec4(vec3(luma), 1.0);
+#else
     outColor = vec4(fragColor, 1.0);
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,28 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_GOOGLE_include_directive : require
+
+#include "lib/instance.glsl"
+
+layout(std430, set = 0, binding = 0) readonly buffer Instances {
+    Instance instances[];
+};
+
+layout(push_constant) uniform Push {
+    mat4 viewProjection;
+} push;
+
+layout(location = 0) out vec3 fragColor;
+
+// base.vert's triangle
+vec3 positions[3] = vec3[](
+    vec3(0.0, -0.5, 0.0),
+    vec3(0.5, 0.5, 0.0),
+    vec3(-0.5, 0.5, 0.0)
+);
+
+void main() {
+    Instance instance = instances[gl_InstanceIndex];
+    gl_Position = push.viewProjection * vec4(instanceTransform(instance, positions[gl_VertexIndex]), 1.0);
+    fragColor = instanceColor(instance).rgb;
+}
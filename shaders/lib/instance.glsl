@@ -0,0 +1,28 @@
+// Per instance data of InstanceBuffer, 32 bytes
+
+struct Instance {
+    vec3 position;
+    float scale;
+    // Quaternion xyzw, snorm16
+    uvec2 rotation;
+    // RGBA8 unorm
+    uint color;
+    uint padding;
+};
+
+vec4 instanceRotation(Instance instance) {
+    return vec4(unpackSnorm2x16(instance.rotation.x), unpackSnorm2x16(instance.rotation.y));
+}
+
+vec4 instanceColor(Instance instance) {
+    return unpackUnorm4x8(instance.color);
+}
+
+vec3 rotateByQuaternion(vec3 v, vec4 q) {
+    return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+// Scaled, rotated and then placed
+vec3 instanceTransform(Instance instance, vec3 position) {
+    return instance.position + rotateByQuaternion(position * instance.scale, instanceRotation(instance));
+}
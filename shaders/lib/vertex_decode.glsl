@@ -0,0 +1,21 @@
+// Decoders of the quantized vertex format, VertexLayout::Quantized in Mesh.hpp
+
+// Unorm position back into the mesh bounds
+vec3 decodePosition(vec3 quantized, vec3 boundsMin, vec3 boundsExtent) {
+    return boundsMin + quantized * boundsExtent;
+}
+
+// Octahedral encoding in [-1, 1]^2 back to a unit vector
+vec3 decodeOctahedral(vec2 encoded) {
+    vec3 n = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    // Lower hemisphere was folded over the diagonals
+    float fold = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -fold : fold;
+    n.y += n.y >= 0.0 ? -fold : fold;
+    return normalize(n);
+}
+
+// Tangent with the bitangent's handedness in w, stored as 0 or 1
+vec4 decodeTangent(vec2 encoded, float handedness) {
+    return vec4(decodeOctahedral(encoded), handedness * 2.0 - 1.0);
+}
@@ -0,0 +1,18 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inNormal;
+layout(location = 2) in vec2 inUv;
+
+layout(push_constant) uniform Push {
+    mat4 viewProjection;
+} push;
+
+layout(location = 0) out vec3 fragColor;
+
+void main() {
+    gl_Position = push.viewProjection * vec4(inPosition, 1.0);
+    // Normals as colors until there is lighting, base.frag shades with them
+    fragColor = normalize(inNormal) * 0.5 + 0.5;
+}
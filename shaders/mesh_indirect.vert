@@ -0,0 +1,28 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_GOOGLE_include_directive : require
+
+#include "lib/instance.glsl"
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inNormal;
+layout(location = 2) in vec2 inUv;
+
+layout(std430, set = 0, binding = 0) readonly buffer Instances {
+    Instance instances[];
+};
+
+layout(push_constant) uniform Push {
+    mat4 viewProjection;
+} push;
+
+layout(location = 0) out vec3 fragColor;
+
+void main() {
+    // Draws written by cull.comp carry the object's index as firstInstance
+    Instance instance = instances[gl_InstanceIndex];
+    gl_Position = push.viewProjection * vec4(instanceTransform(instance, inPosition), 1.0);
+    // Lit from above until there is lighting
+    vec3 normal = normalize(rotateByQuaternion(inNormal, instanceRotation(instance)));
+    fragColor = instanceColor(instance).rgb * (normal.y * 0.35 + 0.65);
+}
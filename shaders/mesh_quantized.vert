@@ -0,0 +1,27 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_GOOGLE_include_directive : require
+
+#include "lib/vertex_decode.glsl"
+
+// Unorm position in xyz, tangent handedness in w
+layout(location = 0) in vec4 inPosition;
+// Octahedral normal in xy, tangent in zw
+layout(location = 1) in vec4 inNormalTangent;
+layout(location = 2) in vec2 inUv;
+
+layout(push_constant) uniform Push {
+    mat4 viewProjection;
+    vec4 boundsMin;
+    vec4 boundsExtent;
+} push;
+
+layout(location = 0) out vec3 fragColor;
+
+void main() {
+    vec3 position = decodePosition(inPosition.xyz, push.boundsMin.xyz, push.boundsExtent.xyz);
+    vec3 normal = decodeOctahedral(inNormalTangent.xy);
+    gl_Position = push.viewProjection * vec4(position, 1.0);
+    // Same colors as mesh.vert
+    fragColor = normal * 0.5 + 0.5;
+}